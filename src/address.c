@@ -0,0 +1,199 @@
+//
+//  address.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include "address.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netdb.h>
+#include <sys/un.h>
+#include "utility.h"
+
+static px_address_list *px_address_list_resolve_unix(const char *restrict directory, const unsigned int port);
+static void px_address_list_interleave(px_address_list *restrict address_list);
+
+px_address_list *px_address_list_resolve(const char *restrict hostname, const unsigned int port)
+{
+    // like libpq, a host name that is an absolute path is the directory of the server's socket
+    if (hostname != NULL && hostname[0] == '/')
+        return px_address_list_resolve_unix(hostname, port);
+    
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    
+    struct addrinfo *address_info = NULL;
+    char port_string[16];
+    sprintf(port_string, "%u", port);
+    
+    const int address_error = getaddrinfo(hostname, port_string, &hints, &address_info);
+    
+    if (address_error != 0)
+    {
+        fprintf(stderr, "%s\n", gai_strerror(address_error));
+        if (address_info != NULL) freeaddrinfo(address_info);
+        return NULL;
+    }
+    
+    px_address_list *address_list = calloc(1, sizeof(px_address_list));
+    address_list->reference_count = 1;
+    
+    for (struct addrinfo *current = address_info; current != NULL; current = current->ai_next)
+        address_list->count++;
+    
+    address_list->addresses = calloc(address_list->count, sizeof(px_address));
+    
+    unsigned int i = 0;
+    for (struct addrinfo *current = address_info; current != NULL; current = current->ai_next, i++)
+    {
+        px_address *address = &address_list->addresses[i];
+        address->family = current->ai_family;
+        address->socket_type = current->ai_socktype;
+        address->protocol = current->ai_protocol;
+        address->length = current->ai_addrlen;
+        memcpy(&address->storage, current->ai_addr, current->ai_addrlen);
+    }
+    
+    freeaddrinfo(address_info);
+    px_address_list_interleave(address_list);
+    
+    return address_list;
+}
+
+static void px_address_list_interleave(px_address_list *restrict address_list)
+{
+    // RFC 8305 section 4: the preferred family goes first, then the families take turns
+    for (unsigned int i = 1; i < address_list->count; i++)
+    {
+        const int previous_family = address_list->addresses[i - 1].family;
+        if (address_list->addresses[i].family != previous_family)
+            continue;
+        
+        unsigned int other = i + 1;
+        while (other < address_list->count && address_list->addresses[other].family == previous_family)
+            other++;
+        
+        if (other == address_list->count)
+            return;
+        
+        // move the next address of another family forward, keeping the order of the rest
+        const px_address address = address_list->addresses[other];
+        memmove(&address_list->addresses[i + 1], &address_list->addresses[i], (other - i) * sizeof(px_address));
+        address_list->addresses[i] = address;
+    }
+}
+
+static px_address_list *px_address_list_resolve_unix(const char *restrict directory, const unsigned int port)
+{
+    struct sockaddr_un socket_address;
+    memset(&socket_address, 0, sizeof(socket_address));
+    socket_address.sun_family = AF_UNIX;
+    
+    const int length = snprintf(socket_address.sun_path, sizeof(socket_address.sun_path), "%s/.s.PGSQL.%u", directory, port);
+    if (length < 0 || (size_t)length >= sizeof(socket_address.sun_path))
+    {
+        fprintf(stderr, "Unix-domain socket path \"%s/.s.PGSQL.%u\" is too long\n", directory, port);
+        return NULL;
+    }
+    
+    px_address_list *address_list = calloc(1, sizeof(px_address_list));
+    address_list->reference_count = 1;
+    address_list->count = 1;
+    address_list->addresses = calloc(1, sizeof(px_address));
+    
+    px_address *address = &address_list->addresses[0];
+    address->family = AF_UNIX;
+    address->socket_type = SOCK_STREAM;
+    address->protocol = 0;
+    address->length = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + (size_t)length + 1);
+    memcpy(&address->storage, &socket_address, sizeof(socket_address));
+    
+    return address_list;
+}
+
+px_address_list *px_address_list_retain(px_address_list *address_list)
+{
+    __sync_add_and_fetch(&address_list->reference_count, 1);
+    
+    return address_list;
+}
+
+void px_address_list_release(px_address_list *address_list)
+{
+    if (address_list == NULL || __sync_sub_and_fetch(&address_list->reference_count, 1) != 0)
+        return;
+    
+    free(address_list->addresses);
+    free(address_list);
+}
+
+px_address_cache *px_address_cache_new(void)
+{
+    px_address_cache *address_cache = calloc(1, sizeof(px_address_cache));
+    pthread_mutex_init(&address_cache->mutex, NULL);
+    
+    return address_cache;
+}
+
+void px_address_cache_delete(px_address_cache *address_cache)
+{
+    px_address_list_release(address_cache->current);
+    pthread_mutex_destroy(&address_cache->mutex);
+    free(address_cache);
+}
+
+px_address_list *px_address_cache_get(px_address_cache *restrict address_cache, const char *restrict hostname, const unsigned int port, const unsigned int ttl)
+{
+    if (ttl == 0)
+        return px_address_list_resolve(hostname, port);
+    
+    // the lookup happens under the lock, so that a pool opening many connections at
+    // once resolves the host only once while the rest wait for the result
+    pthread_mutex_lock(&address_cache->mutex);
+    
+    const uint64_t now = px_get_monotonic_time();
+    
+    if (address_cache->current == NULL || address_cache->current->expires <= now)
+    {
+        px_address_list *address_list = px_address_list_resolve(hostname, port);
+        
+        if (address_list != NULL)
+        {
+            address_list->expires = now + (uint64_t)ttl * 1000;
+            px_address_list_release(address_cache->current);
+            address_cache->current = address_list;
+        }
+        else if (address_cache->current != NULL)
+        {
+            // keep using the stale addresses while the resolver is unavailable
+            px_address_list *stale = px_address_list_retain(address_cache->current);
+            pthread_mutex_unlock(&address_cache->mutex);
+            return stale;
+        }
+        else
+        {
+            pthread_mutex_unlock(&address_cache->mutex);
+            return NULL;
+        }
+    }
+    
+    px_address_list *address_list = px_address_list_retain(address_cache->current);
+    pthread_mutex_unlock(&address_cache->mutex);
+    
+    return address_list;
+}
+
+void px_address_cache_clear(px_address_cache *restrict address_cache)
+{
+    pthread_mutex_lock(&address_cache->mutex);
+    px_address_list_release(address_cache->current);
+    address_cache->current = NULL;
+    pthread_mutex_unlock(&address_cache->mutex);
+}
@@ -0,0 +1,55 @@
+//
+//  address.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_address_h
+#define libpx_address_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "typedef.h"
+
+typedef struct px_address
+{
+    int family;
+    int socket_type;
+    int protocol;
+    socklen_t length;
+    struct sockaddr_storage storage;
+} px_address;
+
+// the addresses a host name resolved to, in the order getaddrinfo returned them but with
+// the address families interleaved, so that connection attempts alternate between them
+struct px_address_list
+{
+    volatile unsigned int reference_count;
+    uint64_t expires;
+    unsigned int count;
+    px_address *addresses;
+};
+
+// the last resolution of a host, shared by all connections using the same params
+struct px_address_cache
+{
+    pthread_mutex_t mutex;
+    px_address_list *current;
+};
+
+// resolving addresses
+px_address_list *px_address_list_resolve(const char *restrict hostname, const unsigned int port);
+px_address_list *px_address_list_retain(px_address_list *address_list);
+void px_address_list_release(px_address_list *address_list);
+
+// caching resolved addresses
+px_address_cache *px_address_cache_new(void);
+void px_address_cache_delete(px_address_cache *address_cache);
+px_address_list *px_address_cache_get(px_address_cache *restrict address_cache, const char *restrict hostname, const unsigned int port, const unsigned int ttl);
+void px_address_cache_clear(px_address_cache *restrict address_cache);
+
+#endif
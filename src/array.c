@@ -0,0 +1,671 @@
+//
+//  array.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "array.h"
+#include "data_type.h"
+#include "utility.h"
+
+static px_array *px_array_new(const unsigned int element_oid, const unsigned int count, const size_t heap_size);
+static bool px_array_measure_text(const char *restrict text, const size_t length, const char delimiter, px_array *restrict shape, size_t *restrict offset);
+static bool px_array_parse_bound(const char **restrict character, const char *restrict end, int *restrict value);
+static const char *px_array_skip_element(const char *restrict character, const char *restrict end, const char delimiter) __attribute__((pure));
+static const char *px_array_read_element(const char *restrict character, const char *restrict end, const char delimiter, char *restrict copy, const size_t capacity, size_t *restrict copy_length, bool *restrict is_null);
+static bool px_array_parse_element(px_array *restrict array, const unsigned int index, const char *restrict text);
+static bool px_array_read_binary_element(px_array *restrict array, const unsigned int index, const unsigned char *restrict data, const size_t length, char **restrict heap_end);
+static bool px_array_is_sent_as_text(const unsigned int element_oid) __attribute__((const));
+static bool px_array_is_space(const char character) __attribute__((const));
+static void px_array_set_null(px_array *restrict array, const unsigned int index);
+
+// by px_array_element_kind
+static const size_t px_array_element_sizes[] = { sizeof(char *), sizeof(bool), sizeof(int16_t), sizeof(int32_t), sizeof(int64_t), sizeof(float), sizeof(double), sizeof(uint32_t) };
+static const size_t px_array_binary_element_sizes[] = { 0, 1, 2, 4, 8, 4, 8, 4 };
+
+// numbers longer than this aren't numbers
+#define PX_ARRAY_MAX_NUMBER_LENGTH 64
+
+px_array *px_array_decode_text(const char *restrict text, const size_t length, const unsigned int element_oid, const char delimiter)
+{
+    px_array shape;
+    size_t offset;
+    if (!px_array_measure_text(text, length, delimiter, &shape, &offset))
+        return NULL;
+    
+    // a string is never longer than its text, which is followed by a delimiter or a brace its terminating zero takes the place of
+    const px_array_element_kind element_kind = px_array_get_element_kind(element_oid);
+    const size_t heap_size = element_kind == px_array_element_kind_string ? length : 0;
+    
+    px_array *array = px_array_new(element_oid, shape.count, heap_size);
+    array->dimension_count = shape.dimension_count;
+    memcpy(array->dimensions, shape.dimensions, sizeof(shape.dimensions));
+    memcpy(array->lower_bounds, shape.lower_bounds, sizeof(shape.lower_bounds));
+    
+    const char *character = text + offset;
+    const char *end = text + length;
+    char *heap_end = array->heap;
+    char number[PX_ARRAY_MAX_NUMBER_LENGTH];
+    
+    // the shape is known by now, only the elements are left to read
+    for (unsigned int index = 0; index < array->count && character < end; )
+    {
+        if (*character == '{' || *character == '}' || *character == delimiter || px_array_is_space(*character))
+        {
+            character++;
+            continue;
+        }
+        
+        size_t copy_length;
+        bool is_null;
+        
+        if (element_kind == px_array_element_kind_string)
+        {
+            character = px_array_read_element(character, end, delimiter, heap_end, (size_t)(array->heap + heap_size - heap_end), &copy_length, &is_null);
+            if (character != NULL && !is_null)
+            {
+                ((const char **)array->values)[index] = heap_end;
+                heap_end += copy_length + 1;
+            }
+        }
+        else
+        {
+            character = px_array_read_element(character, end, delimiter, number, sizeof(number), &copy_length, &is_null);
+            if (character != NULL && !is_null && !px_array_parse_element(array, index, number))
+                character = NULL;
+        }
+        
+        if (character == NULL)
+        {
+            px_array_delete(array);
+            return NULL;
+        }
+        
+        if (is_null)
+            px_array_set_null(array, index);
+        
+        index++;
+    }
+    
+    return array;
+}
+
+px_array *px_array_decode_binary(const void *restrict data, const size_t length)
+{
+    // the number of dimensions, whether there are NULLs, the element type, then the length and the lower bound of each dimension
+    const unsigned char *bytes = data;
+    if (length < 12)
+        return NULL;
+    
+    const int dimension_count = (int)px_read_network_uint32(bytes);
+    const unsigned int element_oid = px_read_network_uint32(bytes + 8);
+    
+    if (dimension_count < 0 || dimension_count > PX_ARRAY_MAX_DIMENSIONS || length < 12 + (size_t)dimension_count * 8)
+        return NULL;
+    
+    const px_array_element_kind element_kind = px_array_get_element_kind(element_oid);
+    if (element_kind == px_array_element_kind_string && !px_array_is_sent_as_text(element_oid))
+        return NULL;
+    
+    int dimensions[PX_ARRAY_MAX_DIMENSIONS];
+    int lower_bounds[PX_ARRAY_MAX_DIMENSIONS];
+    uint64_t count = dimension_count == 0 ? 0 : 1;
+    
+    for (int i = 0; i < dimension_count; i++)
+    {
+        dimensions[i] = (int)px_read_network_uint32(bytes + 12 + i * 8);
+        lower_bounds[i] = (int)px_read_network_uint32(bytes + 16 + i * 8);
+        
+        // every element takes 4 bytes at least, for its length
+        count *= (uint64_t)(dimensions[i] < 0 ? 0 : dimensions[i]);
+        if (dimensions[i] < 0 || count > length / 4)
+            return NULL;
+    }
+    
+    // each string takes the place of its length, with room to spare for its terminating zero
+    px_array *array = px_array_new(element_oid, (unsigned int)count, element_kind == px_array_element_kind_string ? length : 0);
+    array->dimension_count = (unsigned int)dimension_count;
+    memcpy(array->dimensions, dimensions, (size_t)dimension_count * sizeof(int));
+    memcpy(array->lower_bounds, lower_bounds, (size_t)dimension_count * sizeof(int));
+    
+    const unsigned char *element = bytes + 12 + dimension_count * 8;
+    const unsigned char *end = bytes + length;
+    char *heap_end = array->heap;
+    bool malformed = false;
+    
+    for (unsigned int index = 0; index < array->count && !malformed; index++)
+    {
+        if (end - element < 4)
+        {
+            malformed = true;
+            break;
+        }
+        
+        const int element_length = (int)px_read_network_uint32(element);
+        element += 4;
+        
+        if (element_length == -1)
+        {
+            px_array_set_null(array, index);
+            continue;
+        }
+        
+        malformed = element_length < 0 || end - element < element_length
+            || !px_array_read_binary_element(array, index, element, (size_t)element_length, &heap_end);
+        element += malformed ? 0 : element_length;
+    }
+    
+    if (malformed || element != end)
+    {
+        px_array_delete(array);
+        return NULL;
+    }
+    
+    return array;
+}
+
+px_array *px_array_decode_vector(const char *restrict text, const size_t length, const unsigned int element_oid)
+{
+    const char *end = text + length;
+    unsigned int count = 0;
+    
+    for (const char *character = text; character < end; character++)
+    {
+        if (!px_array_is_space(*character) && (character == text || px_array_is_space(character[-1])))
+            count++;
+    }
+    
+    // like the binary form of the vector types, the elements start at 0
+    px_array *array = px_array_new(element_oid, count, 0);
+    if (count > 0)
+    {
+        array->dimension_count = 1;
+        array->dimensions[0] = (int)count;
+    }
+    
+    const char *character = text;
+    char number[PX_ARRAY_MAX_NUMBER_LENGTH];
+    
+    for (unsigned int index = 0; index < count; index++)
+    {
+        while (px_array_is_space(*character))
+            character++;
+        
+        const char *number_end = character;
+        while (number_end < end && !px_array_is_space(*number_end))
+            number_end++;
+        
+        const size_t number_length = (size_t)(number_end - character);
+        if (number_length >= sizeof(number))
+        {
+            px_array_delete(array);
+            return NULL;
+        }
+        
+        memcpy(number, character, number_length);
+        number[number_length] = '\0';
+        
+        if (!px_array_parse_element(array, index, number))
+        {
+            px_array_delete(array);
+            return NULL;
+        }
+        
+        character = number_end;
+    }
+    
+    return array;
+}
+
+void px_array_delete(px_array *array)
+{
+    // the values, the NULL bitmap and the heap are in the same block
+    free(array);
+}
+
+bool px_array_is_null(const px_array *restrict array, const unsigned int index)
+{
+    return (array->nulls[index >> 3] >> (index & 7)) & 1;
+}
+
+unsigned int px_array_get_element_oid(const unsigned int array_oid)
+{
+    switch (array_oid)
+    {
+        case px_data_type_boola:                return px_data_type_bool;
+        case px_data_type_namea:                return px_data_type_name;
+        case px_data_type_int16au:              return px_data_type_int16;
+        case px_data_type_int32a:               return px_data_type_int32;
+        case px_data_type_int64a:               return px_data_type_int64;
+        case px_data_type_texta:                return px_data_type_varcharu;
+        case px_data_type_charna:               return px_data_type_charn;
+        case px_data_type_varcharna:            return px_data_type_varcharn;
+        case px_data_type_floata:               return px_data_type_single;
+        case px_data_type_doublea:              return px_data_type_double;
+        case px_data_type_oidau:                return px_data_type_oid;
+        case px_data_type_acla:                 return px_data_type_acl;
+        case px_data_type_timestampa:           return px_data_type_timestamp;
+        case px_data_type_datea:                return px_data_type_date;
+        case px_data_type_timestampza:          return px_data_type_timestampz;
+        case px_data_type_numerica:             return px_data_type_numeric;
+        case px_data_type_regtypea:             return px_data_type_regtype;
+        case px_data_type_uuida:                return px_data_type_uuid;
+        default:                                return 0;
+    }
+}
+
+px_array_element_kind px_array_get_element_kind(const unsigned int element_oid)
+{
+    switch (element_oid)
+    {
+        case px_data_type_bool:                 return px_array_element_kind_bool;
+        case px_data_type_int16:                return px_array_element_kind_int16;
+        case px_data_type_int32:                return px_array_element_kind_int32;
+        case px_data_type_int64:                return px_array_element_kind_int64;
+        case px_data_type_single:               return px_array_element_kind_single;
+        case px_data_type_double:               return px_array_element_kind_double;
+        case px_data_type_oid:
+        case px_data_type_xid:
+        case px_data_type_cid:                  return px_array_element_kind_oid;
+        default:                                return px_array_element_kind_string;
+    }
+}
+
+static px_array *px_array_new(const unsigned int element_oid, const unsigned int count, const size_t heap_size)
+{
+    const px_array_element_kind element_kind = px_array_get_element_kind(element_oid);
+    const size_t values_size = ((size_t)count * px_array_element_sizes[element_kind] + 7) & ~(size_t)7;
+    const size_t nulls_size = ((size_t)count + 7) / 8;
+    
+    // zeroed, so that NULL elements are 0 or NULL and no bit of the bitmap is set
+    px_array *array = calloc(1, sizeof(px_array) + values_size + nulls_size + heap_size);
+    array->element_oid = element_oid;
+    array->element_kind = element_kind;
+    array->count = count;
+    array->values = array + 1;
+    array->nulls = (uint8_t *)array->values + values_size;
+    array->heap = (char *)array->nulls + nulls_size;
+    
+    return array;
+}
+
+static bool px_array_measure_text(const char *restrict text, const size_t length, const char delimiter, px_array *restrict shape, size_t *restrict offset)
+{
+    const char *character = text;
+    const char *end = text + length;
+    
+    memset(shape, 0, sizeof(px_array));
+    for (int i = 0; i < PX_ARRAY_MAX_DIMENSIONS; i++)
+    {
+        shape->dimensions[i] = -1;
+        shape->lower_bounds[i] = 1;
+    }
+    
+    // [lower:upper] for each dimension before the elements when the lower bounds aren't all 1
+    int explicit_dimensions[PX_ARRAY_MAX_DIMENSIONS];
+    int explicit_count = 0;
+    
+    while (character < end && *character == '[')
+    {
+        int upper_bound;
+        character++;
+        
+        if (explicit_count == PX_ARRAY_MAX_DIMENSIONS
+            || !px_array_parse_bound(&character, end, &shape->lower_bounds[explicit_count])
+            || character == end || *character++ != ':'
+            || !px_array_parse_bound(&character, end, &upper_bound)
+            || character == end || *character++ != ']')
+        {
+            return false;
+        }
+        
+        // the length of [-2147483648:2147483647] doesn't fit an int
+        const int64_t dimension = (int64_t)upper_bound - shape->lower_bounds[explicit_count] + 1;
+        if (dimension < 1 || dimension > INT32_MAX)
+            return false;
+        
+        explicit_dimensions[explicit_count++] = (int)dimension;
+    }
+    
+    if (explicit_count > 0 && (character == end || *character++ != '='))
+        return false;
+    
+    *offset = (size_t)(character - text);
+    
+    // the elements at each level have to be either arrays or elements, and all arrays of a level as long as each other
+    int items[PX_ARRAY_MAX_DIMENSIONS];
+    int depth = 0;
+    int element_depth = 0;
+    
+    // each item, an element or an inner array, is followed by a delimiter or the closing brace
+    bool after_item = false;
+    bool after_delimiter = false;
+    
+    if (character == end || *character != '{')
+        return false;
+    
+    while (character < end)
+    {
+        if (*character == '{')
+        {
+            if (depth == PX_ARRAY_MAX_DIMENSIONS || (element_depth != 0 && depth >= element_depth) || after_item)
+                return false;
+            
+            if (depth > 0)
+                items[depth - 1]++;
+            
+            items[depth++] = 0;
+            after_delimiter = false;
+            character++;
+        }
+        else if (*character == '}')
+        {
+            if (depth == 0 || after_delimiter)
+                return false;
+            
+            depth--;
+            if (shape->dimensions[depth] == -1)
+                shape->dimensions[depth] = items[depth];
+            else if (shape->dimensions[depth] != items[depth])
+                return false;
+            
+            after_item = true;
+            character++;
+            if (depth == 0)
+                break;
+        }
+        else if (*character == delimiter)
+        {
+            if (!after_item)
+                return false;
+            
+            after_item = false;
+            after_delimiter = true;
+            character++;
+        }
+        else if (px_array_is_space(*character))
+        {
+            character++;
+        }
+        else
+        {
+            if (depth == 0 || (element_depth != 0 && depth != element_depth) || after_item)
+                return false;
+            
+            element_depth = depth;
+            after_item = true;
+            after_delimiter = false;
+            items[depth - 1]++;
+            shape->count++;
+            
+            character = px_array_skip_element(character, end, delimiter);
+            if (character == NULL)
+                return false;
+        }
+    }
+    
+    if (depth != 0)
+        return false;
+    
+    for (; character < end; character++)
+    {
+        if (!px_array_is_space(*character))
+            return false;
+    }
+    
+    // {} and arrays of empty arrays have no dimensions at all
+    shape->dimension_count = shape->count == 0 ? 0 : (unsigned int)element_depth;
+    
+    if (explicit_count > 0)
+    {
+        if ((unsigned int)explicit_count != shape->dimension_count)
+            return false;
+        
+        for (int i = 0; i < explicit_count; i++)
+        {
+            if (explicit_dimensions[i] != shape->dimensions[i])
+                return false;
+        }
+    }
+    
+    for (int i = (int)shape->dimension_count; i < PX_ARRAY_MAX_DIMENSIONS; i++)
+    {
+        shape->dimensions[i] = 0;
+        shape->lower_bounds[i] = 0;
+    }
+    
+    return true;
+}
+
+static bool px_array_parse_bound(const char **restrict character, const char *restrict end, int *restrict value)
+{
+    const char *digit = *character;
+    const bool negative = digit < end && *digit == '-';
+    if (negative)
+        digit++;
+    
+    int64_t magnitude = 0;
+    const char *first_digit = digit;
+    
+    for (; digit < end && *digit >= '0' && *digit <= '9'; digit++)
+    {
+        magnitude = magnitude * 10 + (*digit - '0');
+        if (magnitude > (negative ? -(int64_t)INT32_MIN : INT32_MAX))
+            return false;
+    }
+    
+    if (digit == first_digit)
+        return false;
+    
+    *value = (int)(negative ? -magnitude : magnitude);
+    *character = digit;
+    return true;
+}
+
+static const char *px_array_skip_element(const char *restrict character, const char *restrict end, const char delimiter)
+{
+    if (*character == '"')
+    {
+        for (character++; character < end && *character != '"'; character++)
+        {
+            if (*character == '\\')
+                character++;
+        }
+        
+        return character < end ? character + 1 : NULL;
+    }
+    
+    for (; character < end && *character != delimiter && *character != '}'; character++)
+    {
+        if (*character == '\\')
+            character++;
+    }
+    
+    return character < end ? character : NULL;
+}
+
+static const char *px_array_read_element(const char *restrict character, const char *restrict end, const char delimiter, char *restrict copy, const size_t capacity, size_t *restrict copy_length, bool *restrict is_null)
+{
+    size_t length = 0;
+    *is_null = false;
+    
+    if (*character == '"')
+    {
+        for (character++; character < end && *character != '"'; character++)
+        {
+            if (*character == '\\' && ++character == end)
+                return NULL;
+            
+            if (length + 1 >= capacity)
+                return NULL;
+            
+            copy[length++] = *character;
+        }
+        
+        if (character == end)
+            return NULL;
+        
+        character++;
+    }
+    else
+    {
+        // whitespace around the unquoted ones is dropped, an unquoted NULL is a NULL
+        size_t trimmed_length = 0;
+        bool escaped = false;
+        
+        for (; character < end && *character != delimiter && *character != '}'; character++)
+        {
+            if (*character == '\\')
+            {
+                if (++character == end)
+                    return NULL;
+                
+                escaped = true;
+            }
+            
+            if (length + 1 >= capacity)
+                return NULL;
+            
+            copy[length++] = *character;
+            if (escaped || !px_array_is_space(*character))
+                trimmed_length = length;
+        }
+        
+        length = trimmed_length;
+        *is_null = !escaped && length == 4 && strncasecmp(copy, "NULL", 4) == 0;
+    }
+    
+    copy[length] = '\0';
+    *copy_length = length;
+    
+    return character;
+}
+
+static bool px_array_parse_element(px_array *restrict array, const unsigned int index, const char *restrict text)
+{
+    char *end;
+    
+    switch (array->element_kind)
+    {
+        case px_array_element_kind_bool:
+            if (strcmp(text, "t") == 0 || strcmp(text, "true") == 0)
+                ((bool *)array->values)[index] = true;
+            else if (strcmp(text, "f") != 0 && strcmp(text, "false") != 0)
+                return false;
+            return true;
+        case px_array_element_kind_int16:
+        {
+            const long value = strtol(text, &end, 10);
+            ((int16_t *)array->values)[index] = (int16_t)value;
+            return *text != '\0' && *end == '\0' && value >= INT16_MIN && value <= INT16_MAX;
+        }
+        case px_array_element_kind_int32:
+        {
+            const long long value = strtoll(text, &end, 10);
+            ((int32_t *)array->values)[index] = (int32_t)value;
+            return *text != '\0' && *end == '\0' && value >= INT32_MIN && value <= INT32_MAX;
+        }
+        case px_array_element_kind_int64:
+            // strtoll saturates when out of range, only errno tells
+            errno = 0;
+            ((int64_t *)array->values)[index] = strtoll(text, &end, 10);
+            return *text != '\0' && *end == '\0' && errno != ERANGE;
+        case px_array_element_kind_single:
+            ((float *)array->values)[index] = strtof(text, &end);
+            return *text != '\0' && *end == '\0';
+        case px_array_element_kind_double:
+            ((double *)array->values)[index] = strtod(text, &end);
+            return *text != '\0' && *end == '\0';
+        case px_array_element_kind_oid:
+        {
+            const unsigned long long value = strtoull(text, &end, 10);
+            ((uint32_t *)array->values)[index] = (uint32_t)value;
+            return *text != '\0' && *end == '\0' && value <= UINT32_MAX;
+        }
+        default:
+            return false;
+    }
+}
+
+static bool px_array_read_binary_element(px_array *restrict array, const unsigned int index, const unsigned char *restrict data, const size_t length, char **restrict heap_end)
+{
+    if (array->element_kind == px_array_element_kind_string)
+    {
+        memcpy(*heap_end, data, length);
+        (*heap_end)[length] = '\0';
+        ((const char **)array->values)[index] = *heap_end;
+        *heap_end += length + 1;
+        return true;
+    }
+    
+    if (length != px_array_binary_element_sizes[array->element_kind])
+        return false;
+    
+    switch (array->element_kind)
+    {
+        case px_array_element_kind_bool:
+            ((bool *)array->values)[index] = data[0] != 0;
+            break;
+        case px_array_element_kind_int16:
+            ((int16_t *)array->values)[index] = (int16_t)px_read_network_uint16(data);
+            break;
+        case px_array_element_kind_int32:
+            ((int32_t *)array->values)[index] = (int32_t)px_read_network_uint32(data);
+            break;
+        case px_array_element_kind_int64:
+            ((int64_t *)array->values)[index] = (int64_t)px_read_network_uint64(data);
+            break;
+        case px_array_element_kind_single:
+        {
+            const uint32_t bits = px_read_network_uint32(data);
+            memcpy((float *)array->values + index, &bits, sizeof(float));
+            break;
+        }
+        case px_array_element_kind_double:
+        {
+            const uint64_t bits = px_read_network_uint64(data);
+            memcpy((double *)array->values + index, &bits, sizeof(double));
+            break;
+        }
+        case px_array_element_kind_oid:
+            ((uint32_t *)array->values)[index] = px_read_network_uint32(data);
+            break;
+        default:
+            return false;
+    }
+    
+    return true;
+}
+
+static bool px_array_is_sent_as_text(const unsigned int element_oid)
+{
+    switch (element_oid)
+    {
+        case px_data_type_char:
+        case px_data_type_name:
+        case px_data_type_varcharu:
+        case px_data_type_charn:
+        case px_data_type_varcharn:
+        case px_data_type_xml:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool px_array_is_space(const char character)
+{
+    return character == ' ' || character == '\t' || character == '\n' || character == '\r' || character == '\v' || character == '\f';
+}
+
+static void px_array_set_null(px_array *restrict array, const unsigned int index)
+{
+    array->nulls[index >> 3] |= (uint8_t)(1 << (index & 7));
+    array->null_count++;
+}
@@ -0,0 +1,67 @@
+//
+//  array.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_array_h
+#define libpx_array_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "typedef.h"
+
+// the server doesn't have arrays of more dimensions either (MAXDIM)
+#define PX_ARRAY_MAX_DIMENSIONS 6
+
+// what the values of an array are, by the type of its elements
+typedef enum px_array_element_kind
+{
+    px_array_element_kind_string = 0,   // const char *, the text of any other type
+    px_array_element_kind_bool = 1,     // bool
+    px_array_element_kind_int16 = 2,    // int16_t
+    px_array_element_kind_int32 = 3,    // int32_t
+    px_array_element_kind_int64 = 4,    // int64_t
+    px_array_element_kind_single = 5,   // float
+    px_array_element_kind_double = 6,   // double
+    px_array_element_kind_oid = 7       // uint32_t
+} px_array_element_kind;
+
+// an array decoded in a single allocation: the elements in row-major order in one typed buffer,
+// a bit per element that is set for NULL elements (which are 0 or NULL in the values), and the
+// zero terminated strings of string elements one after the other in the heap
+struct px_array
+{
+    unsigned int element_oid;
+    px_array_element_kind element_kind;
+    
+    unsigned int dimension_count;
+    int dimensions[PX_ARRAY_MAX_DIMENSIONS];
+    int lower_bounds[PX_ARRAY_MAX_DIMENSIONS];
+    
+    unsigned int count;
+    unsigned int null_count;
+    void *values;
+    uint8_t *nulls;
+    char *heap;
+};
+
+// decoding arrays, the text form isn't zero terminated. elements of types other than the ones
+// of px_array_element_kind are strings in the text form; in the binary form only those of types
+// sent as plain text are. returns NULL if the array is malformed or an element can't be decoded.
+// int2vector and oidvector are numbers separated by spaces without braces in the text form
+px_array *px_array_decode_text(const char *restrict text, const size_t length, const unsigned int element_oid, const char delimiter);
+px_array *px_array_decode_vector(const char *restrict text, const size_t length, const unsigned int element_oid);
+px_array *px_array_decode_binary(const void *restrict data, const size_t length);
+void px_array_delete(px_array *array);
+
+bool px_array_is_null(const px_array *restrict array, const unsigned int index) __attribute__((pure));
+
+// the element type of the built-in array types, 0 for other types
+unsigned int px_array_get_element_oid(const unsigned int array_oid) __attribute__((const));
+px_array_element_kind px_array_get_element_kind(const unsigned int element_oid) __attribute__((const));
+
+#endif
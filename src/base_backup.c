@@ -0,0 +1,732 @@
+//
+//  base_backup.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "base_backup.h"
+#include "connection.h"
+#include "error.h"
+#include "message.h"
+#include "replication.h"
+#include "response.h"
+#include "utility.h"
+
+static bool px_base_backup_send(px_base_backup *restrict base_backup);
+static bool px_base_backup_receive(px_base_backup *restrict base_backup);
+static bool px_base_backup_process_row(px_base_backup *restrict base_backup, const px_response *restrict response, const unsigned int result_number);
+static bool px_base_backup_process_copy_data(px_base_backup *restrict base_backup, const px_response *restrict response);
+static bool px_base_backup_open_archive(px_base_backup *restrict base_backup, const char *restrict name, const bool compress);
+static bool px_base_backup_close_archive(px_base_backup *restrict base_backup);
+static bool px_base_backup_append(px_base_backup *restrict base_backup, const char *restrict data, size_t length);
+static bool px_base_backup_queue(px_base_backup *restrict base_backup, const bool last);
+static bool px_base_backup_start_threads(px_base_backup *restrict base_backup);
+static bool px_base_backup_stop_threads(px_base_backup *restrict base_backup);
+static void *px_base_backup_compress(void *argument);
+static void *px_base_backup_write(void *argument);
+static bool px_base_backup_write_chunk(const px_base_backup_chunk *restrict chunk);
+static void px_base_backup_set_error(px_base_backup *restrict base_backup, const char *restrict action, const char *restrict path, const int error_number);
+static void px_base_backup_fail(px_base_backup *restrict base_backup, const char *restrict action, const char *restrict path);
+
+// the new syntax of BASE_BACKUP and the archive and manifest messages of its stream
+static const int px_base_backup_minimum_server_version = 150000;
+
+// large enough for the compressors to be efficient, small enough for all workers to get some of a small archive
+static const size_t px_base_backup_default_chunk_size = 1024 * 1024;
+
+static const size_t px_base_backup_default_memory_limit = 64 * 1024 * 1024;
+
+px_base_backup *px_base_backup_new(px_connection *restrict connection, const char *restrict directory)
+{
+    px_base_backup *base_backup = calloc(1, sizeof(px_base_backup));
+    base_backup->connection = connection;
+    base_backup->directory = px_copy_string(directory);
+    base_backup->label = px_copy_string("px base backup");
+    base_backup->include_wal = true;
+    base_backup->manifest = true;
+    base_backup->compression = px_compression_is_available(px_compression_algorithm_zstd) ? px_compression_algorithm_zstd : px_compression_algorithm_gzip;
+    base_backup->chunk_size = px_base_backup_default_chunk_size;
+    base_backup->memory_limit = px_base_backup_default_memory_limit;
+    base_backup->fd = -1;
+    
+    const long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+    base_backup->thread_count = processor_count > 0 ? (unsigned int)processor_count : 1;
+    
+    return base_backup;
+}
+
+void px_base_backup_delete(px_base_backup *base_backup)
+{
+    free(base_backup->directory);
+    free(base_backup->label);
+    free(base_backup);
+}
+
+bool px_base_backup_run(px_base_backup *restrict base_backup)
+{
+    px_connection *connection = base_backup->connection;
+    
+    if (connection->connection_status != px_connection_status_open)
+    {
+        px_connection_set_last_error(connection, px_error_new_io_error());
+        return false;
+    }
+    
+    if (connection->results.busy)
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("55000", "another query is already in progress"));
+        return false;
+    }
+    
+    if (px_connection_get_server_version_number(connection) < px_base_backup_minimum_server_version)
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("0A000", "base backups need PostgreSQL 15 or later"));
+        return false;
+    }
+    
+    if (mkdir(base_backup->directory, 0700) != 0 && errno != EEXIST)
+    {
+        px_base_backup_fail(base_backup, "create directory", base_backup->directory);
+        return false;
+    }
+    
+    base_backup->start_lsn = 0;
+    base_backup->end_lsn = 0;
+    base_backup->timeline = 0;
+    base_backup->received_size = 0;
+    base_backup->written_size = 0;
+    
+    px_connection_set_last_error(connection, NULL);
+    
+    if (!px_base_backup_start_threads(base_backup))
+        return false;
+    
+    bool success = px_base_backup_send(base_backup) && px_base_backup_receive(base_backup);
+    
+    // whatever has been queued is written before the error of the stream is reported, so that a
+    // failed backup leaves complete chunks behind
+    if (!px_base_backup_stop_threads(base_backup) && success)
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("58030", base_backup->error_message));
+        success = false;
+    }
+    
+    free(base_backup->error_message);
+    base_backup->error_message = NULL;
+    
+    if (success)
+    {
+        const int fd = open(base_backup->directory, O_RDONLY | O_CLOEXEC);
+        success = fd >= 0 && fsync(fd) == 0;
+        
+        if (!success)
+            px_base_backup_fail(base_backup, "sync", base_backup->directory);
+        
+        if (fd >= 0)
+            close(fd);
+    }
+    
+    return success;
+}
+
+uint64_t px_base_backup_get_start_lsn(const px_base_backup *restrict base_backup)
+{
+    return base_backup->start_lsn;
+}
+
+uint64_t px_base_backup_get_end_lsn(const px_base_backup *restrict base_backup)
+{
+    return base_backup->end_lsn;
+}
+
+unsigned int px_base_backup_get_timeline(const px_base_backup *restrict base_backup)
+{
+    return base_backup->timeline;
+}
+
+uint64_t px_base_backup_get_received_size(const px_base_backup *restrict base_backup)
+{
+    return base_backup->received_size;
+}
+
+uint64_t px_base_backup_get_written_size(const px_base_backup *restrict base_backup)
+{
+    return base_backup->written_size;
+}
+
+void px_base_backup_set_label(px_base_backup *restrict base_backup, const char *restrict value)
+{
+    free(base_backup->label);
+    base_backup->label = px_copy_string(value);
+}
+
+void px_base_backup_set_fast_checkpoint(px_base_backup *restrict base_backup, const bool value)
+{
+    base_backup->fast_checkpoint = value;
+}
+
+void px_base_backup_set_include_wal(px_base_backup *restrict base_backup, const bool value)
+{
+    base_backup->include_wal = value;
+}
+
+void px_base_backup_set_manifest(px_base_backup *restrict base_backup, const bool value)
+{
+    base_backup->manifest = value;
+}
+
+px_compression_algorithm px_base_backup_get_compression(const px_base_backup *restrict base_backup)
+{
+    return base_backup->compression;
+}
+
+void px_base_backup_set_compression(px_base_backup *restrict base_backup, const px_compression_algorithm algorithm, const int level)
+{
+    // zstd falls back to gzip without libzstd rather than writing the backup uncompressed
+    base_backup->compression = px_compression_is_available(algorithm) ? algorithm : px_compression_algorithm_gzip;
+    base_backup->compression_level = level;
+}
+
+void px_base_backup_set_thread_count(px_base_backup *restrict base_backup, const unsigned int value)
+{
+    base_backup->thread_count = value == 0 ? 1 : value;
+}
+
+void px_base_backup_set_chunk_size(px_base_backup *restrict base_backup, const size_t value)
+{
+    base_backup->chunk_size = value == 0 ? px_base_backup_default_chunk_size : value;
+}
+
+void px_base_backup_set_memory_limit(px_base_backup *restrict base_backup, const size_t value)
+{
+    base_backup->memory_limit = value;
+}
+
+static bool px_base_backup_send(px_base_backup *restrict base_backup)
+{
+    px_connection *connection = base_backup->connection;
+    
+    char *command_text = malloc(strlen(base_backup->label) * 2 + 256);
+    char *end = stpcpy(command_text, "BASE_BACKUP (LABEL ");
+    end = px_replication_append_quoted(end, base_backup->label, '\'');
+    sprintf(end, ", CHECKPOINT '%s', WAL %s, MANIFEST '%s', TABLESPACE_MAP true, WAIT true)", base_backup->fast_checkpoint ? "fast" : "spread", base_backup->include_wal ? "true" : "false", base_backup->manifest ? "yes" : "no");
+    
+    px_message *message = px_message_new("QTs", command_text);
+    const bool sent = px_connection_send_message(connection, message);
+    px_message_delete(message);
+    free(command_text);
+    
+    if (!sent)
+    {
+        px_connection_fail(connection);
+        return false;
+    }
+    
+    connection->results.busy = true;
+    
+    return true;
+}
+
+// the stream is the start position, the tablespaces, the archives and the manifest in copy data, then the end position
+static bool px_base_backup_receive(px_base_backup *restrict base_backup)
+{
+    px_connection *connection = base_backup->connection;
+    unsigned int result_number = 0;
+    
+    while (true)
+    {
+        px_response *response = px_response_read_with_timeout(connection, -1);
+        if (response == NULL)
+        {
+            px_connection_fail(connection);
+            return false;
+        }
+        
+        bool processed = true;
+        switch (response->message_type)
+        {
+            case px_message_type_row_description:
+                result_number++;
+                break;
+            case px_message_type_data_row:
+                processed = px_base_backup_process_row(base_backup, response, result_number);
+                break;
+            case px_message_type_copy_data:
+                processed = px_base_backup_process_copy_data(base_backup, response);
+                break;
+            case px_message_type_copy_done:
+                processed = px_base_backup_close_archive(base_backup);
+                break;
+            case px_message_type_ready_for_query:
+                connection->transaction_status = response->response_data.ready_for_query.transaction_status;
+                connection->results.busy = false;
+                px_response_delete(response);
+            
+                if (connection->last_error == NULL && base_backup->end_lsn == 0)
+                    px_connection_set_last_error(connection, px_error_new_custom("08P01", "the server did not finish the base backup"));
+            
+                return connection->last_error == NULL;
+            default:
+                // errors are kept as the last error of the connection, the server becomes ready afterwards
+                break;
+        }
+        
+        px_response_delete(response);
+        
+        if (!processed)
+        {
+            // the rest of the backup can't be stored, so the connection is dropped rather than drained.
+            // the error is set again as failing the connection replaces it
+            px_error *error = connection->last_error;
+            connection->last_error = NULL;
+            px_connection_fail(connection);
+            px_connection_set_last_error(connection, error);
+            return false;
+        }
+    }
+}
+
+static bool px_base_backup_process_row(px_base_backup *restrict base_backup, const px_response *restrict response, const unsigned int result_number)
+{
+    // the rows of the tablespaces are only informational
+    if (result_number == 2)
+        return true;
+    
+    // the start and the end position: the LSN and the timeline
+    const px_data_cell *cells = response->response_data.data_row.cells;
+    char lsn_text[PX_LSN_STRING_SIZE];
+    char timeline_text[16];
+    
+    if (response->response_data.data_row.cell_count < 2 || cells[0].length <= 0 || cells[0].length >= (int)sizeof(lsn_text) || cells[1].length <= 0 || cells[1].length >= (int)sizeof(timeline_text))
+    {
+        px_connection_set_last_error(base_backup->connection, px_error_new_custom("08P01", "malformed BASE_BACKUP result"));
+        return false;
+    }
+    
+    memcpy(lsn_text, cells[0].data, (size_t)cells[0].length);
+    lsn_text[cells[0].length] = '\0';
+    memcpy(timeline_text, cells[1].data, (size_t)cells[1].length);
+    timeline_text[cells[1].length] = '\0';
+    
+    uint64_t lsn;
+    char *timeline_end;
+    const unsigned long timeline = strtoul(timeline_text, &timeline_end, 10);
+    if (!px_replication_parse_lsn(lsn_text, &lsn) || *timeline_end != '\0' || timeline == 0)
+    {
+        px_connection_set_last_error(base_backup->connection, px_error_new_custom("08P01", "malformed BASE_BACKUP result"));
+        return false;
+    }
+    
+    if (result_number == 1)
+        base_backup->start_lsn = lsn;
+    else
+        base_backup->end_lsn = lsn;
+    
+    base_backup->timeline = (unsigned int)timeline;
+    
+    return true;
+}
+
+static bool px_base_backup_process_copy_data(px_base_backup *restrict base_backup, const px_response *restrict response)
+{
+    const char *data = response->response_data.copy_data.data;
+    const size_t length = response->response_data.copy_data.length;
+    
+    if (length == 0)
+        return true;
+    
+    switch (data[0])
+    {
+        case 'n':
+        {
+            // a new archive: its name and the location of its tablespace, both zero terminated
+            const char *name = data + 1;
+            const char *name_end = memchr(name, '\0', length - 1);
+            
+            // the name is written to the directory, so anything but a plain name is refused
+            if (name_end == NULL || *name == '\0' || *name == '.' || strchr(name, '/') != NULL)
+            {
+                px_connection_set_last_error(base_backup->connection, px_error_new_custom("08P01", "malformed archive name in the base backup"));
+                return false;
+            }
+            
+            return px_base_backup_close_archive(base_backup) && px_base_backup_open_archive(base_backup, name, true);
+        }
+        case 'm':
+            // the manifest follows the archives, it is stored uncompressed next to them
+            return px_base_backup_close_archive(base_backup) && px_base_backup_open_archive(base_backup, "backup_manifest", false);
+        case 'd':
+            if (base_backup->fd < 0)
+            {
+                px_connection_set_last_error(base_backup->connection, px_error_new_custom("08P01", "base backup data outside of an archive"));
+                return false;
+            }
+        
+            return px_base_backup_append(base_backup, data + 1, length - 1);
+        case 'p':
+        default:
+            return true;
+    }
+}
+
+static bool px_base_backup_open_archive(px_base_backup *restrict base_backup, const char *restrict name, const bool compress)
+{
+    const char *extension = compress ? px_compression_get_extension(base_backup->compression) : "";
+    char *path = malloc(strlen(base_backup->directory) + strlen(name) + strlen(extension) + 2);
+    sprintf(path, "%s/%s%s", base_backup->directory, name, extension);
+    
+    // an existing backup is never overwritten
+    const int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        px_base_backup_fail(base_backup, "create", path);
+        free(path);
+        return false;
+    }
+    
+    base_backup->fd = fd;
+    base_backup->path = path;
+    base_backup->compress = compress && base_backup->compression != px_compression_algorithm_none;
+    
+    return true;
+}
+
+static bool px_base_backup_close_archive(px_base_backup *restrict base_backup)
+{
+    if (base_backup->fd < 0)
+        return true;
+    
+    // the last chunk closes the file once it has been written, even an empty one
+    return px_base_backup_queue(base_backup, true);
+}
+
+static bool px_base_backup_append(px_base_backup *restrict base_backup, const char *restrict data, size_t length)
+{
+    base_backup->received_size += length;
+    
+    while (length > 0)
+    {
+        // the chunk being filled is owned by this thread until it's queued
+        px_base_backup_chunk *chunk = &base_backup->chunks[base_backup->filled_count % base_backup->chunk_count];
+        const size_t copied = length < base_backup->chunk_size - chunk->length ? length : base_backup->chunk_size - chunk->length;
+        memcpy(chunk->data + chunk->length, data, copied);
+        chunk->length += copied;
+        data += copied;
+        length -= copied;
+        
+        if (chunk->length == base_backup->chunk_size && !px_base_backup_queue(base_backup, false))
+            return false;
+    }
+    
+    return true;
+}
+
+// hands the chunk being filled over to the workers and waits for the next one to be free
+static bool px_base_backup_queue(px_base_backup *restrict base_backup, const bool last)
+{
+    px_base_backup_chunk *chunk = &base_backup->chunks[base_backup->filled_count % base_backup->chunk_count];
+    chunk->sequence = base_backup->filled_count;
+    chunk->fd = base_backup->fd;
+    chunk->path = base_backup->path;
+    chunk->last = last;
+    chunk->compress = base_backup->compress;
+    
+    if (last)
+    {
+        base_backup->fd = -1;
+        base_backup->path = NULL;
+    }
+    
+    pthread_mutex_lock(&base_backup->mutex);
+    
+    chunk->state = chunk->compress ? px_base_backup_chunk_state_filled : px_base_backup_chunk_state_compressed;
+    base_backup->filled_count++;
+    pthread_cond_broadcast(&base_backup->changed);
+    
+    px_base_backup_chunk *next_chunk = &base_backup->chunks[base_backup->filled_count % base_backup->chunk_count];
+    while (next_chunk->state != px_base_backup_chunk_state_free && base_backup->error_message == NULL)
+        pthread_cond_wait(&base_backup->changed, &base_backup->mutex);
+    
+    const bool failed = base_backup->error_message != NULL;
+    pthread_mutex_unlock(&base_backup->mutex);
+    
+    if (failed)
+    {
+        px_connection_set_last_error(base_backup->connection, px_error_new_custom("58030", base_backup->error_message));
+        return false;
+    }
+    
+    next_chunk->length = 0;
+    
+    return true;
+}
+
+static bool px_base_backup_start_threads(px_base_backup *restrict base_backup)
+{
+    // every chunk needs room for its data and for the worst case of compressing it, but at least two
+    // chunks are needed for reading and writing at the same time
+    const size_t chunk_memory = base_backup->chunk_size + (base_backup->compression == px_compression_algorithm_none ? 0 : px_compression_bound(base_backup->chunk_size));
+    const size_t chunk_count = base_backup->memory_limit / chunk_memory;
+    base_backup->chunk_count = chunk_count < 2 ? 2 : chunk_count > UINT32_MAX ? UINT32_MAX : (unsigned int)chunk_count;
+    base_backup->chunks = calloc(base_backup->chunk_count, sizeof(px_base_backup_chunk));
+    
+    for (unsigned int i = 0; i < base_backup->chunk_count; i++)
+    {
+        base_backup->chunks[i].fd = -1;
+        base_backup->chunks[i].data = malloc(base_backup->chunk_size);
+        if (base_backup->compression != px_compression_algorithm_none)
+            base_backup->chunks[i].compressed = malloc(px_compression_bound(base_backup->chunk_size));
+    }
+    
+    base_backup->filled_count = 0;
+    base_backup->compressing_count = 0;
+    base_backup->written_count = 0;
+    base_backup->finishing = false;
+    
+    pthread_mutex_init(&base_backup->mutex, NULL);
+    pthread_cond_init(&base_backup->changed, NULL);
+    
+    // the writer first, then the workers, there are none without compression
+    const unsigned int worker_count = base_backup->compression == px_compression_algorithm_none ? 0 : base_backup->thread_count;
+    base_backup->threads = calloc(worker_count + 1, sizeof(pthread_t));
+    base_backup->thread_count_started = 0;
+    
+    for (unsigned int i = 0; i <= worker_count; i++)
+    {
+        if (pthread_create(&base_backup->threads[i], NULL, i == 0 ? px_base_backup_write : px_base_backup_compress, base_backup) != 0)
+        {
+            // running with fewer workers is only slower, but without the writer nothing gets stored
+            if (i > 0)
+                break;
+            
+            px_base_backup_fail(base_backup, "start the writer of", base_backup->directory);
+            px_base_backup_stop_threads(base_backup);
+            free(base_backup->error_message);
+            base_backup->error_message = NULL;
+            return false;
+        }
+        
+        base_backup->thread_count_started++;
+    }
+    
+    return true;
+}
+
+// waits for the threads to write everything queued, then releases the chunks. false if they failed
+static bool px_base_backup_stop_threads(px_base_backup *restrict base_backup)
+{
+    pthread_mutex_lock(&base_backup->mutex);
+    base_backup->finishing = true;
+    pthread_cond_broadcast(&base_backup->changed);
+    pthread_mutex_unlock(&base_backup->mutex);
+    
+    for (unsigned int i = 0; i < base_backup->thread_count_started; i++)
+        pthread_join(base_backup->threads[i], NULL);
+    
+    // after an error the files of the chunks that weren't written are closed here
+    for (uint64_t sequence = base_backup->written_count; sequence < base_backup->filled_count; sequence++)
+    {
+        px_base_backup_chunk *chunk = &base_backup->chunks[sequence % base_backup->chunk_count];
+        if (chunk->last)
+        {
+            close(chunk->fd);
+            free(chunk->path);
+        }
+    }
+    
+    if (base_backup->fd >= 0)
+    {
+        close(base_backup->fd);
+        free(base_backup->path);
+        base_backup->fd = -1;
+        base_backup->path = NULL;
+    }
+    
+    for (unsigned int i = 0; i < base_backup->chunk_count; i++)
+    {
+        free(base_backup->chunks[i].data);
+        free(base_backup->chunks[i].compressed);
+    }
+    
+    free(base_backup->chunks);
+    free(base_backup->threads);
+    base_backup->chunks = NULL;
+    base_backup->threads = NULL;
+    base_backup->thread_count_started = 0;
+    
+    pthread_cond_destroy(&base_backup->changed);
+    pthread_mutex_destroy(&base_backup->mutex);
+    
+    return base_backup->error_message == NULL;
+}
+
+// a worker takes the chunks in the order they were filled, but any number of them are compressed at the same time
+static void *px_base_backup_compress(void *argument)
+{
+    px_base_backup *base_backup = argument;
+    px_compressor *compressor = px_compressor_new(base_backup->compression, base_backup->compression_level);
+    const size_t capacity = px_compression_bound(base_backup->chunk_size);
+    
+    pthread_mutex_lock(&base_backup->mutex);
+    
+    while (base_backup->error_message == NULL)
+    {
+        if (base_backup->compressing_count == base_backup->filled_count)
+        {
+            if (base_backup->finishing)
+                break;
+            
+            pthread_cond_wait(&base_backup->changed, &base_backup->mutex);
+            continue;
+        }
+        
+        const uint64_t sequence = base_backup->compressing_count++;
+        px_base_backup_chunk *chunk = &base_backup->chunks[sequence % base_backup->chunk_count];
+        
+        // chunks stored as they are have been handed to the writer already and may have been written
+        // and filled again since
+        if (chunk->sequence != sequence || chunk->state != px_base_backup_chunk_state_filled)
+            continue;
+        
+        pthread_mutex_unlock(&base_backup->mutex);
+        
+        chunk->compressed_length = compressor == NULL ? 0 : px_compressor_compress(compressor, chunk->data, chunk->length, chunk->compressed, capacity);
+        
+        pthread_mutex_lock(&base_backup->mutex);
+        
+        if (chunk->compressed_length == 0 && base_backup->error_message == NULL)
+        {
+            base_backup->error_message = malloc(strlen(chunk->path) + 64);
+            sprintf(base_backup->error_message, "could not compress \"%s\"", chunk->path);
+        }
+        
+        chunk->state = px_base_backup_chunk_state_compressed;
+        pthread_cond_broadcast(&base_backup->changed);
+    }
+    
+    pthread_mutex_unlock(&base_backup->mutex);
+    
+    if (compressor != NULL)
+        px_compressor_delete(compressor);
+    
+    return NULL;
+}
+
+// the writer stores the chunks in the order they were filled, which is the order of the archives
+static void *px_base_backup_write(void *argument)
+{
+    px_base_backup *base_backup = argument;
+    
+    pthread_mutex_lock(&base_backup->mutex);
+    
+    while (base_backup->error_message == NULL)
+    {
+        px_base_backup_chunk *chunk = &base_backup->chunks[base_backup->written_count % base_backup->chunk_count];
+        
+        if (base_backup->written_count == base_backup->filled_count || chunk->state != px_base_backup_chunk_state_compressed)
+        {
+            if (base_backup->finishing && base_backup->written_count == base_backup->filled_count)
+                break;
+            
+            pthread_cond_wait(&base_backup->changed, &base_backup->mutex);
+            continue;
+        }
+        
+        pthread_mutex_unlock(&base_backup->mutex);
+        
+        bool written = px_base_backup_write_chunk(chunk);
+        int error_number = errno;
+        if (chunk->last)
+        {
+            if (written && fsync(chunk->fd) != 0)
+            {
+                written = false;
+                error_number = errno;
+            }
+            
+            if (close(chunk->fd) != 0 && written)
+            {
+                written = false;
+                error_number = errno;
+            }
+        }
+        
+        pthread_mutex_lock(&base_backup->mutex);
+        
+        if (!written)
+        {
+            if (base_backup->error_message == NULL)
+                px_base_backup_set_error(base_backup, "write", chunk->path, error_number);
+            
+            // a failed last chunk is not written again, its file is closed already
+            if (chunk->last)
+            {
+                chunk->last = false;
+                free(chunk->path);
+            }
+            
+            pthread_cond_broadcast(&base_backup->changed);
+            break;
+        }
+        
+        base_backup->written_size += chunk->compress ? chunk->compressed_length : chunk->length;
+        
+        if (chunk->last)
+            free(chunk->path);
+        
+        chunk->state = px_base_backup_chunk_state_free;
+        base_backup->written_count++;
+        pthread_cond_broadcast(&base_backup->changed);
+    }
+    
+    pthread_mutex_unlock(&base_backup->mutex);
+    
+    return NULL;
+}
+
+static bool px_base_backup_write_chunk(const px_base_backup_chunk *restrict chunk)
+{
+    const char *data = chunk->compress ? chunk->compressed : chunk->data;
+    size_t length = chunk->compress ? chunk->compressed_length : chunk->length;
+    
+    while (length > 0)
+    {
+        const ssize_t written = write(chunk->fd, data, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            
+            return false;
+        }
+        
+        data += written;
+        length -= (size_t)written;
+    }
+    
+    return true;
+}
+
+// the error of a thread, the connection is only touched by the thread reading the stream
+static void px_base_backup_set_error(px_base_backup *restrict base_backup, const char *restrict action, const char *restrict path, const int error_number)
+{
+    base_backup->error_message = malloc(strlen(path) + 128);
+    sprintf(base_backup->error_message, "could not %s \"%s\": %s", action, path, strerror(error_number));
+}
+
+static void px_base_backup_fail(px_base_backup *restrict base_backup, const char *restrict action, const char *restrict path)
+{
+    char *message = malloc(strlen(path) + 128);
+    sprintf(message, "could not %s \"%s\": %s", action, path, strerror(errno));
+    px_connection_set_last_error(base_backup->connection, px_error_new_custom("58030", message));
+    free(message);
+}
@@ -0,0 +1,113 @@
+//
+//  base_backup.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_base_backup_h
+#define libpx_base_backup_h
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "typedef.h"
+#include "compression.h"
+
+typedef enum px_base_backup_chunk_state
+{
+    px_base_backup_chunk_state_free = 0,
+    px_base_backup_chunk_state_filled = 1,
+    px_base_backup_chunk_state_compressed = 2
+} px_base_backup_chunk_state;
+
+// a piece of an archive, compressed on its own. the last chunk of an archive closes its file
+typedef struct px_base_backup_chunk
+{
+    px_base_backup_chunk_state state;
+    uint64_t sequence;
+    int fd;
+    bool last;
+    bool compress;
+    char *path;
+    char *data;
+    size_t length;
+    char *compressed;
+    size_t compressed_length;
+} px_base_backup_chunk;
+
+// takes a base backup through a replication connection into a directory, each tablespace into a tar
+// archive of its own next to the backup manifest
+struct px_base_backup
+{
+    px_connection *connection;
+    char *directory;
+    
+    // settings
+    char *label;
+    bool fast_checkpoint;
+    bool include_wal;
+    bool manifest;
+    px_compression_algorithm compression;
+    int compression_level;
+    unsigned int thread_count;
+    size_t chunk_size;
+    size_t memory_limit;
+    
+    // the WAL the backup needs to be consistent, and the size of the archives before and after compression
+    uint64_t start_lsn;
+    uint64_t end_lsn;
+    unsigned int timeline;
+    uint64_t received_size;
+    uint64_t written_size;
+    
+    // chunks are filled in order by the thread reading the stream, compressed in any order by the
+    // workers and written in order by the writer. the chunks form a ring, a chunk is only filled again
+    // once it has been written, so the memory used doesn't grow with the size of the backup
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    unsigned int chunk_count;
+    px_base_backup_chunk *chunks;
+    uint64_t filled_count;
+    uint64_t compressing_count;
+    uint64_t written_count;
+    bool finishing;
+    
+    unsigned int thread_count_started;
+    pthread_t *threads;
+    
+    // the first error of the workers and the writer, reported by the reading thread
+    char *error_message;
+    
+    // the archive being received, its path is freed with its last chunk
+    int fd;
+    char *path;
+    bool compress;
+};
+
+// create & delete
+px_base_backup *px_base_backup_new(px_connection *restrict connection, const char *restrict directory);
+void px_base_backup_delete(px_base_backup *base_backup);
+
+// taking the backup
+bool px_base_backup_run(px_base_backup *restrict base_backup);
+
+// getters & setters
+uint64_t px_base_backup_get_start_lsn(const px_base_backup *restrict base_backup) __attribute__((pure));
+uint64_t px_base_backup_get_end_lsn(const px_base_backup *restrict base_backup) __attribute__((pure));
+unsigned int px_base_backup_get_timeline(const px_base_backup *restrict base_backup) __attribute__((pure));
+uint64_t px_base_backup_get_received_size(const px_base_backup *restrict base_backup) __attribute__((pure));
+uint64_t px_base_backup_get_written_size(const px_base_backup *restrict base_backup) __attribute__((pure));
+void px_base_backup_set_label(px_base_backup *restrict base_backup, const char *restrict value);
+void px_base_backup_set_fast_checkpoint(px_base_backup *restrict base_backup, const bool value);
+void px_base_backup_set_include_wal(px_base_backup *restrict base_backup, const bool value);
+void px_base_backup_set_manifest(px_base_backup *restrict base_backup, const bool value);
+px_compression_algorithm px_base_backup_get_compression(const px_base_backup *restrict base_backup) __attribute__((pure));
+void px_base_backup_set_compression(px_base_backup *restrict base_backup, const px_compression_algorithm algorithm, const int level);
+void px_base_backup_set_thread_count(px_base_backup *restrict base_backup, const unsigned int value);
+void px_base_backup_set_chunk_size(px_base_backup *restrict base_backup, const size_t value);
+void px_base_backup_set_memory_limit(px_base_backup *restrict base_backup, const size_t value);
+
+#endif
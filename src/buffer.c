@@ -0,0 +1,95 @@
+//
+//  buffer.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "buffer.h"
+
+static const size_t px_buffer_initial_capacity = 8192;
+
+void px_buffer_delete_members(px_buffer *buffer)
+{
+    if (buffer->bytes != NULL)
+    {
+        free(buffer->bytes);
+    }
+    
+    memset(buffer, 0, sizeof(px_buffer));
+}
+
+void px_buffer_clear(px_buffer *restrict buffer)
+{
+    buffer->offset = 0;
+    buffer->length = 0;
+}
+
+size_t px_buffer_get_length(const px_buffer *restrict buffer)
+{
+    return buffer->length - buffer->offset;
+}
+
+const char *px_buffer_get_bytes(const px_buffer *restrict buffer)
+{
+    return buffer->bytes + buffer->offset;
+}
+
+void px_buffer_consume(px_buffer *restrict buffer, const size_t length)
+{
+    buffer->offset += length;
+    
+    if (buffer->offset >= buffer->length)
+    {
+        // everything has been consumed, start over from the beginning of the block
+        px_buffer_clear(buffer);
+    }
+}
+
+void px_buffer_append(px_buffer *restrict buffer, const void *restrict data, const size_t length)
+{
+    memcpy(px_buffer_reserve(buffer, length), data, length);
+    px_buffer_commit(buffer, length);
+}
+
+char *px_buffer_reserve(px_buffer *restrict buffer, const size_t length)
+{
+    if (buffer->length + length <= buffer->capacity)
+    {
+        return buffer->bytes + buffer->length;
+    }
+    
+    // move the unconsumed data to the front before growing the block
+    if (buffer->offset > 0)
+    {
+        memmove(buffer->bytes, buffer->bytes + buffer->offset, buffer->length - buffer->offset);
+        buffer->length -= buffer->offset;
+        buffer->offset = 0;
+    }
+    
+    if (buffer->length + length > buffer->capacity)
+    {
+        if (buffer->capacity == 0)
+        {
+            buffer->capacity = px_buffer_initial_capacity;
+        }
+        
+        while (buffer->length + length > buffer->capacity)
+        {
+            buffer->capacity *= 2;
+        }
+        
+        buffer->bytes = realloc(buffer->bytes, buffer->capacity);
+    }
+    
+    return buffer->bytes + buffer->length;
+}
+
+void px_buffer_commit(px_buffer *restrict buffer, const size_t length)
+{
+    buffer->length += length;
+}
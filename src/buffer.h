@@ -0,0 +1,38 @@
+//
+//  buffer.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_buffer_h
+#define libpx_buffer_h
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "typedef.h"
+
+// A growable byte queue: data is appended at the end and consumed from the front.
+struct px_buffer
+{
+    size_t offset;
+    size_t length;
+    size_t capacity;
+    char *bytes;
+};
+
+void px_buffer_delete_members(px_buffer *buffer);
+void px_buffer_clear(px_buffer *restrict buffer);
+
+// reading
+size_t px_buffer_get_length(const px_buffer *restrict buffer) __attribute__((pure));
+const char *px_buffer_get_bytes(const px_buffer *restrict buffer) __attribute__((pure));
+void px_buffer_consume(px_buffer *restrict buffer, const size_t length);
+
+// writing
+void px_buffer_append(px_buffer *restrict buffer, const void *restrict data, const size_t length);
+char *px_buffer_reserve(px_buffer *restrict buffer, const size_t length);
+void px_buffer_commit(px_buffer *restrict buffer, const size_t length);
+
+#endif
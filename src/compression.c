@@ -0,0 +1,200 @@
+//
+//  compression.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef PX_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PX_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "compression.h"
+
+#ifdef PX_HAVE_ZLIB
+static size_t px_compression_zlib_gzip(z_stream *restrict stream, const void *restrict data, const size_t length, void *restrict buffer, const size_t capacity);
+
+// a window of 2^15 bytes with the gzip header and trailer
+static const int px_compression_zlib_gzip_window_bits = 15 + 16;
+
+// zlib's own default level
+static const int px_compression_default_gzip_level = 6;
+#endif
+
+#ifdef PX_HAVE_ZSTD
+// libzstd's own default level
+static const int px_compression_default_zstd_level = 3;
+#endif
+
+px_compressor *px_compressor_new(const px_compression_algorithm algorithm, const int level)
+{
+    if (!px_compression_is_available(algorithm))
+        return NULL;
+    
+    px_compressor *compressor = calloc(1, sizeof(px_compressor));
+    compressor->algorithm = algorithm;
+    compressor->level = level;
+    
+    switch (algorithm)
+    {
+        case px_compression_algorithm_gzip:
+        {
+#ifdef PX_HAVE_ZLIB
+            z_stream *stream = calloc(1, sizeof(z_stream));
+            if (deflateInit2(stream, level == 0 ? px_compression_default_gzip_level : level, Z_DEFLATED, px_compression_zlib_gzip_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                free(stream);
+                free(compressor);
+                return NULL;
+            }
+            
+            compressor->context = stream;
+#else
+            // the built-in encoder has a single level
+            compressor->context = px_compression_builtin_gzip_new();
+#endif
+            break;
+        }
+        case px_compression_algorithm_zstd:
+#ifdef PX_HAVE_ZSTD
+            compressor->context = ZSTD_createCCtx();
+            ZSTD_CCtx_setParameter(compressor->context, ZSTD_c_compressionLevel, level == 0 ? px_compression_default_zstd_level : level);
+            ZSTD_CCtx_setParameter(compressor->context, ZSTD_c_checksumFlag, 1);
+#endif
+            break;
+        case px_compression_algorithm_none:
+        default:
+            break;
+    }
+    
+    return compressor;
+}
+
+void px_compressor_delete(px_compressor *compressor)
+{
+    switch (compressor->algorithm)
+    {
+        case px_compression_algorithm_gzip:
+#ifdef PX_HAVE_ZLIB
+            deflateEnd(compressor->context);
+            free(compressor->context);
+#else
+            px_compression_builtin_gzip_delete(compressor->context);
+#endif
+            break;
+        case px_compression_algorithm_zstd:
+#ifdef PX_HAVE_ZSTD
+            ZSTD_freeCCtx(compressor->context);
+#endif
+            break;
+        case px_compression_algorithm_none:
+        default:
+            break;
+    }
+    
+    free(compressor);
+}
+
+size_t px_compressor_compress(px_compressor *restrict compressor, const void *restrict data, const size_t length, void *restrict buffer, const size_t capacity)
+{
+    switch (compressor->algorithm)
+    {
+        case px_compression_algorithm_gzip:
+#ifdef PX_HAVE_ZLIB
+            return px_compression_zlib_gzip(compressor->context, data, length, buffer, capacity);
+#else
+            return px_compression_builtin_gzip(compressor->context, data, length, buffer, capacity);
+#endif
+        case px_compression_algorithm_zstd:
+#ifdef PX_HAVE_ZSTD
+        {
+            const size_t result = ZSTD_compress2(compressor->context, buffer, capacity, data, length);
+            return ZSTD_isError(result) ? 0 : result;
+        }
+#else
+            return 0;
+#endif
+        case px_compression_algorithm_none:
+        default:
+            if (length > capacity)
+                return 0;
+        
+            memcpy(buffer, data, length);
+            return length;
+    }
+}
+
+size_t px_compression_bound(const size_t length)
+{
+    // the built-in encoder needs the most: 9 bits for a literal and the gzip header and trailer.
+    // zlib and libzstd need a lot less than this for incompressible data
+    return length + length / 8 + 64;
+}
+
+bool px_compression_is_available(const px_compression_algorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case px_compression_algorithm_none:
+        case px_compression_algorithm_gzip:
+            return true;
+        case px_compression_algorithm_zstd:
+#ifdef PX_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char *px_compression_get_extension(const px_compression_algorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case px_compression_algorithm_gzip:
+            return ".gz";
+        case px_compression_algorithm_zstd:
+            return ".zst";
+        case px_compression_algorithm_none:
+        default:
+            return "";
+    }
+}
+
+bool px_compression_parse_algorithm(const char *restrict name, px_compression_algorithm *restrict algorithm)
+{
+    static const char *names[] = { "none", "gzip", "zstd" };
+    
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *algorithm = (px_compression_algorithm)i;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+#ifdef PX_HAVE_ZLIB
+static size_t px_compression_zlib_gzip(z_stream *restrict stream, const void *restrict data, const size_t length, void *restrict buffer, const size_t capacity)
+{
+    if (deflateReset(stream) != Z_OK)
+        return 0;
+    
+    stream->next_in = (Bytef *)data;
+    stream->avail_in = (uInt)length;
+    stream->next_out = buffer;
+    stream->avail_out = (uInt)capacity;
+    
+    return deflate(stream, Z_FINISH) == Z_STREAM_END ? capacity - stream->avail_out : 0;
+}
+#endif
@@ -0,0 +1,51 @@
+//
+//  compression.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_compression_h
+#define libpx_compression_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "typedef.h"
+
+typedef enum px_compression_algorithm
+{
+    px_compression_algorithm_none = 0,
+    px_compression_algorithm_gzip = 1,
+    px_compression_algorithm_zstd = 2
+} px_compression_algorithm;
+
+// compresses independent chunks, each of them a complete gzip member or zstd frame. concatenated they
+// are a single valid stream, so chunks can be compressed in parallel and still be decompressed in one go.
+// a compressor isn't thread safe, every thread needs its own
+struct px_compressor
+{
+    px_compression_algorithm algorithm;
+    int level;
+    void *context;
+};
+
+// create & delete
+px_compressor *px_compressor_new(const px_compression_algorithm algorithm, const int level);
+void px_compressor_delete(px_compressor *compressor);
+
+// compressing a chunk into a buffer of at least px_compression_bound bytes, 0 on errors
+size_t px_compressor_compress(px_compressor *restrict compressor, const void *restrict data, const size_t length, void *restrict buffer, const size_t capacity);
+
+// algorithms
+size_t px_compression_bound(const size_t length) __attribute__((const));
+bool px_compression_is_available(const px_compression_algorithm algorithm) __attribute__((const));
+const char *px_compression_get_extension(const px_compression_algorithm algorithm) __attribute__((const));
+bool px_compression_parse_algorithm(const char *restrict name, px_compression_algorithm *restrict algorithm);
+
+// the built-in gzip encoder used without zlib
+void *px_compression_builtin_gzip_new(void);
+void px_compression_builtin_gzip_delete(void *context);
+size_t px_compression_builtin_gzip(void *restrict context, const void *restrict data, const size_t length, void *restrict buffer, const size_t capacity);
+
+#endif
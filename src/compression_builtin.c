@@ -0,0 +1,342 @@
+//
+//  compression_builtin.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compression.h"
+
+// a single block of deflate (RFC 1951) with the fixed Huffman codes, matches are found with a hash
+// table of the last position of every 3 bytes. it compresses less than zlib, but it's fast and every
+// gzip reader understands it
+#define PX_COMPRESSION_BUILTIN_HASH_BITS 15
+
+typedef struct px_compression_builtin_gzip_context
+{
+    uint32_t positions[1 << PX_COMPRESSION_BUILTIN_HASH_BITS];
+} px_compression_builtin_gzip_context;
+
+typedef struct px_compression_bit_writer
+{
+    unsigned char *buffer;
+    size_t capacity;
+    size_t length;
+    uint64_t bits;
+    unsigned int count;
+    bool overflow;
+} px_compression_bit_writer;
+
+static size_t px_compression_builtin_deflate_fixed(px_compression_builtin_gzip_context *restrict context, const unsigned char *restrict data, const size_t length, unsigned char *restrict buffer, const size_t capacity);
+static size_t px_compression_builtin_deflate_stored(const unsigned char *restrict data, const size_t length, unsigned char *restrict buffer, const size_t capacity);
+static void px_compression_builtin_init_tables(void);
+static uint32_t px_compression_builtin_crc32(const unsigned char *restrict data, size_t length);
+
+static inline void px_compression_write_bits(px_compression_bit_writer *restrict writer, const uint32_t value, const unsigned int count)
+{
+    writer->bits |= (uint64_t)value << writer->count;
+    writer->count += count;
+    
+    if (writer->count >= 32)
+    {
+        if (writer->length + 4 <= writer->capacity)
+        {
+            const uint32_t word = (uint32_t)writer->bits;
+            writer->buffer[writer->length] = (unsigned char)word;
+            writer->buffer[writer->length + 1] = (unsigned char)(word >> 8);
+            writer->buffer[writer->length + 2] = (unsigned char)(word >> 16);
+            writer->buffer[writer->length + 3] = (unsigned char)(word >> 24);
+            writer->length += 4;
+        }
+        else
+        {
+            writer->overflow = true;
+        }
+        
+        writer->bits >>= 32;
+        writer->count -= 32;
+    }
+}
+
+static inline uint32_t px_compression_read_uint24(const unsigned char *data)
+{
+    return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16;
+}
+
+static inline unsigned int px_compression_log2(const uint32_t value)
+{
+    return 31 - (unsigned int)__builtin_clz(value);
+}
+
+// gzip header: magic, deflate, no flags, no time, no extra flags, unix
+static const unsigned char px_compression_gzip_header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3 };
+
+static const size_t px_compression_gzip_trailer_length = 8;
+
+// the distance of a match can't be more than the window
+static const size_t px_compression_window_size = 32768;
+
+static const size_t px_compression_max_match_length = 258;
+
+// stored blocks hold at most this many bytes
+static const size_t px_compression_max_stored_length = 65535;
+
+// the fixed Huffman codes, bit reversed as deflate sends them from the least significant bit
+static uint16_t px_compression_literal_codes[288];
+static uint8_t px_compression_literal_code_lengths[288];
+static uint8_t px_compression_distance_codes[30];
+static uint32_t px_compression_crc32_table[8][256];
+static pthread_once_t px_compression_tables_once = PTHREAD_ONCE_INIT;
+
+void *px_compression_builtin_gzip_new(void)
+{
+    pthread_once(&px_compression_tables_once, px_compression_builtin_init_tables);
+    
+    return calloc(1, sizeof(px_compression_builtin_gzip_context));
+}
+
+void px_compression_builtin_gzip_delete(void *context)
+{
+    free(context);
+}
+
+size_t px_compression_builtin_gzip(void *restrict context, const void *restrict data, const size_t length, void *restrict buffer, const size_t capacity)
+{
+    unsigned char *output = buffer;
+    const size_t header_length = sizeof(px_compression_gzip_header);
+    
+    if (capacity < header_length + px_compression_gzip_trailer_length)
+        return 0;
+    
+    memcpy(output, px_compression_gzip_header, header_length);
+    const size_t available = capacity - header_length - px_compression_gzip_trailer_length;
+    
+    // data that doesn't compress is sent as it is instead
+    size_t deflated_length = px_compression_builtin_deflate_fixed(context, data, length, output + header_length, available);
+    if (deflated_length == 0 || deflated_length > length + length / px_compression_max_stored_length * 5 + 5)
+        deflated_length = px_compression_builtin_deflate_stored(data, length, output + header_length, available);
+    
+    if (deflated_length == 0)
+        return 0;
+    
+    unsigned char *trailer = output + header_length + deflated_length;
+    const uint32_t crc = px_compression_builtin_crc32(data, length);
+    const uint32_t size = (uint32_t)length;
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        trailer[i] = (unsigned char)(crc >> (i * 8));
+        trailer[i + 4] = (unsigned char)(size >> (i * 8));
+    }
+    
+    return header_length + deflated_length + px_compression_gzip_trailer_length;
+}
+
+static size_t px_compression_builtin_deflate_fixed(px_compression_builtin_gzip_context *restrict context, const unsigned char *restrict data, const size_t length, unsigned char *restrict buffer, const size_t capacity)
+{
+    px_compression_bit_writer writer = { buffer, capacity, 0, 0, 0, false };
+    uint32_t *positions = context->positions;
+    
+    // the last block, compressed with the fixed codes
+    px_compression_write_bits(&writer, 3, 3);
+    
+    // positions left in the table by earlier chunks are only matches if the bytes there are the same
+    size_t i = 0;
+    while (i + 3 <= length && !writer.overflow)
+    {
+        const uint32_t value = px_compression_read_uint24(data + i);
+        const uint32_t hash = (value * 2654435761u) >> (32 - PX_COMPRESSION_BUILTIN_HASH_BITS);
+        const size_t candidate = positions[hash];
+        positions[hash] = (uint32_t)i;
+        
+        if (candidate >= i || i - candidate > px_compression_window_size || px_compression_read_uint24(data + candidate) != value)
+        {
+            const unsigned char literal = data[i++];
+            px_compression_write_bits(&writer, px_compression_literal_codes[literal], px_compression_literal_code_lengths[literal]);
+            continue;
+        }
+        
+        const size_t max_length = length - i < px_compression_max_match_length ? length - i : px_compression_max_match_length;
+        size_t match_length = 3;
+        while (match_length < max_length && data[candidate + match_length] == data[i + match_length])
+            match_length++;
+        
+        // lengths 3 to 10 have a code each, longer ones share codes in groups of 2, 4, 8 and 16
+        const uint32_t length_offset = (uint32_t)match_length - 3;
+        unsigned int length_code, length_extra_bits = 0;
+        if (length_offset < 8)
+        {
+            length_code = length_offset;
+        }
+        else if (length_offset == 255)
+        {
+            length_code = 28;
+        }
+        else
+        {
+            const unsigned int magnitude = px_compression_log2(length_offset);
+            length_code = 4 * (magnitude - 1) + ((length_offset >> (magnitude - 2)) & 3);
+            length_extra_bits = magnitude - 2;
+        }
+        
+        const unsigned int symbol = 257 + length_code;
+        px_compression_write_bits(&writer, px_compression_literal_codes[symbol], px_compression_literal_code_lengths[symbol]);
+        if (length_extra_bits > 0)
+            px_compression_write_bits(&writer, length_offset - ((4 + (length_code & 3)) << length_extra_bits), length_extra_bits);
+        
+        // distances 1 to 4 have a code each, longer ones share codes in groups doubling in size
+        const uint32_t distance_offset = (uint32_t)(i - candidate) - 1;
+        if (distance_offset < 4)
+        {
+            px_compression_write_bits(&writer, px_compression_distance_codes[distance_offset], 5);
+        }
+        else
+        {
+            const unsigned int magnitude = px_compression_log2(distance_offset);
+            const unsigned int distance_code = 2 * magnitude + ((distance_offset >> (magnitude - 1)) & 1);
+            const unsigned int distance_extra_bits = magnitude - 1;
+            px_compression_write_bits(&writer, px_compression_distance_codes[distance_code], 5);
+            px_compression_write_bits(&writer, distance_offset - ((2 + (distance_code & 1)) << distance_extra_bits), distance_extra_bits);
+        }
+        
+        i += match_length;
+    }
+    
+    while (i < length && !writer.overflow)
+    {
+        const unsigned char literal = data[i++];
+        px_compression_write_bits(&writer, px_compression_literal_codes[literal], px_compression_literal_code_lengths[literal]);
+    }
+    
+    // the end of the block, padded to a full byte
+    px_compression_write_bits(&writer, px_compression_literal_codes[256], px_compression_literal_code_lengths[256]);
+    
+    if (writer.overflow)
+        return 0;
+    
+    const size_t remaining = (writer.count + 7) / 8;
+    if (writer.length + remaining > capacity)
+        return 0;
+    
+    for (size_t j = 0; j < remaining; j++)
+        buffer[writer.length++] = (unsigned char)(writer.bits >> (j * 8));
+    
+    return writer.length;
+}
+
+static size_t px_compression_builtin_deflate_stored(const unsigned char *restrict data, const size_t length, unsigned char *restrict buffer, const size_t capacity)
+{
+    size_t offset = 0, output_length = 0;
+    
+    do
+    {
+        const size_t block_length = length - offset < px_compression_max_stored_length ? length - offset : px_compression_max_stored_length;
+        if (output_length + 5 + block_length > capacity)
+            return 0;
+        
+        // the block header is padded to a full byte, followed by the length and its complement
+        unsigned char *block = buffer + output_length;
+        block[0] = offset + block_length == length ? 1 : 0;
+        block[1] = (unsigned char)block_length;
+        block[2] = (unsigned char)(block_length >> 8);
+        block[3] = (unsigned char)~block_length;
+        block[4] = (unsigned char)(~block_length >> 8);
+        memcpy(block + 5, data + offset, block_length);
+        
+        output_length += 5 + block_length;
+        offset += block_length;
+    } while (offset < length);
+    
+    return output_length;
+}
+
+static void px_compression_builtin_init_tables(void)
+{
+    // literals 0-143 have 8 bit codes from 00110000, 144-255 9 bit codes from 110010000, the end of
+    // block and lengths 256-279 7 bit codes from 0000000 and 280-287 8 bit codes from 11000000
+    for (unsigned int symbol = 0; symbol < 288; symbol++)
+    {
+        unsigned int code, code_length;
+        if (symbol < 144)
+        {
+            code = 0x30 + symbol;
+            code_length = 8;
+        }
+        else if (symbol < 256)
+        {
+            code = 0x190 + symbol - 144;
+            code_length = 9;
+        }
+        else if (symbol < 280)
+        {
+            code = symbol - 256;
+            code_length = 7;
+        }
+        else
+        {
+            code = 0xc0 + symbol - 280;
+            code_length = 8;
+        }
+        
+        unsigned int reversed = 0;
+        for (unsigned int bit = 0; bit < code_length; bit++)
+            reversed |= ((code >> bit) & 1) << (code_length - 1 - bit);
+        
+        px_compression_literal_codes[symbol] = (uint16_t)reversed;
+        px_compression_literal_code_lengths[symbol] = (uint8_t)code_length;
+    }
+    
+    // distance codes are all 5 bits
+    for (unsigned int code = 0; code < 30; code++)
+    {
+        unsigned int reversed = 0;
+        for (unsigned int bit = 0; bit < 5; bit++)
+            reversed |= ((code >> bit) & 1) << (4 - bit);
+        
+        px_compression_distance_codes[code] = (uint8_t)reversed;
+    }
+    
+    // CRC-32 as used by gzip, 8 bytes at a time
+    for (uint32_t byte = 0; byte < 256; byte++)
+    {
+        uint32_t crc = byte;
+        for (unsigned int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+        
+        px_compression_crc32_table[0][byte] = crc;
+    }
+    
+    for (unsigned int slice = 1; slice < 8; slice++)
+    {
+        for (unsigned int byte = 0; byte < 256; byte++)
+        {
+            const uint32_t previous = px_compression_crc32_table[slice - 1][byte];
+            px_compression_crc32_table[slice][byte] = (previous >> 8) ^ px_compression_crc32_table[0][previous & 0xff];
+        }
+    }
+}
+
+static uint32_t px_compression_builtin_crc32(const unsigned char *restrict data, size_t length)
+{
+    uint32_t crc = 0xffffffff;
+    
+    while (length >= 8)
+    {
+        const uint32_t low = crc ^ ((uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24);
+        crc = px_compression_crc32_table[7][low & 0xff] ^ px_compression_crc32_table[6][(low >> 8) & 0xff] ^
+              px_compression_crc32_table[5][(low >> 16) & 0xff] ^ px_compression_crc32_table[4][low >> 24] ^
+              px_compression_crc32_table[3][data[4]] ^ px_compression_crc32_table[2][data[5]] ^
+              px_compression_crc32_table[1][data[6]] ^ px_compression_crc32_table[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+    
+    while (length-- > 0)
+        crc = (crc >> 8) ^ px_compression_crc32_table[0][(crc ^ *data++) & 0xff];
+    
+    return crc ^ 0xffffffff;
+}
@@ -7,55 +7,114 @@
 //
 
 #include "connection.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <netdb.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include "address.h"
 #include "connection_params.h"
 #include "error.h"
 #include "message.h"
+#include "notification.h"
 #include "response.h"
+#include "result.h"
+#include "scram.h"
 #include "security.h"
-
-typedef struct px_sockaddr_with_length
-{
-    socklen_t length;
-    struct sockaddr *sockaddr;
-} px_sockaddr_with_length;
+#include "tls.h"
+#include "type_cache.h"
+#include "utility.h"
 
 static const unsigned int px_connection_protocol_version = 196608;
-
-static px_sockaddr_with_length px_socket_address_new(const px_connection_params *restrict connection_params);
-static void px_socket_address_delete(px_sockaddr_with_length socket_address);
+static const int px_connection_authentication_timeout = 5 * 1000;
+static const int px_connection_startup_timeout = 15 * 1000;
+static const size_t px_connection_read_size = 8192;
+static const size_t px_connection_read_limit = 1024 * 1024;
+static const unsigned int px_connection_cancel_request_code = 80877102;
+static const char *px_connection_scram_mechanism = "SCRAM-SHA-256";
+static const int px_connection_cancel_timeout = 5 * 1000;
+static const uint64_t px_connection_attempt_delay = 250;
+static const unsigned int px_connection_ssl_request_code = 80877103;
+static const char *px_connection_default_tls_host = "localhost";
 
 static bool px_connection_open_socket(px_connection *restrict connection);
-static px_connection_attempt_result px_connection_startup(px_connection *restrict connection);
-static bool px_connection_read_authentication_response(px_connection *restrict connection);
+static bool px_connection_open_next_host(px_connection *restrict connection);
+static bool px_connection_matches_target_session_type(const px_connection *restrict connection) __attribute__((pure));
+static bool px_connection_start_attempt(px_connection *restrict connection);
+static px_connection_polling_status px_connection_poll_attempts(px_connection *restrict connection);
+static void px_connection_wait_for_attempts(const px_connection *restrict connection);
+static void px_connection_stop_connecting(px_connection *restrict connection);
+static void px_connection_set_socket(px_connection *restrict connection, const int socket_number);
+static bool px_connection_set_socket_options(const px_connection *restrict connection, const int socket_number);
+static bool px_connection_socket_connected(const int socket_number);
+static px_connection_attempt_result px_connection_open_complete(px_connection *restrict connection);
+static px_connection_polling_status px_connection_open_fail(px_connection *restrict connection, const px_connection_attempt_result attempt_result);
+static px_connection_polling_status px_connection_open_flush(px_connection *restrict connection);
+static px_connection_polling_status px_connection_open_process_response(px_connection *restrict connection, const px_response *restrict response);
 
-static bool px_authentication_method_needs_password(px_authentication_method method) __attribute__((const));
-static void px_connection_send_authentication(px_connection *restrict connection);
+static bool px_connection_requests_ssl(const px_connection *restrict connection) __attribute__((pure));
+static px_connection_polling_status px_connection_open_process_ssl_response(px_connection *restrict connection);
+static px_connection_polling_status px_connection_open_handshake(px_connection *restrict connection);
+static void px_connection_set_tls_error(px_connection *restrict connection, const char *restrict sql_state);
+static px_connection_flush_result px_connection_flush_tls(px_connection *restrict connection);
+static bool px_connection_read_tls(px_connection *restrict connection);
+static void px_connection_close_socket(px_connection *restrict connection);
 
-static px_connection_attempt_result px_connection_wait_for_server_startup(px_connection *restrict connection);
+static bool px_authentication_method_needs_password(px_authentication_method method) __attribute__((const));
+static px_connection_polling_status px_connection_open_send_authentication(px_connection *restrict connection);
+static bool px_connection_queue_authentication(px_connection *restrict connection);
 
-static bool px_connection_send_startup_message(const px_connection *restrict connection);
-static bool px_connection_send_terminate_message(const px_connection *restrict connection);
-static bool px_connection_send_sync_message(const px_connection *restrict connection);
-static bool px_connection_send_password_message(const px_connection *restrict connection, const char *restrict password);
+static void px_connection_queue_startup_message(px_connection *restrict connection);
+static void px_connection_queue_terminate_message(px_connection *restrict connection);
+static void px_connection_queue_password_message(px_connection *restrict connection, const char *restrict password);
 
-static bool px_connection_send_password_message_md5(const px_connection *restrict connection);
+static bool px_connection_queue_password_message_md5(px_connection *restrict connection);
+static bool px_connection_queue_scram_client_first_message(px_connection *restrict connection);
+static px_connection_polling_status px_connection_open_continue_scram(px_connection *restrict connection, const px_response *restrict response);
+static px_connection_polling_status px_connection_open_finish_scram(px_connection *restrict connection, const px_response *restrict response);
+static bool px_connection_supports_sasl_mechanism(const px_response *restrict response, const char *restrict mechanism) __attribute__((pure));
+static void px_connection_clear_authentication_details(px_connection *restrict connection);
 
 static void px_connection_add_runtime_parameter(px_connection *restrict connection, const char *restrict param_name, const char *restrict param_value);
+static void px_connection_track_command_tag(px_connection *restrict connection, const char *restrict command_tag);
+static void px_connection_clear_runtime_parameters(px_connection *restrict connection);
+static void px_connection_add_notification(px_connection *restrict connection, const px_response *restrict response);
+static void px_connection_grow_runtime_parameters(px_connection *restrict connection);
+static void px_connection_update_decoding_parameters(px_connection *restrict connection, const char *restrict param_name, const char *restrict param_value);
+static px_connection_runtime_parameter_entry *px_connection_find_runtime_parameter(const px_connection *restrict connection, const char *restrict name, const uint32_t hash) __attribute__((pure));
+static uint32_t px_connection_hash_runtime_parameter_name(const char *restrict name) __attribute__((pure));
+static int px_connection_parse_server_version(const char *restrict server_version) __attribute__((pure));
+
+static bool px_connection_wait_for_input(px_connection *restrict connection);
+static bool px_connection_wait_until(const int socket_number, const short events, const uint64_t deadline);
+static void px_connection_process_input(px_connection *restrict connection);
+static void px_connection_process_response(px_connection *restrict connection, const px_response *restrict response);
+static void px_connection_add_result(px_connection *restrict connection);
+static void px_connection_clear_results(px_connection *restrict connection);
 
 px_connection *px_connection_new(const px_connection_params *restrict connection_params)
 {
     px_connection *connection = calloc(1, sizeof(px_connection));
     connection->connection_params = px_connection_params_copy(connection_params);
+    connection->socket_number = -1;
+    
+    return connection;
+}
+
+px_connection *px_connection_new_with_shared_params(px_connection_params *connection_params)
+{
+    px_connection *connection = calloc(1, sizeof(px_connection));
+    connection->connection_params = px_connection_params_retain(connection_params);
+    connection->socket_number = -1;
     
     return connection;
 }
@@ -72,12 +131,9 @@ void px_connection_delete(px_connection *connection)
         px_connection_params_delete(connection->connection_params);
     }
     
+    px_connection_clear_runtime_parameters(connection);
     if (connection->runtime_params.params != NULL)
     {
-        for (unsigned int i = 0; i < connection->runtime_params.count; i++)
-        {
-            free(connection->runtime_params.params[i].name);
-        }
         free(connection->runtime_params.params);
     }
     
@@ -86,6 +142,18 @@ void px_connection_delete(px_connection *connection)
         px_error_delete(connection->last_error);
     }
     
+    px_buffer_delete_members(&connection->input_buffer);
+    px_buffer_delete_members(&connection->output_buffer);
+    
+    px_connection_clear_results(connection);
+    if (connection->results.values != NULL)
+    {
+        free(connection->results.values);
+    }
+    
+    px_connection_clear_notifications(connection);
+    px_type_cache_release(connection->type_cache);
+    
     free(connection);
 }
 
@@ -111,273 +179,992 @@ px_connection_status px_connection_get_status(const px_connection *restrict conn
     return connection->connection_status;
 }
 
+px_connection_attempt_result px_connection_get_attempt_result(const px_connection *restrict connection)
+{
+    return connection->attempt_result;
+}
+
+int px_connection_get_socket(const px_connection *restrict connection)
+{
+    switch (connection->connection_status)
+    {
+        case px_connection_status_opening:
+        case px_connection_status_authentication_pending:
+        case px_connection_status_open:
+            return connection->socket_number;
+        case px_connection_status_closed:
+        case px_connection_status_failed:
+        default:
+            return -1;
+    }
+}
+
+const char *px_connection_get_host(const px_connection *restrict connection)
+{
+    return px_connection_params_get_host(connection->connection_params, connection->host.index);
+}
+
+bool px_connection_is_encrypted(const px_connection *restrict connection)
+{
+    return connection->tls != NULL;
+}
+
+bool px_connection_is_kernel_tls(const px_connection *restrict connection)
+{
+    return connection->tls != NULL && px_tls_is_kernel_offloaded(connection->tls);
+}
+
+unsigned int px_connection_get_session_state(const px_connection *restrict connection)
+{
+    return connection->session_state;
+}
+
+px_type_cache *px_connection_get_type_cache(const px_connection *restrict connection)
+{
+    return connection->type_cache;
+}
+
+void px_connection_set_type_cache(px_connection *restrict connection, px_type_cache *type_cache)
+{
+    px_type_cache *previous = connection->type_cache;
+    connection->type_cache = px_type_cache_retain(type_cache);
+    px_type_cache_release(previous);
+}
+
+void px_connection_mark_session_state(px_connection *restrict connection, const unsigned int session_state)
+{
+    connection->session_state |= session_state;
+}
+
+void px_connection_clear_session_state(px_connection *restrict connection)
+{
+    connection->session_state = px_connection_session_state_clean;
+}
+
+const char *px_connection_get_runtime_parameter(const px_connection *restrict connection, const char *restrict name)
+{
+    if (connection->runtime_params.count == 0)
+        return NULL;
+    
+    const px_connection_runtime_parameter_entry *entry = px_connection_find_runtime_parameter(connection, name, px_connection_hash_runtime_parameter_name(name));
+    return entry->name != NULL ? entry->value : NULL;
+}
+
+int px_connection_get_server_version_number(const px_connection *restrict connection)
+{
+    return connection->runtime_params.server_version_number;
+}
+
+bool px_connection_has_integer_datetimes(const px_connection *restrict connection)
+{
+    return connection->runtime_params.integer_datetimes;
+}
+
+bool px_connection_is_client_encoding_utf8(const px_connection *restrict connection)
+{
+    return connection->runtime_params.client_encoding_utf8;
+}
+
 void px_connection_set_password_callback(px_connection *restrict connection, PXPasswordCallback *callback, void* context)
 {
     connection->password_callback = callback;
     connection->password_callback_context = context;
 }
 
+void px_connection_set_notification_callback(px_connection *restrict connection, PXNotificationCallback *callback, void *context)
+{
+    connection->notification_callback = callback;
+    connection->notification_callback_context = context;
+}
+
 px_connection_attempt_result px_connection_open(px_connection *restrict connection)
+{
+    if (!px_connection_open_start(connection))
+    {
+        return connection->attempt_result;
+    }
+    
+    return px_connection_open_complete(connection);
+}
+
+bool px_connection_open_start(px_connection *restrict connection)
 {
     if (connection->connection_status != px_connection_status_closed)
     {
-        return px_connection_attempt_result_not_closed;
+        connection->attempt_result = px_connection_attempt_result_not_closed;
+        return false;
     }
     
-    if (!px_connection_open_socket(connection))
+    px_buffer_clear(&connection->input_buffer);
+    px_buffer_clear(&connection->output_buffer);
+    connection->attempt_result = px_connection_attempt_result_success;
+    connection->host.index = 0;
+    connection->host.any_session = false;
+    
+    if (!px_connection_open_socket(connection) && !px_connection_open_next_host(connection))
     {
         connection->connection_status = px_connection_status_failed;
-        return px_connection_attempt_result_invalid_host;
+        connection->attempt_result = px_connection_attempt_result_invalid_host;
+        return false;
+    }
+    
+    return true;
+}
+
+px_connection_polling_status px_connection_open_poll(px_connection *restrict connection)
+{
+    switch (connection->open_state)
+    {
+        case px_connection_open_state_connecting:
+            switch (px_connection_poll_attempts(connection))
+            {
+                case px_connection_polling_status_ok:
+                    break;
+                case px_connection_polling_status_failed:
+                    return px_connection_open_fail(connection, px_connection_attempt_result_invalid_host);
+                default:
+                    return px_connection_polling_status_writing;
+            }
+        
+            if (px_connection_requests_ssl(connection))
+            {
+                px_message *message = px_message_new("0Ti", px_connection_ssl_request_code);
+                px_connection_queue_message(connection, message);
+                px_message_delete(message);
+                connection->open_state = px_connection_open_state_ssl_requested;
+                break;
+            }
+        
+            px_connection_queue_startup_message(connection);
+            connection->open_state = px_connection_open_state_authenticating;
+            break;
+        case px_connection_open_state_ssl_requested:
+        {
+            const px_connection_polling_status status = px_connection_open_process_ssl_response(connection);
+            if (status != px_connection_polling_status_ok)
+                return status;
+            
+            if (connection->open_state != px_connection_open_state_ssl_handshaking)
+                break;
+            
+            // the handshake starts right away
+            const px_connection_polling_status handshake_status = px_connection_open_handshake(connection);
+            if (handshake_status != px_connection_polling_status_ok)
+                return handshake_status;
+            break;
+        }
+        case px_connection_open_state_ssl_handshaking:
+        {
+            const px_connection_polling_status status = px_connection_open_handshake(connection);
+            if (status != px_connection_polling_status_ok)
+                return status;
+            break;
+        }
+        case px_connection_open_state_password_needed:
+        {
+            const px_connection_polling_status status = px_connection_open_send_authentication(connection);
+            if (status != px_connection_polling_status_reading)
+                return status;
+            break;
+        }
+        case px_connection_open_state_authenticating:
+        case px_connection_open_state_starting_up:
+        {
+            // process whatever arrived before a possible end of stream, it may be an error message
+            const bool input_open = px_connection_read_input(connection);
+            
+            px_response *response;
+            while ((response = px_response_next(connection)) != NULL)
+            {
+                const px_connection_polling_status status = px_connection_open_process_response(connection, response);
+                px_response_delete(response);
+                
+                if (status != px_connection_polling_status_reading)
+                    return status;
+            }
+            
+            if (!input_open)
+            {
+                px_connection_set_last_error(connection, px_error_new_io_error());
+                return px_connection_open_fail(connection,
+                                               connection->open_state == px_connection_open_state_authenticating ?
+                                               px_connection_attempt_result_authentication_failed :
+                                               px_connection_attempt_result_unrecognized_server_message);
+            }
+            break;
+        }
+        case px_connection_open_state_idle:
+        default:
+            return connection->connection_status == px_connection_status_open ?
+                px_connection_polling_status_ok : px_connection_polling_status_failed;
     }
     
-    const px_connection_attempt_result startUpResult = px_connection_startup(connection);
-    if (startUpResult != px_connection_attempt_result_success)
+    return px_connection_open_flush(connection);
+}
+
+static px_connection_attempt_result px_connection_open_complete(px_connection *restrict connection)
+{
+    while (true)
     {
-        if (startUpResult != px_connection_attempt_result_authentication_needed)
+        const px_connection_polling_status status = px_connection_open_poll(connection);
+        
+        switch (status)
+        {
+            case px_connection_polling_status_ok:
+                return px_connection_attempt_result_success;
+            case px_connection_polling_status_failed:
+                return connection->attempt_result;
+            case px_connection_polling_status_reading:
+            case px_connection_polling_status_writing:
+                break;
+        }
+        
+        if (connection->open_state == px_connection_open_state_connecting)
+        {
+            px_connection_wait_for_attempts(connection);
+            continue;
+        }
+        
+        int timeout;
+        switch (connection->open_state)
         {
-            px_connection_close(connection);
-            connection->connection_status = px_connection_status_failed;
+            case px_connection_open_state_ssl_requested:
+            case px_connection_open_state_ssl_handshaking:
+            case px_connection_open_state_authenticating:
+                timeout = px_connection_authentication_timeout;
+                break;
+            case px_connection_open_state_starting_up:
+                timeout = px_connection_startup_timeout;
+                break;
+            default:
+                timeout = -1;
+                break;
         }
+        
+        if (!px_connection_wait(connection, status == px_connection_polling_status_reading ? POLLIN : POLLOUT, timeout))
+        {
+            px_connection_set_last_error(connection, px_error_new_io_error());
+            if (px_connection_open_fail(connection, px_connection_attempt_result_startup_timeout) == px_connection_polling_status_failed)
+                return connection->attempt_result;
+        }
+    }
+}
+
+static px_connection_polling_status px_connection_open_fail(px_connection *restrict connection, const px_connection_attempt_result attempt_result)
+{
+    px_connection_close(connection);
+    
+    // the remaining hosts are tried before giving up
+    if (px_connection_open_next_host(connection))
+        return px_connection_polling_status_writing;
+    
+    connection->connection_status = px_connection_status_failed;
+    connection->attempt_result = attempt_result;
+    return px_connection_polling_status_failed;
+}
+
+static px_connection_polling_status px_connection_open_flush(px_connection *restrict connection)
+{
+    switch (px_connection_flush(connection))
+    {
+        case px_connection_flush_result_done:
+            return px_connection_polling_status_reading;
+        case px_connection_flush_result_pending:
+            return px_connection_polling_status_writing;
+        case px_connection_flush_result_failed:
+        default:
+            return px_connection_open_fail(connection, px_connection_attempt_result_cannot_send_startup_message);
+    }
+}
+
+int px_connection_get_open_timeout(const px_connection *restrict connection)
+{
+    if (connection->open_state != px_connection_open_state_connecting)
+        return -1;
+    
+    uint64_t wakeup = connection->connecting.deadline;
+    
+    if (connection->connecting.addresses != NULL
+        && connection->connecting.next < connection->connecting.addresses->count
+        && connection->connecting.count < PX_CONNECTION_MAX_ATTEMPTS
+        && (wakeup == 0 || connection->connecting.next_attempt < wakeup))
+    {
+        wakeup = connection->connecting.next_attempt;
     }
     
-    return startUpResult;
+    if (wakeup == 0)
+        return -1;
+    
+    const uint64_t now = px_get_monotonic_time();
+    return wakeup > now ? (int)(wakeup - now) : 0;
 }
 
 void px_connection_close(px_connection *restrict connection)
 {
+    px_connection_stop_connecting(connection);
+    
     switch (connection->connection_status)
     {
         case px_connection_status_open:
         case px_connection_status_authentication_pending:
-            px_connection_send_terminate_message(connection);
+            px_connection_queue_terminate_message(connection);
+            px_connection_flush(connection);
         case px_connection_status_opening:
-            close(connection->socket_number);
+            px_connection_close_socket(connection);
         case px_connection_status_closed:
         case px_connection_status_failed:
             break;
     }
     
     connection->connection_status = px_connection_status_closed;
+    connection->open_state = px_connection_open_state_idle;
+    connection->socket_number = -1;
+    px_buffer_clear(&connection->input_buffer);
+    px_buffer_clear(&connection->output_buffer);
+    px_connection_clear_results(connection);
+    px_connection_clear_authentication_details(connection);
+    connection->deadline.at = 0;
+    connection->deadline.cancelled = false;
 }
 
 static bool px_connection_open_socket(px_connection *restrict connection)
 {
-    px_sockaddr_with_length socket_address = px_socket_address_new(connection->connection_params);
-    if (socket_address.sockaddr == NULL)
-    {
-        return false;
-    }
+    px_connection_clear_runtime_parameters(connection);
+    px_connection_clear_session_state(connection);
+    px_connection_clear_notifications(connection);
     
-    const int socket_number = socket(socket_address.sockaddr->sa_family, SOCK_STREAM, 0);
-    if (socket_number == -1)
+    px_address_list *address_list = px_connection_params_resolve(connection->connection_params, connection->host.index);
+    if (address_list == NULL)
     {
-        px_socket_address_delete(socket_address);
         return false;
     }
-    connection->socket_number = socket_number;
     
-    const int connect_result = connect(socket_number, socket_address.sockaddr, socket_address.length);
-    if (connect_result == -1)
+    const unsigned int connect_timeout = connection->connection_params->connect_timeout;
+    connection->connecting.addresses = address_list;
+    connection->connecting.next = 0;
+    connection->connecting.count = 0;
+    connection->connecting.deadline = connect_timeout == 0 ? 0 : px_get_monotonic_time() + connect_timeout;
+    
+    if (!px_connection_start_attempt(connection))
     {
-        close(socket_number);
-        px_socket_address_delete(socket_address);
+        px_connection_stop_connecting(connection);
         return false;
     }
     
-    px_socket_address_delete(socket_address);
+    px_connection_set_socket(connection, connection->connecting.sockets[0]);
     connection->connection_status = px_connection_status_opening;
+    connection->open_state = px_connection_open_state_connecting;
     return true;
 }
 
-static px_connection_attempt_result px_connection_startup(px_connection *restrict connection)
+static bool px_connection_start_attempt(px_connection *restrict connection)
 {
-    if (!px_connection_send_startup_message(connection))
-        return px_connection_attempt_result_cannot_send_startup_message;
+    const px_address_list *address_list = connection->connecting.addresses;
+    
+    while (connection->connecting.next < address_list->count)
+    {
+        const px_address *address = &address_list->addresses[connection->connecting.next++];
+        const int socket_number = socket(address->family, address->socket_type, address->protocol);
+        if (socket_number == -1)
+            continue;
+        
+        // the socket is always non-blocking, the blocking calls wait with poll() instead.
+        // buffer sizes have to be set before connecting, as they decide the window scale
+        const int flags = fcntl(socket_number, F_GETFL, 0);
+        if (flags == -1 || fcntl(socket_number, F_SETFL, flags | O_NONBLOCK) == -1
+            || ((address->family == AF_INET || address->family == AF_INET6) && !px_connection_set_socket_options(connection, socket_number))
+            || (connect(socket_number, (const struct sockaddr *)&address->storage, address->length) == -1 && errno != EINPROGRESS))
+        {
+            close(socket_number);
+            continue;
+        }
+        
+        connection->connecting.sockets[connection->connecting.count++] = socket_number;
+        connection->connecting.next_attempt = px_get_monotonic_time() + px_connection_attempt_delay;
+        return true;
+    }
     
-    return px_connection_authenticate(connection);
+    return false;
 }
 
-px_connection_attempt_result px_connection_authenticate(px_connection *restrict connection)
+static px_connection_polling_status px_connection_poll_attempts(px_connection *restrict connection)
 {
-    while (!px_connection_read_authentication_response(connection))
+    const unsigned int count = connection->connecting.count;
+    struct pollfd fds[PX_CONNECTION_MAX_ATTEMPTS];
+    for (unsigned int i = 0; i < count; i++)
+    {
+        fds[i] = (struct pollfd) { .fd = connection->connecting.sockets[i], .events = POLLOUT, .revents = 0 };
+    }
+    
+    int poll_result;
+    do
+    {
+        poll_result = poll(fds, count, 0);
+    }
+    while (poll_result == -1 && errno == EINTR);
+    
+    // the first attempt to succeed wins, the ones that failed are dropped
+    unsigned int remaining = 0;
+    for (unsigned int i = 0; i < count; i++)
     {
-        if (connection->connection_status != px_connection_status_authentication_pending)
-            return px_connection_attempt_result_authentication_failed;
+        const int socket_number = connection->connecting.sockets[i];
         
-        if (px_authentication_method_needs_password(connection->authentication_method) &&
-            connection->connection_params->password == NULL)
+        if (poll_result > 0 && fds[i].revents != 0)
         {
-            if (connection->password_callback != NULL)
-            {
-                if (!connection->password_callback(connection, connection->password_callback_context))
-                    return px_connection_attempt_result_authentication_needed;
-            }
-            else
+            if (px_connection_socket_connected(socket_number))
             {
-                return px_connection_attempt_result_authentication_needed;
+                for (unsigned int j = i + 1; j < count; j++)
+                    connection->connecting.sockets[remaining++] = connection->connecting.sockets[j];
+                
+                connection->connecting.count = remaining;
+                px_connection_set_socket(connection, socket_number);
+                px_connection_stop_connecting(connection);
+                return px_connection_polling_status_ok;
             }
+            
+            close(socket_number);
+            if (socket_number == connection->socket_number)
+                connection->socket_number = -1;
+            continue;
         }
         
-        px_connection_send_authentication(connection);
+        connection->connecting.sockets[remaining++] = socket_number;
     }
     
-    return px_connection_wait_for_server_startup(connection);
+    connection->connecting.count = remaining;
+    
+    const uint64_t now = px_get_monotonic_time();
+    if (connection->connecting.deadline != 0 && now >= connection->connecting.deadline)
+        return px_connection_polling_status_failed;
+    
+    // the next address gets its turn once the newest attempt had a head start or all of them failed
+    if ((remaining == 0 || now >= connection->connecting.next_attempt) && remaining < PX_CONNECTION_MAX_ATTEMPTS)
+        px_connection_start_attempt(connection);
+    
+    if (connection->connecting.count == 0)
+        return px_connection_polling_status_failed;
+    
+    px_connection_set_socket(connection, connection->connecting.sockets[connection->connecting.count - 1]);
+    return px_connection_polling_status_writing;
 }
 
-static bool px_connection_read_authentication_response(px_connection *restrict connection)
+static void px_connection_wait_for_attempts(const px_connection *restrict connection)
 {
-    connection->connection_status = px_connection_status_opening;
-    bool success = false;
-        
-    px_response *response = px_response_read_with_timeout(connection, 5 * 1000);
-    if (response == NULL) return false;
-    
-    switch (response->message_type)
+    struct pollfd fds[PX_CONNECTION_MAX_ATTEMPTS];
+    for (unsigned int i = 0; i < connection->connecting.count; i++)
     {
-        case px_message_type_authentication_ok:
-            success = true;
-            break;
-        case px_message_type_authentication_md5_password:
-            connection->connection_status = px_connection_status_authentication_pending;
-            connection->authentication_method = PXAuthenticationMethodMD5;
-            memcpy(connection->authentication_details.md5.salt,
-                   response->response_data.authentication_md5_password.salt,
-                   4);
-            success = false;
-            break;
-        case px_message_type_error:
-            success = false;
-            break;
-        default:
-            success = false;
-            break;
+        fds[i] = (struct pollfd) { .fd = connection->connecting.sockets[i], .events = POLLOUT, .revents = 0 };
     }
-    px_response_delete(response);
     
-    return success;
+    int poll_result;
+    do
+    {
+        poll_result = poll(fds, connection->connecting.count, px_connection_get_open_timeout(connection));
+    }
+    while (poll_result == -1 && errno == EINTR);
 }
 
-static bool px_authentication_method_needs_password(px_authentication_method method)
+static void px_connection_stop_connecting(px_connection *restrict connection)
 {
-    switch (method)
+    // the socket of the connection is closed along with the connection
+    for (unsigned int i = 0; i < connection->connecting.count; i++)
     {
-        case PXAuthenticationMethodMD5:
-            return true;
-        case PXAuthenticationMethodNone:
-        default:
-            return false;
+        if (connection->connecting.sockets[i] != connection->socket_number)
+            close(connection->connecting.sockets[i]);
+    }
+    
+    connection->connecting.count = 0;
+    
+    if (connection->connecting.addresses != NULL)
+    {
+        px_address_list_release(connection->connecting.addresses);
+        connection->connecting.addresses = NULL;
     }
 }
 
-static void px_connection_send_authentication(px_connection *restrict connection)
+static void px_connection_set_socket(px_connection *restrict connection, const int socket_number)
 {
-    switch (connection->authentication_method)
+    if (connection->socket_number != socket_number)
     {
-        case PXAuthenticationMethodMD5:
-            px_connection_send_password_message_md5(connection);
-            break;
-        default:
-            break;
+        connection->socket_number = socket_number;
+        connection->socket_generation++;
     }
 }
 
-static px_connection_attempt_result px_connection_wait_for_server_startup(px_connection *restrict connection)
+static bool px_connection_open_next_host(px_connection *restrict connection)
 {
-    while (connection->connection_status == px_connection_status_opening)
-    {        
-        px_response *response = px_response_read_with_timeout(connection, 15 * 1000);
-        if (response == NULL) return px_connection_attempt_result_unrecognized_server_message;
-        
-        switch (response->message_type)
+    const px_connection_params *connection_params = connection->connection_params;
+    
+    while (true)
+    {
+        if (++connection->host.index >= connection_params->hosts.count)
         {
-            case px_message_type_backend_key_data:
-                connection->backend_process_id = response->response_data.backend_key_data.process_id;
-                connection->backend_secret_key = response->response_data.backend_key_data.secret_key;
-                break;
-            case px_message_type_parameter_status:
-                px_connection_add_runtime_parameter(connection,
-                                                response->response_data.runtime_parameter_status.param_name,
-                                                response->response_data.runtime_parameter_status.param_value);
-                break;
-            case px_message_type_ready_for_query:
-                connection->connection_status = px_connection_status_open;
-                break;
-            case px_message_type_error:
-                px_response_delete(response);
-                return px_connection_attempt_result_server_error;
-            default:
-                break;
+            connection->host.index = 0;
+            
+            // prefer-standby settles for any server once none of the hosts turned out to be a standby
+            if (connection_params->target_session_type != px_target_session_type_prefer_standby || connection->host.any_session)
+                return false;
+            
+            connection->host.any_session = true;
         }
         
-        px_response_delete(response);
+        if (px_connection_open_socket(connection))
+            return true;
     }
-    
-    return px_connection_attempt_result_success;
 }
 
-void px_connection_add_runtime_parameter(px_connection *restrict connection, const char *restrict param_name, const char *restrict param_value)
+static bool px_connection_matches_target_session_type(const px_connection *restrict connection)
 {
-    const size_t name_length = strlen(param_name);
-    const size_t value_length = strlen(param_value);
-    
-    char *name_copy = malloc(name_length + value_length + 2);
-    char *value_copy = stpcpy(name_copy, param_name) + 1;
-    stpcpy(value_copy, param_value);
+    // servers older than 14 don't report in_hot_standby, they are taken for primaries
+    const char *in_hot_standby = px_connection_get_runtime_parameter(connection, "in_hot_standby");
+    const char *default_transaction_read_only = px_connection_get_runtime_parameter(connection, "default_transaction_read_only");
+    const bool standby = in_hot_standby != NULL && strcmp(in_hot_standby, "on") == 0;
+    const bool read_only = standby || (default_transaction_read_only != NULL && strcmp(default_transaction_read_only, "on") == 0);
     
-    if (connection->runtime_params.capacity == 0)
-    {
-        connection->runtime_params.capacity = 16;
-        connection->runtime_params.params = calloc(connection->runtime_params.capacity, sizeof(px_connection_runtime_parameter_entry));
-    }
-    else if (connection->runtime_params.count + 1 >= connection->runtime_params.capacity)
+    switch (connection->connection_params->target_session_type)
     {
-        connection->runtime_params.capacity *= 2;
-        connection->runtime_params.params = realloc(connection->runtime_params.params,
-                                                    connection->runtime_params.capacity * sizeof(px_connection_runtime_parameter_entry));
+        case px_target_session_type_read_write:
+            return !read_only;
+        case px_target_session_type_read_only:
+            return read_only;
+        case px_target_session_type_primary:
+            return !standby;
+        case px_target_session_type_standby:
+            return standby;
+        case px_target_session_type_prefer_standby:
+            return standby || connection->host.any_session;
+        case px_target_session_type_any:
+        default:
+            return true;
     }
-    
-    connection->runtime_params.params[connection->runtime_params.count++] = (px_connection_runtime_parameter_entry)
-    {
-        .name = name_copy,
-        .value = value_copy
-    };
 }
 
-static px_sockaddr_with_length px_socket_address_new(const px_connection_params *restrict connection_params)
+static bool px_connection_set_socket_options(const px_connection *restrict connection, const int socket_number)
 {
-    struct addrinfo* address_info = NULL;
-    char port_string[16];
-    sprintf(port_string, "%u", connection_params->port);
-    
-    const int address_error = getaddrinfo(connection_params->hostname, port_string, NULL, &address_info);
+    const px_connection_params *connection_params = connection->connection_params;
     
-    if (address_error != 0)
-    {
-        fprintf(stderr, "%s\n", gai_strerror(address_error));
-        if (address_info != NULL) freeaddrinfo(address_info);
-        return (px_sockaddr_with_length){ .length = 0, .sockaddr = NULL };
-    }
+    // queries are written as several small messages followed by a flush, there's nothing to gain from Nagle's algorithm
+    const int nodelay = connection_params->tcp_nodelay ? 1 : 0;
+    if (setsockopt(socket_number, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) == -1)
+        return false;
     
-    struct sockaddr *copy = malloc(address_info->ai_addrlen);
-    memcpy(copy, address_info->ai_addr, address_info->ai_addrlen);
-
-    px_sockaddr_with_length result = (px_sockaddr_with_length)
-    {
-        .length = address_info->ai_addrlen,
-        .sockaddr = copy
-    };
+    if (connection_params->receive_buffer_size > 0 && setsockopt(socket_number, SOL_SOCKET, SO_RCVBUF, &connection_params->receive_buffer_size, sizeof(int)) == -1)
+        return false;
     
-    freeaddrinfo(address_info);
+    if (connection_params->send_buffer_size > 0 && setsockopt(socket_number, SOL_SOCKET, SO_SNDBUF, &connection_params->send_buffer_size, sizeof(int)) == -1)
+        return false;
     
-    return result;
+    if (connection_params->keepalive)
+    {
+        const int keepalive = 1;
+        if (setsockopt(socket_number, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive)) == -1)
+            return false;
+        
+        const int idle = (int)connection_params->keepalive_idle;
+#if defined(TCP_KEEPIDLE)
+        if (idle > 0 && setsockopt(socket_number, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle)) == -1)
+            return false;
+#elif defined(TCP_KEEPALIVE)
+        if (idle > 0 && setsockopt(socket_number, IPPROTO_TCP, TCP_KEEPALIVE, &idle, sizeof(idle)) == -1)
+            return false;
+#endif
+        
+#ifdef TCP_KEEPINTVL
+        const int interval = (int)connection_params->keepalive_interval;
+        if (interval > 0 && setsockopt(socket_number, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval)) == -1)
+            return false;
+#endif
+        
+#ifdef TCP_KEEPCNT
+        const int count = (int)connection_params->keepalive_count;
+        if (count > 0 && setsockopt(socket_number, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count)) == -1)
+            return false;
+#endif
+    }
+    
+#ifdef TCP_USER_TIMEOUT
+    const unsigned int user_timeout = connection_params->user_timeout;
+    if (user_timeout > 0 && setsockopt(socket_number, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_timeout, sizeof(user_timeout)) == -1)
+        return false;
+#endif
+    
+    return true;
+}
+
+static bool px_connection_socket_connected(const int socket_number)
+{
+    int socket_error = 0;
+    socklen_t socket_error_length = sizeof(socket_error);
+    
+    if (getsockopt(socket_number, SOL_SOCKET, SO_ERROR, &socket_error, &socket_error_length) == -1)
+        return false;
+    
+    return socket_error == 0;
+}
+
+px_connection_attempt_result px_connection_authenticate(px_connection *restrict connection)
+{
+    if (connection->open_state != px_connection_open_state_password_needed)
+    {
+        return connection->connection_status == px_connection_status_open ?
+            px_connection_attempt_result_success : px_connection_attempt_result_authentication_failed;
+    }
+    
+    return px_connection_open_complete(connection);
+}
+
+static px_connection_polling_status px_connection_open_process_response(px_connection *restrict connection, const px_response *restrict response)
+{
+    switch (response->message_type)
+    {
+        case px_message_type_authentication_ok:
+            // the exchange is only over once the server has proven that it knows the password
+            if (connection->authentication_method == PXAuthenticationMethodSCRAMSHA256 && connection->authentication_details.scram.exchange != NULL)
+            {
+                px_connection_set_last_error(connection, px_error_new_custom("28000", "the server did not complete the SCRAM exchange"));
+                return px_connection_open_fail(connection, px_connection_attempt_result_authentication_failed);
+            }
+        
+            connection->open_state = px_connection_open_state_starting_up;
+            connection->connection_status = px_connection_status_opening;
+            return px_connection_polling_status_reading;
+        case px_message_type_authentication_md5_password:
+            px_connection_clear_authentication_details(connection);
+            connection->authentication_method = PXAuthenticationMethodMD5;
+            memcpy(connection->authentication_details.md5.salt,
+                   response->response_data.authentication_md5_password.salt,
+                   4);
+            return px_connection_open_send_authentication(connection);
+        case px_message_type_authentication_sasl:
+            if (!px_connection_supports_sasl_mechanism(response, px_connection_scram_mechanism))
+            {
+                px_connection_set_last_error(connection, px_error_new_custom("28000", "none of the SASL authentication mechanisms of the server are supported"));
+                return px_connection_open_fail(connection, px_connection_attempt_result_authentication_failed);
+            }
+        
+            px_connection_clear_authentication_details(connection);
+            connection->authentication_method = PXAuthenticationMethodSCRAMSHA256;
+            return px_connection_open_send_authentication(connection);
+        case px_message_type_authentication_sasl_continue:
+            return px_connection_open_continue_scram(connection, response);
+        case px_message_type_authentication_sasl_final:
+            return px_connection_open_finish_scram(connection, response);
+        case px_message_type_authentication_unsupported:
+        {
+            char message[80];
+            snprintf(message, sizeof(message), "authentication method %i requested by the server is not supported",
+                     response->response_data.authentication_unsupported.code);
+            px_connection_set_last_error(connection, px_error_new_custom("28000", message));
+            return px_connection_open_fail(connection, px_connection_attempt_result_authentication_failed);
+        }
+        case px_message_type_backend_key_data:
+            connection->backend_process_id = response->response_data.backend_key_data.process_id;
+            connection->backend_secret_key = response->response_data.backend_key_data.secret_key;
+            return px_connection_polling_status_reading;
+        case px_message_type_parameter_status:
+            px_connection_add_runtime_parameter(connection,
+                                                response->response_data.runtime_parameter_status.param_name,
+                                                response->response_data.runtime_parameter_status.param_value);
+            return px_connection_polling_status_reading;
+        case px_message_type_ready_for_query:
+            if (!px_connection_matches_target_session_type(connection))
+                return px_connection_open_fail(connection, px_connection_attempt_result_session_type_mismatch);
+        
+            connection->connection_status = px_connection_status_open;
+            connection->open_state = px_connection_open_state_idle;
+            connection->transaction_status = response->response_data.ready_for_query.transaction_status;
+            return px_connection_polling_status_ok;
+        case px_message_type_error:
+            return px_connection_open_fail(connection,
+                                           connection->open_state == px_connection_open_state_authenticating ?
+                                           px_connection_attempt_result_authentication_failed :
+                                           px_connection_attempt_result_server_error);
+        default:
+            return px_connection_polling_status_reading;
+    }
+}
+
+static bool px_connection_requests_ssl(const px_connection *restrict connection)
+{
+    const px_ssl_mode ssl_mode = connection->connection_params->ssl_mode;
+    const char *hostname = px_connection_get_host(connection);
+    
+    // unix sockets are never encrypted and prefer settles for plaintext without a TLS implementation
+    if (ssl_mode == px_ssl_mode_disable || (hostname != NULL && hostname[0] == '/'))
+        return false;
+    
+    return ssl_mode != px_ssl_mode_prefer || px_tls_is_supported();
+}
+
+static px_connection_polling_status px_connection_open_process_ssl_response(px_connection *restrict connection)
+{
+    const bool input_open = px_connection_read_input(connection);
+    const size_t length = px_buffer_get_length(&connection->input_buffer);
+    
+    if (length == 0)
+    {
+        if (input_open)
+            return px_connection_polling_status_reading;
+        
+        px_connection_set_last_error(connection, px_error_new_io_error());
+        return px_connection_open_fail(connection, px_connection_attempt_result_ssl_failed);
+    }
+    
+    const char response = px_buffer_get_bytes(&connection->input_buffer)[0];
+    px_buffer_clear(&connection->input_buffer);
+    
+    // anything after the single byte would have been injected before the handshake
+    if (length > 1)
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("08P01", "received unencrypted data after the response to the TLS request"));
+        return px_connection_open_fail(connection, px_connection_attempt_result_ssl_failed);
+    }
+    
+    px_connection_params *connection_params = connection->connection_params;
+    
+    if (response == 'S')
+    {
+        const char *hostname = px_connection_get_host(connection);
+        const char *error = NULL;
+        connection->tls = px_tls_new(connection_params->tls_context, connection_params,
+                                     hostname == NULL ? px_connection_default_tls_host : hostname,
+                                     connection->socket_number, &error);
+        
+        if (connection->tls == NULL)
+        {
+            px_connection_set_last_error(connection, px_error_new_custom("08001", error));
+            return px_connection_open_fail(connection, px_connection_attempt_result_ssl_failed);
+        }
+        
+        connection->open_state = px_connection_open_state_ssl_handshaking;
+        return px_connection_polling_status_ok;
+    }
+    
+    if (response == 'N' && connection_params->ssl_mode == px_ssl_mode_prefer)
+    {
+        px_connection_queue_startup_message(connection);
+        connection->open_state = px_connection_open_state_authenticating;
+        return px_connection_polling_status_ok;
+    }
+    
+    px_connection_set_last_error(connection, response == 'N' ?
+                                 px_error_new_custom("08001", "the server does not support TLS") :
+                                 px_error_new_custom("08P01", "unexpected response to the TLS request"));
+    return px_connection_open_fail(connection, px_connection_attempt_result_ssl_failed);
+}
+
+static px_connection_polling_status px_connection_open_handshake(px_connection *restrict connection)
+{
+    switch (px_tls_handshake(connection->tls))
+    {
+        case px_tls_result_done:
+            px_connection_queue_startup_message(connection);
+            connection->open_state = px_connection_open_state_authenticating;
+            return px_connection_polling_status_ok;
+        case px_tls_result_want_read:
+            return px_connection_polling_status_reading;
+        case px_tls_result_want_write:
+            return px_connection_polling_status_writing;
+        case px_tls_result_failed:
+        case px_tls_result_closed:
+        default:
+            px_connection_set_tls_error(connection, "08001");
+            return px_connection_open_fail(connection, px_connection_attempt_result_ssl_failed);
+    }
+}
+
+static void px_connection_set_tls_error(px_connection *restrict connection, const char *restrict sql_state)
+{
+    const char *message = px_tls_get_error(connection->tls);
+    px_connection_set_last_error(connection, message == NULL ? px_error_new_io_error() : px_error_new_custom(sql_state, message));
+}
+
+static bool px_authentication_method_needs_password(px_authentication_method method)
+{
+    switch (method)
+    {
+        case PXAuthenticationMethodMD5:
+        case PXAuthenticationMethodSCRAMSHA256:
+            return true;
+        case PXAuthenticationMethodNone:
+        default:
+            return false;
+    }
+}
+
+static px_connection_polling_status px_connection_open_send_authentication(px_connection *restrict connection)
+{
+    if (px_authentication_method_needs_password(connection->authentication_method) &&
+        connection->connection_params->password == NULL)
+    {
+        if (connection->password_callback == NULL ||
+            !connection->password_callback(connection, connection->password_callback_context) ||
+            connection->connection_params->password == NULL)
+        {
+            // keep the socket open, the password can still be supplied through px_connection_authenticate
+            connection->open_state = px_connection_open_state_password_needed;
+            connection->connection_status = px_connection_status_authentication_pending;
+            connection->attempt_result = px_connection_attempt_result_authentication_needed;
+            return px_connection_polling_status_failed;
+        }
+    }
+    
+    connection->open_state = px_connection_open_state_authenticating;
+    connection->connection_status = px_connection_status_authentication_pending;
+    
+    if (!px_connection_queue_authentication(connection))
+        return px_connection_open_fail(connection, px_connection_attempt_result_authentication_failed);
+    
+    return px_connection_polling_status_reading;
+}
+
+static bool px_connection_queue_authentication(px_connection *restrict connection)
+{
+    switch (connection->authentication_method)
+    {
+        case PXAuthenticationMethodMD5:
+            return px_connection_queue_password_message_md5(connection);
+        case PXAuthenticationMethodSCRAMSHA256:
+            return px_connection_queue_scram_client_first_message(connection);
+        default:
+            return true;
+    }
+}
+
+void px_connection_add_runtime_parameter(px_connection *restrict connection, const char *restrict param_name, const char *restrict param_value)
+{
+    const size_t name_length = strlen(param_name);
+    const size_t value_length = strlen(param_value);
+    
+    char *name_copy = malloc(name_length + value_length + 2);
+    char *value_copy = stpcpy(name_copy, param_name) + 1;
+    stpcpy(value_copy, param_value);
+    
+    px_connection_update_decoding_parameters(connection, param_name, param_value);
+    
+    // keeping the table at most half full keeps the probe sequences short
+    if ((connection->runtime_params.count + 1) * 2 > connection->runtime_params.capacity)
+        px_connection_grow_runtime_parameters(connection);
+    
+    // the server reports every later change of a parameter as well, which replaces the entry
+    const uint32_t hash = px_connection_hash_runtime_parameter_name(param_name);
+    px_connection_runtime_parameter_entry *entry = px_connection_find_runtime_parameter(connection, param_name, hash);
+    if (entry->name != NULL)
+        free(entry->name);
+    else
+        connection->runtime_params.count++;
+    
+    *entry = (px_connection_runtime_parameter_entry)
+    {
+        .name = name_copy,
+        .value = value_copy,
+        .hash = hash
+    };
 }
 
-static void px_socket_address_delete(px_sockaddr_with_length socketAddress)
+static void px_connection_clear_runtime_parameters(px_connection *restrict connection)
 {
-    free(socketAddress.sockaddr);
+    // the value is stored in the same allocation as the name
+    for (size_t i = 0; i < connection->runtime_params.capacity; i++)
+    {
+        free(connection->runtime_params.params[i].name);
+        connection->runtime_params.params[i].name = NULL;
+    }
+    
+    connection->runtime_params.count = 0;
+    connection->runtime_params.server_version_number = 0;
+    connection->runtime_params.integer_datetimes = false;
+    connection->runtime_params.client_encoding_utf8 = false;
+}
+
+static void px_connection_grow_runtime_parameters(px_connection *restrict connection)
+{
+    const size_t old_capacity = connection->runtime_params.capacity;
+    px_connection_runtime_parameter_entry *old_params = connection->runtime_params.params;
+    
+    // the server reports about fifteen parameters when the connection is opened
+    connection->runtime_params.capacity = old_capacity == 0 ? 32 : old_capacity * 2;
+    connection->runtime_params.params = calloc(connection->runtime_params.capacity, sizeof(px_connection_runtime_parameter_entry));
+    
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old_params[i].name != NULL)
+            *px_connection_find_runtime_parameter(connection, old_params[i].name, old_params[i].hash) = old_params[i];
+    }
+    
+    free(old_params);
+}
+
+static void px_connection_update_decoding_parameters(px_connection *restrict connection, const char *restrict param_name, const char *restrict param_value)
+{
+    if (strcmp(param_name, "server_version") == 0)
+        connection->runtime_params.server_version_number = px_connection_parse_server_version(param_value);
+    else if (strcmp(param_name, "integer_datetimes") == 0)
+        connection->runtime_params.integer_datetimes = strcmp(param_value, "on") == 0;
+    else if (strcmp(param_name, "client_encoding") == 0)
+        connection->runtime_params.client_encoding_utf8 = strcasecmp(param_value, "UTF8") == 0 || strcasecmp(param_value, "UTF-8") == 0;
+}
+
+// returns the entry of the name, or the empty slot where it belongs. the table can't be full
+static px_connection_runtime_parameter_entry *px_connection_find_runtime_parameter(const px_connection *restrict connection, const char *restrict name, const uint32_t hash)
+{
+    const size_t mask = connection->runtime_params.capacity - 1;
+    
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        px_connection_runtime_parameter_entry *entry = &connection->runtime_params.params[i];
+        if (entry->name == NULL || (entry->hash == hash && strcmp(entry->name, name) == 0))
+            return entry;
+    }
+}
+
+static uint32_t px_connection_hash_runtime_parameter_name(const char *restrict name)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)name; *c != '\0'; c++)
+    {
+        hash ^= *c;
+        hash *= 16777619u;
+    }
+    
+    return hash;
+}
+
+static int px_connection_parse_server_version(const char *restrict server_version)
+{
+    // e.g. "16.2 (Debian 16.2-1)", "17beta1" or "9.6.24", the patch level has been the second
+    // number since version 10
+    char *end;
+    const long major = strtol(server_version, &end, 10);
+    const long minor = *end == '.' ? strtol(end + 1, &end, 10) : 0;
+    const long patch = major < 10 && *end == '.' ? strtol(end + 1, &end, 10) : 0;
+    
+    return (int)(major < 10 ? major * 10000 + minor * 100 + patch : major * 10000 + minor);
+}
+
+static void px_connection_add_notification(px_connection *restrict connection, const px_response *restrict response)
+{
+    px_notification *notification = px_notification_new(response);
+    
+    // the callback runs as soon as the notification is read, even in the middle of a query
+    if (connection->notification_callback != NULL &&
+        !connection->notification_callback(connection, notification, connection->notification_callback_context))
+    {
+        px_notification_delete(notification);
+        return;
+    }
+    
+    if (connection->notifications.last != NULL)
+        connection->notifications.last->next = notification;
+    else
+        connection->notifications.first = notification;
+    
+    connection->notifications.last = notification;
+    connection->notifications.count++;
 }
 
-static bool px_connection_send_startup_message(const px_connection *restrict connection)
+static void px_connection_queue_startup_message(px_connection *restrict connection)
 {
     static const char *user_key = "user";
     const char *user_value = connection->connection_params->username;
@@ -385,49 +1172,490 @@ static bool px_connection_send_startup_message(const px_connection *restrict con
     const char *database_value = connection->connection_params->database;
     static const char *application_name_key = "application_name";
     const char *application_name_value = connection->connection_params->application_name == NULL ? "libpx" : connection->connection_params->application_name;
+    static const char *replication_key = "replication";
+    const px_replication_mode replication_mode = connection->connection_params->replication_mode;
     
-    px_message *message = px_message_new("0Tissssssc",
-                                         px_connection_protocol_version,
-                                         user_key,
-                                         user_value,
-                                         database_key,
-                                         database_value,
-                                         application_name_key,
-                                         application_name_value,
-                                         0);
-    const bool success = px_message_send(message, connection->socket_number);
+    px_message *message = replication_mode == px_replication_mode_none ?
+        px_message_new("0Tissssssc",
+                       px_connection_protocol_version,
+                       user_key,
+                       user_value,
+                       database_key,
+                       database_value,
+                       application_name_key,
+                       application_name_value,
+                       0) :
+        px_message_new("0Tissssssssc",
+                       px_connection_protocol_version,
+                       user_key,
+                       user_value,
+                       database_key,
+                       database_value,
+                       application_name_key,
+                       application_name_value,
+                       replication_key,
+                       replication_mode == px_replication_mode_logical ? "database" : "true",
+                       0);
+    px_connection_queue_message(connection, message);
     px_message_delete(message);
-    
-    return success;
 }
 
-static bool px_connection_send_terminate_message(const px_connection *restrict connection)
+static void px_connection_queue_terminate_message(px_connection *restrict connection)
 {
     px_message *message = px_message_new("XT");
-    const bool success = px_message_send(message, connection->socket_number);
+    px_connection_queue_message(connection, message);
     px_message_delete(message);
-    return success;
 }
 
-static bool px_connection_send_password_message(const px_connection *restrict connection, const char *restrict password)
+static void px_connection_queue_password_message(px_connection *restrict connection, const char *restrict password)
 {
     px_message *message = px_message_new("pTs", password);
-    const bool success = px_message_send(message, connection->socket_number);
+    px_connection_queue_message(connection, message);
     px_message_delete(message);
-    return success;
 }
 
-static bool px_connection_send_sync_message(const px_connection *restrict connection)
+void px_connection_queue_message(px_connection *restrict connection, const px_message *restrict message)
 {
-    return px_message_send_sync(connection->socket_number);
+    px_buffer_append(&connection->output_buffer, message->messageBytes, message->messageLength);
+}
+
+bool px_connection_send_message(px_connection *restrict connection, const px_message *restrict message)
+{
+    px_connection_queue_message(connection, message);
+    return px_connection_wait_for_flush(connection);
+}
+
+bool px_connection_wait_for_flush(px_connection *restrict connection)
+{
+    while (true)
+    {
+        switch (px_connection_flush(connection))
+        {
+            case px_connection_flush_result_done:
+                return true;
+            case px_connection_flush_result_pending:
+                if (!px_connection_wait(connection, POLLOUT, -1))
+                    return false;
+                break;
+            case px_connection_flush_result_failed:
+            default:
+                return false;
+        }
+    }
+}
+
+px_connection_flush_result px_connection_flush(px_connection *restrict connection)
+{
+    if (connection->tls != NULL)
+        return px_connection_flush_tls(connection);
+    
+    while (px_buffer_get_length(&connection->output_buffer) > 0)
+    {
+        const ssize_t bytes_written = write(connection->socket_number,
+                                            px_buffer_get_bytes(&connection->output_buffer),
+                                            px_buffer_get_length(&connection->output_buffer));
+        
+        if (bytes_written > 0)
+        {
+            px_buffer_consume(&connection->output_buffer, (size_t)bytes_written);
+        }
+        else if (bytes_written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return px_connection_flush_result_pending;
+        }
+        else if (bytes_written == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            return px_connection_flush_result_failed;
+        }
+    }
+    
+    return px_connection_flush_result_done;
+}
+
+static px_connection_flush_result px_connection_flush_tls(px_connection *restrict connection)
+{
+    while (px_buffer_get_length(&connection->output_buffer) > 0)
+    {
+        size_t bytes_written;
+        switch (px_tls_write(connection->tls,
+                             px_buffer_get_bytes(&connection->output_buffer),
+                             px_buffer_get_length(&connection->output_buffer),
+                             &bytes_written))
+        {
+            case px_tls_result_done:
+                px_buffer_consume(&connection->output_buffer, bytes_written);
+                break;
+            case px_tls_result_want_read:
+            case px_tls_result_want_write:
+                return px_connection_flush_result_pending;
+            case px_tls_result_failed:
+            case px_tls_result_closed:
+            default:
+                return px_connection_flush_result_failed;
+        }
+    }
+    
+    return px_connection_flush_result_done;
+}
+
+bool px_connection_read_input(px_connection *restrict connection)
+{
+    if (connection->tls != NULL)
+        return px_connection_read_tls(connection);
+    
+    while (true)
+    {
+        char *destination = px_buffer_reserve(&connection->input_buffer, px_connection_read_size);
+        const ssize_t bytes_read = read(connection->socket_number, destination, px_connection_read_size);
+        
+        if (bytes_read > 0)
+        {
+            px_buffer_commit(&connection->input_buffer, (size_t)bytes_read);
+            
+            // a short read means the socket has been drained. a stream arriving faster than it is
+            // processed, such as a base backup, is left in the socket rather than buffered without
+            // limit, poll() reports the rest right away
+            if ((size_t)bytes_read < px_connection_read_size || px_buffer_get_length(&connection->input_buffer) >= px_connection_read_limit)
+                return true;
+        }
+        else if (bytes_read == 0)
+        {
+            // end of stream
+            return false;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return true;
+        }
+        else if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+}
+
+static bool px_connection_read_tls(px_connection *restrict connection)
+{
+    // decrypted data left in the TLS library wouldn't wake up poll(), so reading goes on until it wants more
+    while (true)
+    {
+        char *destination = px_buffer_reserve(&connection->input_buffer, px_connection_read_size);
+        size_t bytes_read;
+        
+        switch (px_tls_read(connection->tls, destination, px_connection_read_size, &bytes_read))
+        {
+            case px_tls_result_done:
+                px_buffer_commit(&connection->input_buffer, bytes_read);
+                break;
+            case px_tls_result_want_read:
+            case px_tls_result_want_write:
+                return true;
+            case px_tls_result_failed:
+            case px_tls_result_closed:
+            default:
+                return false;
+        }
+    }
+}
+
+bool px_connection_consume_input(px_connection *restrict connection)
+{
+    const bool input_open = px_connection_read_input(connection);
+    px_connection_process_input(connection);
+    
+    if (!input_open)
+    {
+        px_connection_fail(connection);
+        return false;
+    }
+    
+    return true;
+}
+
+void px_connection_fail(px_connection *restrict connection)
+{
+    // the server went away, nothing else is going to arrive
+    if (connection->tls != NULL)
+        px_connection_set_tls_error(connection, "08006");
+    else
+        px_connection_set_last_error(connection, px_error_new_io_error());
+    
+    connection->results.busy = false;
+    connection->connection_status = px_connection_status_failed;
+    px_connection_close_socket(connection);
+    connection->socket_number = -1;
+}
+
+static void px_connection_close_socket(px_connection *restrict connection)
+{
+    if (connection->tls != NULL)
+    {
+        px_tls_delete(connection->tls);
+        connection->tls = NULL;
+    }
+    
+    close(connection->socket_number);
+}
+
+bool px_connection_is_busy(px_connection *restrict connection)
+{
+    px_connection_process_input(connection);
+    return connection->results.busy && connection->results.first == connection->results.count;
+}
+
+px_result *px_connection_get_next_result(px_connection *restrict connection)
+{
+    while (px_connection_is_busy(connection))
+    {
+        if (!px_connection_wait_for_input(connection))
+        {
+            px_connection_set_last_error(connection, px_error_new_io_error());
+            connection->results.busy = false;
+            break;
+        }
+        
+        px_connection_consume_input(connection);
+    }
+    
+    if (connection->results.first == connection->results.count)
+    {
+        connection->results.first = 0;
+        connection->results.count = 0;
+        return NULL;
+    }
+    
+    return connection->results.values[connection->results.first++];
+}
+
+px_notification *px_connection_get_notification(px_connection *restrict connection)
+{
+    px_connection_process_input(connection);
+    
+    px_notification *notification = connection->notifications.first;
+    if (notification != NULL)
+    {
+        connection->notifications.first = notification->next;
+        if (connection->notifications.first == NULL)
+            connection->notifications.last = NULL;
+        
+        connection->notifications.count--;
+        notification->next = NULL;
+    }
+    
+    return notification;
+}
+
+px_notification *px_connection_wait_notification(px_connection *restrict connection, const int timeout)
+{
+    const uint64_t deadline = px_get_monotonic_time() + (uint64_t)(timeout < 0 ? 0 : timeout);
+    
+    px_connection_process_input(connection);
+    while (connection->notifications.first == NULL && connection->connection_status == px_connection_status_open)
+    {
+        int remaining = -1;
+        if (timeout >= 0)
+        {
+            const uint64_t now = px_get_monotonic_time();
+            remaining = now < deadline ? (int)(deadline - now) : 0;
+        }
+        
+        // a query in flight may still have to be sent, its results are kept as they arrive
+        if (!px_connection_wait_for_flush(connection))
+            return NULL;
+        
+        if (!px_connection_poll(connection, remaining))
+            break;
+        
+        if (!px_connection_consume_input(connection))
+            return NULL;
+    }
+    
+    return px_connection_get_notification(connection);
+}
+
+void px_connection_clear_notifications(px_connection *restrict connection)
+{
+    px_notification *notification = connection->notifications.first;
+    while (notification != NULL)
+    {
+        px_notification *next = notification->next;
+        px_notification_delete(notification);
+        notification = next;
+    }
+    
+    connection->notifications.first = NULL;
+    connection->notifications.last = NULL;
+    connection->notifications.count = 0;
+}
+
+static bool px_connection_wait_for_input(px_connection *restrict connection)
+{
+    if (!px_connection_wait_for_flush(connection))
+        return false;
+    
+    while (connection->deadline.at != 0)
+    {
+        const uint64_t now = px_get_monotonic_time();
+        if (now < connection->deadline.at && px_connection_poll(connection, (int)(connection->deadline.at - now)))
+            return true;
+        
+        if (px_get_monotonic_time() < connection->deadline.at || !px_connection_expire_query(connection, NULL))
+            return false;
+    }
+    
+    return px_connection_poll(connection, -1);
+}
+
+static void px_connection_process_input(px_connection *restrict connection)
+{
+    px_response *response;
+    while ((response = px_response_next(connection)) != NULL)
+    {
+        px_connection_process_response(connection, response);
+        px_response_delete(response);
+    }
+}
+
+static void px_connection_process_response(px_connection *restrict connection, const px_response *restrict response)
+{
+    switch (response->message_type)
+    {
+        case px_message_type_ready_for_query:
+            if (connection->results.current != NULL)
+            {
+                px_result_delete(connection->results.current);
+                connection->results.current = NULL;
+            }
+            connection->transaction_status = response->response_data.ready_for_query.transaction_status;
+            connection->results.busy = false;
+            connection->deadline.at = 0;
+            connection->deadline.cancelled = false;
+            break;
+        case px_message_type_row_description:
+            if (connection->results.current == NULL) connection->results.current = px_result_new();
+            px_result_add_headers(connection->results.current,
+                                  response->response_data.row_description.column_count,
+                                  response->response_data.row_description.columns);
+            break;
+        case px_message_type_data_row:
+            if (connection->results.current == NULL) connection->results.current = px_result_new();
+            px_result_add_data_row(connection->results.current,
+                                   response->response_data.data_row.cell_count,
+                                   response->response_data.data_row.cells);
+            break;
+        case px_message_type_error:
+            // the error itself is kept as the last error of the connection
+            if (connection->results.current != NULL)
+            {
+                px_result_delete(connection->results.current);
+                connection->results.current = NULL;
+            }
+            break;
+        case px_message_type_command_complete:
+            if (connection->results.current == NULL) connection->results.current = px_result_new();
+            px_result_parse_command_tag(connection->results.current, response->response_data.command_complete.command_tag);
+            px_connection_track_command_tag(connection, response->response_data.command_complete.command_tag);
+            px_connection_add_result(connection);
+            break;
+        case px_message_type_empty_query_response:
+            // an empty statement completes with a result of its own too, just without a command tag
+            if (connection->results.current == NULL) connection->results.current = px_result_new();
+            px_connection_add_result(connection);
+            break;
+        case px_message_type_parameter_status:
+        {
+            const char *name = response->response_data.runtime_parameter_status.param_name;
+            px_connection_add_runtime_parameter(connection, name, response->response_data.runtime_parameter_status.param_value);
+            
+            // a standby being promoted isn't something the application did to the session
+            if (strcmp(name, "in_hot_standby") != 0)
+                px_connection_mark_session_state(connection, px_connection_session_state_settings);
+            break;
+        }
+        case px_message_type_notification:
+            px_connection_add_notification(connection, response);
+            break;
+        case px_message_type_parse_complete:
+        case px_message_type_bind_complete:
+        case px_message_type_close_complete:
+            break;
+        default:
+            fprintf(stderr, "unhandled message type: %c %i\n", (char)response->message_class, response->message_type);
+            break;
+    }
+}
+
+static void px_connection_track_command_tag(px_connection *restrict connection, const char *restrict command_tag)
+{
+    // the rest of the session state can only be told from the command text, see px_query_queue
+    if (strcmp(command_tag, "SET") == 0 || strcmp(command_tag, "RESET") == 0)
+        px_connection_mark_session_state(connection, px_connection_session_state_settings);
+    else if (strcmp(command_tag, "LISTEN") == 0)
+        px_connection_mark_session_state(connection, px_connection_session_state_listening);
+    else if (strcmp(command_tag, "DISCARD ALL") == 0)
+        px_connection_clear_session_state(connection);
+    else if (strcmp(command_tag, "DISCARD TEMP") == 0)
+        connection->session_state &= ~(unsigned int)px_connection_session_state_temp_tables;
+}
+
+static void px_connection_add_result(px_connection *restrict connection)
+{
+    if (connection->results.capacity == 0)
+    {
+        connection->results.capacity = 4;
+        connection->results.values = malloc(connection->results.capacity * sizeof(px_result*));
+    }
+    else if (connection->results.count + 1 > connection->results.capacity)
+    {
+        connection->results.capacity *= 2;
+        connection->results.values = realloc(connection->results.values, connection->results.capacity * sizeof(px_result*));
+    }
+    
+    connection->results.current->type_cache = px_type_cache_retain(connection->type_cache);
+    connection->results.values[connection->results.count++] = connection->results.current;
+    connection->results.current = NULL;
+}
+
+static void px_connection_clear_results(px_connection *restrict connection)
+{
+    if (connection->results.current != NULL)
+    {
+        px_result_delete(connection->results.current);
+        connection->results.current = NULL;
+    }
+    
+    for (unsigned int i = connection->results.first; i < connection->results.count; i++)
+    {
+        px_result_delete(connection->results.values[i]);
+    }
+    
+    connection->results.first = 0;
+    connection->results.count = 0;
+    connection->results.busy = false;
 }
 
 bool px_connection_sync(px_connection *restrict connection, const bool read_response)
 {
-    if (!px_connection_send_sync_message(connection)) return false;
+    px_message *message = px_message_new("ST");
+    const bool sent = px_connection_send_message(connection, message);
+    px_message_delete(message);
+    
+    if (!sent) return false;
     if (read_response)
     {
         px_response *response = px_response_read_with_timeout(connection, -1);
+        while (response != NULL && response->message_type == px_message_type_notification)
+        {
+            px_connection_add_notification(connection, response);
+            px_response_delete(response);
+            response = px_response_read_with_timeout(connection, -1);
+        }
+        
+        if (response == NULL) return false;
         const bool ready_for_query = response->message_type == px_message_type_ready_for_query;
         px_response_delete(response);
         return ready_for_query;
@@ -438,48 +1666,263 @@ bool px_connection_sync(px_connection *restrict connection, const bool read_resp
     }
 }
 
-static bool px_connection_send_password_message_md5(const px_connection *restrict connection)
+bool px_connection_cancel(const px_connection *restrict connection)
+{
+    px_connection *cancel_request = px_connection_new_cancel_request(connection);
+    if (cancel_request == NULL)
+        return false;
+    
+    const uint64_t deadline = px_get_monotonic_time() + (uint64_t)px_connection_cancel_timeout;
+    px_connection_flush_result flush_result;
+    
+    while ((flush_result = px_connection_flush(cancel_request)) == px_connection_flush_result_pending &&
+           px_connection_wait_until(cancel_request->socket_number, POLLOUT, deadline));
+    
+    // the server closes the connection once it has processed the request
+    const bool sent = flush_result == px_connection_flush_result_done;
+    if (sent && px_connection_wait_until(cancel_request->socket_number, POLLIN, deadline))
+    {
+        char byte;
+        while (read(cancel_request->socket_number, &byte, 1) == -1 && errno == EINTR);
+    }
+    
+    px_connection_delete(cancel_request);
+    return sent;
+}
+
+px_connection *px_connection_new_cancel_request(const px_connection *restrict connection)
+{
+    if (connection->connection_status != px_connection_status_open || connection->backend_process_id == 0)
+        return NULL;
+    
+    // the cancel request goes to the same server over a new connection
+    struct sockaddr_storage address;
+    socklen_t address_length = sizeof(address);
+    if (getpeername(connection->socket_number, (struct sockaddr *)&address, &address_length) == -1)
+        return NULL;
+    
+    const int socket_number = socket(address.ss_family, SOCK_STREAM, 0);
+    if (socket_number == -1)
+        return NULL;
+    
+    const int flags = fcntl(socket_number, F_GETFL, 0);
+    if (flags == -1 || fcntl(socket_number, F_SETFL, flags | O_NONBLOCK) == -1 ||
+        (connect(socket_number, (const struct sockaddr *)&address, address_length) == -1 && errno != EINPROGRESS))
+    {
+        close(socket_number);
+        return NULL;
+    }
+    
+    // it never gets any further than opening, closing it just closes the socket
+    px_connection *cancel_request = px_connection_new_with_shared_params(connection->connection_params);
+    cancel_request->socket_number = socket_number;
+    cancel_request->connection_status = px_connection_status_opening;
+    
+    px_message *message = px_message_new("0Tiii",
+                                         px_connection_cancel_request_code,
+                                         connection->backend_process_id,
+                                         connection->backend_secret_key);
+    px_connection_queue_message(cancel_request, message);
+    px_message_delete(message);
+    
+    return cancel_request;
+}
+
+bool px_connection_expire_query(px_connection *restrict connection, px_connection **restrict cancel_request)
+{
+    // the first time around the query is cancelled and the connection is given some time to drain
+    if (!connection->deadline.cancelled)
+    {
+        connection->deadline.cancelled = true;
+        connection->deadline.at = px_get_monotonic_time() + (uint64_t)px_connection_cancel_timeout;
+        
+        if (cancel_request == NULL ? px_connection_cancel(connection) : (*cancel_request = px_connection_new_cancel_request(connection)) != NULL)
+            return true;
+    }
+    
+    // the state of the protocol is unknown once a query has been abandoned half way
+    px_connection_close(connection);
+    connection->connection_status = px_connection_status_failed;
+    px_connection_set_last_error(connection, px_error_new_custom("57014", "canceling statement due to query deadline"));
+    return false;
+}
+
+static bool px_connection_wait_until(const int socket_number, const short events, const uint64_t deadline)
+{
+    struct pollfd fd = (struct pollfd)
+    {
+        .fd = socket_number,
+        .events = events,
+        .revents = 0
+    };
+    
+    while (true)
+    {
+        const uint64_t now = px_get_monotonic_time();
+        if (now >= deadline)
+            return false;
+        
+        const int poll_result = poll(&fd, 1, (int)(deadline - now));
+        if (poll_result == 1)
+            return (fd.revents & (POLLERR | POLLNVAL)) == 0 || (events & POLLIN);
+        
+        if (poll_result == 0 || errno != EINTR)
+            return false;
+    }
+}
+
+static bool px_connection_queue_password_message_md5(px_connection *restrict connection)
 {
     unsigned char md5_0[16];
     unsigned char md5_1[16];
     char intermediate[64];
-    char final_hash[64];
-    char md5_response[64];
+    char md5_response[64] = "md5";
     
     const char *password = connection->connection_params->password;
+    const char *username = connection->connection_params->username;
     const char *salt = connection->authentication_details.md5.salt;
     
-    if (password == NULL || salt == NULL)
+    if (password == NULL || username == NULL)
         return false;
     
-    char *password_with_username = malloc(strlen(password) + strlen(connection->connection_params->username) + 1);
-    sprintf(password_with_username, "%s%s", password, connection->connection_params->username);
-    px_security_md5_to_buffer(password_with_username, strlen(password_with_username), md5_0);
-    free(password_with_username);
+    // md5(md5(password || username) || salt), only unusually long credentials need the heap
+    const size_t password_length = strlen(password);
+    const size_t username_length = strlen(username);
+    char stack_buffer[256];
+    char *password_with_username = password_length + username_length <= sizeof(stack_buffer) ?
+        stack_buffer : malloc(password_length + username_length);
+    memcpy(password_with_username, password, password_length);
+    memcpy(password_with_username + password_length, username, username_length);
+    px_security_md5_to_buffer(password_with_username, password_length + username_length, md5_0);
+    memset(password_with_username, 0, password_length);
+    if (password_with_username != stack_buffer)
+        free(password_with_username);
     
     px_security_print_md5(md5_0, intermediate);
     memcpy(intermediate + 32, salt, 4);
     
     px_security_md5_to_buffer(intermediate, 36, md5_1);
-    px_security_print_md5(md5_1, final_hash);
-    sprintf(md5_response, "md5%s", final_hash);
+    px_security_print_md5(md5_1, md5_response + 3);
     
-    return px_connection_send_password_message(connection, md5_response);
+    px_connection_queue_password_message(connection, md5_response);
+    return true;
 }
 
-bool px_connection_poll(const px_connection *restrict connection, const int timeout)
+static bool px_connection_queue_scram_client_first_message(px_connection *restrict connection)
+{
+    px_scram *scram = px_scram_new();
+    if (scram == NULL)
+        return false;
+    
+    connection->authentication_details.scram.exchange = scram;
+    
+    char *client_first = px_scram_get_client_first_message(scram);
+    const size_t length = strlen(client_first);
+    px_message *message = px_message_new("pTsib", px_connection_scram_mechanism, (unsigned int)length, client_first, length);
+    px_connection_queue_message(connection, message);
+    px_message_delete(message);
+    free(client_first);
+    
+    return true;
+}
+
+static px_connection_polling_status px_connection_open_continue_scram(px_connection *restrict connection, const px_response *restrict response)
+{
+    px_scram *scram = connection->authentication_method == PXAuthenticationMethodSCRAMSHA256 ? connection->authentication_details.scram.exchange : NULL;
+    
+    // the salted password comes from the cache of the params whenever the server sent the same salt before
+    char *client_final = scram == NULL ? NULL :
+        px_scram_process_server_first_message(scram,
+                                              connection->connection_params->scram_cache,
+                                              connection->connection_params->password,
+                                              response->response_data.authentication_sasl.data,
+                                              response->response_data.authentication_sasl.length);
+    if (client_final == NULL)
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("08P01", "invalid SCRAM message from the server"));
+        return px_connection_open_fail(connection, px_connection_attempt_result_authentication_failed);
+    }
+    
+    px_message *message = px_message_new("pTb", client_final, strlen(client_final));
+    px_connection_queue_message(connection, message);
+    px_message_delete(message);
+    free(client_final);
+    
+    return px_connection_polling_status_reading;
+}
+
+static px_connection_polling_status px_connection_open_finish_scram(px_connection *restrict connection, const px_response *restrict response)
 {
+    const px_scram *scram = connection->authentication_method == PXAuthenticationMethodSCRAMSHA256 ? connection->authentication_details.scram.exchange : NULL;
+    
+    // a server that doesn't know the password must not be trusted with the session
+    if (scram == NULL ||
+        !px_scram_verify_server_final_message(scram,
+                                              response->response_data.authentication_sasl.data,
+                                              response->response_data.authentication_sasl.length))
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("28000", "invalid SCRAM server signature"));
+        return px_connection_open_fail(connection, px_connection_attempt_result_authentication_failed);
+    }
+    
+    px_connection_clear_authentication_details(connection);
+    return px_connection_polling_status_reading;
+}
+
+static bool px_connection_supports_sasl_mechanism(const px_response *restrict response, const char *restrict mechanism)
+{
+    // a list of terminated names, ending with an empty one
+    const char *name = response->response_data.authentication_sasl.data;
+    const char *end = name + response->response_data.authentication_sasl.length;
+    
+    while (name < end && *name != '\0')
+    {
+        const size_t length = strnlen(name, (size_t)(end - name));
+        if (name + length < end && strcmp(name, mechanism) == 0)
+            return true;
+        
+        name += length + 1;
+    }
+    
+    return false;
+}
+
+static void px_connection_clear_authentication_details(px_connection *restrict connection)
+{
+    if (connection->authentication_method == PXAuthenticationMethodSCRAMSHA256 && connection->authentication_details.scram.exchange != NULL)
+        px_scram_delete(connection->authentication_details.scram.exchange);
+    
+    memset(&connection->authentication_details, 0, sizeof(connection->authentication_details));
+}
+
+bool px_connection_wait(const px_connection *restrict connection, const short events, const int timeout)
+{
+    if (connection->socket_number == -1)
+        return false;
+    
     struct pollfd fd = (struct pollfd)
     {
         .fd = connection->socket_number,
-        .events = POLLIN,
+        .events = events,
         .revents = 0
     };
     
-    return poll(&fd, 1, timeout) == 1;
+    int poll_result;
+    do
+    {
+        poll_result = poll(&fd, 1, timeout);
+    }
+    while (poll_result == -1 && errno == EINTR);
+    
+    return poll_result == 1;
+}
+
+bool px_connection_poll(const px_connection *restrict connection, const int timeout)
+{
+    return px_connection_wait(connection, POLLIN, timeout);
 }
 
 bool px_connection_has_incoming_data(const px_connection *restrict connection)
 {
-    return px_connection_poll(connection, 0);
+    return px_buffer_get_length(&connection->input_buffer) > 0 || px_connection_poll(connection, 0);
 }
@@ -10,9 +10,15 @@
 #define libpx_connection_h
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include "typedef.h"
+#include "buffer.h"
+#include "response.h"
+
+// connection attempts to different addresses of a host that can be in flight at the same time
+#define PX_CONNECTION_MAX_ATTEMPTS 8
 
 typedef enum px_connection_status
 {
@@ -26,7 +32,8 @@ typedef enum px_connection_status
 typedef enum px_authentication_method
 {
     PXAuthenticationMethodNone,
-    PXAuthenticationMethodMD5
+    PXAuthenticationMethodMD5,
+    PXAuthenticationMethodSCRAMSHA256
 } px_authentication_method;
 
 typedef enum px_connection_attempt_result
@@ -39,28 +46,77 @@ typedef enum px_connection_attempt_result
     px_connection_attempt_result_cannot_send_startup_message = 5,
     px_connection_attempt_result_startup_timeout = 6,
     px_connection_attempt_result_unrecognized_server_message = 7,
-    px_connection_attempt_result_server_error = 8
+    px_connection_attempt_result_server_error = 8,
+    px_connection_attempt_result_session_type_mismatch = 9,
+    px_connection_attempt_result_ssl_failed = 10
 } px_connection_attempt_result;
 
+typedef enum px_connection_polling_status
+{
+    px_connection_polling_status_failed = -1,
+    px_connection_polling_status_ok = 0,
+    px_connection_polling_status_reading = 1,
+    px_connection_polling_status_writing = 2
+} px_connection_polling_status;
+
+typedef enum px_connection_open_state
+{
+    px_connection_open_state_idle = 0,
+    px_connection_open_state_connecting,
+    px_connection_open_state_authenticating,
+    px_connection_open_state_password_needed,
+    px_connection_open_state_starting_up,
+    px_connection_open_state_ssl_requested,
+    px_connection_open_state_ssl_handshaking
+} px_connection_open_state;
+
+// what has been changed about the session since it was opened, so that a pool only has to reset that
+typedef enum px_connection_session_state
+{
+    px_connection_session_state_clean = 0,
+    px_connection_session_state_settings = 1 << 0,          // SET, RESET, set_config() or a change reported by the server
+    px_connection_session_state_listening = 1 << 1,         // LISTEN
+    px_connection_session_state_temp_tables = 1 << 2,       // CREATE TEMP TABLE and the like
+    px_connection_session_state_advisory_locks = 1 << 3,    // session-level advisory locks
+    px_connection_session_state_held_cursors = 1 << 4       // cursors declared WITH HOLD
+} px_connection_session_state;
+
+typedef enum px_connection_flush_result
+{
+    px_connection_flush_result_failed = -1,
+    px_connection_flush_result_done = 0,
+    px_connection_flush_result_pending = 1
+} px_connection_flush_result;
+
 typedef struct px_connection_runtime_parameter_entry
 {
     char *name;
     char *value;
+    uint32_t hash;
 } px_connection_runtime_parameter_entry;
 
+// an open addressing hash table keyed by parameter name, its capacity is a power of two
 typedef struct px_connection_runtime_params
 {
     size_t count;
     size_t capacity;
     px_connection_runtime_parameter_entry* params;
+    
+    // the parameters decoding depends on, kept up to date along with the table
+    int server_version_number;
+    bool integer_datetimes;
+    bool client_encoding_utf8;
 } px_connection_runtime_params;
 
 typedef bool PXPasswordCallback(const px_connection* connection, void *context);
+typedef bool PXNotificationCallback(px_connection *connection, const px_notification *notification, void *context);
 
 struct px_connection
 {
     px_connection_params *connection_params;
     px_connection_status connection_status;
+    px_connection_open_state open_state;
+    px_connection_attempt_result attempt_result;
     px_authentication_method authentication_method;
     px_connection_runtime_params runtime_params;
     px_error *last_error;
@@ -69,6 +125,74 @@ struct px_connection
     int backend_secret_key;
     PXPasswordCallback *password_callback;
     void *password_callback_context;
+    PXNotificationCallback *notification_callback;
+    void *notification_callback_context;
+    px_buffer input_buffer;
+    px_buffer output_buffer;
+    px_transaction_status transaction_status;
+    unsigned int session_state;
+    
+    // TLS session of the connection once the server agreed to encrypt it, all I/O goes through it
+    px_tls *tls;
+    
+    // host of the connection params the connection is opened to. prefer-standby goes around
+    // the hosts a second time accepting any server
+    struct
+    {
+        unsigned int index;
+        bool any_session;
+    } host;
+    
+    // connection attempts in flight to the addresses of the host, staggered as in RFC 8305.
+    // the newest one is the socket of the connection until one of them succeeds
+    struct
+    {
+        px_address_list *addresses;
+        unsigned int next;
+        unsigned int count;
+        int sockets[PX_CONNECTION_MAX_ATTEMPTS];
+        uint64_t next_attempt;
+        uint64_t deadline;
+    } connecting;
+    
+    // bumped whenever the socket changes while opening, so that event loops know to watch the new one
+    unsigned int socket_generation;
+    
+    // pool and slot holding this connection when it belongs to a pool
+    px_pool *pool;
+    unsigned int pool_slot;
+    
+    // set while the connection is driven by a reactor
+    px_reactor_entry *reactor_entry;
+    
+    // types of the server, usually shared with the other connections of a pool; a reference is held
+    px_type_cache *type_cache;
+    
+    // results of the query in flight that haven't been picked up yet
+    struct
+    {
+        bool busy;
+        px_result *current;
+        unsigned int first;
+        unsigned int count;
+        unsigned int capacity;
+        px_result **values;
+    } results;
+    
+    // notifications received that haven't been picked up yet, oldest first
+    struct
+    {
+        px_notification *first;
+        px_notification *last;
+        unsigned int count;
+    } notifications;
+    
+    // deadline of the query in flight (0 when it has none) and whether it has been cancelled for missing it
+    struct
+    {
+        uint64_t at;
+        bool cancelled;
+    } deadline;
     
     union
     {
@@ -76,11 +200,16 @@ struct px_connection
         {
             char salt[4];
         } md5;
+        struct
+        {
+            px_scram *exchange;
+        } scram;
     } authentication_details;
 };
 
 // creation & deletion
 px_connection *px_connection_new(const px_connection_params *restrict connection_params);
+px_connection *px_connection_new_with_shared_params(px_connection_params *connection_params);
 void px_connection_delete(px_connection *connection);
 
 // opening & closing a connection
@@ -89,21 +218,67 @@ void px_connection_close(px_connection *restrict connection);
 
 px_connection_attempt_result px_connection_authenticate(px_connection *restrict connection);
 
+// opening a connection without blocking
+bool px_connection_open_start(px_connection *restrict connection);
+px_connection_polling_status px_connection_open_poll(px_connection *restrict connection);
+int px_connection_get_open_timeout(const px_connection *restrict connection);
+
 // getting information about a connection
 px_connection_status px_connection_get_status(const px_connection *restrict connection) __attribute__((pure));
 px_connection_params *px_connection_get_connection_params(const px_connection *restrict connection) __attribute__((pure));
 const px_error *px_connection_get_last_error(const px_connection *restrict connection) __attribute__((pure));
+px_connection_attempt_result px_connection_get_attempt_result(const px_connection *restrict connection) __attribute__((pure));
+int px_connection_get_socket(const px_connection *restrict connection) __attribute__((pure));
+const char *px_connection_get_host(const px_connection *restrict connection) __attribute__((pure));
+bool px_connection_is_encrypted(const px_connection *restrict connection) __attribute__((pure));
+bool px_connection_is_kernel_tls(const px_connection *restrict connection);
+unsigned int px_connection_get_session_state(const px_connection *restrict connection) __attribute__((pure));
+px_type_cache *px_connection_get_type_cache(const px_connection *restrict connection) __attribute__((pure));
+const char *px_connection_get_runtime_parameter(const px_connection *restrict connection, const char *restrict name) __attribute__((pure));
+int px_connection_get_server_version_number(const px_connection *restrict connection) __attribute__((pure));
+bool px_connection_has_integer_datetimes(const px_connection *restrict connection) __attribute__((pure));
+bool px_connection_is_client_encoding_utf8(const px_connection *restrict connection) __attribute__((pure));
 
 // connection callbacks
 void px_connection_set_password_callback(px_connection *restrict connection, PXPasswordCallback *callback, void* context);
+void px_connection_set_notification_callback(px_connection *restrict connection, PXNotificationCallback *callback, void *context);
 
 // changing connection properties
 void px_connection_set_last_error(px_connection *restrict connection, px_error *error);
+void px_connection_set_type_cache(px_connection *restrict connection, px_type_cache *type_cache);
+void px_connection_mark_session_state(px_connection *restrict connection, const unsigned int session_state);
+void px_connection_clear_session_state(px_connection *restrict connection);
 
 // sending various messages
+void px_connection_queue_message(px_connection *restrict connection, const px_message *restrict message);
+bool px_connection_send_message(px_connection *restrict connection, const px_message *restrict message);
+px_connection_flush_result px_connection_flush(px_connection *restrict connection);
+bool px_connection_wait_for_flush(px_connection *restrict connection);
 bool px_connection_sync(px_connection *restrict connection, const bool read_response);
 
+// cancelling queries. px_connection_new_cancel_request queues the cancel request on a connection
+// of its own whose socket is still connecting, the request has been delivered once the server
+// closes it. px_connection_expire_query hands one out rather than waiting for it when asked to
+bool px_connection_cancel(const px_connection *restrict connection);
+px_connection *px_connection_new_cancel_request(const px_connection *restrict connection);
+bool px_connection_expire_query(px_connection *restrict connection, px_connection **restrict cancel_request);
+
+// receiving data
+bool px_connection_read_input(px_connection *restrict connection);
+
+// asynchronous query processing
+bool px_connection_consume_input(px_connection *restrict connection);
+void px_connection_fail(px_connection *restrict connection);
+bool px_connection_is_busy(px_connection *restrict connection);
+px_result *px_connection_get_next_result(px_connection *restrict connection);
+
+// notifications
+px_notification *px_connection_get_notification(px_connection *restrict connection);
+px_notification *px_connection_wait_notification(px_connection *restrict connection, const int timeout);
+void px_connection_clear_notifications(px_connection *restrict connection);
+
 // investigate incoming data
+bool px_connection_wait(const px_connection *restrict connection, const short events, const int timeout);
 bool px_connection_poll(const px_connection *restrict connection, const int timeout);
 bool px_connection_has_incoming_data(const px_connection *restrict connection);
 
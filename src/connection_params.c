@@ -10,11 +10,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include "connection_params.h"
+#include "address.h"
+#include "scram.h"
+#include "tls.h"
 #include "utility.h"
 
+static const unsigned int px_connection_params_default_address_ttl = 60;
+
+static void px_connection_params_set_hosts(px_connection_params *restrict connection_params, const char *restrict hostname);
+static void px_connection_params_clear_hosts(px_connection_params *restrict connection_params);
+
 px_connection_params *px_connection_params_new(void)
 {
-    return calloc(1, sizeof(px_connection_params));
+    px_connection_params *connection_params = calloc(1, sizeof(px_connection_params));
+    connection_params->reference_count = 1;
+    connection_params->scram_cache = px_scram_cache_new();
+    connection_params->tls_context = px_tls_context_new();
+    connection_params->address_ttl = px_connection_params_default_address_ttl;
+    px_connection_params_set_hosts(connection_params, NULL);
+    connection_params->tcp_nodelay = true;
+    
+    return connection_params;
 }
 
 px_connection_params *px_connection_params_copy(const px_connection_params *restrict old)
@@ -26,12 +42,37 @@ px_connection_params *px_connection_params_copy(const px_connection_params *rest
     px_connection_params_set_username(new, px_connection_params_get_username(old));
     px_connection_params_set_password(new, px_connection_params_get_password(old));
     px_connection_params_set_application_name(new, px_connection_params_get_application_name(old));
+    px_connection_params_set_target_session_type(new, px_connection_params_get_target_session_type(old));
+    px_connection_params_set_address_ttl(new, px_connection_params_get_address_ttl(old));
+    px_connection_params_set_connect_timeout(new, px_connection_params_get_connect_timeout(old));
+    px_connection_params_set_ssl_mode(new, px_connection_params_get_ssl_mode(old));
+    px_connection_params_set_ssl_root_cert(new, px_connection_params_get_ssl_root_cert(old));
+    px_connection_params_set_replication_mode(new, px_connection_params_get_replication_mode(old));
+    px_connection_params_set_tcp_nodelay(new, px_connection_params_get_tcp_nodelay(old));
+    px_connection_params_set_receive_buffer_size(new, px_connection_params_get_receive_buffer_size(old));
+    px_connection_params_set_send_buffer_size(new, px_connection_params_get_send_buffer_size(old));
+    px_connection_params_set_keepalive(new, px_connection_params_get_keepalive(old));
+    px_connection_params_set_keepalive_idle(new, px_connection_params_get_keepalive_idle(old));
+    px_connection_params_set_keepalive_interval(new, px_connection_params_get_keepalive_interval(old));
+    px_connection_params_set_keepalive_count(new, px_connection_params_get_keepalive_count(old));
+    px_connection_params_set_user_timeout(new, px_connection_params_get_user_timeout(old));
     
     return new;
 }
 
+px_connection_params *px_connection_params_retain(px_connection_params *connection_params)
+{
+    __sync_add_and_fetch(&connection_params->reference_count, 1);
+    
+    return connection_params;
+}
+
 void px_connection_params_delete(px_connection_params *connection_params)
 {
+    // only the last reference frees the params
+    if (__sync_sub_and_fetch(&connection_params->reference_count, 1) != 0)
+        return;
+    
     if (connection_params->hostname != NULL)
         free(connection_params->hostname);
     
@@ -47,6 +88,12 @@ void px_connection_params_delete(px_connection_params *connection_params)
     if (connection_params->application_name != NULL)
         free(connection_params->application_name);
     
+    if (connection_params->ssl_root_cert != NULL)
+        free(connection_params->ssl_root_cert);
+    
+    px_connection_params_clear_hosts(connection_params);
+    px_scram_cache_delete(connection_params->scram_cache);
+    px_tls_context_delete(connection_params->tls_context);
     free(connection_params);
 }
 
@@ -57,6 +104,11 @@ const char *px_connection_params_get_hostname(const px_connection_params *restri
 
 void px_connection_params_set_hostname(px_connection_params *restrict connection_params, const char *restrict value)
 {
+    // resumable sessions are kept per host
+    px_tls_context_clear(connection_params->tls_context);
+    px_connection_params_clear_hosts(connection_params);
+    px_connection_params_set_hosts(connection_params, value);
+    
     if (connection_params->hostname != NULL)
     {
         free(connection_params->hostname);
@@ -79,6 +131,8 @@ const char *px_connection_params_get_username(const px_connection_params *restri
 
 void px_connection_params_set_username(px_connection_params *restrict connection_params, const char *restrict value)
 {
+    px_scram_cache_clear(connection_params->scram_cache);
+    
     if (connection_params->username != NULL)
     {
         free(connection_params->username);
@@ -101,6 +155,8 @@ const char *px_connection_params_get_password(const px_connection_params *restri
 
 void px_connection_params_set_password(px_connection_params *restrict connection_params, const char *restrict value)
 {
+    px_scram_cache_clear(connection_params->scram_cache);
+    
     if (connection_params->password != NULL)
     {
         free(connection_params->password);
@@ -145,6 +201,10 @@ unsigned int px_connection_params_get_port(const px_connection_params *restrict
 
 void px_connection_params_set_port(px_connection_params *restrict connection_params, const unsigned int value)
 {
+    for (unsigned int i = 0; i < connection_params->hosts.count; i++)
+        px_address_cache_clear(connection_params->hosts.values[i].address_cache);
+    
+    px_tls_context_clear(connection_params->tls_context);
     connection_params->port = value;
 }
 
@@ -170,3 +230,219 @@ void px_connection_params_set_application_name(px_connection_params *restrict co
     }
 }
 
+px_target_session_type px_connection_params_get_target_session_type(const px_connection_params *restrict connection_params)
+{
+    return connection_params->target_session_type;
+}
+
+void px_connection_params_set_target_session_type(px_connection_params *restrict connection_params, const px_target_session_type value)
+{
+    connection_params->target_session_type = value;
+}
+
+px_replication_mode px_connection_params_get_replication_mode(const px_connection_params *restrict connection_params)
+{
+    return connection_params->replication_mode;
+}
+
+void px_connection_params_set_replication_mode(px_connection_params *restrict connection_params, const px_replication_mode value)
+{
+    connection_params->replication_mode = value;
+}
+
+unsigned int px_connection_params_get_host_count(const px_connection_params *restrict connection_params)
+{
+    return connection_params->hosts.count;
+}
+
+const char *px_connection_params_get_host(const px_connection_params *restrict connection_params, const unsigned int index)
+{
+    return index < connection_params->hosts.count ? connection_params->hosts.values[index].hostname : NULL;
+}
+
+unsigned int px_connection_params_get_address_ttl(const px_connection_params *restrict connection_params)
+{
+    return connection_params->address_ttl;
+}
+
+void px_connection_params_set_address_ttl(px_connection_params *restrict connection_params, const unsigned int value)
+{
+    connection_params->address_ttl = value;
+}
+
+unsigned int px_connection_params_get_connect_timeout(const px_connection_params *restrict connection_params)
+{
+    return connection_params->connect_timeout;
+}
+
+void px_connection_params_set_connect_timeout(px_connection_params *restrict connection_params, const unsigned int value)
+{
+    connection_params->connect_timeout = value;
+}
+
+px_ssl_mode px_connection_params_get_ssl_mode(const px_connection_params *restrict connection_params)
+{
+    return connection_params->ssl_mode;
+}
+
+void px_connection_params_set_ssl_mode(px_connection_params *restrict connection_params, const px_ssl_mode value)
+{
+    px_tls_context_clear(connection_params->tls_context);
+    connection_params->ssl_mode = value;
+}
+
+const char *px_connection_params_get_ssl_root_cert(const px_connection_params *restrict connection_params)
+{
+    return connection_params->ssl_root_cert;
+}
+
+void px_connection_params_set_ssl_root_cert(px_connection_params *restrict connection_params, const char *restrict value)
+{
+    px_tls_context_clear(connection_params->tls_context);
+    
+    if (connection_params->ssl_root_cert != NULL)
+    {
+        free(connection_params->ssl_root_cert);
+    }
+    
+    if (value == NULL)
+    {
+        connection_params->ssl_root_cert = NULL;
+    }
+    else
+    {
+        connection_params->ssl_root_cert = px_copy_string(value);
+    }
+}
+
+bool px_connection_params_get_tcp_nodelay(const px_connection_params *restrict connection_params)
+{
+    return connection_params->tcp_nodelay;
+}
+
+void px_connection_params_set_tcp_nodelay(px_connection_params *restrict connection_params, const bool value)
+{
+    connection_params->tcp_nodelay = value;
+}
+
+int px_connection_params_get_receive_buffer_size(const px_connection_params *restrict connection_params)
+{
+    return connection_params->receive_buffer_size;
+}
+
+void px_connection_params_set_receive_buffer_size(px_connection_params *restrict connection_params, const int value)
+{
+    connection_params->receive_buffer_size = value;
+}
+
+int px_connection_params_get_send_buffer_size(const px_connection_params *restrict connection_params)
+{
+    return connection_params->send_buffer_size;
+}
+
+void px_connection_params_set_send_buffer_size(px_connection_params *restrict connection_params, const int value)
+{
+    connection_params->send_buffer_size = value;
+}
+
+bool px_connection_params_get_keepalive(const px_connection_params *restrict connection_params)
+{
+    return connection_params->keepalive;
+}
+
+void px_connection_params_set_keepalive(px_connection_params *restrict connection_params, const bool value)
+{
+    connection_params->keepalive = value;
+}
+
+unsigned int px_connection_params_get_keepalive_idle(const px_connection_params *restrict connection_params)
+{
+    return connection_params->keepalive_idle;
+}
+
+void px_connection_params_set_keepalive_idle(px_connection_params *restrict connection_params, const unsigned int value)
+{
+    connection_params->keepalive_idle = value;
+}
+
+unsigned int px_connection_params_get_keepalive_interval(const px_connection_params *restrict connection_params)
+{
+    return connection_params->keepalive_interval;
+}
+
+void px_connection_params_set_keepalive_interval(px_connection_params *restrict connection_params, const unsigned int value)
+{
+    connection_params->keepalive_interval = value;
+}
+
+unsigned int px_connection_params_get_keepalive_count(const px_connection_params *restrict connection_params)
+{
+    return connection_params->keepalive_count;
+}
+
+void px_connection_params_set_keepalive_count(px_connection_params *restrict connection_params, const unsigned int value)
+{
+    connection_params->keepalive_count = value;
+}
+
+unsigned int px_connection_params_get_user_timeout(const px_connection_params *restrict connection_params)
+{
+    return connection_params->user_timeout;
+}
+
+void px_connection_params_set_user_timeout(px_connection_params *restrict connection_params, const unsigned int value)
+{
+    connection_params->user_timeout = value;
+}
+
+px_address_list *px_connection_params_resolve(px_connection_params *restrict connection_params, const unsigned int host_index)
+{
+    const px_connection_params_host *host = &connection_params->hosts.values[host_index];
+    return px_address_cache_get(host->address_cache, host->hostname, connection_params->port, connection_params->address_ttl);
+}
+
+static void px_connection_params_set_hosts(px_connection_params *restrict connection_params, const char *restrict hostname)
+{
+    // without a hostname there is still a single host, resolved with the defaults of the system
+    unsigned int count = 1;
+    for (const char *character = hostname; character != NULL && *character != '\0'; character++)
+    {
+        if (*character == ',')
+            count++;
+    }
+    
+    connection_params->hosts.count = count;
+    connection_params->hosts.values = calloc(count, sizeof(px_connection_params_host));
+    
+    const char *start = hostname;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        px_connection_params_host *host = &connection_params->hosts.values[i];
+        host->address_cache = px_address_cache_new();
+        
+        if (start == NULL)
+            continue;
+        
+        const char *end = strchr(start, ',');
+        const size_t length = end == NULL ? strlen(start) : (size_t)(end - start);
+        host->hostname = malloc(length + 1);
+        memcpy(host->hostname, start, length);
+        host->hostname[length] = '\0';
+        start = end == NULL ? NULL : end + 1;
+    }
+}
+
+static void px_connection_params_clear_hosts(px_connection_params *restrict connection_params)
+{
+    for (unsigned int i = 0; i < connection_params->hosts.count; i++)
+    {
+        if (connection_params->hosts.values[i].hostname != NULL)
+            free(connection_params->hosts.values[i].hostname);
+        
+        px_address_cache_delete(connection_params->hosts.values[i].address_cache);
+    }
+    
+    free(connection_params->hosts.values);
+    connection_params->hosts.count = 0;
+    connection_params->hosts.values = NULL;
+}
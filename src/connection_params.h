@@ -8,8 +8,41 @@
 
 #ifndef libpx_connection_params_h
 #define libpx_connection_params_h
+#include <stdbool.h>
 #include "typedef.h"
 
+typedef enum px_target_session_type
+{
+    px_target_session_type_any = 0,
+    px_target_session_type_read_write = 1,
+    px_target_session_type_read_only = 2,
+    px_target_session_type_primary = 3,
+    px_target_session_type_standby = 4,
+    px_target_session_type_prefer_standby = 5
+} px_target_session_type;
+
+typedef enum px_ssl_mode
+{
+    px_ssl_mode_prefer = 0,
+    px_ssl_mode_disable = 1,
+    px_ssl_mode_require = 2,
+    px_ssl_mode_verify_ca = 3,
+    px_ssl_mode_verify_full = 4
+} px_ssl_mode;
+
+typedef enum px_replication_mode
+{
+    px_replication_mode_none = 0,
+    px_replication_mode_physical = 1,
+    px_replication_mode_logical = 2
+} px_replication_mode;
+
+typedef struct px_connection_params_host
+{
+    char *hostname;
+    px_address_cache *address_cache;
+} px_connection_params_host;
+
 struct px_connection_params
 {
     char *hostname;
@@ -18,13 +51,57 @@ struct px_connection_params
     char *username;
     char *password;
     
+    // keys derived from the password for SCRAM authentication, cleared along with the user or the password
+    px_scram_cache *scram_cache;
+    
     char *application_name;
+    
+    // the hostname may be a comma separated list of hosts, they are tried in order until
+    // one of them accepts the connection and matches the target session type
+    struct
+    {
+        unsigned int count;
+        px_connection_params_host *values;
+    } hosts;
+    px_target_session_type target_session_type;
+    
+    // resolved addresses of the hosts, reused for address_ttl seconds
+    unsigned int address_ttl;
+    
+    // milliseconds to wait for connecting to a host before moving on to the next one, 0 waits as long as the system does
+    unsigned int connect_timeout;
+    
+    // TLS is negotiated with TCP hosts only; the certificate of the server is checked against
+    // ssl_root_cert (the default trust store when NULL) in the verify modes
+    px_ssl_mode ssl_mode;
+    char *ssl_root_cert;
+    
+    // set up by the first connection and shared with the others, so that they can resume sessions
+    px_tls_context *tls_context;
+    
+    // replication connections (replication=true or database in the startup message) only accept
+    // simple queries and replication commands
+    px_replication_mode replication_mode;
+    
+    // socket options, only applied to TCP sockets; 0 leaves the system default in place
+    bool tcp_nodelay;
+    int receive_buffer_size;
+    int send_buffer_size;
+    bool keepalive;
+    unsigned int keepalive_idle;
+    unsigned int keepalive_interval;
+    unsigned int keepalive_count;
+    unsigned int user_timeout;
+    
+    // shared by the connections of a pool, see px_connection_params_retain
+    volatile unsigned int reference_count;
 };
 
 // creation, copying & deletion of connection params
 px_connection_params *px_connection_params_new(void);
 px_connection_params *px_connection_params_copy(const px_connection_params *restrict old);
 void px_connection_params_delete(px_connection_params *connection_params);
+px_connection_params *px_connection_params_retain(px_connection_params *connection_params);
 
 // getters & setters of connection params
 const char *px_connection_params_get_hostname(const px_connection_params *restrict connection_params) __attribute__((pure));
@@ -45,4 +122,52 @@ void px_connection_params_set_port(px_connection_params *restrict connection_par
 const char *px_connection_params_get_application_name(const px_connection_params *restrict connection_params) __attribute__((pure));
 void px_connection_params_set_application_name(px_connection_params *restrict connection_params, const char *restrict value);
 
+px_target_session_type px_connection_params_get_target_session_type(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_target_session_type(px_connection_params *restrict connection_params, const px_target_session_type value);
+
+unsigned int px_connection_params_get_host_count(const px_connection_params *restrict connection_params) __attribute__((pure));
+const char *px_connection_params_get_host(const px_connection_params *restrict connection_params, const unsigned int index) __attribute__((pure));
+
+unsigned int px_connection_params_get_address_ttl(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_address_ttl(px_connection_params *restrict connection_params, const unsigned int value);
+
+unsigned int px_connection_params_get_connect_timeout(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_connect_timeout(px_connection_params *restrict connection_params, const unsigned int value);
+
+px_ssl_mode px_connection_params_get_ssl_mode(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_ssl_mode(px_connection_params *restrict connection_params, const px_ssl_mode value);
+
+const char *px_connection_params_get_ssl_root_cert(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_ssl_root_cert(px_connection_params *restrict connection_params, const char *restrict value);
+
+px_replication_mode px_connection_params_get_replication_mode(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_replication_mode(px_connection_params *restrict connection_params, const px_replication_mode value);
+
+bool px_connection_params_get_tcp_nodelay(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_tcp_nodelay(px_connection_params *restrict connection_params, const bool value);
+
+int px_connection_params_get_receive_buffer_size(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_receive_buffer_size(px_connection_params *restrict connection_params, const int value);
+
+int px_connection_params_get_send_buffer_size(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_send_buffer_size(px_connection_params *restrict connection_params, const int value);
+
+bool px_connection_params_get_keepalive(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_keepalive(px_connection_params *restrict connection_params, const bool value);
+
+unsigned int px_connection_params_get_keepalive_idle(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_keepalive_idle(px_connection_params *restrict connection_params, const unsigned int value);
+
+unsigned int px_connection_params_get_keepalive_interval(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_keepalive_interval(px_connection_params *restrict connection_params, const unsigned int value);
+
+unsigned int px_connection_params_get_keepalive_count(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_keepalive_count(px_connection_params *restrict connection_params, const unsigned int value);
+
+unsigned int px_connection_params_get_user_timeout(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_user_timeout(px_connection_params *restrict connection_params, const unsigned int value);
+
+// resolving the hosts
+px_address_list *px_connection_params_resolve(px_connection_params *restrict connection_params, const unsigned int host_index);
+
 #endif /* libpx_connection_params_h */
@@ -44,10 +44,16 @@ typedef enum px_datatype
     px_data_type_macaddress        = 829,
     px_data_type_inet              = 869,
     px_data_type_net               = 650,
+    px_data_type_boola             = 1000,
+    px_data_type_namea             = 1003,
     px_data_type_int16au           = 1005,
     px_data_type_int32a            = 1007,
     px_data_type_texta             = 1009,
+    px_data_type_charna            = 1014,
+    px_data_type_varcharna         = 1015,
+    px_data_type_int64a            = 1016,
     px_data_type_floata            = 1021,
+    px_data_type_doublea           = 1022,
     px_data_type_oidau             = 1028,
     px_data_type_acl               = 1033,
     px_data_type_acla              = 1034,
@@ -57,11 +63,15 @@ typedef enum px_datatype
     px_data_type_date              = 1082,
     px_data_type_time              = 1083,
     px_data_type_timestamp         = 1114,
+    px_data_type_timestampa        = 1115,
+    px_data_type_datea             = 1182,
     px_data_type_timestampz        = 1184,
+    px_data_type_timestampza       = 1185,
     px_data_type_interval          = 1186,
     px_data_type_timez             = 1266,
     px_data_type_fixbitstring      = 1560,
     px_data_type_varbitstring      = 1562,
+    px_data_type_numerica          = 1231,
     px_data_type_numeric           = 1700,
     px_data_type_refcursor         = 2202,
     px_data_type_regop             = 2203,
@@ -70,6 +80,7 @@ typedef enum px_datatype
     px_data_type_regtype           = 2206,
     px_data_type_regtypea          = 2211,
     px_data_type_uuid              = 2950,
+    px_data_type_uuida             = 2951,
     // To be continued ...
 } px_datatype;
 
@@ -22,8 +22,6 @@ typedef union
 
 static void px_message_build_message_data(const char *restrict pattern, void** parameters, unsigned int *parameter_cursor, size_t *message_length, size_t *message_buffer_size, void **message, unsigned int *length_offset, bool is_sub_pattern);
 
-static px_message *px_message_new_sync(void);
-
 px_message *px_message_new(const char *restrict pattern, ...)
 {
     const size_t pattern_length = strlen(pattern); 
@@ -90,7 +88,7 @@ px_message *px_message_new(const char *restrict pattern, ...)
             }
         }
         
-        if (message_length + data_length < message_buffer_size)
+        while (message_length + data_length > message_buffer_size)
         {
             message_buffer_size *= 2;
             message = realloc(message, message_buffer_size);
@@ -131,7 +129,7 @@ px_message *px_message_new_with_array(const char *restrict pattern, void** param
 static void px_message_build_message_data(const char *restrict pattern, void** parameters, unsigned int *parameter_cursor, size_t *message_length, size_t *message_buffer_size, void **message, unsigned int *length_offset, bool is_sub_pattern)
 {
     const size_t pattern_length = strlen(pattern); 
-
+    
     for (unsigned int i = 0; i < pattern_length; i++)
     {
         stack_values values;
@@ -186,7 +184,7 @@ static void px_message_build_message_data(const char *restrict pattern, void** p
                 {
                     const char *string = (char*)parameters[(*parameter_cursor)++];
                     data = (void*)string;
-                    data_length = strlen(string);
+                    data_length = string == NULL ? 0 : strlen(string);
                     break;
                 }
                 case 'b':
@@ -227,8 +225,9 @@ static void px_message_build_message_data(const char *restrict pattern, void** p
                         }
                         
                         const unsigned int sub_pattern_length = closing_parenthesis_position - i + 1 - 2;
-                        char *sub_pattern = malloc(sub_pattern_length * sizeof(char));
+                        char *sub_pattern = malloc((sub_pattern_length + 1) * sizeof(char));
                         memcpy(sub_pattern, pattern + i + 1, sub_pattern_length);
+                        sub_pattern[sub_pattern_length] = 0;
                         
                         for (unsigned int j = 0; j < subpattern_count; j++)
                         {
@@ -242,6 +241,7 @@ static void px_message_build_message_data(const char *restrict pattern, void** p
                         fprintf(stderr, "Invalid px_message pattern\n");
                         return;
                     }
+                    break;
                 }
                 default:
                     fprintf(stderr, "Unhandled px_message pattern: %c\n", pattern[i]);
@@ -249,7 +249,7 @@ static void px_message_build_message_data(const char *restrict pattern, void** p
             }
         }
         
-        if (message_length + data_length < message_buffer_size)
+        while (*message_length + data_length > *message_buffer_size)
         {
             *message_buffer_size *= 2;
             *message = realloc(*message, *message_buffer_size);
@@ -265,22 +265,3 @@ void px_message_delete(px_message *message)
     free(message);
 }
 
-bool px_message_send(const px_message *restrict message, const int file_descriptor)
-{
-    const ssize_t bytes_written = write(file_descriptor, message->messageBytes, message->messageLength);
-    return bytes_written != -1 && bytes_written == message->messageLength;
-}
-
-static px_message *px_message_new_sync(void)
-{
-    return px_message_new("ST");
-}
-
-bool px_message_send_sync(const int file_descriptor)
-{
-    px_message *message = px_message_new_sync();
-    const bool success = px_message_send(message, file_descriptor);
-    px_message_delete(message);
-    return success;
-}
-
@@ -24,8 +24,4 @@ px_message *px_message_new(const char *restrict pattern, ...);
 px_message *px_message_new_with_array(const char *restrict pattern, void** parameters);
 void px_message_delete(px_message *message);
 
-bool px_message_send(const px_message *restrict message, const int file_descriptor);
-
-bool px_message_send_sync(const int file_descriptor);
-
 #endif
@@ -13,12 +13,23 @@ typedef enum px_message_type
 {
     px_message_type_authentication_ok,
     px_message_type_authentication_md5_password,
+    px_message_type_authentication_sasl,
+    px_message_type_authentication_sasl_continue,
+    px_message_type_authentication_sasl_final,
+    px_message_type_authentication_unsupported,
     px_message_type_backend_key_data,
     px_message_type_bind_complete,
     px_message_type_close_complete,
     px_message_type_command_complete,
+    px_message_type_copy_both_response,
+    px_message_type_copy_data,
+    px_message_type_copy_done,
+    px_message_type_copy_in_response,
+    px_message_type_copy_out_response,
     px_message_type_data_row,
+    px_message_type_empty_query_response,
     px_message_type_error,
+    px_message_type_notification,
     px_message_type_parameter_status,
     px_message_type_parse_complete,
     px_message_type_ready_for_query,
@@ -33,8 +44,15 @@ typedef enum px_message_class
     px_message_class_close_complete = '3',
     px_message_class_command_complete = 'C',
     px_message_class_data_row = 'D',
+    px_message_class_empty_query_response = 'I',
     px_message_class_error = 'E',
+    px_message_class_copy_both_response = 'W',
+    px_message_class_copy_data = 'd',
+    px_message_class_copy_done = 'c',
+    px_message_class_copy_in_response = 'G',
+    px_message_class_copy_out_response = 'H',
     px_message_class_cancellation_key_data = 'K',
+    px_message_class_notification = 'A',
     px_message_class_authentication_request = 'R',
     px_message_class_runtime_parameter_status_report = 'S',
     px_message_class_row_description = 'T',
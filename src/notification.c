@@ -0,0 +1,51 @@
+//
+//  notification.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "notification.h"
+#include "response.h"
+
+px_notification *px_notification_new(const px_response *restrict response)
+{
+    const char *channel = response->response_data.notification.channel;
+    const char *payload = response->response_data.notification.payload;
+    const size_t channel_length = strlen(channel);
+    const size_t payload_length = strlen(payload);
+    
+    // the strings are stored in the same allocation as the notification
+    px_notification *notification = malloc(sizeof(px_notification) + channel_length + payload_length + 2);
+    notification->process_id = response->response_data.notification.process_id;
+    notification->channel = (char *)(notification + 1);
+    notification->payload = notification->channel + channel_length + 1;
+    notification->next = NULL;
+    memcpy(notification->channel, channel, channel_length + 1);
+    memcpy(notification->payload, payload, payload_length + 1);
+    
+    return notification;
+}
+
+void px_notification_delete(px_notification *notification)
+{
+    free(notification);
+}
+
+int px_notification_get_process_id(const px_notification *restrict notification)
+{
+    return notification->process_id;
+}
+
+const char *px_notification_get_channel(const px_notification *restrict notification)
+{
+    return notification->channel;
+}
+
+const char *px_notification_get_payload(const px_notification *restrict notification)
+{
+    return notification->payload;
+}
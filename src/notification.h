@@ -0,0 +1,33 @@
+//
+//  notification.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_notification_h
+#define libpx_notification_h
+
+#include "typedef.h"
+
+struct px_notification
+{
+    int process_id;
+    char *channel;
+    char *payload;
+    
+    // the next notification in the queue of the connection
+    px_notification *next;
+};
+
+// create & delete
+px_notification *px_notification_new(const px_response *restrict response);
+void px_notification_delete(px_notification *notification);
+
+// getters
+int px_notification_get_process_id(const px_notification *restrict notification) __attribute__((pure));
+const char *px_notification_get_channel(const px_notification *restrict notification) __attribute__((pure));
+const char *px_notification_get_payload(const px_notification *restrict notification) __attribute__((pure));
+
+#endif
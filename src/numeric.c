@@ -0,0 +1,489 @@
+//
+//  numeric.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numeric.h"
+#include "utility.h"
+
+// scaled decimals are built as an unsigned magnitude first, as wide as the widest type decoded
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 px_numeric_magnitude;
+#else
+typedef uint64_t px_numeric_magnitude;
+#endif
+
+typedef struct px_numeric_header
+{
+    int digit_count;
+    int weight;
+    px_numeric_sign sign;
+    unsigned int display_scale;
+    const unsigned char *digits;
+} px_numeric_header;
+
+static bool px_numeric_read_header(const void *restrict data, const size_t length, px_numeric_header *restrict header);
+static unsigned int px_numeric_get_digit(const px_numeric_header *restrict header, const int index) __attribute__((pure));
+static bool px_numeric_decode_magnitude(const px_numeric_header *restrict header, const unsigned int scale, px_numeric_magnitude *restrict magnitude);
+static bool px_numeric_scale_up(px_numeric_magnitude *restrict magnitude, unsigned int shift);
+static size_t px_numeric_measure(const px_numeric_header *restrict header) __attribute__((pure));
+static void px_numeric_write(const px_numeric_header *restrict header, char *restrict text);
+static char *px_numeric_write_group(char *restrict text, const unsigned int digit);
+static const char *px_numeric_get_special_text(const px_numeric_header *restrict header) __attribute__((pure));
+
+static const unsigned int px_numeric_powers_of_ten[] = { 1, 10, 100, 1000, 10000 };
+
+// the powers of ten that doubles represent exactly
+static const double px_numeric_exact_powers_of_ten[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t px_numeric_max_exact_double_mantissa = (uint64_t)1 << 53;
+
+bool px_numeric_decode_int64(const void *restrict data, const size_t length, const unsigned int scale, int64_t *restrict value)
+{
+    px_numeric_header header;
+    px_numeric_magnitude magnitude;
+    
+    if (!px_numeric_read_header(data, length, &header) || !px_numeric_decode_magnitude(&header, scale, &magnitude))
+        return false;
+    
+    if (header.sign == px_numeric_sign_negative)
+    {
+        if (magnitude > (px_numeric_magnitude)INT64_MAX + 1)
+            return false;
+        
+        *value = magnitude == 0 ? 0 : -(int64_t)(magnitude - 1) - 1;
+    }
+    else
+    {
+        if (magnitude > (px_numeric_magnitude)INT64_MAX)
+            return false;
+        
+        *value = (int64_t)magnitude;
+    }
+    
+    return true;
+}
+
+#ifdef __SIZEOF_INT128__
+bool px_numeric_decode_int128(const void *restrict data, const size_t length, const unsigned int scale, __int128 *restrict value)
+{
+    px_numeric_header header;
+    px_numeric_magnitude magnitude;
+    
+    if (!px_numeric_read_header(data, length, &header) || !px_numeric_decode_magnitude(&header, scale, &magnitude))
+        return false;
+    
+    const px_numeric_magnitude max = ((px_numeric_magnitude)1 << 127) - 1;
+    
+    if (header.sign == px_numeric_sign_negative)
+    {
+        if (magnitude > max + 1)
+            return false;
+        
+        *value = magnitude == 0 ? 0 : -(__int128)(magnitude - 1) - 1;
+    }
+    else
+    {
+        if (magnitude > max)
+            return false;
+        
+        *value = (__int128)magnitude;
+    }
+    
+    return true;
+}
+#endif
+
+bool px_numeric_decode_double(const void *restrict data, const size_t length, double *restrict value)
+{
+    px_numeric_header header;
+    if (!px_numeric_read_header(data, length, &header))
+        return false;
+    
+    switch (header.sign)
+    {
+        case px_numeric_sign_nan:
+            *value = NAN;
+            return true;
+        case px_numeric_sign_infinity:
+            *value = INFINITY;
+            return true;
+        case px_numeric_sign_negative_infinity:
+            *value = -INFINITY;
+            return true;
+        default:
+            break;
+    }
+    
+    // trailing zero digits only move the exponent
+    int digit_count = header.digit_count;
+    while (digit_count > 0 && px_numeric_get_digit(&header, digit_count - 1) == 0)
+        digit_count--;
+    
+    if (digit_count == 0)
+    {
+        *value = 0.0;
+        return true;
+    }
+    
+    const int exponent = (header.weight - digit_count + 1) * 4;
+    
+    // exact when the digits fit in the mantissa and the power of ten is exact too (Clinger's fast path)
+    if (digit_count <= 4)
+    {
+        uint64_t mantissa = 0;
+        for (int i = 0; i < digit_count; i++)
+            mantissa = mantissa * 10000 + px_numeric_get_digit(&header, i);
+        
+        if (mantissa <= px_numeric_max_exact_double_mantissa && exponent >= -22 && exponent <= 22)
+        {
+            double result = (double)mantissa;
+            result = exponent >= 0 ? result * px_numeric_exact_powers_of_ten[exponent] : result / px_numeric_exact_powers_of_ten[-exponent];
+            *value = header.sign == px_numeric_sign_negative ? -result : result;
+            return true;
+        }
+    }
+    
+    // everything else is rounded by strtod, from the digits and the exponent without a decimal point
+    // so that the locale doesn't matter
+    char buffer[128];
+    const size_t size = 1 + (size_t)digit_count * 4 + 16;
+    char *text = size <= sizeof(buffer) ? buffer : malloc(size);
+    char *end = text;
+    
+    if (header.sign == px_numeric_sign_negative)
+        *end++ = '-';
+    
+    for (int i = 0; i < digit_count; i++)
+        end = px_numeric_write_group(end, px_numeric_get_digit(&header, i));
+    
+    sprintf(end, "e%d", exponent);
+    *value = strtod(text, NULL);
+    
+    if (text != buffer)
+        free(text);
+    
+    return true;
+}
+
+size_t px_numeric_format(const void *restrict data, const size_t length, char *restrict text, const size_t size)
+{
+    px_numeric_header header;
+    if (!px_numeric_read_header(data, length, &header))
+    {
+        if (size > 0)
+            text[0] = '\0';
+        return 0;
+    }
+    
+    const char *special_text = px_numeric_get_special_text(&header);
+    if (special_text != NULL)
+        return (size_t)snprintf(text, size, "%s", special_text);
+    
+    const size_t text_length = px_numeric_measure(&header);
+    if (text_length < size)
+    {
+        px_numeric_write(&header, text);
+    }
+    else if (size > 0)
+    {
+        char *whole_text = malloc(text_length + 1);
+        px_numeric_write(&header, whole_text);
+        memcpy(text, whole_text, size - 1);
+        text[size - 1] = '\0';
+        free(whole_text);
+    }
+    
+    return text_length;
+}
+
+char *px_numeric_copy_string(const void *restrict data, const size_t length)
+{
+    const size_t text_length = px_numeric_format(data, length, NULL, 0);
+    if (text_length == 0)
+        return NULL;
+    
+    char *text = malloc(text_length + 1);
+    px_numeric_format(data, length, text, text_length + 1);
+    
+    return text;
+}
+
+bool px_numeric_parse_int64(const char *restrict text, const size_t length, const unsigned int scale, int64_t *restrict value)
+{
+    const char *character = text;
+    const char *end = text + length;
+    
+    bool negative = false;
+    if (character < end && (*character == '-' || *character == '+'))
+        negative = *character++ == '-';
+    
+    uint64_t magnitude = 0;
+    unsigned int decimals = 0;
+    bool has_digits = false;
+    bool has_point = false;
+    bool rounded = false;
+    bool round_up = false;
+    
+    for (; character < end; character++)
+    {
+        if (*character == '.' && !has_point)
+        {
+            has_point = true;
+            continue;
+        }
+        
+        if (*character < '0' || *character > '9')
+            return false;
+        
+        has_digits = true;
+        
+        // only the first digit beyond the scale decides the rounding
+        if (has_point && decimals == scale)
+        {
+            if (!rounded)
+                round_up = *character >= '5';
+            rounded = true;
+            continue;
+        }
+        
+        if (__builtin_mul_overflow(magnitude, 10, &magnitude) || __builtin_add_overflow(magnitude, (uint64_t)(*character - '0'), &magnitude))
+            return false;
+        
+        if (has_point)
+            decimals++;
+    }
+    
+    if (!has_digits)
+        return false;
+    
+    for (; decimals < scale; decimals++)
+    {
+        if (__builtin_mul_overflow(magnitude, 10, &magnitude))
+            return false;
+    }
+    
+    if (round_up && __builtin_add_overflow(magnitude, 1, &magnitude))
+        return false;
+    
+    if (negative)
+    {
+        if (magnitude > (uint64_t)INT64_MAX + 1)
+            return false;
+        
+        *value = magnitude == 0 ? 0 : -(int64_t)(magnitude - 1) - 1;
+    }
+    else
+    {
+        if (magnitude > (uint64_t)INT64_MAX)
+            return false;
+        
+        *value = (int64_t)magnitude;
+    }
+    
+    return true;
+}
+
+static bool px_numeric_read_header(const void *restrict data, const size_t length, px_numeric_header *restrict header)
+{
+    if (length < 8)
+        return false;
+    
+    const unsigned char *bytes = data;
+    header->digit_count = (int16_t)px_read_network_uint16(bytes);
+    header->weight = (int16_t)px_read_network_uint16(bytes + 2);
+    header->sign = (px_numeric_sign)px_read_network_uint16(bytes + 4);
+    header->display_scale = px_read_network_uint16(bytes + 6);
+    header->digits = bytes + 8;
+    
+    if (header->digit_count < 0 || length != 8 + (size_t)header->digit_count * 2)
+        return false;
+    
+    switch (header->sign)
+    {
+        case px_numeric_sign_positive:
+        case px_numeric_sign_negative:
+        case px_numeric_sign_nan:
+        case px_numeric_sign_infinity:
+        case px_numeric_sign_negative_infinity:
+            break;
+        default:
+            return false;
+    }
+    
+    for (int i = 0; i < header->digit_count; i++)
+    {
+        if (px_numeric_get_digit(header, i) >= 10000)
+            return false;
+    }
+    
+    return true;
+}
+
+static unsigned int px_numeric_get_digit(const px_numeric_header *restrict header, const int index)
+{
+    return px_read_network_uint16(header->digits + index * 2);
+}
+
+static bool px_numeric_decode_magnitude(const px_numeric_header *restrict header, const unsigned int scale, px_numeric_magnitude *restrict magnitude)
+{
+    if (header->sign != px_numeric_sign_positive && header->sign != px_numeric_sign_negative)
+        return false;
+    
+    // the decimal exponent of the last digit taken, which ends up at 10^-scale at most
+    const int lowest_exponent = -(int)scale;
+    int exponent = (header->weight + 1) * 4;
+    bool round_up = false;
+    
+    *magnitude = 0;
+    
+    for (int i = 0; i < header->digit_count; i++)
+    {
+        const unsigned int digit = px_numeric_get_digit(header, i);
+        const int kept = exponent - lowest_exponent;
+        
+        if (kept >= 4)
+        {
+            if (__builtin_mul_overflow(*magnitude, 10000, magnitude) || __builtin_add_overflow(*magnitude, digit, magnitude))
+                return false;
+            
+            exponent -= 4;
+            continue;
+        }
+        
+        // the digit is cut at the scale, the first decimal dropped rounds it
+        if (kept > 0)
+        {
+            if (__builtin_mul_overflow(*magnitude, px_numeric_powers_of_ten[kept], magnitude)
+                || __builtin_add_overflow(*magnitude, digit / px_numeric_powers_of_ten[4 - kept], magnitude))
+            {
+                return false;
+            }
+            
+            round_up = (digit / px_numeric_powers_of_ten[3 - kept]) % 10 >= 5;
+            exponent = lowest_exponent;
+        }
+        else if (kept == 0)
+        {
+            round_up = digit >= 5000;
+        }
+        
+        break;
+    }
+    
+    // the zeros after the last digit down to the scale
+    if (exponent > lowest_exponent && !px_numeric_scale_up(magnitude, (unsigned int)(exponent - lowest_exponent)))
+        return false;
+    
+    return !round_up || !__builtin_add_overflow(*magnitude, 1, magnitude);
+}
+
+static bool px_numeric_scale_up(px_numeric_magnitude *restrict magnitude, unsigned int shift)
+{
+    if (*magnitude == 0)
+        return true;
+    
+    for (; shift >= 4; shift -= 4)
+    {
+        if (__builtin_mul_overflow(*magnitude, 10000, magnitude))
+            return false;
+    }
+    
+    return !__builtin_mul_overflow(*magnitude, px_numeric_powers_of_ten[shift], magnitude);
+}
+
+static size_t px_numeric_measure(const px_numeric_header *restrict header)
+{
+    size_t length = header->sign == px_numeric_sign_negative ? 1 : 0;
+    
+    if (header->weight < 0 || header->digit_count == 0)
+    {
+        length += 1;
+    }
+    else
+    {
+        const unsigned int first_digit = px_numeric_get_digit(header, 0);
+        length += (first_digit >= 1000 ? 4 : first_digit >= 100 ? 3 : first_digit >= 10 ? 2 : 1) + (size_t)header->weight * 4;
+    }
+    
+    if (header->display_scale > 0)
+        length += 1 + header->display_scale;
+    
+    return length;
+}
+
+static void px_numeric_write(const px_numeric_header *restrict header, char *restrict text)
+{
+    char *end = text;
+    
+    if (header->sign == px_numeric_sign_negative)
+        *end++ = '-';
+    
+    // the integral part: the first digit without its leading zeros, zeros for digits beyond the last
+    if (header->weight < 0 || header->digit_count == 0)
+    {
+        *end++ = '0';
+    }
+    else
+    {
+        end += sprintf(end, "%u", px_numeric_get_digit(header, 0));
+        
+        for (int i = 1; i <= header->weight; i++)
+            end = px_numeric_write_group(end, i < header->digit_count ? px_numeric_get_digit(header, i) : 0);
+    }
+    
+    // as many decimals as the display scale, the last digit written may have to be cut
+    if (header->display_scale > 0)
+    {
+        *end++ = '.';
+        
+        unsigned int decimals = 0;
+        for (int i = header->weight + 1; decimals < header->display_scale; i++)
+        {
+            const unsigned int digit = i >= 0 && i < header->digit_count ? px_numeric_get_digit(header, i) : 0;
+            char group[4];
+            px_numeric_write_group(group, digit);
+            
+            for (unsigned int j = 0; j < 4 && decimals < header->display_scale; j++, decimals++)
+                *end++ = group[j];
+        }
+    }
+    
+    *end = '\0';
+}
+
+static char *px_numeric_write_group(char *restrict text, const unsigned int digit)
+{
+    text[0] = (char)('0' + digit / 1000);
+    text[1] = (char)('0' + digit / 100 % 10);
+    text[2] = (char)('0' + digit / 10 % 10);
+    text[3] = (char)('0' + digit % 10);
+    
+    return text + 4;
+}
+
+static const char *px_numeric_get_special_text(const px_numeric_header *restrict header)
+{
+    switch (header->sign)
+    {
+        case px_numeric_sign_nan:
+            return "NaN";
+        case px_numeric_sign_infinity:
+            return "Infinity";
+        case px_numeric_sign_negative_infinity:
+            return "-Infinity";
+        default:
+            return NULL;
+    }
+}
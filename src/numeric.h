@@ -0,0 +1,47 @@
+//
+//  numeric.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_numeric_h
+#define libpx_numeric_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// the binary form of numeric values: the number of digits, the weight of the first digit, the sign
+// and the display scale as 16 bit integers, followed by the digits in base 10000, most significant first.
+// the value is the sum of digit[i] * 10000^(weight - i)
+typedef enum px_numeric_sign
+{
+    px_numeric_sign_positive = 0x0000,
+    px_numeric_sign_negative = 0x4000,
+    px_numeric_sign_nan = 0xC000,
+    px_numeric_sign_infinity = 0xD000,
+    px_numeric_sign_negative_infinity = 0xF000
+} px_numeric_sign;
+
+// scaled decimals: the value times 10^scale, rounded half away from zero like round() does.
+// NaN, infinities, malformed values and values out of range aren't decoded
+bool px_numeric_decode_int64(const void *restrict data, const size_t length, const unsigned int scale, int64_t *restrict value);
+#ifdef __SIZEOF_INT128__
+bool px_numeric_decode_int128(const void *restrict data, const size_t length, const unsigned int scale, __int128 *restrict value);
+#endif
+
+// the nearest double, including NaN and the infinities
+bool px_numeric_decode_double(const void *restrict data, const size_t length, double *restrict value);
+
+// the text form the server would send (numeric_out), with as many decimals as the display scale.
+// formatting writes at most size - 1 characters and a terminating zero, and returns the length of the
+// whole text like snprintf, or 0 if the value is malformed
+size_t px_numeric_format(const void *restrict data, const size_t length, char *restrict text, const size_t size);
+char *px_numeric_copy_string(const void *restrict data, const size_t length);
+
+// scaled decimals from the text form, which isn't zero terminated
+bool px_numeric_parse_int64(const char *restrict text, const size_t length, const unsigned int scale, int64_t *restrict value);
+
+#endif
@@ -0,0 +1,325 @@
+//
+//  pgoutput.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "pgoutput.h"
+#include "utility.h"
+
+// reading a message, every read after running out of data fails
+typedef struct px_pgoutput_reader
+{
+    const char *cursor;
+    const char *end;
+    bool failed;
+} px_pgoutput_reader;
+
+static bool px_pgoutput_decode_relation(px_pgoutput *restrict pgoutput, px_pgoutput_reader *restrict reader);
+static bool px_pgoutput_decode_change(px_pgoutput *restrict pgoutput, px_pgoutput_reader *restrict reader, const px_pgoutput_message_type type);
+static bool px_pgoutput_decode_truncate(px_pgoutput *restrict pgoutput, px_pgoutput_reader *restrict reader);
+static bool px_pgoutput_decode_tuple(px_pgoutput_reader *restrict reader, px_pgoutput_tuple *restrict tuple, unsigned int *restrict capacity, px_pgoutput_value **restrict values);
+static void px_pgoutput_relation_delete(px_pgoutput_relation *relation);
+
+static const char *px_pgoutput_read_bytes(px_pgoutput_reader *restrict reader, const size_t length);
+static const char *px_pgoutput_read_string(px_pgoutput_reader *restrict reader);
+static uint8_t px_pgoutput_read_uint8(px_pgoutput_reader *restrict reader);
+static uint16_t px_pgoutput_read_uint16(px_pgoutput_reader *restrict reader);
+static uint32_t px_pgoutput_read_uint32(px_pgoutput_reader *restrict reader);
+static uint64_t px_pgoutput_read_uint64(px_pgoutput_reader *restrict reader);
+
+px_pgoutput *px_pgoutput_new(void)
+{
+    return calloc(1, sizeof(px_pgoutput));
+}
+
+void px_pgoutput_delete(px_pgoutput *pgoutput)
+{
+    for (unsigned int i = 0; i < pgoutput->relations.count; i++)
+    {
+        px_pgoutput_relation_delete(pgoutput->relations.values[i]);
+    }
+    
+    free(pgoutput->relations.values);
+    free(pgoutput->old_values.values);
+    free(pgoutput->new_values.values);
+    free(pgoutput->relation_oids.values);
+    free(pgoutput);
+}
+
+const px_pgoutput_message *px_pgoutput_decode(px_pgoutput *restrict pgoutput, const char *restrict data, const size_t length)
+{
+    px_pgoutput_reader reader = { .cursor = data, .end = data + length, .failed = false };
+    px_pgoutput_message *message = &pgoutput->message;
+    
+    memset(message, 0, sizeof(px_pgoutput_message));
+    message->type = (px_pgoutput_message_type)px_pgoutput_read_uint8(&reader);
+    
+    switch (message->type)
+    {
+        case px_pgoutput_message_type_begin:
+            message->data.begin.final_lsn = px_pgoutput_read_uint64(&reader);
+            message->data.begin.commit_time = (int64_t)px_pgoutput_read_uint64(&reader);
+            message->data.begin.xid = px_pgoutput_read_uint32(&reader);
+            break;
+        case px_pgoutput_message_type_commit:
+            message->data.commit.flags = px_pgoutput_read_uint8(&reader);
+            message->data.commit.commit_lsn = px_pgoutput_read_uint64(&reader);
+            message->data.commit.end_lsn = px_pgoutput_read_uint64(&reader);
+            message->data.commit.commit_time = (int64_t)px_pgoutput_read_uint64(&reader);
+            break;
+        case px_pgoutput_message_type_origin:
+            message->data.origin.commit_lsn = px_pgoutput_read_uint64(&reader);
+            message->data.origin.name = px_pgoutput_read_string(&reader);
+            break;
+        case px_pgoutput_message_type_relation:
+            if (!px_pgoutput_decode_relation(pgoutput, &reader))
+                return NULL;
+            break;
+        case px_pgoutput_message_type_type:
+            message->data.type.oid = px_pgoutput_read_uint32(&reader);
+            message->data.type.namespace = px_pgoutput_read_string(&reader);
+            message->data.type.name = px_pgoutput_read_string(&reader);
+            break;
+        case px_pgoutput_message_type_insert:
+        case px_pgoutput_message_type_update:
+        case px_pgoutput_message_type_delete:
+            if (!px_pgoutput_decode_change(pgoutput, &reader, message->type))
+                return NULL;
+            break;
+        case px_pgoutput_message_type_truncate:
+            if (!px_pgoutput_decode_truncate(pgoutput, &reader))
+                return NULL;
+            break;
+        case px_pgoutput_message_type_message:
+            message->data.message.flags = px_pgoutput_read_uint8(&reader);
+            message->data.message.lsn = px_pgoutput_read_uint64(&reader);
+            message->data.message.prefix = px_pgoutput_read_string(&reader);
+            message->data.message.length = px_pgoutput_read_uint32(&reader);
+            message->data.message.content = px_pgoutput_read_bytes(&reader, message->data.message.length);
+            break;
+        default:
+            return NULL;
+    }
+    
+    return reader.failed ? NULL : message;
+}
+
+const px_pgoutput_relation *px_pgoutput_get_relation(const px_pgoutput *restrict pgoutput, const unsigned int oid)
+{
+    // a publication rarely has more than a few dozen tables
+    for (unsigned int i = 0; i < pgoutput->relations.count; i++)
+    {
+        if (pgoutput->relations.values[i]->oid == oid)
+            return pgoutput->relations.values[i];
+    }
+    
+    return NULL;
+}
+
+static bool px_pgoutput_decode_relation(px_pgoutput *restrict pgoutput, px_pgoutput_reader *restrict reader)
+{
+    px_pgoutput_relation *relation = calloc(1, sizeof(px_pgoutput_relation));
+    relation->oid = px_pgoutput_read_uint32(reader);
+    relation->namespace = px_copy_string(px_pgoutput_read_string(reader));
+    relation->name = px_copy_string(px_pgoutput_read_string(reader));
+    relation->replica_identity = (char)px_pgoutput_read_uint8(reader);
+    relation->column_count = px_pgoutput_read_uint16(reader);
+    relation->columns = calloc(relation->column_count, sizeof(px_pgoutput_column));
+    
+    for (unsigned int i = 0; i < relation->column_count && !reader->failed; i++)
+    {
+        px_pgoutput_column *column = &relation->columns[i];
+        column->key = (px_pgoutput_read_uint8(reader) & 1) != 0;
+        column->name = px_copy_string(px_pgoutput_read_string(reader));
+        column->datatype_oid = px_pgoutput_read_uint32(reader);
+        column->type_modifier = (int)px_pgoutput_read_uint32(reader);
+    }
+    
+    if (reader->failed)
+    {
+        px_pgoutput_relation_delete(relation);
+        return false;
+    }
+    
+    // the server sends the relation again whenever its definition changes
+    unsigned int index = 0;
+    while (index < pgoutput->relations.count && pgoutput->relations.values[index]->oid != relation->oid)
+        index++;
+    
+    if (index < pgoutput->relations.count)
+    {
+        px_pgoutput_relation_delete(pgoutput->relations.values[index]);
+    }
+    else
+    {
+        if (pgoutput->relations.count == pgoutput->relations.capacity)
+        {
+            pgoutput->relations.capacity = pgoutput->relations.capacity == 0 ? 16 : pgoutput->relations.capacity * 2;
+            pgoutput->relations.values = realloc(pgoutput->relations.values, pgoutput->relations.capacity * sizeof(px_pgoutput_relation *));
+        }
+        
+        pgoutput->relations.count++;
+    }
+    
+    pgoutput->relations.values[index] = relation;
+    pgoutput->message.data.change.relation = relation;
+    return true;
+}
+
+static bool px_pgoutput_decode_change(px_pgoutput *restrict pgoutput, px_pgoutput_reader *restrict reader, const px_pgoutput_message_type type)
+{
+    px_pgoutput_message *message = &pgoutput->message;
+    message->data.change.relation = px_pgoutput_get_relation(pgoutput, px_pgoutput_read_uint32(reader));
+    if (message->data.change.relation == NULL)
+        return false;
+    
+    char tuple_kind = (char)px_pgoutput_read_uint8(reader);
+    if (tuple_kind == 'K' || tuple_kind == 'O')
+    {
+        message->data.change.old_tuple_kind = tuple_kind;
+        if (!px_pgoutput_decode_tuple(reader, &message->data.change.old_tuple, &pgoutput->old_values.capacity, &pgoutput->old_values.values))
+            return false;
+        
+        if (type == px_pgoutput_message_type_delete)
+            return true;
+        
+        tuple_kind = (char)px_pgoutput_read_uint8(reader);
+    }
+    
+    if (tuple_kind != 'N' || type == px_pgoutput_message_type_delete)
+        return false;
+    
+    return px_pgoutput_decode_tuple(reader, &message->data.change.new_tuple, &pgoutput->new_values.capacity, &pgoutput->new_values.values);
+}
+
+static bool px_pgoutput_decode_truncate(px_pgoutput *restrict pgoutput, px_pgoutput_reader *restrict reader)
+{
+    px_pgoutput_message *message = &pgoutput->message;
+    const unsigned int relation_count = px_pgoutput_read_uint32(reader);
+    message->data.truncate.options = px_pgoutput_read_uint8(reader);
+    
+    const char *oids = px_pgoutput_read_bytes(reader, (size_t)relation_count * 4);
+    if (oids == NULL)
+        return false;
+    
+    if (relation_count > pgoutput->relation_oids.capacity)
+    {
+        pgoutput->relation_oids.capacity = relation_count;
+        pgoutput->relation_oids.values = realloc(pgoutput->relation_oids.values, relation_count * sizeof(unsigned int));
+    }
+    
+    for (unsigned int i = 0; i < relation_count; i++)
+    {
+        pgoutput->relation_oids.values[i] = px_read_network_uint32(oids + i * 4);
+    }
+    
+    message->data.truncate.relation_count = relation_count;
+    message->data.truncate.relation_oids = pgoutput->relation_oids.values;
+    return true;
+}
+
+static bool px_pgoutput_decode_tuple(px_pgoutput_reader *restrict reader, px_pgoutput_tuple *restrict tuple, unsigned int *restrict capacity, px_pgoutput_value **restrict values)
+{
+    const unsigned int column_count = px_pgoutput_read_uint16(reader);
+    if (column_count > *capacity)
+    {
+        *capacity = column_count;
+        *values = realloc(*values, column_count * sizeof(px_pgoutput_value));
+    }
+    
+    for (unsigned int i = 0; i < column_count && !reader->failed; i++)
+    {
+        px_pgoutput_value *value = &(*values)[i];
+        value->kind = (px_pgoutput_value_kind)px_pgoutput_read_uint8(reader);
+        value->length = 0;
+        value->data = NULL;
+        
+        switch (value->kind)
+        {
+            case px_pgoutput_value_kind_null:
+            case px_pgoutput_value_kind_unchanged_toast:
+                break;
+            case px_pgoutput_value_kind_text:
+            case px_pgoutput_value_kind_binary:
+                value->length = px_pgoutput_read_uint32(reader);
+                value->data = px_pgoutput_read_bytes(reader, value->length);
+                break;
+            default:
+                reader->failed = true;
+                break;
+        }
+    }
+    
+    tuple->column_count = column_count;
+    tuple->values = *values;
+    return !reader->failed;
+}
+
+static void px_pgoutput_relation_delete(px_pgoutput_relation *relation)
+{
+    for (unsigned int i = 0; i < relation->column_count; i++)
+    {
+        free(relation->columns[i].name);
+    }
+    
+    free(relation->columns);
+    free(relation->namespace);
+    free(relation->name);
+    free(relation);
+}
+
+static const char *px_pgoutput_read_bytes(px_pgoutput_reader *restrict reader, const size_t length)
+{
+    if (reader->failed || (size_t)(reader->end - reader->cursor) < length)
+    {
+        reader->failed = true;
+        return NULL;
+    }
+    
+    const char *bytes = reader->cursor;
+    reader->cursor += length;
+    return bytes;
+}
+
+static const char *px_pgoutput_read_string(px_pgoutput_reader *restrict reader)
+{
+    const char *terminator = reader->failed ? NULL : memchr(reader->cursor, '\0', (size_t)(reader->end - reader->cursor));
+    if (terminator == NULL)
+    {
+        reader->failed = true;
+        return "";
+    }
+    
+    const char *string = reader->cursor;
+    reader->cursor = terminator + 1;
+    return string;
+}
+
+static uint8_t px_pgoutput_read_uint8(px_pgoutput_reader *restrict reader)
+{
+    const char *bytes = px_pgoutput_read_bytes(reader, 1);
+    return bytes == NULL ? 0 : (uint8_t)*bytes;
+}
+
+static uint16_t px_pgoutput_read_uint16(px_pgoutput_reader *restrict reader)
+{
+    const char *bytes = px_pgoutput_read_bytes(reader, 2);
+    return bytes == NULL ? 0 : px_read_network_uint16(bytes);
+}
+
+static uint32_t px_pgoutput_read_uint32(px_pgoutput_reader *restrict reader)
+{
+    const char *bytes = px_pgoutput_read_bytes(reader, 4);
+    return bytes == NULL ? 0 : px_read_network_uint32(bytes);
+}
+
+static uint64_t px_pgoutput_read_uint64(px_pgoutput_reader *restrict reader)
+{
+    const char *bytes = px_pgoutput_read_bytes(reader, 8);
+    return bytes == NULL ? 0 : px_read_network_uint64(bytes);
+}
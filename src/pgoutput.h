@@ -0,0 +1,163 @@
+//
+//  pgoutput.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_pgoutput_h
+#define libpx_pgoutput_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "typedef.h"
+
+typedef enum px_pgoutput_message_type
+{
+    px_pgoutput_message_type_begin = 'B',
+    px_pgoutput_message_type_commit = 'C',
+    px_pgoutput_message_type_origin = 'O',
+    px_pgoutput_message_type_relation = 'R',
+    px_pgoutput_message_type_type = 'Y',
+    px_pgoutput_message_type_insert = 'I',
+    px_pgoutput_message_type_update = 'U',
+    px_pgoutput_message_type_delete = 'D',
+    px_pgoutput_message_type_truncate = 'T',
+    px_pgoutput_message_type_message = 'M'
+} px_pgoutput_message_type;
+
+typedef enum px_pgoutput_value_kind
+{
+    px_pgoutput_value_kind_null = 'n',
+    px_pgoutput_value_kind_unchanged_toast = 'u',
+    px_pgoutput_value_kind_text = 't',
+    px_pgoutput_value_kind_binary = 'b'
+} px_pgoutput_value_kind;
+
+typedef struct px_pgoutput_column
+{
+    char *name;
+    unsigned int datatype_oid;
+    int type_modifier;
+    bool key;
+} px_pgoutput_column;
+
+struct px_pgoutput_relation
+{
+    unsigned int oid;
+    char *namespace;
+    char *name;
+    char replica_identity;
+    unsigned int column_count;
+    px_pgoutput_column *columns;
+};
+
+// the data of a value isn't zero terminated
+typedef struct px_pgoutput_value
+{
+    px_pgoutput_value_kind kind;
+    unsigned int length;
+    const char *data;
+} px_pgoutput_value;
+
+typedef struct px_pgoutput_tuple
+{
+    unsigned int column_count;
+    px_pgoutput_value *values;
+} px_pgoutput_tuple;
+
+// times are in microseconds since 2000-01-01 00:00:00 UTC
+struct px_pgoutput_message
+{
+    px_pgoutput_message_type type;
+    union
+    {
+        struct
+        {
+            uint64_t final_lsn;
+            int64_t commit_time;
+            uint32_t xid;
+        } begin;
+        struct
+        {
+            uint8_t flags;
+            uint64_t commit_lsn;
+            uint64_t end_lsn;
+            int64_t commit_time;
+        } commit;
+        struct
+        {
+            uint64_t commit_lsn;
+            const char *name;
+        } origin;
+        struct
+        {
+            unsigned int oid;
+            const char *namespace;
+            const char *name;
+        } type;
+        // relation messages only carry the relation, the old tuple of updates and deletes is
+        // either the replica identity key ('K'), the whole old row ('O') or missing (0)
+        struct
+        {
+            const px_pgoutput_relation *relation;
+            char old_tuple_kind;
+            px_pgoutput_tuple old_tuple;
+            px_pgoutput_tuple new_tuple;
+        } change;
+        struct
+        {
+            uint8_t options;
+            unsigned int relation_count;
+            const unsigned int *relation_oids;
+        } truncate;
+        struct
+        {
+            uint8_t flags;
+            uint64_t lsn;
+            const char *prefix;
+            unsigned int length;
+            const char *content;
+        } message;
+    } data;
+};
+
+// decodes the messages of the pgoutput plugin (protocol version 1) sent in a logical replication
+// stream. relations are kept until the server sends them again with a new definition, everything
+// else in a message is only valid until the next one is decoded or its data goes away
+struct px_pgoutput
+{
+    struct
+    {
+        unsigned int count;
+        unsigned int capacity;
+        px_pgoutput_relation **values;
+    } relations;
+    
+    // reused by every message, so that decoding a change doesn't allocate once they are large enough
+    px_pgoutput_message message;
+    struct
+    {
+        unsigned int capacity;
+        px_pgoutput_value *values;
+    } old_values, new_values;
+    struct
+    {
+        unsigned int capacity;
+        unsigned int *values;
+    } relation_oids;
+};
+
+// create & delete
+px_pgoutput *px_pgoutput_new(void);
+void px_pgoutput_delete(px_pgoutput *pgoutput);
+
+// decoding messages, NULL if the message is malformed or refers to a relation not seen before
+const px_pgoutput_message *px_pgoutput_decode(px_pgoutput *restrict pgoutput, const char *restrict data, const size_t length);
+
+// getters
+const px_pgoutput_relation *px_pgoutput_get_relation(const px_pgoutput *restrict pgoutput, const unsigned int oid) __attribute__((pure));
+
+#endif
@@ -0,0 +1,809 @@
+//
+//  pool.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include "pool.h"
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include "connection.h"
+#include "connection_params.h"
+#include "query.h"
+#include "result.h"
+#include "type_cache.h"
+#include "utility.h"
+
+typedef enum px_pool_attempt
+{
+    px_pool_attempt_failed = -1,
+    px_pool_attempt_unavailable = 0,
+    px_pool_attempt_acquired = 1
+} px_pool_attempt;
+
+static const unsigned int px_pool_default_idle_timeout = 10 * 60 * 1000;
+static const uint64_t px_pool_stack_index_mask = 0xFFFFFFFF;
+static const int px_pool_warm_timeout = 15 * 1000;
+static const uint64_t px_pool_replica_retry_delay = 5 * 1000;
+
+static volatile unsigned int px_pool_last_serial = 0;
+
+// every thread keeps the last connection it released to a pool, so that a thread
+// that keeps acquiring and releasing gets the same connection back without
+// touching any shared cache line other than the slot's state
+static __thread struct
+{
+    const px_pool *pool;
+    unsigned int serial;
+    unsigned int slot;
+} px_pool_thread_cache;
+
+static void px_pool_stack_push(px_pool *restrict pool, volatile uint64_t *head, const unsigned int index);
+static bool px_pool_stack_pop(px_pool *restrict pool, volatile uint64_t *head, unsigned int *restrict index);
+
+static px_pool_attempt px_pool_acquire_slot(px_pool *restrict pool, const int timeout, unsigned int *restrict index);
+static px_connection *px_pool_hand_out(px_pool *restrict pool, const unsigned int index);
+static px_pool_attempt px_pool_try_acquire(px_pool *restrict pool, unsigned int *restrict index);
+static bool px_pool_take_cached(px_pool *restrict pool, unsigned int *restrict index);
+static bool px_pool_take_idle(px_pool *restrict pool, unsigned int *restrict index);
+static bool px_pool_steal_cached(px_pool *restrict pool, unsigned int *restrict index);
+static px_pool_attempt px_pool_grow(px_pool *restrict pool, unsigned int *restrict index);
+
+static void px_pool_make_idle(px_pool *restrict pool, const unsigned int index);
+static bool px_pool_connection_is_reusable(const px_connection *restrict connection) __attribute__((pure));
+static bool px_pool_reset_session(px_connection *restrict connection);
+static void px_pool_discard(px_pool *restrict pool, const unsigned int index);
+static bool px_pool_reserve_shrink(px_pool *restrict pool);
+static void px_pool_wake_waiter(px_pool *restrict pool);
+static void px_pool_reap_if_due(px_pool *restrict pool, const uint64_t now);
+static void px_pool_delete_replicas(px_pool *restrict pool);
+static unsigned int px_pool_pick_replica(px_pool *restrict pool, const uint64_t now);
+
+px_pool *px_pool_new(const px_connection_params *restrict connection_params, const unsigned int min_size, const unsigned int max_size)
+{
+    px_pool *pool = calloc(1, sizeof(px_pool));
+    pool->connection_params = px_connection_params_copy(connection_params);
+    pool->serial = __sync_add_and_fetch(&px_pool_last_serial, 1);
+    pool->max_size = max_size > 0 ? max_size : 1;
+    pool->min_size = min_size < pool->max_size ? min_size : pool->max_size;
+    pool->acquire_timeout = -1;
+    pool->idle_timeout = px_pool_default_idle_timeout;
+    pool->next_reap = px_get_monotonic_time() + pool->idle_timeout;
+    pool->slots = calloc(pool->max_size, sizeof(px_pool_slot));
+    pool->type_cache = px_type_cache_new();
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->available, NULL);
+    
+    // push the slots in reverse so that the lowest ones get used first
+    for (unsigned int i = pool->max_size; i > 0; i--)
+        px_pool_stack_push(pool, &pool->empty_head, i - 1);
+    
+    return pool;
+}
+
+void px_pool_delete(px_pool *pool)
+{
+    // all connections have to be released by this point
+    for (unsigned int i = 0; i < pool->max_size; i++)
+    {
+        if (pool->slots[i].connection != NULL)
+            px_connection_delete(pool->slots[i].connection);
+    }
+    
+    if (px_pool_thread_cache.pool == pool)
+        px_pool_thread_cache.pool = NULL;
+    
+    px_pool_delete_replicas(pool);
+    
+    pthread_cond_destroy(&pool->available);
+    pthread_mutex_destroy(&pool->mutex);
+    px_connection_params_delete(pool->connection_params);
+    px_type_cache_delete(pool->type_cache);
+    free(pool->slots);
+    free(pool);
+}
+
+void px_pool_set_acquire_timeout(px_pool *restrict pool, const int timeout)
+{
+    pool->acquire_timeout = timeout;
+    
+    for (unsigned int i = 0; i < pool->replicas.count; i++)
+        pool->replicas.values[i]->acquire_timeout = timeout;
+}
+
+void px_pool_set_idle_timeout(px_pool *restrict pool, const unsigned int timeout)
+{
+    pool->idle_timeout = timeout;
+    
+    for (unsigned int i = 0; i < pool->replicas.count; i++)
+        pool->replicas.values[i]->idle_timeout = timeout;
+}
+
+void px_pool_set_routing(px_pool *restrict pool, const px_pool_routing routing)
+{
+    px_pool_delete_replicas(pool);
+    pool->routing = routing;
+    
+    if (routing == px_pool_routing_none)
+        return;
+    
+    // every host gets a pool of its own, which only ever connects to it while it's a standby
+    px_connection_params *replica_params = px_connection_params_copy(pool->connection_params);
+    px_connection_params_set_target_session_type(replica_params, px_target_session_type_standby);
+    
+    pool->replicas.count = px_connection_params_get_host_count(pool->connection_params);
+    pool->replicas.values = calloc(pool->replicas.count, sizeof(px_pool *));
+    
+    for (unsigned int i = 0; i < pool->replicas.count; i++)
+    {
+        px_connection_params_set_hostname(replica_params, px_connection_params_get_host(pool->connection_params, i));
+        
+        px_pool *replica = px_pool_new(replica_params, 0, pool->max_size);
+        replica->acquire_timeout = pool->acquire_timeout;
+        replica->idle_timeout = pool->idle_timeout;
+        replica->replica = true;
+        pool->replicas.values[i] = replica;
+    }
+    
+    px_connection_params_delete(replica_params);
+}
+
+unsigned int px_pool_get_size(const px_pool *restrict pool)
+{
+    return __atomic_load_n(&pool->size, __ATOMIC_RELAXED);
+}
+
+const px_connection_params *px_pool_get_connection_params(const px_pool *restrict pool)
+{
+    return pool->connection_params;
+}
+
+px_type_cache *px_pool_get_type_cache(const px_pool *restrict pool)
+{
+    return pool->type_cache;
+}
+
+px_connection *px_pool_acquire(px_pool *restrict pool)
+{
+    unsigned int index = 0;
+    if (px_pool_acquire_slot(pool, pool->acquire_timeout, &index) != px_pool_attempt_acquired)
+        return NULL;
+    
+    return px_pool_hand_out(pool, index);
+}
+
+px_connection *px_pool_acquire_read_only(px_pool *restrict pool)
+{
+    const unsigned int count = pool->replicas.count;
+    if (count == 0)
+        return px_pool_acquire(pool);
+    
+    // the first pass doesn't wait, a busy standby is passed over for one with a connection to spare
+    const uint64_t now = px_get_monotonic_time();
+    const unsigned int first = px_pool_pick_replica(pool, now);
+    px_pool *busy = NULL;
+    unsigned int index = 0;
+    
+    for (unsigned int i = 0; i < count; i++)
+    {
+        px_pool *replica = pool->replicas.values[(first + i) % count];
+        if (__atomic_load_n(&replica->retry_after, __ATOMIC_RELAXED) > now)
+            continue;
+        
+        switch (px_pool_acquire_slot(replica, 0, &index))
+        {
+            case px_pool_attempt_acquired:
+                return px_pool_hand_out(replica, index);
+            case px_pool_attempt_failed:
+                // down or no longer a standby, it isn't tried again for a while
+                __atomic_store_n(&replica->retry_after, now + px_pool_replica_retry_delay, __ATOMIC_RELAXED);
+                break;
+            case px_pool_attempt_unavailable:
+                if (busy == NULL)
+                    busy = replica;
+                break;
+        }
+    }
+    
+    if (busy != NULL && pool->acquire_timeout != 0)
+        return px_pool_acquire_slot(busy, pool->acquire_timeout, &index) == px_pool_attempt_acquired ? px_pool_hand_out(busy, index) : NULL;
+    
+    // without a standby to connect to, read-only queries go to the pool's own hosts
+    return busy == NULL ? px_pool_acquire(pool) : NULL;
+}
+
+static px_pool_attempt px_pool_acquire_slot(px_pool *restrict pool, const int timeout, unsigned int *restrict index)
+{
+    px_pool_attempt attempt = px_pool_try_acquire(pool, index);
+    
+    if (attempt == px_pool_attempt_unavailable && timeout != 0)
+    {
+        // every connection is in use: wait until one is released or discarded.
+        // the generation counter is bumped under the mutex by whoever wakes us up, so
+        // a release that happens between two attempts is never missed
+        struct timespec deadline;
+        if (timeout > 0)
+        {
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            const long nanoseconds = now.tv_usec * 1000L + (timeout % 1000) * 1000000L;
+            deadline.tv_sec = now.tv_sec + timeout / 1000 + nanoseconds / 1000000000L;
+            deadline.tv_nsec = nanoseconds % 1000000000L;
+        }
+        
+        pthread_mutex_lock(&pool->mutex);
+        __atomic_add_fetch(&pool->waiters, 1, __ATOMIC_SEQ_CST);
+        
+        while (true)
+        {
+            const unsigned int generation = pool->generation;
+            pthread_mutex_unlock(&pool->mutex);
+            attempt = px_pool_try_acquire(pool, index);
+            pthread_mutex_lock(&pool->mutex);
+            
+            if (attempt != px_pool_attempt_unavailable)
+                break;
+            
+            int error = 0;
+            while (generation == pool->generation && error != ETIMEDOUT)
+            {
+                if (timeout > 0)
+                    error = pthread_cond_timedwait(&pool->available, &pool->mutex, &deadline);
+                else
+                    pthread_cond_wait(&pool->available, &pool->mutex);
+            }
+            
+            if (error == ETIMEDOUT && generation == pool->generation)
+                break;
+        }
+        
+        __atomic_sub_fetch(&pool->waiters, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    
+    return attempt;
+}
+
+static px_connection *px_pool_hand_out(px_pool *restrict pool, const unsigned int index)
+{
+    px_connection *connection = pool->slots[index].connection;
+    connection->pool = pool;
+    connection->pool_slot = index;
+    
+    if (pool->replica)
+        __atomic_add_fetch(&pool->outstanding, 1, __ATOMIC_RELAXED);
+    
+    return connection;
+}
+
+void px_pool_release(px_pool *restrict pool, px_connection *restrict connection)
+{
+    // read-only connections go back to the pool of their standby
+    if (connection->pool != pool)
+    {
+        px_pool_release(connection->pool, connection);
+        return;
+    }
+    
+    if (pool->replica)
+        __atomic_sub_fetch(&pool->outstanding, 1, __ATOMIC_RELAXED);
+    
+    const unsigned int index = connection->pool_slot;
+    px_pool_slot *slot = &pool->slots[index];
+    
+    px_connection_set_last_error(connection, NULL);
+    
+    if (!px_pool_connection_is_reusable(connection) || !px_pool_reset_session(connection))
+    {
+        px_pool_discard(pool, index);
+        return;
+    }
+    
+    // notifications and their callback belong to whoever used the connection
+    px_connection_set_notification_callback(connection, NULL, NULL);
+    px_connection_clear_notifications(connection);
+    
+    const uint64_t now = px_get_monotonic_time();
+    slot->last_used = now;
+    
+    // park the connection in this thread's cache unless somebody is waiting for one
+    // or the cache still holds another connection of this pool
+    if (__atomic_load_n(&pool->waiters, __ATOMIC_SEQ_CST) == 0
+        && (px_pool_thread_cache.pool != pool
+            || px_pool_thread_cache.serial != pool->serial
+            || __atomic_load_n(&pool->slots[px_pool_thread_cache.slot].state, __ATOMIC_RELAXED) != px_pool_slot_state_cached))
+    {
+        px_pool_thread_cache.pool = pool;
+        px_pool_thread_cache.serial = pool->serial;
+        px_pool_thread_cache.slot = index;
+        __atomic_store_n(&slot->state, px_pool_slot_state_cached, __ATOMIC_SEQ_CST);
+        
+        // somebody may have started waiting after the check above and missed the parked connection,
+        // it goes to the idle ones then, unless a waiter has stolen it already
+        int state = px_pool_slot_state_cached;
+        if (__atomic_load_n(&pool->waiters, __ATOMIC_SEQ_CST) != 0
+            && __atomic_compare_exchange_n(&slot->state, &state, px_pool_slot_state_in_use, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            px_pool_thread_cache.pool = NULL;
+            px_pool_make_idle(pool, index);
+        }
+    }
+    else
+    {
+        px_pool_make_idle(pool, index);
+    }
+    
+    px_pool_reap_if_due(pool, now);
+}
+
+unsigned int px_pool_warm(px_pool *restrict pool, const unsigned int count)
+{
+    const unsigned int target = count < pool->max_size ? count : pool->max_size;
+    const unsigned int size = px_pool_get_size(pool);
+    if (size >= target)
+        return size;
+    
+    // start all connections first and then drive their handshakes together, so that
+    // warming up takes about as long as opening a single connection
+    const unsigned int needed = target - size;
+    unsigned int *indices = malloc(needed * sizeof(unsigned int));
+    struct pollfd *fds = malloc(needed * sizeof(struct pollfd));
+    unsigned int opening = 0;
+    unsigned int index;
+    
+    // a failed start puts its slot back on the empty stack, so only as many are taken as needed
+    for (unsigned int started = 0; started < needed && px_pool_stack_pop(pool, &pool->empty_head, &index); started++)
+    {
+        px_pool_slot *slot = &pool->slots[index];
+        __atomic_store_n(&slot->state, px_pool_slot_state_in_use, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&pool->size, 1, __ATOMIC_RELAXED);
+        slot->connection = px_connection_new_with_shared_params(pool->connection_params);
+        px_connection_set_type_cache(slot->connection, pool->type_cache);
+        
+        if (!px_connection_open_start(slot->connection))
+        {
+            px_pool_discard(pool, index);
+            continue;
+        }
+        
+        indices[opening] = index;
+        fds[opening].fd = px_connection_get_socket(slot->connection);
+        fds[opening].events = POLLOUT;
+        opening++;
+    }
+    
+    const uint64_t deadline = px_get_monotonic_time() + (uint64_t)px_pool_warm_timeout;
+    
+    while (opening > 0)
+    {
+        const uint64_t now = px_get_monotonic_time();
+        if (now >= deadline)
+        {
+            for (unsigned int i = 0; i < opening; i++)
+                px_pool_discard(pool, indices[i]);
+            break;
+        }
+        
+        // connections still connecting may have to try another address before their socket is ready
+        int timeout = (int)(deadline - now);
+        for (unsigned int i = 0; i < opening; i++)
+        {
+            const int open_timeout = px_connection_get_open_timeout(pool->slots[indices[i]].connection);
+            if (open_timeout >= 0 && open_timeout < timeout)
+                timeout = open_timeout;
+        }
+        
+        if (poll(fds, opening, timeout) == -1 && errno != EINTR)
+        {
+            for (unsigned int i = 0; i < opening; i++)
+                px_pool_discard(pool, indices[i]);
+            break;
+        }
+        
+        for (unsigned int i = 0; i < opening; )
+        {
+            if (fds[i].revents == 0 && px_connection_get_open_timeout(pool->slots[indices[i]].connection) != 0)
+            {
+                i++;
+                continue;
+            }
+            
+            // the socket changes when the connection moves on to another address or host
+            px_connection *connection = pool->slots[indices[i]].connection;
+            const px_connection_polling_status status = px_connection_open_poll(connection);
+            fds[i].fd = px_connection_get_socket(connection);
+            
+            switch (status)
+            {
+                case px_connection_polling_status_reading:
+                    fds[i].events = POLLIN;
+                    fds[i].revents = 0;
+                    i++;
+                    continue;
+                case px_connection_polling_status_writing:
+                    fds[i].events = POLLOUT;
+                    fds[i].revents = 0;
+                    i++;
+                    continue;
+                case px_connection_polling_status_ok:
+                    px_pool_make_idle(pool, indices[i]);
+                    break;
+                case px_connection_polling_status_failed:
+                    px_pool_discard(pool, indices[i]);
+                    break;
+            }
+            
+            // this one is done, the last one in the list takes its place
+            opening--;
+            indices[i] = indices[opening];
+            fds[i] = fds[opening];
+        }
+    }
+    
+    free(indices);
+    free(fds);
+    
+    return px_pool_get_size(pool);
+}
+
+unsigned int px_pool_reap(px_pool *restrict pool)
+{
+    if (pool->idle_timeout == 0)
+        return 0;
+    
+    const uint64_t now = px_get_monotonic_time();
+    unsigned int reaped = 0;
+    
+    for (unsigned int i = 0; i < pool->max_size; i++)
+    {
+        px_pool_slot *slot = &pool->slots[i];
+        int state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+        
+        if (state != px_pool_slot_state_idle && state != px_pool_slot_state_cached)
+            continue;
+        
+        // idle slots stay on the idle stack while they are being reaped, the thread
+        // that eventually pops them moves them over to the empty stack
+        const int claimed_state = state == px_pool_slot_state_idle ? px_pool_slot_state_reaping : px_pool_slot_state_in_use;
+        if (!__atomic_compare_exchange_n(&slot->state, &state, claimed_state, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            continue;
+        
+        if (now - slot->last_used < pool->idle_timeout || !px_pool_reserve_shrink(pool))
+        {
+            __atomic_store_n(&slot->state, state, __ATOMIC_RELEASE);
+            continue;
+        }
+        
+        px_connection *connection = slot->connection;
+        slot->connection = NULL;
+        
+        if (state == px_pool_slot_state_idle)
+        {
+            __atomic_store_n(&slot->state, px_pool_slot_state_reaped, __ATOMIC_RELEASE);
+        }
+        else
+        {
+            __atomic_store_n(&slot->state, px_pool_slot_state_empty, __ATOMIC_RELEASE);
+            px_pool_stack_push(pool, &pool->empty_head, i);
+        }
+        
+        px_connection_delete(connection);
+        px_pool_wake_waiter(pool);
+        reaped++;
+    }
+    
+    for (unsigned int i = 0; i < pool->replicas.count; i++)
+        reaped += px_pool_reap(pool->replicas.values[i]);
+    
+    return reaped;
+}
+
+static px_pool_attempt px_pool_try_acquire(px_pool *restrict pool, unsigned int *restrict index)
+{
+    if (px_pool_take_cached(pool, index) || px_pool_take_idle(pool, index) || px_pool_steal_cached(pool, index))
+        return px_pool_attempt_acquired;
+    
+    return px_pool_grow(pool, index);
+}
+
+static bool px_pool_take_cached(px_pool *restrict pool, unsigned int *restrict index)
+{
+    if (px_pool_thread_cache.pool != pool || px_pool_thread_cache.serial != pool->serial)
+        return false;
+    
+    // the slot may have been stolen or reaped since this thread parked it
+    px_pool_thread_cache.pool = NULL;
+    
+    int state = px_pool_slot_state_cached;
+    if (!__atomic_compare_exchange_n(&pool->slots[px_pool_thread_cache.slot].state, &state, px_pool_slot_state_in_use, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return false;
+    
+    *index = px_pool_thread_cache.slot;
+    return true;
+}
+
+static bool px_pool_take_idle(px_pool *restrict pool, unsigned int *restrict index)
+{
+    unsigned int popped;
+    while (px_pool_stack_pop(pool, &pool->idle_head, &popped))
+    {
+        px_pool_slot *slot = &pool->slots[popped];
+        
+        while (true)
+        {
+            int state = px_pool_slot_state_idle;
+            if (__atomic_compare_exchange_n(&slot->state, &state, px_pool_slot_state_in_use, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+            {
+                *index = popped;
+                return true;
+            }
+            
+            if (state == px_pool_slot_state_reaped)
+            {
+                __atomic_store_n(&slot->state, px_pool_slot_state_empty, __ATOMIC_RELAXED);
+                px_pool_stack_push(pool, &pool->empty_head, popped);
+                break;
+            }
+            
+            // px_pool_reap is looking at the slot right now
+            sched_yield();
+        }
+    }
+    
+    return false;
+}
+
+static bool px_pool_steal_cached(px_pool *restrict pool, unsigned int *restrict index)
+{
+    // connections parked in other threads' caches are only taken when nothing else is idle
+    for (unsigned int i = 0; i < pool->max_size; i++)
+    {
+        int state = px_pool_slot_state_cached;
+        if (__atomic_load_n(&pool->slots[i].state, __ATOMIC_RELAXED) == state
+            && __atomic_compare_exchange_n(&pool->slots[i].state, &state, px_pool_slot_state_in_use, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            *index = i;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+static px_pool_attempt px_pool_grow(px_pool *restrict pool, unsigned int *restrict index)
+{
+    unsigned int popped;
+    if (!px_pool_stack_pop(pool, &pool->empty_head, &popped))
+        return px_pool_attempt_unavailable;
+    
+    px_pool_slot *slot = &pool->slots[popped];
+    __atomic_store_n(&slot->state, px_pool_slot_state_in_use, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&pool->size, 1, __ATOMIC_RELAXED);
+    
+    slot->connection = px_connection_new_with_shared_params(pool->connection_params);
+    px_connection_set_type_cache(slot->connection, pool->type_cache);
+    if (px_connection_open(slot->connection) != px_connection_attempt_result_success)
+    {
+        px_pool_discard(pool, popped);
+        return px_pool_attempt_failed;
+    }
+    
+    *index = popped;
+    return px_pool_attempt_acquired;
+}
+
+static void px_pool_make_idle(px_pool *restrict pool, const unsigned int index)
+{
+    pool->slots[index].last_used = px_get_monotonic_time();
+    __atomic_store_n(&pool->slots[index].state, px_pool_slot_state_idle, __ATOMIC_RELEASE);
+    px_pool_stack_push(pool, &pool->idle_head, index);
+    px_pool_wake_waiter(pool);
+}
+
+static bool px_pool_connection_is_reusable(const px_connection *restrict connection)
+{
+    return connection->connection_status == px_connection_status_open
+        && !connection->results.busy;
+}
+
+static bool px_pool_reset_session(px_connection *restrict connection)
+{
+    const unsigned int session_state = connection->session_state;
+    const bool in_transaction = connection->transaction_status != px_transaction_status_idle;
+    
+    if (session_state == px_connection_session_state_clean && !in_transaction)
+        return true;
+    
+    // only what has been changed is reset, in a single round trip. unlike DISCARD ALL this
+    // keeps the prepared statements and doesn't have to run outside of a transaction block
+    char command_text[192];
+    char *end = command_text;
+    *end = '\0';
+    
+    if (in_transaction)
+        end = stpcpy(end, "ROLLBACK;");
+    
+    if (session_state & px_connection_session_state_held_cursors)
+        end = stpcpy(end, "CLOSE ALL;");
+    
+    if (session_state & px_connection_session_state_listening)
+        end = stpcpy(end, "UNLISTEN *;");
+    
+    // RESET ALL leaves the role and the session authorization alone
+    if (session_state & px_connection_session_state_settings)
+        end = stpcpy(end, "SET SESSION AUTHORIZATION DEFAULT;RESET ALL;");
+    
+    if (session_state & px_connection_session_state_temp_tables)
+        end = stpcpy(end, "DISCARD TEMP;");
+    
+    if (session_state & px_connection_session_state_advisory_locks)
+        stpcpy(end, "SELECT pg_advisory_unlock_all();");
+    
+    px_query *query = px_query_new(command_text, connection);
+    px_result_list *results = px_query_execute(query);
+    px_query_delete(query);
+    
+    if (results != NULL)
+        px_result_list_delete(results, false);
+    
+    if (connection->last_error != NULL
+        || connection->connection_status != px_connection_status_open
+        || connection->transaction_status != px_transaction_status_idle)
+    {
+        return false;
+    }
+    
+    // the reset itself reports changed parameters
+    px_connection_clear_session_state(connection);
+    return true;
+}
+
+static void px_pool_discard(px_pool *restrict pool, const unsigned int index)
+{
+    px_pool_slot *slot = &pool->slots[index];
+    px_connection *connection = slot->connection;
+    slot->connection = NULL;
+    
+    __atomic_sub_fetch(&pool->size, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->state, px_pool_slot_state_empty, __ATOMIC_RELEASE);
+    px_pool_stack_push(pool, &pool->empty_head, index);
+    px_pool_wake_waiter(pool);
+    
+    px_connection_delete(connection);
+}
+
+static bool px_pool_reserve_shrink(px_pool *restrict pool)
+{
+    unsigned int size = __atomic_load_n(&pool->size, __ATOMIC_RELAXED);
+    
+    do
+    {
+        if (size <= pool->min_size)
+            return false;
+    } while (!__atomic_compare_exchange_n(&pool->size, &size, size - 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    
+    return true;
+}
+
+static void px_pool_wake_waiter(px_pool *restrict pool)
+{
+    if (__atomic_load_n(&pool->waiters, __ATOMIC_SEQ_CST) == 0)
+        return;
+    
+    pthread_mutex_lock(&pool->mutex);
+    pool->generation++;
+    pthread_cond_signal(&pool->available);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void px_pool_reap_if_due(px_pool *restrict pool, const uint64_t now)
+{
+    uint64_t next_reap = __atomic_load_n(&pool->next_reap, __ATOMIC_RELAXED);
+    if (pool->idle_timeout == 0 || now < next_reap)
+        return;
+    
+    // only one of the releasing threads gets to do it
+    if (__atomic_compare_exchange_n(&pool->next_reap, &next_reap, now + pool->idle_timeout / 2 + 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        px_pool_reap(pool);
+}
+
+static void px_pool_delete_replicas(px_pool *restrict pool)
+{
+    for (unsigned int i = 0; i < pool->replicas.count; i++)
+        px_pool_delete(pool->replicas.values[i]);
+    
+    if (pool->replicas.values != NULL)
+        free(pool->replicas.values);
+    
+    pool->replicas.count = 0;
+    pool->replicas.values = NULL;
+}
+
+static unsigned int px_pool_pick_replica(px_pool *restrict pool, const uint64_t now)
+{
+    const unsigned int count = pool->replicas.count;
+    const unsigned int next = __atomic_fetch_add(&pool->next_replica, 1, __ATOMIC_RELAXED) % count;
+    
+    if (pool->routing != px_pool_routing_least_outstanding)
+    {
+        // the turns only go around the hosts that are up, so the one after a failed host doesn't get twice the share
+        unsigned int available = 0;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (__atomic_load_n(&pool->replicas.values[i]->retry_after, __ATOMIC_RELAXED) <= now)
+                available++;
+        }
+        
+        unsigned int skipped = available == 0 ? 0 : next % available;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (__atomic_load_n(&pool->replicas.values[i]->retry_after, __ATOMIC_RELAXED) <= now && skipped-- == 0)
+                return i;
+        }
+        
+        return next;
+    }
+    
+    // ties go to the standbys in turn, so that an idle cluster still gets an even spread
+    unsigned int picked = next;
+    unsigned int least = UINT_MAX;
+    
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const unsigned int index = (next + i) % count;
+        const px_pool *replica = pool->replicas.values[index];
+        if (__atomic_load_n(&replica->retry_after, __ATOMIC_RELAXED) > now)
+            continue;
+        
+        const unsigned int outstanding = __atomic_load_n(&replica->outstanding, __ATOMIC_RELAXED);
+        if (outstanding < least)
+        {
+            least = outstanding;
+            picked = index;
+        }
+    }
+    
+    return picked;
+}
+
+static void px_pool_stack_push(px_pool *restrict pool, volatile uint64_t *head, const unsigned int index)
+{
+    uint64_t old_head = __atomic_load_n(head, __ATOMIC_RELAXED);
+    uint64_t new_head;
+    
+    do
+    {
+        __atomic_store_n(&pool->slots[index].next, (unsigned int)(old_head & px_pool_stack_index_mask), __ATOMIC_RELAXED);
+        new_head = (((old_head >> 32) + 1) << 32) | (index + 1);
+    } while (!__atomic_compare_exchange_n(head, &old_head, new_head, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+}
+
+static bool px_pool_stack_pop(px_pool *restrict pool, volatile uint64_t *head, unsigned int *restrict index)
+{
+    uint64_t old_head = __atomic_load_n(head, __ATOMIC_ACQUIRE);
+    uint64_t new_head;
+    unsigned int top;
+    
+    // the tag in the upper half changes on every push and pop, so a stale next
+    // read from a slot that has been popped and pushed again never gets installed
+    do
+    {
+        top = (unsigned int)(old_head & px_pool_stack_index_mask);
+        if (top == 0)
+            return false;
+        
+        const unsigned int next = __atomic_load_n(&pool->slots[top - 1].next, __ATOMIC_RELAXED);
+        new_head = (((old_head >> 32) + 1) << 32) | next;
+    } while (!__atomic_compare_exchange_n(head, &old_head, new_head, true, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE));
+    
+    *index = top - 1;
+    return true;
+}
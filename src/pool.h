@@ -0,0 +1,108 @@
+//
+//  pool.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_pool_h
+#define libpx_pool_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "typedef.h"
+
+typedef enum px_pool_slot_state
+{
+    px_pool_slot_state_empty = 0,       // no connection, on the empty stack
+    px_pool_slot_state_idle = 1,        // open connection, on the idle stack
+    px_pool_slot_state_cached = 2,      // open connection, parked in a thread's cache
+    px_pool_slot_state_in_use = 3,      // handed out by px_pool_acquire
+    px_pool_slot_state_reaping = 4,     // being closed by px_pool_reap while still on the idle stack
+    px_pool_slot_state_reaped = 5       // closed by px_pool_reap, waiting to be moved to the empty stack
+} px_pool_slot_state;
+
+typedef enum px_pool_routing
+{
+    px_pool_routing_none = 0,               // read-only connections come from the pool itself
+    px_pool_routing_round_robin = 1,        // read-only connections come from the standbys in turn
+    px_pool_routing_least_outstanding = 2   // read-only connections come from the standby with the fewest in use
+} px_pool_routing;
+
+typedef struct px_pool_slot
+{
+    px_connection *connection;
+    uint64_t last_used;
+    volatile unsigned int next;
+    volatile int state;
+} px_pool_slot;
+
+struct px_pool
+{
+    px_connection_params *connection_params;
+    unsigned int serial;
+    unsigned int min_size;
+    unsigned int max_size;
+    int acquire_timeout;
+    unsigned int idle_timeout;
+    
+    // every slot is on exactly one of the stacks or owned by a single thread;
+    // a stack head is a generation tag in the upper half and slot index + 1 in the lower half
+    px_pool_slot *slots;
+    volatile uint64_t idle_head;
+    volatile uint64_t empty_head;
+    volatile unsigned int size;
+    volatile uint64_t next_reap;
+    
+    // only used when a thread has to wait for a connection
+    volatile unsigned int waiters;
+    unsigned int generation;
+    pthread_mutex_t mutex;
+    pthread_cond_t available;
+    
+    // read-only connections are spread over a pool per host that only accepts standbys
+    px_pool_routing routing;
+    struct
+    {
+        unsigned int count;
+        px_pool **values;
+    } replicas;
+    volatile unsigned int next_replica;
+    
+    // only maintained for the pools of standbys
+    bool replica;
+    volatile unsigned int outstanding;
+    volatile uint64_t retry_after;
+    
+    // the types of the server, shared by the connections of the pool
+    px_type_cache *type_cache;
+};
+
+// creation & deletion
+px_pool *px_pool_new(const px_connection_params *restrict connection_params, const unsigned int min_size, const unsigned int max_size);
+void px_pool_delete(px_pool *pool);
+
+// settings
+void px_pool_set_acquire_timeout(px_pool *restrict pool, const int timeout);
+void px_pool_set_idle_timeout(px_pool *restrict pool, const unsigned int timeout);
+void px_pool_set_routing(px_pool *restrict pool, const px_pool_routing routing);
+
+// getting information about a pool
+unsigned int px_pool_get_size(const px_pool *restrict pool);
+const px_connection_params *px_pool_get_connection_params(const px_pool *restrict pool) __attribute__((pure));
+px_type_cache *px_pool_get_type_cache(const px_pool *restrict pool) __attribute__((pure));
+
+// acquiring & releasing connections
+px_connection *px_pool_acquire(px_pool *restrict pool);
+px_connection *px_pool_acquire_read_only(px_pool *restrict pool);
+void px_pool_release(px_pool *restrict pool, px_connection *restrict connection);
+
+// opening connections ahead of time
+unsigned int px_pool_warm(px_pool *restrict pool, const unsigned int count);
+
+// closing connections that have been idle for too long
+unsigned int px_pool_reap(px_pool *restrict pool);
+
+#endif
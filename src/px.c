@@ -9,6 +9,7 @@
 #include <err.h>
 #include <getopt.h>
 #include <pwd.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,10 +21,16 @@
 
 static bool use_colors = true;
 static bool detailed_errors = true;
+static volatile sig_atomic_t stop_requested = 0;
 
 static void repl(px_connection *restrict connection);
 static void eval(px_connection *restrict connection, const char *restrict command_text);
 static void print_help(void);
+static bool parse_ssl_mode(const char *restrict value, px_connection_params *restrict connection_params);
+static int receive_wal(px_connection *restrict connection, const char *restrict directory, const char *restrict slot_name, const unsigned int sync_interval, const bool direct_io);
+static bool parse_compression(const char *restrict value, px_compression_algorithm *restrict algorithm, int *restrict level);
+static int take_base_backup(px_connection *restrict connection, const char *restrict directory, const px_compression_algorithm algorithm, const int level, const unsigned int job_count, const bool fast_checkpoint);
+static void request_stop(int signal_number);
 static void print_px_error(const px_error *restrict error);
 static void print_result(const px_result *restrict result);
 static void print_result_summary(const px_result *restrict result);
@@ -41,6 +48,15 @@ static bool describe_table_constraints(px_connection *restrict connection, const
 int main(int argc, char *const argv[])
 {
     px_connection_params *connectionParams = px_connection_params_new();
+    const char *wal_directory = NULL;
+    const char *slot_name = NULL;
+    unsigned int sync_interval = 10000;
+    bool direct_io = false;
+    const char *backup_directory = NULL;
+    px_compression_algorithm compression = px_compression_is_available(px_compression_algorithm_zstd) ? px_compression_algorithm_zstd : px_compression_algorithm_gzip;
+    int compression_level = 0;
+    unsigned int job_count = 0;
+    bool fast_checkpoint = false;
     
     while (1)
     {
@@ -49,6 +65,15 @@ int main(int argc, char *const argv[])
             { "username", required_argument, NULL, 'u' },
             { "host", required_argument, NULL, 'h' },
             { "database", required_argument, NULL, 'd' },
+            { "sslmode", required_argument, NULL, 2 },
+            { "receive-wal", required_argument, NULL, 3 },
+            { "slot", required_argument, NULL, 4 },
+            { "sync-interval", required_argument, NULL, 5 },
+            { "direct-io", no_argument, NULL, 6 },
+            { "base-backup", required_argument, NULL, 7 },
+            { "compress", required_argument, NULL, 8 },
+            { "jobs", required_argument, NULL, 9 },
+            { "fast-checkpoint", no_argument, NULL, 10 },
             { "help", no_argument, NULL, 1 },
             { NULL, 0, 0, 0 }
         };
@@ -72,6 +97,49 @@ int main(int argc, char *const argv[])
             case 'd':
                 px_connection_params_set_database(connectionParams, optarg);
                 break;
+            case 2:
+                if (!parse_ssl_mode(optarg, connectionParams))
+                    errx(2, "invalid sslmode: %s", optarg);
+                break;
+            case 3:
+                wal_directory = optarg;
+                break;
+            case 4:
+                slot_name = optarg;
+                break;
+            case 5:
+            {
+                char *end;
+                const unsigned long value = strtoul(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0' || value > INT32_MAX)
+                    errx(2, "invalid sync interval: %s", optarg);
+                
+                sync_interval = (unsigned int)value;
+                break;
+            }
+            case 6:
+                direct_io = true;
+                break;
+            case 7:
+                backup_directory = optarg;
+                break;
+            case 8:
+                if (!parse_compression(optarg, &compression, &compression_level))
+                    errx(2, "invalid compression: %s", optarg);
+                break;
+            case 9:
+            {
+                char *end;
+                const unsigned long value = strtoul(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0' || value == 0 || value > 1024)
+                    errx(2, "invalid number of jobs: %s", optarg);
+                
+                job_count = (unsigned int)value;
+                break;
+            }
+            case 10:
+                fast_checkpoint = true;
+                break;
             case 1:
                 print_help();
                 exit(0);
@@ -106,7 +174,10 @@ int main(int argc, char *const argv[])
         px_connection_params_set_port(connectionParams, 5432);
     }
     
-    px_connection_params_set_application_name(connectionParams, "px");
+    px_connection_params_set_application_name(connectionParams, wal_directory != NULL ? "px_receivewal" : backup_directory != NULL ? "px_basebackup" : "px");
+    
+    if (wal_directory != NULL || backup_directory != NULL)
+        px_connection_params_set_replication_mode(connectionParams, px_replication_mode_physical);
     
     px_connection *connection = px_connection_new(connectionParams);
     px_connection_params_delete(connectionParams);
@@ -148,10 +219,25 @@ int main(int argc, char *const argv[])
         }
     }
     
-    repl(connection);
+    int exit_code = 0;
+    if (wal_directory != NULL)
+        exit_code = receive_wal(connection, wal_directory, slot_name, sync_interval, direct_io);
+    else if (backup_directory != NULL)
+        exit_code = take_base_backup(connection, backup_directory, compression, compression_level, job_count, fast_checkpoint);
+    else
+    {
+        // columns of types other than the built-in ones are shown with their names
+        px_type_cache *type_cache = px_type_cache_new();
+        px_connection_set_type_cache(connection, type_cache);
+        repl(connection);
+        px_connection_set_type_cache(connection, NULL);
+        px_type_cache_delete(type_cache);
+    }
     
     px_connection_close(connection);
     px_connection_delete(connection);
+    
+    return exit_code;
 }
 
 static void print_help(void)
@@ -161,13 +247,155 @@ static void print_help(void)
         "px is a command line client for PostgreSQL.\n\n"
         "Options\n"
         " -u, --username=USERNAME    username to connect with\n"
-        " -h, --host=HOST            the hostname of the database to connect to\n"
+        " -h, --host=HOST            the hostname of the database to connect to or the\n"
+        "                            directory of its unix domain socket\n"
         " -d, --database=DATABASE    the name of the database to connect to\n"
+        "     --sslmode=MODE         disable, prefer (default), require, verify-ca or\n"
+        "                            verify-full\n"
+        "     --receive-wal=DIRECTORY\n"
+        "                            archives the WAL of the server into DIRECTORY until\n"
+        "                            interrupted instead of starting a prompt\n"
+        "     --slot=SLOT            the physical replication slot to stream from\n"
+        "     --sync-interval=MS     how often the WAL received is synced to disk and\n"
+        "                            reported to the server, 0 syncs whenever the\n"
+        "                            stream goes idle (default: 10000)\n"
+        "     --direct-io            writes the WAL with O_DIRECT\n"
+        "     --base-backup=DIRECTORY\n"
+        "                            takes a base backup of the server into DIRECTORY\n"
+        "                            instead of starting a prompt\n"
+        "     --compress=METHOD[:LEVEL]\n"
+        "                            none, gzip or zstd (default: zstd if available,\n"
+        "                            gzip otherwise)\n"
+        "     --jobs=N               the number of threads compressing the backup\n"
+        "                            (default: the number of processors)\n"
+        "     --fast-checkpoint      starts the backup with an immediate checkpoint\n"
         "     --help                 shows this help\n";
-
+    
     printf("%s", help_text);
 }
 
+static bool parse_ssl_mode(const char *restrict value, px_connection_params *restrict connection_params)
+{
+    static const char *names[] = { "prefer", "disable", "require", "verify-ca", "verify-full" };
+    
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (strcmp(value, names[i]) == 0)
+        {
+            px_connection_params_set_ssl_mode(connection_params, (px_ssl_mode)i);
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+static int receive_wal(px_connection *restrict connection, const char *restrict directory, const char *restrict slot_name, const unsigned int sync_interval, const bool direct_io)
+{
+    px_wal_receiver *wal_receiver = px_wal_receiver_new(connection, directory);
+    px_wal_receiver_set_sync_interval(wal_receiver, sync_interval);
+    px_wal_receiver_set_direct_io(wal_receiver, direct_io);
+    
+    // the stream is stopped cleanly, so that everything received is synced and reported
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    
+    bool success = px_wal_receiver_start(wal_receiver, slot_name, 0, 0);
+    if (success)
+    {
+        while (!stop_requested && px_wal_receiver_receive(wal_receiver, 1000))
+            ;
+        
+        // the stream only ends on its own because of errors or the server shutting down
+        success = stop_requested ? px_wal_receiver_stop(wal_receiver) : px_connection_get_last_error(connection) == NULL;
+    }
+    
+    if (success)
+    {
+        char lsn[PX_LSN_STRING_SIZE];
+        px_replication_format_lsn(px_wal_receiver_get_synced_lsn(wal_receiver), lsn);
+        printf("Received the WAL up to %s on timeline %u.\n", lsn, px_wal_receiver_get_timeline(wal_receiver));
+    }
+    else
+    {
+        print_px_error(px_connection_get_last_error(connection));
+    }
+    
+    px_wal_receiver_delete(wal_receiver);
+    
+    return success ? 0 : 1;
+}
+
+static bool parse_compression(const char *restrict value, px_compression_algorithm *restrict algorithm, int *restrict level)
+{
+    char name[16];
+    const char *separator = strchr(value, ':');
+    const size_t name_length = separator == NULL ? strlen(value) : (size_t)(separator - value);
+    if (name_length >= sizeof(name))
+        return false;
+    
+    memcpy(name, value, name_length);
+    name[name_length] = '\0';
+    
+    if (!px_compression_parse_algorithm(name, algorithm))
+        return false;
+    
+    *level = 0;
+    if (separator != NULL)
+    {
+        char *end;
+        const long parsed_level = strtol(separator + 1, &end, 10);
+        if (separator[1] == '\0' || *end != '\0' || parsed_level < 1 || parsed_level > 22)
+            return false;
+        
+        *level = (int)parsed_level;
+    }
+    
+    if (!px_compression_is_available(*algorithm))
+        warnx("%s is not available, using gzip", name);
+    
+    return true;
+}
+
+static int take_base_backup(px_connection *restrict connection, const char *restrict directory, const px_compression_algorithm algorithm, const int level, const unsigned int job_count, const bool fast_checkpoint)
+{
+    px_base_backup *base_backup = px_base_backup_new(connection, directory);
+    px_base_backup_set_compression(base_backup, algorithm, level);
+    px_base_backup_set_fast_checkpoint(base_backup, fast_checkpoint);
+    if (job_count > 0)
+        px_base_backup_set_thread_count(base_backup, job_count);
+    
+    const bool success = px_base_backup_run(base_backup);
+    if (success)
+    {
+        char start_lsn[PX_LSN_STRING_SIZE], end_lsn[PX_LSN_STRING_SIZE];
+        px_replication_format_lsn(px_base_backup_get_start_lsn(base_backup), start_lsn);
+        px_replication_format_lsn(px_base_backup_get_end_lsn(base_backup), end_lsn);
+        printf("Base backup from %s to %s on timeline %u: %llu bytes received, %llu bytes written.\n", start_lsn, end_lsn, px_base_backup_get_timeline(base_backup), (unsigned long long)px_base_backup_get_received_size(base_backup), (unsigned long long)px_base_backup_get_written_size(base_backup));
+    }
+    else
+    {
+        print_px_error(px_connection_get_last_error(connection));
+    }
+    
+    px_base_backup_delete(base_backup);
+    
+    return success ? 0 : 1;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+static void request_stop(int signal_number)
+{
+    stop_requested = 1;
+}
+
+#pragma clang diagnostic pop
+
 static void repl(px_connection *restrict connection)
 {
     char prompt[256];
@@ -317,7 +545,7 @@ static void print_result(const px_result *restrict result)
         {
             printf(" ");
         }
-
+        
     }
     printf("│\n");
     
@@ -608,7 +836,7 @@ static bool describe_table_columns(px_connection *restrict connection, const cha
     {
         print_px_error(px_connection_get_last_error(connection));
     }
-
+    
     px_result_list_delete(result_list, false);
     
     return success;
@@ -10,14 +10,25 @@
 #define libpx_px_h
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 // structs
+typedef struct px_base_backup px_base_backup;
 typedef struct px_connection px_connection;
 typedef struct px_connection_params px_connection_params;
 typedef struct px_error px_error;
+typedef struct px_notification px_notification;
 typedef struct px_parameter px_parameter;
+typedef struct px_pgoutput px_pgoutput;
+typedef struct px_pool px_pool;
 typedef struct px_query px_query;
+typedef struct px_reactor px_reactor;
+typedef struct px_replication px_replication;
 typedef struct px_result px_result;
+typedef struct px_result_cache px_result_cache;
+typedef struct px_type_cache px_type_cache;
+typedef struct px_wal_receiver px_wal_receiver;
 
 typedef struct px_result_list
 {
@@ -44,9 +55,70 @@ typedef enum px_connection_attempt_result
     px_connection_attempt_result_authentication_failed = 4,
     px_connection_attempt_result_cannot_send_startup_message = 5,
     px_connection_attempt_result_startup_timeout = 6,
-    px_connection_attempt_result_unrecognized_server_message = 7
+    px_connection_attempt_result_unrecognized_server_message = 7,
+    px_connection_attempt_result_server_error = 8,
+    px_connection_attempt_result_session_type_mismatch = 9,
+    px_connection_attempt_result_ssl_failed = 10
 } px_connection_attempt_result;
 
+typedef enum px_target_session_type
+{
+    px_target_session_type_any = 0,
+    px_target_session_type_read_write = 1,
+    px_target_session_type_read_only = 2,
+    px_target_session_type_primary = 3,
+    px_target_session_type_standby = 4,
+    px_target_session_type_prefer_standby = 5
+} px_target_session_type;
+
+typedef enum px_ssl_mode
+{
+    px_ssl_mode_prefer = 0,
+    px_ssl_mode_disable = 1,
+    px_ssl_mode_require = 2,
+    px_ssl_mode_verify_ca = 3,
+    px_ssl_mode_verify_full = 4
+} px_ssl_mode;
+
+typedef enum px_replication_mode
+{
+    px_replication_mode_none = 0,
+    px_replication_mode_physical = 1,
+    px_replication_mode_logical = 2
+} px_replication_mode;
+
+typedef enum px_connection_session_state
+{
+    px_connection_session_state_clean = 0,
+    px_connection_session_state_settings = 1 << 0,
+    px_connection_session_state_listening = 1 << 1,
+    px_connection_session_state_temp_tables = 1 << 2,
+    px_connection_session_state_advisory_locks = 1 << 3,
+    px_connection_session_state_held_cursors = 1 << 4
+} px_connection_session_state;
+
+typedef enum px_pool_routing
+{
+    px_pool_routing_none = 0,
+    px_pool_routing_round_robin = 1,
+    px_pool_routing_least_outstanding = 2
+} px_pool_routing;
+
+typedef enum px_connection_polling_status
+{
+    px_connection_polling_status_failed = -1,
+    px_connection_polling_status_ok = 0,
+    px_connection_polling_status_reading = 1,   // wait until the socket is readable (POLLIN)
+    px_connection_polling_status_writing = 2    // wait until the socket is writable (POLLOUT)
+} px_connection_polling_status;
+
+typedef enum px_connection_flush_result
+{
+    px_connection_flush_result_failed = -1,
+    px_connection_flush_result_done = 0,
+    px_connection_flush_result_pending = 1      // call again once the socket is writable
+} px_connection_flush_result;
+
 typedef enum px_command_type
 {
     px_command_type_unknown = 0,
@@ -59,10 +131,223 @@ typedef enum px_command_type
     px_command_type_copy
 } px_command_type;
 
+typedef enum px_reactor_backend_type
+{
+    px_reactor_backend_type_default = 0,        // the best one available
+    px_reactor_backend_type_poll = 1,
+    px_reactor_backend_type_epoll = 2,          // Linux
+    px_reactor_backend_type_io_uring = 3        // Linux 6.0 or later, built with IO_URING=1
+} px_reactor_backend_type;
+
+typedef enum px_compression_algorithm
+{
+    px_compression_algorithm_none = 0,
+    px_compression_algorithm_gzip = 1,          // zlib with ZLIB=1, a built-in encoder otherwise
+    px_compression_algorithm_zstd = 2           // built with ZSTD=1
+} px_compression_algorithm;
+
 typedef unsigned int px_datatype;
 
+// how values of a type are sent in binary, told by the receive function of the type
+typedef enum px_type_receive
+{
+    px_type_receive_unknown = 0,
+    px_type_receive_bool = 1,
+    px_type_receive_bytea = 2,
+    px_type_receive_char = 3,
+    px_type_receive_int16 = 4,
+    px_type_receive_int32 = 5,
+    px_type_receive_int64 = 6,
+    px_type_receive_oid = 7,
+    px_type_receive_single = 8,
+    px_type_receive_double = 9,
+    px_type_receive_numeric = 10,
+    px_type_receive_text = 11,
+    px_type_receive_uuid = 12,
+    px_type_receive_date = 13,
+    px_type_receive_time = 14,
+    px_type_receive_timestamp = 15,
+    px_type_receive_timestampz = 16,
+    px_type_receive_interval = 17,
+    px_type_receive_json = 18,
+    px_type_receive_jsonb = 19,
+    px_type_receive_array = 20,
+    px_type_receive_record = 21,
+    px_type_receive_range = 22,
+    px_type_receive_domain = 23
+} px_type_receive;
+
+// arrays: the values are a typed buffer by the type of the elements, the strings of string elements
+// are in the heap of the array
+typedef enum px_array_element_kind
+{
+    px_array_element_kind_string = 0,   // const char *, the text of any other type
+    px_array_element_kind_bool = 1,     // bool
+    px_array_element_kind_int16 = 2,    // int16_t
+    px_array_element_kind_int32 = 3,    // int32_t
+    px_array_element_kind_int64 = 4,    // int64_t
+    px_array_element_kind_single = 5,   // float
+    px_array_element_kind_double = 6,   // double
+    px_array_element_kind_oid = 7       // uint32_t
+} px_array_element_kind;
+
+#define PX_ARRAY_MAX_DIMENSIONS 6
+
+typedef struct px_array
+{
+    unsigned int element_oid;
+    px_array_element_kind element_kind;
+    unsigned int dimension_count;
+    int dimensions[PX_ARRAY_MAX_DIMENSIONS];
+    int lower_bounds[PX_ARRAY_MAX_DIMENSIONS];
+    unsigned int count;
+    unsigned int null_count;
+    void *values;
+    uint8_t *nulls;
+    char *heap;
+} px_array;
+
+// a row of pg_type: the name is the one in the catalog (_int4), the formatted name the one in SQL (integer[])
+typedef struct px_type
+{
+    unsigned int oid;
+    char *name;
+    char *formatted_name;
+    short length;
+    char kind;
+    char category;
+    unsigned int element_oid;
+    unsigned int array_oid;
+    unsigned int base_oid;
+    char delimiter;
+    px_type_receive receive;
+} px_type;
+
+// the WAL sent by the server (XLogData), a change decoded by the output plugin in logical streams.
+// end_lsn is where the WAL ended on the server when it was sent
+typedef struct px_replication_data
+{
+    uint64_t start_lsn;
+    uint64_t end_lsn;
+    int64_t send_time;
+    const char *data;
+    size_t length;
+} px_replication_data;
+
+typedef enum px_pgoutput_message_type
+{
+    px_pgoutput_message_type_begin = 'B',
+    px_pgoutput_message_type_commit = 'C',
+    px_pgoutput_message_type_origin = 'O',
+    px_pgoutput_message_type_relation = 'R',
+    px_pgoutput_message_type_type = 'Y',
+    px_pgoutput_message_type_insert = 'I',
+    px_pgoutput_message_type_update = 'U',
+    px_pgoutput_message_type_delete = 'D',
+    px_pgoutput_message_type_truncate = 'T',
+    px_pgoutput_message_type_message = 'M'
+} px_pgoutput_message_type;
+
+typedef enum px_pgoutput_value_kind
+{
+    px_pgoutput_value_kind_null = 'n',
+    px_pgoutput_value_kind_unchanged_toast = 'u',
+    px_pgoutput_value_kind_text = 't',
+    px_pgoutput_value_kind_binary = 'b'
+} px_pgoutput_value_kind;
+
+typedef struct px_pgoutput_column
+{
+    char *name;
+    unsigned int datatype_oid;
+    int type_modifier;
+    bool key;
+} px_pgoutput_column;
+
+typedef struct px_pgoutput_relation
+{
+    unsigned int oid;
+    char *namespace;
+    char *name;
+    char replica_identity;
+    unsigned int column_count;
+    px_pgoutput_column *columns;
+} px_pgoutput_relation;
+
+// the data of a value isn't zero terminated
+typedef struct px_pgoutput_value
+{
+    px_pgoutput_value_kind kind;
+    unsigned int length;
+    const char *data;
+} px_pgoutput_value;
+
+typedef struct px_pgoutput_tuple
+{
+    unsigned int column_count;
+    px_pgoutput_value *values;
+} px_pgoutput_tuple;
+
+// times are in microseconds since 2000-01-01 00:00:00 UTC
+typedef struct px_pgoutput_message
+{
+    px_pgoutput_message_type type;
+    union
+    {
+        struct
+        {
+            uint64_t final_lsn;
+            int64_t commit_time;
+            uint32_t xid;
+        } begin;
+        struct
+        {
+            uint8_t flags;
+            uint64_t commit_lsn;
+            uint64_t end_lsn;
+            int64_t commit_time;
+        } commit;
+        struct
+        {
+            uint64_t commit_lsn;
+            const char *name;
+        } origin;
+        struct
+        {
+            unsigned int oid;
+            const char *namespace;
+            const char *name;
+        } type;
+        // relation messages only carry the relation, the old tuple of updates and deletes is
+        // either the replica identity key ('K'), the whole old row ('O') or missing (0)
+        struct
+        {
+            const px_pgoutput_relation *relation;
+            char old_tuple_kind;
+            px_pgoutput_tuple old_tuple;
+            px_pgoutput_tuple new_tuple;
+        } change;
+        struct
+        {
+            uint8_t options;
+            unsigned int relation_count;
+            const unsigned int *relation_oids;
+        } truncate;
+        struct
+        {
+            uint8_t flags;
+            uint64_t lsn;
+            const char *prefix;
+            unsigned int length;
+            const char *content;
+        } message;
+    } data;
+} px_pgoutput_message;
+
 // function pointer types
 typedef bool PXPasswordCallback(const px_connection* connection, void *context);
+typedef bool PXNotificationCallback(px_connection *connection, const px_notification *notification, void *context);
+typedef void PXReactorCallback(px_reactor *reactor, px_connection *connection, px_result_list *results, void *context);
 
 // creation & deletion of connection params
 px_connection_params *px_connection_params_new(void);
@@ -70,12 +355,17 @@ px_connection_params *px_connection_params_copy(const px_connection_params *rest
 void px_connection_params_delete(px_connection_params *connection_params);
 
 // getters & setters of connection params
+// a hostname starting with '/' is the directory of the server's unix domain socket, e.g. /tmp or /var/run/postgresql.
+// several hosts can be given separated by commas, they are tried in order until one of them matches the
+// target session type (any by default; standbys are told apart by the in_hot_standby setting of PostgreSQL 14+)
 const char *px_connection_params_get_hostname(const px_connection_params *restrict connection_params) __attribute__((pure));
 void px_connection_params_set_hostname(px_connection_params *restrict connectionParams, const char *restrict value);
 
 const char *px_connection_params_get_username(const px_connection_params *restrict connection_params) __attribute__((pure));
 void px_connection_params_set_username(px_connection_params *restrict connection_params, const char *restrict value);
 
+// the password is used for MD5 and SCRAM-SHA-256 authentication. the SCRAM keys derived from it are cached
+// per salt and iteration count, so the connections of a pool and reopened connections skip PBKDF2
 const char *px_connection_params_get_password(const px_connection_params *restrict connection_params) __attribute__((pure));
 void px_connection_params_set_password(px_connection_params *restrict connection_params, const char *restrict value);
 
@@ -88,6 +378,65 @@ void px_connection_params_set_port(px_connection_params *restrict connection_par
 const char *px_connection_params_get_application_name(const px_connection_params *restrict connection_params) __attribute__((pure));
 void px_connection_params_set_application_name(px_connection_params *restrict connection_params, const char *restrict value);
 
+px_target_session_type px_connection_params_get_target_session_type(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_target_session_type(px_connection_params *restrict connection_params, const px_target_session_type value);
+
+unsigned int px_connection_params_get_host_count(const px_connection_params *restrict connection_params) __attribute__((pure));
+const char *px_connection_params_get_host(const px_connection_params *restrict connection_params, const unsigned int index) __attribute__((pure));
+
+// resolved addresses are reused for this many seconds (60 by default, 0 resolves on every open)
+unsigned int px_connection_params_get_address_ttl(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_address_ttl(px_connection_params *restrict connection_params, const unsigned int value);
+
+// every address a host resolves to is tried, a new attempt starts every 250 ms while the earlier
+// ones are still pending (RFC 8305). the connect timeout (in milliseconds, 0 for the system's)
+// limits how long a host gets before the next one is tried
+unsigned int px_connection_params_get_connect_timeout(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_connect_timeout(px_connection_params *restrict connection_params, const unsigned int value);
+
+// TLS of TCP connections, as in libpq. prefer (the default) falls back to plaintext when the server
+// or the build doesn't support it, require insists on encryption, verify-ca also checks the
+// certificate of the server against the root certificates (the default trust store when NULL) and
+// verify-full its host name as well. sessions are resumed by later connections using the same params
+px_ssl_mode px_connection_params_get_ssl_mode(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_ssl_mode(px_connection_params *restrict connection_params, const px_ssl_mode value);
+
+const char *px_connection_params_get_ssl_root_cert(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_ssl_root_cert(px_connection_params *restrict connection_params, const char *restrict value);
+
+// replication connections stream the WAL of the whole cluster (physical) or the changes decoded
+// from the WAL of the database (logical) with px_replication, besides that they only accept
+// simple queries and replication commands such as IDENTIFY_SYSTEM and CREATE_REPLICATION_SLOT
+px_replication_mode px_connection_params_get_replication_mode(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_replication_mode(px_connection_params *restrict connection_params, const px_replication_mode value);
+
+// socket options of TCP connections. TCP_NODELAY is on by default, buffer sizes of 0 leave the
+// system defaults in place. the keepalive idle time and interval are in seconds, the user timeout
+// (TCP_USER_TIMEOUT, only supported on Linux) in milliseconds; 0 leaves them unchanged
+bool px_connection_params_get_tcp_nodelay(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_tcp_nodelay(px_connection_params *restrict connection_params, const bool value);
+
+int px_connection_params_get_receive_buffer_size(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_receive_buffer_size(px_connection_params *restrict connection_params, const int value);
+
+int px_connection_params_get_send_buffer_size(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_send_buffer_size(px_connection_params *restrict connection_params, const int value);
+
+bool px_connection_params_get_keepalive(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_keepalive(px_connection_params *restrict connection_params, const bool value);
+
+unsigned int px_connection_params_get_keepalive_idle(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_keepalive_idle(px_connection_params *restrict connection_params, const unsigned int value);
+
+unsigned int px_connection_params_get_keepalive_interval(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_keepalive_interval(px_connection_params *restrict connection_params, const unsigned int value);
+
+unsigned int px_connection_params_get_keepalive_count(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_keepalive_count(px_connection_params *restrict connection_params, const unsigned int value);
+
+unsigned int px_connection_params_get_user_timeout(const px_connection_params *restrict connection_params) __attribute__((pure));
+void px_connection_params_set_user_timeout(px_connection_params *restrict connection_params, const unsigned int value);
+
 // creation & deletion of connections
 px_connection *px_connection_new(px_connection_params *connection_params);
 void px_connection_delete(px_connection *connection);
@@ -98,14 +447,130 @@ void px_connection_close(px_connection *restrict connection);
 
 px_connection_attempt_result px_connection_authenticate(px_connection *restrict connection);
 
+// opening a connection without blocking: call px_connection_open_poll whenever the socket
+// is ready for the events requested by the previous call until it returns ok or failed.
+// while connecting, px_connection_get_open_timeout tells how many milliseconds later it has to
+// be called even if the socket isn't ready (-1 if never), as the socket may change in between
+bool px_connection_open_start(px_connection *restrict connection);
+px_connection_polling_status px_connection_open_poll(px_connection *restrict connection);
+int px_connection_get_open_timeout(const px_connection *restrict connection);
+
 // getting information about a connection
 px_connection_status px_connection_get_status(const px_connection *restrict connection) __attribute__((pure));
 px_connection_params *px_connection_get_connection_params(const px_connection *restrict connection) __attribute__((pure));
 const px_error *px_connection_get_last_error(const px_connection *restrict connection) __attribute__((pure));
+px_connection_attempt_result px_connection_get_attempt_result(const px_connection *restrict connection) __attribute__((pure));
+int px_connection_get_socket(const px_connection *restrict connection) __attribute__((pure));
+const char *px_connection_get_host(const px_connection *restrict connection) __attribute__((pure));
+const char *px_connection_get_runtime_parameter(const px_connection *restrict connection, const char *restrict name) __attribute__((pure));
+
+// the runtime parameters the server reported last, that decoding values depends on. the server
+// version is in the format of server_version_num (e.g. 160002), 0 before the server reports it
+int px_connection_get_server_version_number(const px_connection *restrict connection) __attribute__((pure));
+bool px_connection_has_integer_datetimes(const px_connection *restrict connection) __attribute__((pure));
+bool px_connection_is_client_encoding_utf8(const px_connection *restrict connection) __attribute__((pure));
+
+// whether the connection is encrypted and whether the kernel decrypts what the server sends (kTLS)
+bool px_connection_is_encrypted(const px_connection *restrict connection) __attribute__((pure));
+bool px_connection_is_kernel_tls(const px_connection *restrict connection);
+
+// what has been changed about the session since it was opened, a combination of px_connection_session_state
+unsigned int px_connection_get_session_state(const px_connection *restrict connection) __attribute__((pure));
+
+// the type cache the names and the binary formats of the types of the columns of results are
+// looked up in, NULL for none. the connection and its results hold a reference to it; connections of
+// a pool share its cache
+px_type_cache *px_connection_get_type_cache(const px_connection *restrict connection) __attribute__((pure));
+void px_connection_set_type_cache(px_connection *restrict connection, px_type_cache *type_cache);
+
+// asynchronous query processing: after px_query_send, wait for the socket to become
+// readable and call px_connection_consume_input until px_connection_is_busy returns false,
+// then collect the results with px_connection_get_next_result until it returns NULL
+px_connection_flush_result px_connection_flush(px_connection *restrict connection);
+bool px_connection_consume_input(px_connection *restrict connection);
+bool px_connection_is_busy(px_connection *restrict connection);
+px_result *px_connection_get_next_result(px_connection *restrict connection);
+
+// cancelling the query in progress: sends a cancel request to the server over a new connection
+// and waits for at most 5 seconds for it to be delivered. the cancelled query fails with 57014
+// and its results still have to be collected as usual. like everything else about a connection,
+// it is not meant to be called while another thread is using the connection
+bool px_connection_cancel(const px_connection *restrict connection);
 
 // connection callbacks
 void px_connection_set_password_callback(px_connection *restrict connection, PXPasswordCallback *callback);
 
+// the notification callback is called as soon as a notification is read, even while a query is
+// in progress, so it must not use the connection to run queries. it returns whether to queue the
+// notification for px_connection_get_notification as well
+void px_connection_set_notification_callback(px_connection *restrict connection, PXNotificationCallback *callback, void *context);
+
+// notifications of the channels the session listens to (LISTEN), oldest first. the caller
+// deletes the ones returned. px_connection_get_notification returns NULL if none has been read
+// yet, px_connection_wait_notification waits for at most timeout milliseconds (-1 waits forever)
+// and returns NULL if it runs out or the connection fails. releasing a connection to its pool
+// drops its notifications and its callback
+px_notification *px_connection_get_notification(px_connection *restrict connection);
+px_notification *px_connection_wait_notification(px_connection *restrict connection, const int timeout);
+void px_connection_clear_notifications(px_connection *restrict connection);
+
+// connection pools: connections are opened lazily up to max_size and connections idle for
+// longer than the idle timeout are closed down to min_size. px_pool_acquire blocks for at most
+// the acquire timeout (-1 waits forever) and returns NULL if it runs out or a connection cannot
+// be opened. px_pool_warm opens connections concurrently until the pool has count of them
+// and returns the number of open connections. all pool functions can be called from any thread.
+// with routing enabled, px_pool_acquire_read_only hands out connections to the hosts of the
+// connection params that are standbys, either in turn or the one with the fewest connections in
+// use. a host that can't be connected to is skipped for 5 seconds and when there are no standbys
+// at all, it falls back to px_pool_acquire. the routing has to be set before the pool is used.
+// px_pool_release rolls back an open transaction and resets what the connection changed about
+// its session (settings, LISTEN, temporary tables, advisory locks, held cursors) in one round
+// trip, or sends nothing when it changed nothing. prepared statements are kept
+px_pool *px_pool_new(const px_connection_params *restrict connection_params, const unsigned int min_size, const unsigned int max_size);
+void px_pool_delete(px_pool *pool);
+
+void px_pool_set_acquire_timeout(px_pool *restrict pool, const int timeout);
+void px_pool_set_idle_timeout(px_pool *restrict pool, const unsigned int timeout);
+void px_pool_set_routing(px_pool *restrict pool, const px_pool_routing routing);
+unsigned int px_pool_get_size(const px_pool *restrict pool);
+const px_connection_params *px_pool_get_connection_params(const px_pool *restrict pool) __attribute__((pure));
+px_type_cache *px_pool_get_type_cache(const px_pool *restrict pool) __attribute__((pure));
+
+px_connection *px_pool_acquire(px_pool *restrict pool);
+px_connection *px_pool_acquire_read_only(px_pool *restrict pool);
+void px_pool_release(px_pool *restrict pool, px_connection *restrict connection);
+unsigned int px_pool_warm(px_pool *restrict pool, const unsigned int count);
+unsigned int px_pool_reap(px_pool *restrict pool);
+
+// reactors drive many non-blocking connections from a single thread. connections passed to
+// px_reactor_open or px_reactor_query are owned by the reactor until they are removed. the
+// callback gets the results of a query (NULL on failure) or NULL once an open attempt finished.
+// timeouts are in milliseconds, -1 for none; a query without a timeout uses the one of the query.
+// an open that times out fails and closes the connection, a query that times out is cancelled
+// and drained like in px_query_execute. with the io_uring backend, connections in a reactor
+// must not be used for anything else until they are removed from it
+px_reactor *px_reactor_new(void);
+px_reactor *px_reactor_new_with_backend(const px_reactor_backend_type backend_type);
+void px_reactor_delete(px_reactor *reactor);
+
+bool px_reactor_add(px_reactor *restrict reactor, px_connection *restrict connection);
+void px_reactor_remove(px_reactor *restrict reactor, px_connection *restrict connection);
+
+bool px_reactor_open(px_reactor *restrict reactor, px_connection *restrict connection, const int timeout, PXReactorCallback *callback, void *context);
+bool px_reactor_query(px_reactor *restrict reactor, const px_query *restrict query, const int timeout, PXReactorCallback *callback, void *context);
+
+int px_reactor_run_once(px_reactor *restrict reactor, const int timeout);
+bool px_reactor_run(px_reactor *restrict reactor);
+void px_reactor_stop(px_reactor *restrict reactor);
+unsigned int px_reactor_get_pending(const px_reactor *restrict reactor) __attribute__((pure));
+px_reactor_backend_type px_reactor_get_backend_type(const px_reactor *restrict reactor) __attribute__((pure));
+
+// getting information about a notification
+int px_notification_get_process_id(const px_notification *restrict notification) __attribute__((pure));
+const char *px_notification_get_channel(const px_notification *restrict notification) __attribute__((pure));
+const char *px_notification_get_payload(const px_notification *restrict notification) __attribute__((pure));
+void px_notification_delete(px_notification *notification);
+
 // getting information about an error
 const char *px_error_get_severity(const px_error *restrict error) __attribute__((pure));
 const char *px_error_get_sqlstate(const px_error *restrict error) __attribute__((pure));
@@ -139,10 +604,32 @@ void px_query_add_parameter(px_query *restrict query, const px_parameter *restri
 bool px_query_prepare(const px_query *restrict query);
 bool px_query_bind(const px_query *restrict query);
 px_result_list *px_query_execute(const px_query *restrict query);
-
-// results
+bool px_query_send(const px_query *restrict query);
+
+// runs the statements in a transaction in a single round trip, as one pipeline from BEGIN to
+// COMMIT. returns one result per statement once committed (empty statements have one without a
+// command tag), or NULL once rolled back, in which case the last error is the one of the first
+// statement that failed (or of the COMMIT). NULL with an 08P01 error if it has been committed but
+// the results don't match the statements
+px_result_list *px_query_execute_transaction(px_query *const *restrict queries, const unsigned int count);
+
+// query deadlines in milliseconds (0 for none). a query still running at its deadline is
+// cancelled and the connection is drained; if the server doesn't respond to the cancel request
+// within 5 seconds, the connection is closed. the last error is 57014 in both cases
+unsigned int px_query_get_timeout(const px_query *restrict query) __attribute__((pure));
+void px_query_set_timeout(px_query *restrict query, const unsigned int timeout);
+
+// results in the binary format rather than text, for all the columns (off by default). it saves the
+// server and the client formatting and parsing numbers: the getters of numbers, arrays and strings
+// decode the binary form of the built-in types they support, other values are shown as hex
+bool px_query_has_binary_results(const px_query *restrict query) __attribute__((pure));
+void px_query_set_binary_results(px_query *restrict query, const bool binary_results);
+
+// results. results of a result cache are shared, they are released rather than deleted
 void px_result_delete(px_result *result);
 void px_result_list_delete(px_result_list *result_list, bool keepElements);
+px_result *px_result_retain(px_result *result);
+void px_result_release(px_result *result);
 
 unsigned int px_result_get_column_count(const px_result *restrict result) __attribute__((pure));
 unsigned int px_result_get_row_count(const px_result *restrict result) __attribute__((pure));
@@ -160,6 +647,183 @@ char *px_result_copy_column_datatype_as_string(const px_result *restrict result,
 
 char *px_result_copy_cell_value_as_string(const px_result *restrict result, const unsigned int column, const unsigned int row);
 
+// numbers in either format: decimals are scaled by 10^scale (a value of 12.345 is 1235 with a scale of 2),
+// rounded half away from zero. NULL, NaN, the infinities and values out of range aren't converted
+bool px_result_get_cell_value_as_decimal(const px_result *restrict result, const unsigned int column, const unsigned int row, const unsigned int scale, int64_t *restrict value);
+bool px_result_get_cell_value_as_double(const px_result *restrict result, const unsigned int column, const unsigned int row, double *restrict value);
+
+// arrays in either format, decoded in a single allocation to be deleted with px_array_delete: the
+// elements in row-major order, with a bit set in the NULL bitmap for each NULL (which is 0 or NULL in the
+// values). the element type of arrays of other than the built-in types comes from the type cache of the
+// result, and their elements are strings. NULL for NULL cells and arrays that can't be decoded.
+// px_array_decode_vector reads the text form of int2vector and oidvector, numbers separated by spaces
+px_array *px_result_copy_cell_value_as_array(const px_result *restrict result, const unsigned int column, const unsigned int row);
+px_array *px_array_decode_text(const char *restrict text, const size_t length, const unsigned int element_oid, const char delimiter);
+px_array *px_array_decode_vector(const char *restrict text, const size_t length, const unsigned int element_oid);
+px_array *px_array_decode_binary(const void *restrict data, const size_t length);
+void px_array_delete(px_array *array);
+bool px_array_is_null(const px_array *restrict array, const unsigned int index) __attribute__((pure));
+
+// numeric values in the binary format (e.g. of queries with binary results) without going through
+// their text. px_numeric_format is like snprintf, it returns the length of the whole text, 0 if malformed
+bool px_numeric_decode_int64(const void *restrict data, const size_t length, const unsigned int scale, int64_t *restrict value);
+#ifdef __SIZEOF_INT128__
+bool px_numeric_decode_int128(const void *restrict data, const size_t length, const unsigned int scale, __int128 *restrict value);
+#endif
+bool px_numeric_decode_double(const void *restrict data, const size_t length, double *restrict value);
+size_t px_numeric_format(const void *restrict data, const size_t length, char *restrict text, const size_t size);
+char *px_numeric_copy_string(const void *restrict data, const size_t length);
+bool px_numeric_parse_int64(const char *restrict text, const size_t length, const unsigned int scale, int64_t *restrict value);
+
+// result caches: px_result_cache_execute returns the result of a single statement query from the
+// cache while it is fresh, or runs it on the connection of the query and caches the rows of a
+// SELECT for ttl milliseconds (the default ttl, 60 seconds unless set otherwise, if 0). entries are
+// keyed by the command text and the parameter values, and the least recently used ones are evicted
+// beyond the memory limit in bytes. results read within a transaction aren't cached, as they may
+// include its uncommitted changes. the result returned is immutable and must be released with
+// px_result_release. tags are a comma separated list of the tables the query reads: invalidating
+// any of them evicts the entry, as does a notification on the channel a cache listens to on a
+// connection, the payload being the tags (or nothing to evict everything), e.g. from a trigger
+// calling pg_notify('px_cache', TG_TABLE_NAME). the listening connection has to be read (e.g. with
+// px_connection_wait_notification) for notifications to arrive, its other notifications are queued
+// as usual. a cache can be shared by the connections to the same database and by any thread
+px_result_cache *px_result_cache_new(const size_t memory_limit);
+void px_result_cache_delete(px_result_cache *result_cache);
+
+px_result *px_result_cache_execute(px_result_cache *restrict result_cache, const px_query *restrict query, const unsigned int ttl, const char *restrict tags);
+
+bool px_result_cache_listen(px_result_cache *restrict result_cache, px_connection *restrict connection, const char *restrict channel);
+void px_result_cache_invalidate(px_result_cache *restrict result_cache, const char *restrict tags);
+void px_result_cache_clear(px_result_cache *restrict result_cache);
+
+unsigned int px_result_cache_get_default_ttl(px_result_cache *restrict result_cache);
+void px_result_cache_set_default_ttl(px_result_cache *restrict result_cache, const unsigned int value);
+size_t px_result_cache_get_memory_used(px_result_cache *restrict result_cache);
+size_t px_result_cache_get_count(px_result_cache *restrict result_cache);
+uint64_t px_result_cache_get_hit_count(px_result_cache *restrict result_cache);
+uint64_t px_result_cache_get_miss_count(px_result_cache *restrict result_cache);
+
+// type caches: the types of a server, shared by any number of connections to it and threads.
+// the first time a type is missing the whole catalog is loaded, after that only the types still
+// missing are looked up, in a single round trip. px_query_execute looks up the types of the columns
+// of its results that are missing on the same connection; after that finding them doesn't take a
+// round trip and column types are named by px_result_copy_column_datatype_as_string. types are
+// never removed, they stay valid as long as the cache. the cache is reference counted: deleting it
+// releases the reference of its creator, and it's freed once the connections and results using it are
+px_type_cache *px_type_cache_new(void);
+void px_type_cache_delete(px_type_cache *type_cache);
+px_type_cache *px_type_cache_retain(px_type_cache *type_cache);
+void px_type_cache_release(px_type_cache *type_cache);
+
+const px_type *px_type_cache_find(px_type_cache *restrict type_cache, const unsigned int oid);
+const px_type *px_type_cache_get(px_type_cache *restrict type_cache, px_connection *restrict connection, const unsigned int oid);
+size_t px_type_cache_get_count(px_type_cache *restrict type_cache);
+
+// replication: on a connection opened with a replication mode, px_replication_start_logical
+// streams the changes of the publications (a comma separated list) from a logical replication
+// slot using the pgoutput plugin; a start LSN of 0 resumes where the slot was confirmed last.
+// the data and the changes read are valid until the next read. reading returns NULL when the
+// timeout (in milliseconds, -1 waits forever) runs out or the stream ends, px_replication_is_streaming
+// tells which and the last error of the connection why. standby status updates are sent every
+// status interval (10 seconds by default, 0 for never) while reading and whenever the server asks
+// for one, reporting the position confirmed by px_replication_confirm as flushed and applied
+// (e.g. the end LSN of a commit once the transaction has been processed)
+px_replication *px_replication_new(px_connection *connection);
+void px_replication_delete(px_replication *replication);
+
+bool px_replication_start_logical(px_replication *restrict replication, const char *restrict slot_name, const uint64_t start_lsn, const char *restrict publication_names);
+bool px_replication_stop(px_replication *restrict replication);
+
+// physical streams send the WAL as it is written, optionally through a physical replication slot
+// (NULL for none) and from a given timeline (0 for the current one). when the server has sent all
+// of an earlier timeline it ends the stream, after which the next timeline tells where to continue
+bool px_replication_start_physical(px_replication *restrict replication, const char *restrict slot_name, const uint64_t start_lsn, const unsigned int timeline);
+bool px_replication_identify_system(px_replication *restrict replication, uint64_t *restrict system_identifier, unsigned int *restrict timeline, uint64_t *restrict lsn);
+bool px_replication_fetch_timeline_history(px_replication *restrict replication, const unsigned int timeline, char **restrict file_name, char **restrict content, size_t *restrict length);
+unsigned int px_replication_get_next_timeline(const px_replication *restrict replication) __attribute__((pure));
+uint64_t px_replication_get_next_timeline_lsn(const px_replication *restrict replication) __attribute__((pure));
+
+const px_replication_data *px_replication_read(px_replication *restrict replication, const int timeout);
+const px_pgoutput_message *px_replication_read_change(px_replication *restrict replication, const int timeout);
+
+void px_replication_confirm(px_replication *restrict replication, const uint64_t lsn);
+bool px_replication_send_status(px_replication *restrict replication, const bool reply_requested);
+
+bool px_replication_is_streaming(const px_replication *restrict replication) __attribute__((pure));
+uint64_t px_replication_get_received_lsn(const px_replication *restrict replication) __attribute__((pure));
+uint64_t px_replication_get_server_lsn(const px_replication *restrict replication) __attribute__((pure));
+unsigned int px_replication_get_status_interval(const px_replication *restrict replication) __attribute__((pure));
+void px_replication_set_status_interval(px_replication *restrict replication, const unsigned int value);
+
+// the relations of a logical stream as of the last relation message about them
+const px_pgoutput *px_replication_get_pgoutput(const px_replication *restrict replication) __attribute__((pure));
+const px_pgoutput_relation *px_pgoutput_get_relation(const px_pgoutput *restrict pgoutput, const unsigned int oid) __attribute__((pure));
+
+// LSNs in their text form, the buffer has to hold PX_LSN_STRING_SIZE characters
+#define PX_LSN_STRING_SIZE 18
+bool px_replication_parse_lsn(const char *restrict text, uint64_t *restrict lsn);
+void px_replication_format_lsn(const uint64_t lsn, char *restrict text);
+
+// WAL receiver: archives the WAL of a physical replication connection into a directory as segment
+// files (.partial until complete) and timeline history files ready for restore_command. starting
+// at LSN 0 continues after the last segment in the directory, or at the current position of the
+// server if it is empty. receiving writes the WAL that arrives within the timeout (in milliseconds,
+// -1 waits forever) and returns false once the stream ends, following timeline switches on its own.
+// the WAL is written in 1 MB blocks, with O_DIRECT if direct I/O is set, and synced every sync
+// interval (10 seconds by default, 0 syncs whenever the stream goes idle); the server is told the
+// position synced each time, which is what a replication slot keeps the WAL for
+#define PX_WAL_SEGMENT_SIZE (16 * 1024 * 1024)
+px_wal_receiver *px_wal_receiver_new(px_connection *restrict connection, const char *restrict directory);
+void px_wal_receiver_delete(px_wal_receiver *wal_receiver);
+
+bool px_wal_receiver_start(px_wal_receiver *restrict wal_receiver, const char *restrict slot_name, const uint64_t start_lsn, const unsigned int timeline);
+bool px_wal_receiver_receive(px_wal_receiver *restrict wal_receiver, const int timeout);
+bool px_wal_receiver_sync(px_wal_receiver *restrict wal_receiver);
+bool px_wal_receiver_stop(px_wal_receiver *restrict wal_receiver);
+
+px_replication *px_wal_receiver_get_replication(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+unsigned int px_wal_receiver_get_timeline(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+uint64_t px_wal_receiver_get_written_lsn(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+uint64_t px_wal_receiver_get_synced_lsn(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+uint64_t px_wal_receiver_get_segment_size(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+bool px_wal_receiver_set_segment_size(px_wal_receiver *restrict wal_receiver, const uint64_t value);
+unsigned int px_wal_receiver_get_sync_interval(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+void px_wal_receiver_set_sync_interval(px_wal_receiver *restrict wal_receiver, const unsigned int value);
+bool px_wal_receiver_is_direct_io(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+void px_wal_receiver_set_direct_io(px_wal_receiver *restrict wal_receiver, const bool value);
+
+// base backups: takes a base backup of the server of a physical replication connection (PostgreSQL
+// 15 or later) into a directory, a tar archive for each tablespace (base.tar for the data directory,
+// with the WAL needed to restore it unless disabled) and the backup manifest. archives are cut into
+// chunks (1 MB by default) that are compressed in parallel by a thread per processor unless set
+// otherwise; every chunk is a gzip member or zstd frame of its own, so the archive is still a single
+// valid .gz or .zst file. no more than the memory limit (64 MB by default) is held by chunks waiting
+// to be compressed or written. zstd is the default when available, setting an algorithm that isn't
+// available selects gzip. existing files are never overwritten
+px_base_backup *px_base_backup_new(px_connection *restrict connection, const char *restrict directory);
+void px_base_backup_delete(px_base_backup *base_backup);
+
+bool px_base_backup_run(px_base_backup *restrict base_backup);
+
+uint64_t px_base_backup_get_start_lsn(const px_base_backup *restrict base_backup) __attribute__((pure));
+uint64_t px_base_backup_get_end_lsn(const px_base_backup *restrict base_backup) __attribute__((pure));
+unsigned int px_base_backup_get_timeline(const px_base_backup *restrict base_backup) __attribute__((pure));
+uint64_t px_base_backup_get_received_size(const px_base_backup *restrict base_backup) __attribute__((pure));
+uint64_t px_base_backup_get_written_size(const px_base_backup *restrict base_backup) __attribute__((pure));
+void px_base_backup_set_label(px_base_backup *restrict base_backup, const char *restrict value);
+void px_base_backup_set_fast_checkpoint(px_base_backup *restrict base_backup, const bool value);
+void px_base_backup_set_include_wal(px_base_backup *restrict base_backup, const bool value);
+void px_base_backup_set_manifest(px_base_backup *restrict base_backup, const bool value);
+px_compression_algorithm px_base_backup_get_compression(const px_base_backup *restrict base_backup) __attribute__((pure));
+void px_base_backup_set_compression(px_base_backup *restrict base_backup, const px_compression_algorithm algorithm, const int level);
+void px_base_backup_set_thread_count(px_base_backup *restrict base_backup, const unsigned int value);
+void px_base_backup_set_chunk_size(px_base_backup *restrict base_backup, const size_t value);
+void px_base_backup_set_memory_limit(px_base_backup *restrict base_backup, const size_t value);
+
+// compression algorithms by name: none, gzip or zstd
+bool px_compression_is_available(const px_compression_algorithm algorithm) __attribute__((const));
+bool px_compression_parse_algorithm(const char *restrict name, px_compression_algorithm *restrict algorithm);
+
 // utility functions
 size_t px_utf8_strlen(const char *str) __attribute__((const));
 
@@ -9,6 +9,8 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 #include "query.h"
 #include "connection.h"
 #include "error.h"
@@ -16,18 +18,28 @@
 #include "parameter.h"
 #include "response.h"
 #include "result.h"
+#include "type_cache.h"
 #include "utility.h"
 
 static bool px_query_can_use_simple_query(const px_query *restrict query) __attribute__((pure));
-static px_result_list *px_query_execute_sync_simple(const px_query *restrict query);
-static px_result_list *px_query_execute_sync_extended(const px_query *restrict query);
+static void px_query_queue_simple(const px_query *restrict query);
+static void px_query_queue_extended(const px_query *restrict query);
+static void px_query_queue_statement(const px_query *restrict query);
+static void px_query_queue_transaction_command(px_connection *restrict connection, const char *restrict command_text);
+static bool px_query_check_connection(px_connection *restrict connection);
 
-static bool px_query_parse(const px_query *restrict query);
-static bool px_query_bind(const px_query *restrict query);
-static bool px_query_describe_portal(const px_query *restrict query);
-static bool px_query_execute_portal(const px_query *restrict query);
-static bool px_query_close_portal(const px_query *restrict query);
-static bool px_query_close_statement(const px_query *restrict query);
+static void px_query_parse(const px_query *restrict query);
+static void px_query_bind(const px_query *restrict query);
+static void px_query_describe_portal(const px_query *restrict query);
+static void px_query_execute_portal(const px_query *restrict query);
+static void px_query_close_portal(const px_query *restrict query);
+static void px_query_close_statement(const px_query *restrict query);
+static void px_query_sync(const px_query *restrict query);
+
+static void px_query_track_session_state(const px_query *restrict query);
+static const char *px_query_find_keyword(const char *restrict command_text, const char *restrict keyword) __attribute__((pure));
+static bool px_query_creates_temp_table(const char *restrict command_text) __attribute__((pure));
+static bool px_query_declares_held_cursor(const char *restrict command_text) __attribute__((pure));
 
 px_query *px_query_new(const char *restrict command_text, px_connection *restrict connection)
 {
@@ -71,162 +83,253 @@ void px_query_add_parameter(px_query *restrict query, const px_parameter *restri
     px_parameter_copy_to(new_parameter, parameter);
 }
 
+unsigned int px_query_get_timeout(const px_query *restrict query)
+{
+    return query->timeout;
+}
+
+void px_query_set_timeout(px_query *restrict query, const unsigned int timeout)
+{
+    query->timeout = timeout;
+}
+
+bool px_query_has_binary_results(const px_query *restrict query)
+{
+    return query->binary_results;
+}
+
+void px_query_set_binary_results(px_query *restrict query, const bool binary_results)
+{
+    query->binary_results = binary_results;
+}
+
 static bool px_query_can_use_simple_query(const px_query *restrict query)
 {
-    return query->parameters.count == 0;
+    // only Bind asks for binary results
+    return query->parameters.count == 0 && !query->binary_results;
 }
 
 px_result_list *px_query_execute(const px_query *restrict query)
 {
-#ifdef DEBUG_QUERY
-    printf("query: %s\n", query->command_text);
-#endif
-    if (px_query_can_use_simple_query(query))
+    if (!px_query_send(query) || !px_connection_wait_for_flush(query->connection))
     {
-        return px_query_execute_sync_simple(query);
+        return NULL;
     }
-    else
+    
+    px_result_list *result_list = px_result_list_new();
+    
+    px_result *result;
+    while ((result = px_connection_get_next_result(query->connection)) != NULL)
     {
-        return px_query_execute_sync_extended(query);
+        px_result_list_add(result_list, result);
     }
+    
+    // types the cache of the connection doesn't know yet are looked up once, right away
+    if (query->connection->type_cache != NULL)
+        px_type_cache_resolve(query->connection->type_cache, query->connection, result_list);
+    
+    return result_list;
 }
 
-static px_result_list *px_query_execute_sync_simple(const px_query *restrict query)
+px_result_list *px_query_execute_transaction(px_query *const *restrict queries, const unsigned int count)
 {
-    px_message *query_message = px_message_new("QTs", query->command_text);
-    px_message_send(query_message, query->connection->socket_number);
-    px_message_delete(query_message);
-    
-    px_result_list *result_list = calloc(1, sizeof(px_result_list));
-    result_list->capacity = 1;
-    result_list->results = calloc(result_list->capacity, sizeof(px_result*));
+    if (count == 0)
+        return px_result_list_new();
     
-    px_result *result = px_result_new();
+    px_connection *connection = queries[0]->connection;
     
-    bool ready_for_query = false;
-    while (!ready_for_query)
+    for (unsigned int i = 1; i < count; i++)
     {
-        px_response *response = px_response_read(query->connection);
-        if (response == NULL) return NULL;
-        
-        switch (response->message_type)
+        if (queries[i]->connection != connection)
         {
-            case px_message_type_ready_for_query:
-                ready_for_query = true;
-                break;
-            case px_message_type_row_description:
-                if (result == NULL) break;
-                px_result_add_headers(result,
-                                      response->response_data.row_description.column_count,
-                                      response->response_data.row_description.columns);
-                break;
-            case px_message_type_data_row:
-                if (result == NULL) break;
-                px_result_add_data_row(result,
-                                       response->response_data.data_row.cell_count,
-                                       response->response_data.data_row.cells);
-                break;
-            case px_message_type_error:
-                if (result == NULL) break;
-                px_result_delete(result);
-                result = NULL;
-                break;
-            case px_message_type_command_complete:
-                if (result == NULL) break;
-                px_result_parse_command_tag(result, response->response_data.command_complete.command_tag);
-                
-                if (result_list->capacity >= result_list->count + 1)
-                {
-                    result_list->capacity *= 2;
-                    result_list->results = realloc(result_list->results, result_list->capacity + sizeof(px_result*));
-                }
-                result_list->results[result_list->count++] = result;
-                result = px_result_new();
-                
-                break;
-            default:
-                fprintf(stderr, "unhandled message type: %c %i\n", (char)response->message_class, response->message_type);
-                break;
+            px_connection_set_last_error(connection, px_error_new_custom("22023", "the statements of a transaction must be run on the same connection"));
+            return NULL;
         }
+    }
+    
+    if (!px_query_check_connection(connection))
+        return NULL;
+    
+    // COMMIT would end the transaction of the caller rather than ours
+    if (connection->transaction_status != px_transaction_status_idle)
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("25001", "there is already a transaction in progress"));
+        return NULL;
+    }
+    
+    // an error from here on is one the server sent about the transaction
+    px_connection_set_last_error(connection, NULL);
+    
+    // the whole transaction is a single pipeline with one Sync at the end: the server skips
+    // everything after the first error until the Sync, so neither the rest of the statements
+    // nor the COMMIT run, and the transaction is left in a failed state to be rolled back
+    px_query_queue_transaction_command(connection, "BEGIN");
+    
+    unsigned int timeout = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        px_query_queue_statement(queries[i]);
+        px_query_track_session_state(queries[i]);
         
-        px_response_delete(response);
+        // without a deadline for any of the statements there is none for the transaction either
+        if (queries[i]->timeout == 0 || (i > 0 && timeout == 0))
+            timeout = 0;
+        else
+            timeout += queries[i]->timeout;
     }
     
-    if (result != NULL) px_result_delete(result);
+    px_query_queue_transaction_command(connection, "COMMIT");
+    px_query_sync(queries[0]);
     
-    return result_list;
+    connection->results.busy = true;
+    connection->deadline.at = timeout == 0 ? 0 : px_get_monotonic_time() + timeout;
+    connection->deadline.cancelled = false;
+    
+    if (px_connection_flush(connection) == px_connection_flush_result_failed)
+    {
+        px_connection_set_last_error(connection, px_error_new_io_error());
+        connection->results.busy = false;
+        return NULL;
+    }
+    
+    if (!px_connection_wait_for_flush(connection))
+        return NULL;
+    
+    // BEGIN, the statements and COMMIT each complete with a result, up to the first error
+    px_result_list *result_list = px_result_list_new();
+    
+    px_result *result;
+    while ((result = px_connection_get_next_result(connection)) != NULL)
+    {
+        px_result_list_add(result_list, result);
+    }
+    
+    if (result_list->count == count + 2 && connection->transaction_status == px_transaction_status_idle)
+    {
+        px_result_delete(result_list->results[0]);
+        px_result_delete(result_list->results[count + 1]);
+        memmove(result_list->results, result_list->results + 1, count * sizeof(px_result*));
+        result_list->count = count;
+        return result_list;
+    }
+    
+    px_result_list_delete(result_list, false);
+    
+    // nothing failed, yet the results can't be told apart from each other. a COMMIT that failed
+    // (a deferred constraint, a serialization failure) leaves the connection idle too, but rolled back
+    if (connection->last_error == NULL && connection->connection_status == px_connection_status_open && connection->transaction_status == px_transaction_status_idle)
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("08P01", "the transaction has been committed, but its results don't match its statements"));
+        return NULL;
+    }
+    
+    // the error of the statement that failed stays the last error, unless the rollback fails too
+    if (connection->connection_status == px_connection_status_open && connection->transaction_status != px_transaction_status_idle)
+    {
+        px_query rollback = { .command_text = "ROLLBACK", .connection = connection };
+        px_result_list *rollback_results = px_query_execute(&rollback);
+        
+        if (rollback_results != NULL)
+            px_result_list_delete(rollback_results, false);
+    }
+    
+    return NULL;
 }
 
-static px_result_list *px_query_execute_sync_extended(const px_query *restrict query)
+bool px_query_send(const px_query *restrict query)
 {
-    if (!px_query_parse(query)) return NULL;
-    if (!px_query_bind(query)) return NULL;
-    if (!px_query_describe_portal(query)) return NULL;
-    if (!px_query_execute_portal(query)) return NULL;
-    if (!px_query_close_portal(query)) return NULL;
-    if (!px_query_close_statement(query)) return NULL;
-    if (!px_connection_sync(query->connection, false)) return NULL;
-    
-    px_result *result = px_result_new();
-    
-    bool ready_for_query = false;
-    while (!ready_for_query || px_connection_has_incoming_data(query->connection))
+    if (!px_query_queue(query))
+        return false;
+    
+    px_connection *connection = query->connection;
+    
+    if (px_connection_flush(connection) == px_connection_flush_result_failed)
     {
-        px_response *response = px_response_read(query->connection);
-        if (response == NULL) return NULL;
-        
-        switch (response->message_type)
-        {
-            case px_message_type_ready_for_query:
-                ready_for_query = true;
-                break;
-            case px_message_type_row_description:
-                if (result == NULL) break;
-                px_result_add_headers(result,
-                                      response->response_data.row_description.column_count,
-                                      response->response_data.row_description.columns);
-                break;
-            case px_message_type_data_row:
-                if (result == NULL) break;
-                px_result_add_data_row(result,
-                                       response->response_data.data_row.cell_count,
-                                       response->response_data.data_row.cells);
-                break;
-            case px_message_type_error:
-                if (result == NULL) break;
-                px_result_delete(result);
-                result = NULL;
-                break;
-            case px_message_type_command_complete:
-                px_result_parse_command_tag(result, response->response_data.command_complete.command_tag);
-                break;
-            case px_message_type_parse_complete:
-            case px_message_type_bind_complete:
-            case px_message_type_close_complete:
-                break;
-            default:
-                fprintf(stderr, "unhandled message type: %c %i\n", (char)response->message_class, response->message_type);
-                break;
-        }
+        px_connection_set_last_error(connection, px_error_new_io_error());
+        connection->results.busy = false;
+        return false;
     }
     
-    if (result == NULL)
+    return true;
+}
+
+bool px_query_queue(const px_query *restrict query)
+{
+#ifdef DEBUG_QUERY
+    printf("query: %s\n", query->command_text);
+#endif
+    px_connection *connection = query->connection;
+    
+    if (!px_query_check_connection(connection))
+        return false;
+    
+    if (px_query_can_use_simple_query(query))
     {
-        return NULL;
+        px_query_queue_simple(query);
     }
     else
     {
-        px_result_list *result_list = calloc(1, sizeof(px_result_list));
-        result_list->capacity = 1;
-        result_list->count = 1;
-        result_list->results = calloc(1, sizeof(px_result*));
-        result_list->results[0] = result;
-        
-        return result_list;
+        px_query_queue_extended(query);
     }
+    
+    px_query_track_session_state(query);
+    connection->results.busy = true;
+    connection->deadline.at = query->timeout == 0 ? 0 : px_get_monotonic_time() + query->timeout;
+    connection->deadline.cancelled = false;
+    
+    return true;
 }
 
-static bool px_query_parse(const px_query *restrict query)
+static bool px_query_check_connection(px_connection *restrict connection)
+{
+    if (connection->connection_status != px_connection_status_open)
+    {
+        px_connection_set_last_error(connection, px_error_new_io_error());
+        return false;
+    }
+    
+    if (connection->results.busy)
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("55000", "another query is already in progress"));
+        return false;
+    }
+    
+    return true;
+}
+
+static void px_query_queue_simple(const px_query *restrict query)
+{
+    px_message *query_message = px_message_new("QTs", query->command_text);
+    px_connection_queue_message(query->connection, query_message);
+    px_message_delete(query_message);
+}
+
+static void px_query_queue_extended(const px_query *restrict query)
+{
+    px_query_queue_statement(query);
+    px_query_sync(query);
+}
+
+static void px_query_queue_statement(const px_query *restrict query)
+{
+    px_query_parse(query);
+    px_query_bind(query);
+    px_query_describe_portal(query);
+    px_query_execute_portal(query);
+    px_query_close_portal(query);
+    px_query_close_statement(query);
+}
+
+static void px_query_queue_transaction_command(px_connection *restrict connection, const char *restrict command_text)
+{
+    // nothing to describe: the next Parse and Bind replace the unnamed statement and portal
+    const px_query query = { .command_text = (char *)command_text, .connection = connection };
+    px_query_parse(&query);
+    px_query_bind(&query);
+    px_query_execute_portal(&query);
+}
+
+static void px_query_parse(const px_query *restrict query)
 {
     void **parameters = malloc((query->parameters.count + 4) * sizeof(void*));
     parameters[0] = "";
@@ -241,15 +344,13 @@ static bool px_query_parse(const px_query *restrict query)
     
     px_message *message = px_message_new_with_array("PTssw(i)", parameters);
     free(parameters);
-    px_message_send(message, query->connection->socket_number);
+    px_connection_queue_message(query->connection, message);
     px_message_delete(message);
-    
-    return true;
 }
 
-static bool px_query_bind(const px_query *restrict query)
+static void px_query_bind(const px_query *restrict query)
 {
-    void **parameters = malloc(((query->parameters.count * 2) + 5 + 1) * sizeof(void*));
+    void **parameters = malloc(((query->parameters.count * 2) + 5 + 2) * sizeof(void*));
     parameters[0] = "";
     parameters[1] = "";
     parameters[2] = 0;
@@ -262,44 +363,124 @@ static bool px_query_bind(const px_query *restrict query)
         parameters[(i * 2 + 1) + 5] = (void*)(query->parameters.values[i].value);
     }
     
-    parameters[(query->parameters.count * 2) + 5] = (void*)0;
+    // a single result format code applies to all the columns
+    parameters[(query->parameters.count * 2) + 5] = (void*)(query->binary_results ? 1 : 0);
+    parameters[(query->parameters.count * 2) + 6] = (void*)1;
     
-    px_message *message = px_message_new_with_array("BTssww(iS)w", parameters);
+    px_message *message = px_message_new_with_array(query->binary_results ? "BTssww(iS)ww" : "BTssww(iS)w", parameters);
     free(parameters);
-    px_message_send(message, query->connection->socket_number);
+    px_connection_queue_message(query->connection, message);
     px_message_delete(message);
-    
-    return true;
 }
 
-static bool px_query_describe_portal(const px_query *restrict query)
+static void px_query_describe_portal(const px_query *restrict query)
 {
     px_message *message = px_message_new("DTcs", 'P', "");
-    const bool success = px_message_send(message, query->connection->socket_number);
+    px_connection_queue_message(query->connection, message);
     px_message_delete(message);
-    return success;
 }
 
-static bool px_query_execute_portal(const px_query *restrict query)
+static void px_query_execute_portal(const px_query *restrict query)
 {
     px_message *message = px_message_new("ETsi", "", 0);
-    const bool success = px_message_send(message, query->connection->socket_number);
+    px_connection_queue_message(query->connection, message);
     px_message_delete(message);
-    return success;
 }
 
-static bool px_query_close_portal(const px_query *restrict query)
+static void px_query_close_portal(const px_query *restrict query)
 {
     px_message *message = px_message_new("CTcs", 'P', "");
-    const bool success = px_message_send(message, query->connection->socket_number);
+    px_connection_queue_message(query->connection, message);
     px_message_delete(message);
-    return success;
 }
 
-static bool px_query_close_statement(const px_query *restrict query)
+static void px_query_close_statement(const px_query *restrict query)
 {
     px_message *message = px_message_new("CTcs", 'S', "");
-    const bool success = px_message_send(message, query->connection->socket_number);
+    px_connection_queue_message(query->connection, message);
+    px_message_delete(message);
+}
+
+static void px_query_sync(const px_query *restrict query)
+{
+    px_message *message = px_message_new("ST");
+    px_connection_queue_message(query->connection, message);
     px_message_delete(message);
-    return success;
+}
+
+static void px_query_track_session_state(const px_query *restrict query)
+{
+    // only what doesn't show in the command tags is looked for
+    const char *command_text = query->command_text;
+    unsigned int session_state = px_connection_session_state_clean;
+    
+    if (px_query_creates_temp_table(command_text))
+        session_state |= px_connection_session_state_temp_tables;
+    
+    if (px_query_find_keyword(command_text, "set_config") != NULL)
+        session_state |= px_connection_session_state_settings;
+    
+    // pg_advisory_lock(), pg_try_advisory_lock() and their shared variants, but not the transaction-level ones
+    if (px_query_find_keyword(command_text, "advisory_lock") != NULL)
+        session_state |= px_connection_session_state_advisory_locks;
+    
+    if (px_query_declares_held_cursor(command_text))
+        session_state |= px_connection_session_state_held_cursors;
+    
+    if (session_state != px_connection_session_state_clean)
+        px_connection_mark_session_state(query->connection, session_state);
+}
+
+static const char *px_query_find_keyword(const char *restrict command_text, const char *restrict keyword)
+{
+    const size_t length = strlen(keyword);
+    
+    for (const char *character = command_text; *character != '\0'; character++)
+    {
+        if ((*character | 0x20) == keyword[0] && strncasecmp(character, keyword, length) == 0)
+            return character;
+    }
+    
+    return NULL;
+}
+
+static bool px_query_creates_temp_table(const char *restrict command_text)
+{
+    // CREATE [ GLOBAL | LOCAL ] { TEMP | TEMPORARY }: the word before TEMP tells it apart from names
+    for (const char *temp = px_query_find_keyword(command_text, "temp"); temp != NULL; temp = px_query_find_keyword(temp + 4, "temp"))
+    {
+        const char *end = temp;
+        while (end > command_text && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r'))
+            end--;
+        
+        const char *start = end;
+        while (start > command_text && ((start[-1] | 0x20) >= 'a' && (start[-1] | 0x20) <= 'z'))
+            start--;
+        
+        const size_t length = (size_t)(end - start);
+        if (end != temp &&
+            ((length == 6 && (strncasecmp(start, "create", 6) == 0 || strncasecmp(start, "global", 6) == 0)) ||
+             (length == 5 && strncasecmp(start, "local", 5) == 0)))
+        {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+static bool px_query_declares_held_cursor(const char *restrict command_text)
+{
+    // WITH HOLD, split over lines in many a DECLARE
+    for (const char *with = px_query_find_keyword(command_text, "with"); with != NULL; with = px_query_find_keyword(with + 4, "with"))
+    {
+        const char *hold = with + 4;
+        while (*hold == ' ' || *hold == '\t' || *hold == '\n' || *hold == '\r')
+            hold++;
+        
+        if (hold != with + 4 && strncasecmp(hold, "hold", 4) == 0)
+            return true;
+    }
+    
+    return false;
 }
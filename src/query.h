@@ -9,12 +9,15 @@
 #ifndef libpx_query_h
 #define libpx_query_h
 
+#include <stdbool.h>
 #include "typedef.h"
 
 struct px_query
 {
     char *command_text;
     px_connection *connection;
+    unsigned int timeout;
+    bool binary_results;
     struct
     {
         unsigned int count;
@@ -27,6 +30,13 @@ px_query *px_query_new(const char *restrict command_text, px_connection *restric
 void px_query_delete(px_query *query);
 
 void px_query_add_parameter(px_query *restrict query, const px_parameter *restrict parameter);
+unsigned int px_query_get_timeout(const px_query *restrict query) __attribute__((pure));
+void px_query_set_timeout(px_query *restrict query, const unsigned int timeout);
+bool px_query_has_binary_results(const px_query *restrict query) __attribute__((pure));
+void px_query_set_binary_results(px_query *restrict query, const bool binary_results);
 px_result_list *px_query_execute(const px_query *restrict query);
+px_result_list *px_query_execute_transaction(px_query *const *restrict queries, const unsigned int count);
+bool px_query_send(const px_query *restrict query);
+bool px_query_queue(const px_query *restrict query);
 
 #endif
@@ -0,0 +1,595 @@
+//
+//  reactor.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include "reactor.h"
+#include <poll.h>
+#include <stdlib.h>
+#include "buffer.h"
+#include "connection.h"
+#include "error.h"
+#include "query.h"
+#include "result.h"
+#include "utility.h"
+
+static px_reactor_entry *px_reactor_get_entry(px_reactor *restrict reactor, px_connection *restrict connection);
+static void px_reactor_begin(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const px_reactor_operation operation, const int timeout, PXReactorCallback *callback, void *context);
+static void px_reactor_finish(px_reactor *restrict reactor, px_reactor_entry *restrict entry, px_result_list *results);
+static void px_reactor_abandon(px_reactor *restrict reactor, px_reactor_entry *restrict entry);
+
+static void px_reactor_dispatch(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events);
+static void px_reactor_continue_open(px_reactor *restrict reactor, px_reactor_entry *restrict entry);
+static void px_reactor_continue_query(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events);
+static void px_reactor_continue_cancel(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events);
+static void px_reactor_send_cancel_request(px_reactor *restrict reactor, px_connection *restrict cancel_request, const uint64_t deadline);
+static void px_reactor_end_cancel_request(px_reactor *restrict reactor, px_reactor_entry *restrict entry);
+static void px_reactor_expire(px_reactor *restrict reactor, px_reactor_entry *restrict entry);
+static int px_reactor_get_wait_timeout(const px_reactor *restrict reactor, const int timeout) __attribute__((pure));
+static bool px_reactor_transfers_data(const px_reactor *restrict reactor, const px_connection *restrict connection) __attribute__((pure));
+
+static void px_reactor_schedule(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const uint64_t deadline);
+static void px_reactor_schedule_open(px_reactor *restrict reactor, px_reactor_entry *restrict entry);
+static void px_reactor_deadline_add(px_reactor *restrict reactor, px_reactor_entry *restrict entry);
+static void px_reactor_deadline_remove(px_reactor *restrict reactor, px_reactor_entry *restrict entry);
+static void px_reactor_deadline_swap(px_reactor *restrict reactor, const unsigned int a, const unsigned int b);
+static void px_reactor_deadline_sift_up(px_reactor *restrict reactor, unsigned int index);
+static void px_reactor_deadline_sift_down(px_reactor *restrict reactor, unsigned int index);
+
+// in order of preference
+static const px_reactor_backend *px_reactor_backends[] =
+{
+#ifdef PX_HAVE_IO_URING
+    &px_reactor_backend_io_uring,
+#endif
+#ifdef PX_HAVE_EPOLL
+    &px_reactor_backend_epoll,
+#endif
+    &px_reactor_backend_poll
+};
+
+px_reactor *px_reactor_new(void)
+{
+    return px_reactor_new_with_backend(px_reactor_backend_type_default);
+}
+
+px_reactor *px_reactor_new_with_backend(const px_reactor_backend_type backend_type)
+{
+    px_reactor *reactor = calloc(1, sizeof(px_reactor));
+    
+    // the default is the first implementation the running kernel supports
+    for (size_t i = 0; i < sizeof(px_reactor_backends) / sizeof(px_reactor_backends[0]); i++)
+    {
+        if (backend_type != px_reactor_backend_type_default && backend_type != px_reactor_backends[i]->type)
+            continue;
+        
+        if (px_reactor_backends[i]->new(reactor))
+        {
+            reactor->implementation = px_reactor_backends[i];
+            return reactor;
+        }
+    }
+    
+    free(reactor);
+    return NULL;
+}
+
+void px_reactor_delete(px_reactor *reactor)
+{
+    // the reactor owns its connections
+    while (reactor->entries.count > 0)
+    {
+        px_connection *connection = reactor->entries.values[reactor->entries.count - 1]->connection;
+        px_reactor_remove(reactor, connection);
+        px_connection_delete(connection);
+    }
+    
+    reactor->implementation->delete(reactor);
+    
+    if (reactor->entries.values != NULL)
+        free(reactor->entries.values);
+    
+    if (reactor->deadlines.values != NULL)
+        free(reactor->deadlines.values);
+    
+    if (reactor->ready.values != NULL)
+        free(reactor->ready.values);
+    
+    free(reactor);
+}
+
+bool px_reactor_add(px_reactor *restrict reactor, px_connection *restrict connection)
+{
+    if (connection->reactor_entry != NULL)
+        return false;
+    
+    if (reactor->entries.count == reactor->entries.capacity)
+    {
+        reactor->entries.capacity = reactor->entries.capacity == 0 ? 16 : reactor->entries.capacity * 2;
+        reactor->entries.values = realloc(reactor->entries.values, reactor->entries.capacity * sizeof(px_reactor_entry *));
+    }
+    
+    px_reactor_entry *entry = calloc(1, sizeof(px_reactor_entry));
+    entry->connection = connection;
+    entry->index = reactor->entries.count;
+    reactor->entries.values[reactor->entries.count++] = entry;
+    connection->reactor_entry = entry;
+    
+    return true;
+}
+
+void px_reactor_remove(px_reactor *restrict reactor, px_connection *restrict connection)
+{
+    px_reactor_entry *entry = connection->reactor_entry;
+    if (entry == NULL)
+        return;
+    
+    // the callback of an operation in progress is never called
+    if (entry->operation != px_reactor_operation_none)
+        px_reactor_abandon(reactor, entry);
+    
+    if (reactor->implementation->detach != NULL)
+        reactor->implementation->detach(reactor, entry);
+    
+    // the entry may still have events waiting to be dispatched in this round
+    for (unsigned int i = reactor->ready.position; i < reactor->ready.count; i++)
+    {
+        if (reactor->ready.values[i].entry == entry)
+            reactor->ready.values[i].entry = NULL;
+    }
+    
+    px_reactor_entry *last = reactor->entries.values[--reactor->entries.count];
+    last->index = entry->index;
+    reactor->entries.values[entry->index] = last;
+    
+    connection->reactor_entry = NULL;
+    free(entry);
+}
+
+bool px_reactor_open(px_reactor *restrict reactor, px_connection *restrict connection, const int timeout, PXReactorCallback *callback, void *context)
+{
+    px_reactor_entry *entry = px_reactor_get_entry(reactor, connection);
+    if (entry == NULL || !px_connection_open_start(connection))
+        return false;
+    
+    px_reactor_begin(reactor, entry, px_reactor_operation_open, timeout, callback, context);
+    px_reactor_schedule_open(reactor, entry);
+    
+    // the socket becomes writable once the connection has been established
+    reactor->implementation->watch(reactor, entry, POLLOUT);
+    
+    return true;
+}
+
+bool px_reactor_query(px_reactor *restrict reactor, const px_query *restrict query, const int timeout, PXReactorCallback *callback, void *context)
+{
+    px_reactor_entry *entry = px_reactor_get_entry(reactor, query->connection);
+    if (entry == NULL)
+        return false;
+    
+    // completion-based implementations send the query along with everything else in the next batch
+    if (!(px_reactor_transfers_data(reactor, query->connection) ? px_query_queue(query) : px_query_send(query)))
+        return false;
+    
+    // without a timeout of its own the operation runs until the deadline of the query
+    const int query_timeout = timeout < 0 && query->timeout > 0 ? (int)query->timeout : timeout;
+    px_reactor_begin(reactor, entry, px_reactor_operation_query, query_timeout, callback, context);
+    
+    if (px_buffer_get_length(&query->connection->output_buffer) > 0)
+        reactor->implementation->watch(reactor, entry, POLLIN | POLLOUT);
+    else
+        reactor->implementation->watch(reactor, entry, POLLIN);
+    
+    return true;
+}
+
+int px_reactor_run_once(px_reactor *restrict reactor, const int timeout)
+{
+    // events can also be picked up outside of a round, while removing a connection for instance
+    const int wait_timeout = reactor->ready.count > 0 ? 0 : px_reactor_get_wait_timeout(reactor, timeout);
+    
+    if (reactor->implementation->wait(reactor, wait_timeout) < 0)
+        return -1;
+    
+    int dispatched = 0;
+    
+    while (reactor->ready.position < reactor->ready.count)
+    {
+        const px_reactor_event event = reactor->ready.values[reactor->ready.position++];
+        if (event.entry == NULL || event.entry->operation == px_reactor_operation_none)
+            continue;
+        
+        px_reactor_dispatch(reactor, event.entry, event.events);
+        dispatched++;
+    }
+    
+    reactor->ready.position = 0;
+    reactor->ready.count = 0;
+    
+    if (reactor->deadlines.count > 0)
+    {
+        const uint64_t now = px_get_monotonic_time();
+        
+        while (reactor->deadlines.count > 0 && reactor->deadlines.values[1]->deadline <= now)
+        {
+            px_reactor_expire(reactor, reactor->deadlines.values[1]);
+            dispatched++;
+        }
+    }
+    
+    return dispatched;
+}
+
+bool px_reactor_run(px_reactor *restrict reactor)
+{
+    reactor->stopped = false;
+    
+    while (reactor->pending > 0 && !reactor->stopped)
+    {
+        if (px_reactor_run_once(reactor, -1) < 0)
+            return false;
+    }
+    
+    return true;
+}
+
+void px_reactor_stop(px_reactor *restrict reactor)
+{
+    reactor->stopped = true;
+}
+
+unsigned int px_reactor_get_pending(const px_reactor *restrict reactor)
+{
+    return reactor->pending;
+}
+
+px_reactor_backend_type px_reactor_get_backend_type(const px_reactor *restrict reactor)
+{
+    return reactor->implementation->type;
+}
+
+void px_reactor_add_ready(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events)
+{
+    if (reactor->ready.count == reactor->ready.capacity)
+    {
+        reactor->ready.capacity = reactor->ready.capacity == 0 ? 64 : reactor->ready.capacity * 2;
+        reactor->ready.values = realloc(reactor->ready.values, reactor->ready.capacity * sizeof(px_reactor_event));
+    }
+    
+    reactor->ready.values[reactor->ready.count].entry = entry;
+    reactor->ready.values[reactor->ready.count].events = events;
+    reactor->ready.count++;
+}
+
+static px_reactor_entry *px_reactor_get_entry(px_reactor *restrict reactor, px_connection *restrict connection)
+{
+    if (connection->reactor_entry == NULL)
+        px_reactor_add(reactor, connection);
+    
+    // only one operation per connection at a time
+    if (connection->reactor_entry->operation != px_reactor_operation_none)
+        return NULL;
+    
+    return connection->reactor_entry;
+}
+
+static void px_reactor_begin(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const px_reactor_operation operation, const int timeout, PXReactorCallback *callback, void *context)
+{
+    entry->operation = operation;
+    entry->callback = callback;
+    entry->context = context;
+    reactor->pending++;
+    
+    entry->expires = timeout >= 0 ? px_get_monotonic_time() + (uint64_t)timeout : 0;
+    px_reactor_schedule(reactor, entry, entry->expires);
+}
+
+static void px_reactor_finish(px_reactor *restrict reactor, px_reactor_entry *restrict entry, px_result_list *results)
+{
+    PXReactorCallback *callback = entry->callback;
+    void *context = entry->context;
+    px_connection *connection = entry->connection;
+    
+    px_reactor_abandon(reactor, entry);
+    
+    // the callback is free to start another operation on the connection or remove it
+    if (callback != NULL)
+        callback(reactor, connection, results, context);
+    else if (results != NULL)
+        px_result_list_delete(results, false);
+}
+
+static void px_reactor_abandon(px_reactor *restrict reactor, px_reactor_entry *restrict entry)
+{
+    reactor->implementation->watch(reactor, entry, 0);
+    px_reactor_schedule(reactor, entry, 0);
+    
+    entry->operation = px_reactor_operation_none;
+    entry->callback = NULL;
+    entry->context = NULL;
+    reactor->pending--;
+}
+
+static void px_reactor_dispatch(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events)
+{
+    switch (entry->operation)
+    {
+        case px_reactor_operation_open:
+            px_reactor_continue_open(reactor, entry);
+            break;
+        case px_reactor_operation_query:
+            px_reactor_continue_query(reactor, entry, events);
+            break;
+        case px_reactor_operation_cancel:
+            px_reactor_continue_cancel(reactor, entry, events);
+            break;
+        case px_reactor_operation_none:
+            break;
+    }
+}
+
+static void px_reactor_continue_open(px_reactor *restrict reactor, px_reactor_entry *restrict entry)
+{
+    const unsigned int socket_generation = entry->connection->socket_generation;
+    const px_connection_polling_status status = px_connection_open_poll(entry->connection);
+    
+    // the connection moved on to another address or host, the old socket may have been closed
+    if (entry->connection->socket_generation != socket_generation)
+        reactor->implementation->watch(reactor, entry, 0);
+    
+    switch (status)
+    {
+        case px_connection_polling_status_reading:
+            reactor->implementation->watch(reactor, entry, POLLIN);
+            px_reactor_schedule_open(reactor, entry);
+            break;
+        case px_connection_polling_status_writing:
+            reactor->implementation->watch(reactor, entry, POLLOUT);
+            px_reactor_schedule_open(reactor, entry);
+            break;
+        case px_connection_polling_status_ok:
+        case px_connection_polling_status_failed:
+            px_reactor_finish(reactor, entry, NULL);
+            break;
+    }
+}
+
+static void px_reactor_continue_query(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events)
+{
+    px_connection *connection = entry->connection;
+    
+    if (events & POLLOUT)
+    {
+        switch (px_connection_flush(connection))
+        {
+            case px_connection_flush_result_failed:
+                px_reactor_finish(reactor, entry, NULL);
+                return;
+            case px_connection_flush_result_done:
+                reactor->implementation->watch(reactor, entry, POLLIN);
+                break;
+            case px_connection_flush_result_pending:
+                break;
+        }
+    }
+    
+    if (px_reactor_transfers_data(reactor, connection))
+    {
+        if (events & (POLLERR | POLLHUP))
+        {
+            px_connection_fail(connection);
+            px_reactor_finish(reactor, entry, NULL);
+            return;
+        }
+    }
+    else if ((events & (POLLIN | POLLERR | POLLHUP)) && !px_connection_consume_input(connection))
+    {
+        px_reactor_finish(reactor, entry, NULL);
+        return;
+    }
+    
+    if (px_connection_is_busy(connection))
+        return;
+    
+    px_result_list *results = px_result_list_new();
+    px_result *result;
+    while ((result = px_connection_get_next_result(connection)) != NULL)
+        px_result_list_add(results, result);
+    
+    px_reactor_finish(reactor, entry, results);
+}
+
+static void px_reactor_expire(px_reactor *restrict reactor, px_reactor_entry *restrict entry)
+{
+    px_connection *connection = entry->connection;
+    px_connection *cancel_request = NULL;
+    
+    // the query drains until its own deadline whether the server got the request or not
+    if (entry->operation == px_reactor_operation_cancel)
+    {
+        px_reactor_end_cancel_request(reactor, entry);
+        return;
+    }
+    
+    // an open that is due to try another address hasn't timed out yet
+    if (entry->operation == px_reactor_operation_open && (entry->expires == 0 || entry->deadline < entry->expires))
+    {
+        px_reactor_continue_open(reactor, entry);
+        return;
+    }
+    
+    if (entry->operation == px_reactor_operation_open)
+    {
+        px_connection_close(connection);
+        connection->connection_status = px_connection_status_failed;
+        connection->attempt_result = px_connection_attempt_result_startup_timeout;
+        px_connection_set_last_error(connection, px_error_new_custom("08001", "timeout expired while opening the connection"));
+    }
+    else if (px_connection_expire_query(connection, &cancel_request))
+    {
+        // the query is being cancelled, its results still have to be drained before the connection can be reused
+        px_reactor_schedule(reactor, entry, connection->deadline.at);
+        px_reactor_send_cancel_request(reactor, cancel_request, connection->deadline.at);
+        return;
+    }
+    
+    px_reactor_finish(reactor, entry, NULL);
+}
+
+static void px_reactor_continue_cancel(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events)
+{
+    if (events & POLLOUT)
+    {
+        switch (px_connection_flush(entry->connection))
+        {
+            case px_connection_flush_result_pending:
+                return;
+            case px_connection_flush_result_done:
+                // the server closes the connection once it has processed the request
+                reactor->implementation->watch(reactor, entry, POLLIN);
+                return;
+            case px_connection_flush_result_failed:
+                break;
+        }
+    }
+    
+    px_reactor_end_cancel_request(reactor, entry);
+}
+
+static void px_reactor_send_cancel_request(px_reactor *restrict reactor, px_connection *restrict cancel_request, const uint64_t deadline)
+{
+    // the request goes out through the reactor like anything else, so that the other
+    // connections don't have to wait for the server to accept it
+    const uint64_t now = px_get_monotonic_time();
+    px_reactor_add(reactor, cancel_request);
+    px_reactor_begin(reactor, cancel_request->reactor_entry, px_reactor_operation_cancel, deadline > now ? (int)(deadline - now) : 0, NULL, NULL);
+    
+    // the socket becomes writable once the connection has been established
+    reactor->implementation->watch(reactor, cancel_request->reactor_entry, POLLOUT);
+}
+
+static void px_reactor_end_cancel_request(px_reactor *restrict reactor, px_reactor_entry *restrict entry)
+{
+    px_connection *cancel_request = entry->connection;
+    
+    px_reactor_remove(reactor, cancel_request);
+    px_connection_delete(cancel_request);
+}
+
+static int px_reactor_get_wait_timeout(const px_reactor *restrict reactor, const int timeout)
+{
+    if (reactor->deadlines.count == 0)
+        return timeout;
+    
+    const uint64_t now = px_get_monotonic_time();
+    const uint64_t deadline = reactor->deadlines.values[1]->deadline;
+    const int remaining = deadline > now ? (int)(deadline - now) : 0;
+    
+    return timeout < 0 || remaining < timeout ? remaining : timeout;
+}
+
+static bool px_reactor_transfers_data(const px_reactor *restrict reactor, const px_connection *restrict connection)
+{
+    // the TLS library reads and writes the socket of encrypted connections itself
+    return reactor->implementation->transfers_data && !px_connection_is_encrypted(connection);
+}
+
+static void px_reactor_schedule(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const uint64_t deadline)
+{
+    px_reactor_deadline_remove(reactor, entry);
+    entry->deadline = deadline;
+    
+    if (deadline != 0)
+        px_reactor_deadline_add(reactor, entry);
+}
+
+static void px_reactor_schedule_open(px_reactor *restrict reactor, px_reactor_entry *restrict entry)
+{
+    const int timeout = px_connection_get_open_timeout(entry->connection);
+    uint64_t deadline = entry->expires;
+    
+    if (timeout >= 0)
+    {
+        const uint64_t wakeup = px_get_monotonic_time() + (uint64_t)timeout;
+        if (deadline == 0 || wakeup < deadline)
+            deadline = wakeup;
+    }
+    
+    if (deadline != entry->deadline)
+        px_reactor_schedule(reactor, entry, deadline);
+}
+
+static void px_reactor_deadline_add(px_reactor *restrict reactor, px_reactor_entry *restrict entry)
+{
+    // slot 0 is unused so that the children of i are 2i and 2i + 1
+    if (reactor->deadlines.count + 1 >= reactor->deadlines.capacity)
+    {
+        reactor->deadlines.capacity = reactor->deadlines.capacity == 0 ? 16 : reactor->deadlines.capacity * 2;
+        reactor->deadlines.values = realloc(reactor->deadlines.values, reactor->deadlines.capacity * sizeof(px_reactor_entry *));
+    }
+    
+    entry->heap_index = ++reactor->deadlines.count;
+    reactor->deadlines.values[entry->heap_index] = entry;
+    px_reactor_deadline_sift_up(reactor, entry->heap_index);
+}
+
+static void px_reactor_deadline_remove(px_reactor *restrict reactor, px_reactor_entry *restrict entry)
+{
+    const unsigned int index = entry->heap_index;
+    if (index == 0)
+        return;
+    
+    const unsigned int last = reactor->deadlines.count--;
+    entry->heap_index = 0;
+    
+    if (index == last)
+        return;
+    
+    reactor->deadlines.values[index] = reactor->deadlines.values[last];
+    reactor->deadlines.values[index]->heap_index = index;
+    px_reactor_deadline_sift_up(reactor, index);
+    px_reactor_deadline_sift_down(reactor, reactor->deadlines.values[index]->heap_index);
+}
+
+static void px_reactor_deadline_swap(px_reactor *restrict reactor, const unsigned int a, const unsigned int b)
+{
+    px_reactor_entry *entry = reactor->deadlines.values[a];
+    reactor->deadlines.values[a] = reactor->deadlines.values[b];
+    reactor->deadlines.values[b] = entry;
+    reactor->deadlines.values[a]->heap_index = a;
+    reactor->deadlines.values[b]->heap_index = b;
+}
+
+static void px_reactor_deadline_sift_up(px_reactor *restrict reactor, unsigned int index)
+{
+    while (index > 1 && reactor->deadlines.values[index]->deadline < reactor->deadlines.values[index / 2]->deadline)
+    {
+        px_reactor_deadline_swap(reactor, index, index / 2);
+        index /= 2;
+    }
+}
+
+static void px_reactor_deadline_sift_down(px_reactor *restrict reactor, unsigned int index)
+{
+    while (true)
+    {
+        unsigned int smallest = index;
+        const unsigned int left = index * 2;
+        const unsigned int right = left + 1;
+        
+        if (left <= reactor->deadlines.count && reactor->deadlines.values[left]->deadline < reactor->deadlines.values[smallest]->deadline)
+            smallest = left;
+        
+        if (right <= reactor->deadlines.count && reactor->deadlines.values[right]->deadline < reactor->deadlines.values[smallest]->deadline)
+            smallest = right;
+        
+        if (smallest == index)
+            return;
+        
+        px_reactor_deadline_swap(reactor, index, smallest);
+        index = smallest;
+    }
+}
@@ -0,0 +1,139 @@
+//
+//  reactor.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_reactor_h
+#define libpx_reactor_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "typedef.h"
+
+typedef void PXReactorCallback(px_reactor *reactor, px_connection *connection, px_result_list *results, void *context);
+
+typedef enum px_reactor_backend_type
+{
+    px_reactor_backend_type_default = 0,
+    px_reactor_backend_type_poll = 1,
+    px_reactor_backend_type_epoll = 2,
+    px_reactor_backend_type_io_uring = 3
+} px_reactor_backend_type;
+
+typedef enum px_reactor_operation
+{
+    px_reactor_operation_none = 0,
+    px_reactor_operation_open,
+    px_reactor_operation_query,
+    px_reactor_operation_cancel
+} px_reactor_operation;
+
+struct px_reactor_entry
+{
+    px_connection *connection;
+    px_reactor_operation operation;
+    PXReactorCallback *callback;
+    void *context;
+    unsigned int index;
+    
+    // events the backend is currently watching for, POLLIN and/or POLLOUT
+    short events;
+    unsigned int backend_index;
+    void *backend_data;
+    
+    // when the operation times out (0 for never) and when the entry is next due in the deadline
+    // heap, which is earlier for an open that has to try another address in the meantime
+    uint64_t expires;
+    uint64_t deadline;
+    unsigned int heap_index;
+};
+
+typedef struct px_reactor_event
+{
+    px_reactor_entry *entry;
+    short events;
+} px_reactor_event;
+
+// readiness-based implementations report that a socket can be read or written. completion-based
+// ones (transfers_data) do the I/O of queries themselves unless the connection is encrypted: POLLIN means that new data has been
+// appended to the input buffer, POLLOUT that the output buffer has been sent and POLLHUP or
+// POLLERR that the connection has been lost
+typedef struct px_reactor_backend
+{
+    px_reactor_backend_type type;
+    bool transfers_data;
+    bool (*new)(px_reactor *restrict reactor);
+    void (*delete)(px_reactor *restrict reactor);
+    bool (*watch)(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events);
+    void (*detach)(px_reactor *restrict reactor, px_reactor_entry *restrict entry);
+    int (*wait)(px_reactor *restrict reactor, const int timeout);
+} px_reactor_backend;
+
+struct px_reactor
+{
+    const px_reactor_backend *implementation;
+    void *backend;
+    unsigned int pending;
+    bool stopped;
+    
+    struct
+    {
+        unsigned int count;
+        unsigned int capacity;
+        px_reactor_entry **values;
+    } entries;
+    
+    // min-heap of entries ordered by deadline, 1-based
+    struct
+    {
+        unsigned int count;
+        unsigned int capacity;
+        px_reactor_entry **values;
+    } deadlines;
+    
+    // events returned by the last backend wait that haven't been dispatched yet
+    struct
+    {
+        unsigned int position;
+        unsigned int count;
+        unsigned int capacity;
+        px_reactor_event *values;
+    } ready;
+};
+
+// creation & deletion
+px_reactor *px_reactor_new(void);
+px_reactor *px_reactor_new_with_backend(const px_reactor_backend_type backend_type);
+void px_reactor_delete(px_reactor *reactor);
+
+// adding & removing connections
+bool px_reactor_add(px_reactor *restrict reactor, px_connection *restrict connection);
+void px_reactor_remove(px_reactor *restrict reactor, px_connection *restrict connection);
+
+// starting operations
+bool px_reactor_open(px_reactor *restrict reactor, px_connection *restrict connection, const int timeout, PXReactorCallback *callback, void *context);
+bool px_reactor_query(px_reactor *restrict reactor, const px_query *restrict query, const int timeout, PXReactorCallback *callback, void *context);
+
+// running the event loop
+int px_reactor_run_once(px_reactor *restrict reactor, const int timeout);
+bool px_reactor_run(px_reactor *restrict reactor);
+void px_reactor_stop(px_reactor *restrict reactor);
+unsigned int px_reactor_get_pending(const px_reactor *restrict reactor) __attribute__((pure));
+px_reactor_backend_type px_reactor_get_backend_type(const px_reactor *restrict reactor) __attribute__((pure));
+
+// implementations
+extern const px_reactor_backend px_reactor_backend_poll;
+#ifdef PX_HAVE_EPOLL
+extern const px_reactor_backend px_reactor_backend_epoll;
+#endif
+#ifdef PX_HAVE_IO_URING
+extern const px_reactor_backend px_reactor_backend_io_uring;
+#endif
+
+// used by the implementations
+void px_reactor_add_ready(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events);
+
+#endif
@@ -0,0 +1,118 @@
+//
+//  reactor_epoll.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "connection.h"
+#include "reactor.h"
+
+#define PX_REACTOR_EPOLL_MAX_EVENTS 256
+
+typedef struct px_reactor_epoll
+{
+    int epoll_fd;
+    struct epoll_event events[PX_REACTOR_EPOLL_MAX_EVENTS];
+} px_reactor_epoll;
+
+static bool px_reactor_epoll_new(px_reactor *restrict reactor);
+static void px_reactor_epoll_delete(px_reactor *restrict reactor);
+static bool px_reactor_epoll_watch(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events);
+static int px_reactor_epoll_wait(px_reactor *restrict reactor, const int timeout);
+
+const px_reactor_backend px_reactor_backend_epoll =
+{
+    .type = px_reactor_backend_type_epoll,
+    .transfers_data = false,
+    .new = px_reactor_epoll_new,
+    .delete = px_reactor_epoll_delete,
+    .watch = px_reactor_epoll_watch,
+    .detach = NULL,
+    .wait = px_reactor_epoll_wait
+};
+
+static bool px_reactor_epoll_new(px_reactor *restrict reactor)
+{
+    px_reactor_epoll *backend = calloc(1, sizeof(px_reactor_epoll));
+    backend->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    
+    if (backend->epoll_fd == -1)
+    {
+        free(backend);
+        return false;
+    }
+    
+    reactor->backend = backend;
+    return true;
+}
+
+static void px_reactor_epoll_delete(px_reactor *restrict reactor)
+{
+    px_reactor_epoll *backend = reactor->backend;
+    close(backend->epoll_fd);
+    free(backend);
+}
+
+static bool px_reactor_epoll_watch(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events)
+{
+    if (entry->events == events)
+        return true;
+    
+    px_reactor_epoll *backend = reactor->backend;
+    const int socket_number = px_connection_get_socket(entry->connection);
+    const short old_events = entry->events;
+    entry->events = events;
+    
+    // a closed socket has already dropped out of the epoll set
+    if (socket_number == -1)
+        return events == 0;
+    
+    struct epoll_event event;
+    event.events = ((events & POLLIN) ? EPOLLIN : 0) | ((events & POLLOUT) ? EPOLLOUT : 0);
+    event.data.ptr = entry;
+    
+    int operation;
+    if (old_events == 0)
+        operation = EPOLL_CTL_ADD;
+    else if (events == 0)
+        operation = EPOLL_CTL_DEL;
+    else
+        operation = EPOLL_CTL_MOD;
+    
+    return epoll_ctl(backend->epoll_fd, operation, socket_number, &event) == 0;
+}
+
+static int px_reactor_epoll_wait(px_reactor *restrict reactor, const int timeout)
+{
+    px_reactor_epoll *backend = reactor->backend;
+    const int count = epoll_wait(backend->epoll_fd, backend->events, PX_REACTOR_EPOLL_MAX_EVENTS, timeout);
+    
+    if (count == -1)
+        return errno == EINTR ? 0 : -1;
+    
+    for (int i = 0; i < count; i++)
+    {
+        const uint32_t ready = backend->events[i].events;
+        short events = 0;
+        
+        if (ready & EPOLLIN)
+            events |= POLLIN;
+        if (ready & EPOLLOUT)
+            events |= POLLOUT;
+        if (ready & EPOLLERR)
+            events |= POLLERR;
+        if (ready & EPOLLHUP)
+            events |= POLLHUP;
+        
+        px_reactor_add_ready(reactor, backend->events[i].data.ptr, events);
+    }
+    
+    return count;
+}
@@ -0,0 +1,718 @@
+//
+//  reactor_io_uring.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "buffer.h"
+#include "connection.h"
+#include "reactor.h"
+
+// queries are sent and received through the ring: sends of all connections go out in the
+// same io_uring_enter call as the wait, and so do the receives of every connection that is
+// still waiting for its results. receives pick their buffers from a ring of buffers registered
+// with the kernel. nothing is left reading or writing a socket once its operation is over, so
+// the connection can carry on with the blocking API. opening a connection still reads and
+// writes the socket directly, the ring only polls for it then
+
+#define PX_REACTOR_IO_URING_ENTRIES 256
+#define PX_REACTOR_IO_URING_BUFFER_COUNT 256
+#define PX_REACTOR_IO_URING_BUFFER_SIZE 16384
+#define PX_REACTOR_IO_URING_BUFFER_GROUP 0
+
+typedef enum px_reactor_io_uring_request
+{
+    px_reactor_io_uring_request_receive = 1,
+    px_reactor_io_uring_request_send = 2,
+    px_reactor_io_uring_request_poll = 3
+} px_reactor_io_uring_request;
+
+static const uint64_t px_reactor_io_uring_request_mask = 3;
+
+// the requests of one socket; it outlives its entry until the kernel is done with all of them
+typedef struct px_reactor_io_uring_socket
+{
+    px_reactor_entry *entry;
+    int socket_number;
+    bool receiving;
+    bool sending;
+    bool polling;
+    bool settling;
+    bool receive_wanted;
+    unsigned int outstanding;
+    px_buffer send_buffer;
+    struct px_reactor_io_uring_socket *previous;
+    struct px_reactor_io_uring_socket *next;
+} px_reactor_io_uring_socket;
+
+typedef struct px_reactor_io_uring
+{
+    int ring_fd;
+    unsigned int pending_submissions;
+    
+    struct
+    {
+        unsigned int *head;
+        unsigned int *tail;
+        unsigned int *mask;
+        unsigned int *array;
+        unsigned int entries;
+        unsigned int local_tail;
+        struct io_uring_sqe *sqes;
+        void *ring;
+        size_t ring_size;
+        size_t sqes_size;
+    } sq;
+    
+    struct
+    {
+        unsigned int *head;
+        unsigned int *tail;
+        unsigned int *mask;
+        struct io_uring_cqe *cqes;
+        void *ring;
+        size_t ring_size;
+    } cq;
+    
+    struct
+    {
+        struct io_uring_buf_ring *ring;
+        size_t ring_size;
+        char *bytes;
+        unsigned short tail;
+    } buffers;
+    
+    px_reactor_io_uring_socket *sockets;
+    
+    // sockets that receive again in the next wait, once the data they got has been dispatched
+    struct
+    {
+        unsigned int count;
+        unsigned int capacity;
+        px_reactor_io_uring_socket **values;
+    } receives;
+} px_reactor_io_uring;
+
+static bool px_reactor_io_uring_new(px_reactor *restrict reactor);
+static void px_reactor_io_uring_delete(px_reactor *restrict reactor);
+static bool px_reactor_io_uring_watch(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events);
+static void px_reactor_io_uring_detach(px_reactor *restrict reactor, px_reactor_entry *restrict entry);
+static int px_reactor_io_uring_wait(px_reactor *restrict reactor, const int timeout);
+
+const px_reactor_backend px_reactor_backend_io_uring =
+{
+    .type = px_reactor_backend_type_io_uring,
+    .transfers_data = true,
+    .new = px_reactor_io_uring_new,
+    .delete = px_reactor_io_uring_delete,
+    .watch = px_reactor_io_uring_watch,
+    .detach = px_reactor_io_uring_detach,
+    .wait = px_reactor_io_uring_wait
+};
+
+static bool px_reactor_io_uring_map(px_reactor_io_uring *restrict backend, const struct io_uring_params *restrict params);
+static void px_reactor_io_uring_unmap(px_reactor_io_uring *restrict backend);
+static bool px_reactor_io_uring_register_buffers(px_reactor_io_uring *restrict backend);
+static void px_reactor_io_uring_recycle_buffer(px_reactor_io_uring *restrict backend, const unsigned short buffer_id);
+
+static struct io_uring_sqe *px_reactor_io_uring_get_sqe(px_reactor_io_uring *restrict backend);
+static int px_reactor_io_uring_enter(px_reactor_io_uring *restrict backend, const unsigned int min_complete, const int timeout);
+static int px_reactor_io_uring_reap(px_reactor *restrict reactor);
+static void px_reactor_io_uring_complete(px_reactor *restrict reactor, const struct io_uring_cqe *restrict cqe);
+
+static px_reactor_io_uring_socket *px_reactor_io_uring_socket_new(px_reactor_io_uring *restrict backend, px_reactor_entry *restrict entry, const int socket_number);
+static void px_reactor_io_uring_socket_end(px_reactor *restrict reactor, px_reactor_io_uring_socket *restrict socket);
+static void px_reactor_io_uring_socket_settle(px_reactor *restrict reactor, px_reactor_io_uring_socket *restrict socket);
+static void px_reactor_io_uring_socket_release(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket);
+static bool px_reactor_io_uring_socket_is_active(const px_reactor_io_uring_socket *restrict socket) __attribute__((pure));
+
+static void px_reactor_io_uring_want_receive(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket);
+static void px_reactor_io_uring_receive(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket);
+static void px_reactor_io_uring_send(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket);
+static void px_reactor_io_uring_poll(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket, const short events);
+static void px_reactor_io_uring_cancel(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket, const px_reactor_io_uring_request request);
+
+static bool px_reactor_io_uring_new(px_reactor *restrict reactor)
+{
+    px_reactor_io_uring *backend = calloc(1, sizeof(px_reactor_io_uring));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    
+    backend->ring_fd = (int)syscall(__NR_io_uring_setup, PX_REACTOR_IO_URING_ENTRIES, &params);
+    if (backend->ring_fd == -1 && errno == EINVAL)
+    {
+        // kernels older than 5.19 don't know about cooperative task running
+        memset(&params, 0, sizeof(params));
+        backend->ring_fd = (int)syscall(__NR_io_uring_setup, PX_REACTOR_IO_URING_ENTRIES, &params);
+    }
+    
+    if (backend->ring_fd == -1)
+    {
+        free(backend);
+        return false;
+    }
+    
+    // timed waits need IORING_ENTER_EXT_ARG (5.11), provided buffer rings need 5.19
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)
+        || !px_reactor_io_uring_map(backend, &params) || !px_reactor_io_uring_register_buffers(backend))
+    {
+        px_reactor_io_uring_unmap(backend);
+        close(backend->ring_fd);
+        free(backend);
+        return false;
+    }
+    
+    reactor->backend = backend;
+    return true;
+}
+
+static void px_reactor_io_uring_delete(px_reactor *restrict reactor)
+{
+    px_reactor_io_uring *backend = reactor->backend;
+    
+    // closing the ring cancels whatever is still in flight
+    close(backend->ring_fd);
+    px_reactor_io_uring_unmap(backend);
+    
+    while (backend->sockets != NULL)
+    {
+        px_reactor_io_uring_socket *socket = backend->sockets;
+        backend->sockets = socket->next;
+        px_buffer_delete_members(&socket->send_buffer);
+        free(socket);
+    }
+    
+    if (backend->receives.values != NULL)
+        free(backend->receives.values);
+    
+    free(backend);
+}
+
+static bool px_reactor_io_uring_watch(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events)
+{
+    px_reactor_io_uring *backend = reactor->backend;
+    px_reactor_io_uring_socket *socket = entry->backend_data;
+    const int socket_number = px_connection_get_socket(entry->connection);
+    
+    // the requests belong to a socket and the connection may have been closed or reopened since.
+    // the socket only really gets closed once the kernel has given up its requests as well
+    if (socket != NULL && (socket->socket_number != socket_number || (entry->operation == px_reactor_operation_open && events != 0 && entry->events == 0)))
+    {
+        px_reactor_io_uring_socket_end(reactor, socket);
+        entry->backend_data = socket = NULL;
+    }
+    
+    entry->events = events;
+    
+    if (events == 0)
+    {
+        // the operation is over and whatever the server sends from now on belongs to the next
+        // one, which may well be run through the blocking API
+        if (socket != NULL)
+        {
+            px_reactor_io_uring_socket_settle(reactor, socket);
+            
+            if (socket->polling)
+                px_reactor_io_uring_cancel(backend, socket, px_reactor_io_uring_request_poll);
+        }
+        
+        return true;
+    }
+    
+    if (socket_number == -1)
+        return false;
+    
+    if (socket == NULL)
+        socket = entry->backend_data = px_reactor_io_uring_socket_new(backend, entry, socket_number);
+    
+    // encrypted connections do their own I/O through the TLS library, which only needs readiness
+    if (entry->operation != px_reactor_operation_query || px_connection_is_encrypted(entry->connection))
+    {
+        // polls are one-shot and opening only asks for the next event once the last one arrived
+        if (!socket->polling)
+            px_reactor_io_uring_poll(backend, socket, events);
+        
+        return true;
+    }
+    
+    if ((events & POLLIN) && !socket->receiving)
+        px_reactor_io_uring_want_receive(backend, socket);
+    
+    if ((events & POLLOUT) && !socket->sending)
+        px_reactor_io_uring_send(backend, socket);
+    
+    return true;
+}
+
+static void px_reactor_io_uring_detach(px_reactor *restrict reactor, px_reactor_entry *restrict entry)
+{
+    if (entry->backend_data != NULL)
+    {
+        px_reactor_io_uring_socket_end(reactor, entry->backend_data);
+        entry->backend_data = NULL;
+    }
+}
+
+static int px_reactor_io_uring_wait(px_reactor *restrict reactor, const int timeout)
+{
+    px_reactor_io_uring *backend = reactor->backend;
+    
+    // only connections that are still waiting for their results after the last round receive again
+    for (unsigned int i = 0; i < backend->receives.count; i++)
+    {
+        px_reactor_io_uring_socket *socket = backend->receives.values[i];
+        socket->receive_wanted = false;
+        
+        if (px_reactor_io_uring_socket_is_active(socket) && (socket->entry->events & POLLIN) && !socket->receiving)
+            px_reactor_io_uring_receive(backend, socket);
+    }
+    
+    backend->receives.count = 0;
+    
+    if (px_reactor_io_uring_enter(backend, timeout == 0 ? 0 : 1, timeout) < 0)
+        return -1;
+    
+    return px_reactor_io_uring_reap(reactor);
+}
+
+static bool px_reactor_io_uring_map(px_reactor_io_uring *restrict backend, const struct io_uring_params *restrict params)
+{
+    backend->sq.ring_size = params->sq_off.array + params->sq_entries * sizeof(unsigned int);
+    backend->cq.ring_size = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+    backend->sq.sqes_size = params->sq_entries * sizeof(struct io_uring_sqe);
+    
+    // both rings live in the same mapping on every kernel that has provided buffer rings
+    if (!(params->features & IORING_FEAT_SINGLE_MMAP))
+        return false;
+    
+    if (backend->cq.ring_size > backend->sq.ring_size)
+        backend->sq.ring_size = backend->cq.ring_size;
+    
+    backend->sq.ring = mmap(NULL, backend->sq.ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, backend->ring_fd, IORING_OFF_SQ_RING);
+    if (backend->sq.ring == MAP_FAILED)
+    {
+        backend->sq.ring = NULL;
+        return false;
+    }
+    
+    backend->sq.sqes = mmap(NULL, backend->sq.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, backend->ring_fd, IORING_OFF_SQES);
+    if (backend->sq.sqes == MAP_FAILED)
+    {
+        backend->sq.sqes = NULL;
+        return false;
+    }
+    
+    char *ring = backend->sq.ring;
+    backend->sq.head = (unsigned int *)(ring + params->sq_off.head);
+    backend->sq.tail = (unsigned int *)(ring + params->sq_off.tail);
+    backend->sq.mask = (unsigned int *)(ring + params->sq_off.ring_mask);
+    backend->sq.array = (unsigned int *)(ring + params->sq_off.array);
+    backend->sq.entries = params->sq_entries;
+    backend->sq.local_tail = *backend->sq.tail;
+    
+    backend->cq.ring = backend->sq.ring;
+    backend->cq.head = (unsigned int *)(ring + params->cq_off.head);
+    backend->cq.tail = (unsigned int *)(ring + params->cq_off.tail);
+    backend->cq.mask = (unsigned int *)(ring + params->cq_off.ring_mask);
+    backend->cq.cqes = (struct io_uring_cqe *)(ring + params->cq_off.cqes);
+    
+    return true;
+}
+
+static void px_reactor_io_uring_unmap(px_reactor_io_uring *restrict backend)
+{
+    if (backend->sq.sqes != NULL)
+        munmap(backend->sq.sqes, backend->sq.sqes_size);
+    
+    if (backend->sq.ring != NULL)
+        munmap(backend->sq.ring, backend->sq.ring_size);
+    
+    if (backend->buffers.ring != NULL)
+        munmap(backend->buffers.ring, backend->buffers.ring_size);
+    
+    if (backend->buffers.bytes != NULL)
+        free(backend->buffers.bytes);
+}
+
+static bool px_reactor_io_uring_register_buffers(px_reactor_io_uring *restrict backend)
+{
+    backend->buffers.ring_size = PX_REACTOR_IO_URING_BUFFER_COUNT * sizeof(struct io_uring_buf);
+    backend->buffers.ring = mmap(NULL, backend->buffers.ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (backend->buffers.ring == MAP_FAILED)
+    {
+        backend->buffers.ring = NULL;
+        return false;
+    }
+    
+    backend->buffers.bytes = malloc(PX_REACTOR_IO_URING_BUFFER_COUNT * PX_REACTOR_IO_URING_BUFFER_SIZE);
+    
+    struct io_uring_buf_reg registration;
+    memset(&registration, 0, sizeof(registration));
+    registration.ring_addr = (uint64_t)(uintptr_t)backend->buffers.ring;
+    registration.ring_entries = PX_REACTOR_IO_URING_BUFFER_COUNT;
+    registration.bgid = PX_REACTOR_IO_URING_BUFFER_GROUP;
+    
+    if (syscall(__NR_io_uring_register, backend->ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1) != 0)
+        return false;
+    
+    for (unsigned short i = 0; i < PX_REACTOR_IO_URING_BUFFER_COUNT; i++)
+        px_reactor_io_uring_recycle_buffer(backend, i);
+    
+    return true;
+}
+
+static void px_reactor_io_uring_recycle_buffer(px_reactor_io_uring *restrict backend, const unsigned short buffer_id)
+{
+    struct io_uring_buf *buffer = &backend->buffers.ring->bufs[backend->buffers.tail & (PX_REACTOR_IO_URING_BUFFER_COUNT - 1)];
+    buffer->addr = (uint64_t)(uintptr_t)(backend->buffers.bytes + (size_t)buffer_id * PX_REACTOR_IO_URING_BUFFER_SIZE);
+    buffer->len = PX_REACTOR_IO_URING_BUFFER_SIZE;
+    buffer->bid = buffer_id;
+    
+    backend->buffers.tail++;
+    __atomic_store_n(&backend->buffers.ring->tail, backend->buffers.tail, __ATOMIC_RELEASE);
+}
+
+static struct io_uring_sqe *px_reactor_io_uring_get_sqe(px_reactor_io_uring *restrict backend)
+{
+    // submit what has been queued so far if the submission queue is full
+    if (backend->sq.local_tail - __atomic_load_n(backend->sq.head, __ATOMIC_ACQUIRE) == backend->sq.entries)
+        px_reactor_io_uring_enter(backend, 0, 0);
+    
+    const unsigned int index = backend->sq.local_tail & *backend->sq.mask;
+    struct io_uring_sqe *sqe = &backend->sq.sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    
+    backend->sq.array[index] = index;
+    backend->sq.local_tail++;
+    backend->pending_submissions++;
+    
+    return sqe;
+}
+
+static int px_reactor_io_uring_enter(px_reactor_io_uring *restrict backend, const unsigned int min_complete, const int timeout)
+{
+    __atomic_store_n(backend->sq.tail, backend->sq.local_tail, __ATOMIC_RELEASE);
+    
+    unsigned int flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    struct __kernel_timespec wait_time;
+    struct io_uring_getevents_arg argument;
+    memset(&argument, 0, sizeof(argument));
+    
+    if (min_complete > 0 && timeout > 0)
+    {
+        wait_time.tv_sec = timeout / 1000;
+        wait_time.tv_nsec = (timeout % 1000) * 1000000L;
+        argument.ts = (uint64_t)(uintptr_t)&wait_time;
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+    
+    const long submitted = syscall(__NR_io_uring_enter, backend->ring_fd, backend->pending_submissions, min_complete, flags, (flags & IORING_ENTER_EXT_ARG) ? &argument : NULL, sizeof(argument));
+    
+    if (submitted < 0)
+    {
+        // a timeout or a signal just means that there's nothing to complete
+        return errno == ETIME || errno == EINTR || errno == EAGAIN || errno == EBUSY ? 0 : -1;
+    }
+    
+    backend->pending_submissions -= (unsigned int)submitted;
+    return (int)submitted;
+}
+
+static int px_reactor_io_uring_reap(px_reactor *restrict reactor)
+{
+    px_reactor_io_uring *backend = reactor->backend;
+    unsigned int head = *backend->cq.head;
+    const unsigned int tail = __atomic_load_n(backend->cq.tail, __ATOMIC_ACQUIRE);
+    int completed = 0;
+    
+    while (head != tail)
+    {
+        // the entry is handed back to the kernel first, completing it may end up reaping as well
+        const struct io_uring_cqe cqe = backend->cq.cqes[head & *backend->cq.mask];
+        __atomic_store_n(backend->cq.head, ++head, __ATOMIC_RELEASE);
+        
+        px_reactor_io_uring_complete(reactor, &cqe);
+        completed++;
+    }
+    
+    return completed;
+}
+
+static void px_reactor_io_uring_complete(px_reactor *restrict reactor, const struct io_uring_cqe *restrict cqe)
+{
+    // cancellations don't carry a socket
+    if (cqe->user_data == 0)
+        return;
+    
+    px_reactor_io_uring *backend = reactor->backend;
+    px_reactor_io_uring_socket *socket = (px_reactor_io_uring_socket *)(uintptr_t)(cqe->user_data & ~px_reactor_io_uring_request_mask);
+    
+    // completions reaped while a socket settles are no longer news to its operation
+    const bool active = px_reactor_io_uring_socket_is_active(socket) && !socket->settling;
+    
+    switch ((px_reactor_io_uring_request)(cqe->user_data & px_reactor_io_uring_request_mask))
+    {
+        case px_reactor_io_uring_request_receive:
+            if (cqe->flags & IORING_CQE_F_BUFFER)
+            {
+                const unsigned short buffer_id = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            
+                // late data of a connection that has since been reopened is dropped
+                if (cqe->res > 0 && socket->entry != NULL && px_connection_get_socket(socket->entry->connection) == socket->socket_number)
+                {
+                    px_buffer_append(&socket->entry->connection->input_buffer, backend->buffers.bytes + (size_t)buffer_id * PX_REACTOR_IO_URING_BUFFER_SIZE, (size_t)cqe->res);
+                }
+            
+                px_reactor_io_uring_recycle_buffer(backend, buffer_id);
+            }
+        
+            socket->receiving = false;
+            socket->outstanding--;
+        
+            if (cqe->res > 0)
+            {
+                // the next receive waits until the data has been dispatched, the operation may be over by then
+                if (active)
+                {
+                    px_reactor_add_ready(reactor, socket->entry, POLLIN);
+                    px_reactor_io_uring_want_receive(backend, socket);
+                }
+            }
+            else if (cqe->res == -ENOBUFS)
+            {
+                // every buffer was in use, they are recycled by the next wait
+                if (active)
+                    px_reactor_io_uring_want_receive(backend, socket);
+            }
+            else if (cqe->res != -ECANCELED && active)
+            {
+                px_reactor_add_ready(reactor, socket->entry, cqe->res == 0 ? POLLHUP : POLLERR);
+            }
+            break;
+        case px_reactor_io_uring_request_send:
+            socket->sending = false;
+            socket->outstanding--;
+        
+            if (cqe->res < 0)
+            {
+                if (active && cqe->res != -ECANCELED)
+                    px_reactor_add_ready(reactor, socket->entry, POLLERR);
+            }
+            else
+            {
+                px_buffer_consume(&socket->send_buffer, (size_t)cqe->res);
+            
+                if (socket->entry == NULL || socket->settling)
+                    break;
+            
+                if (px_buffer_get_length(&socket->send_buffer) > 0 || px_buffer_get_length(&socket->entry->connection->output_buffer) > 0)
+                    px_reactor_io_uring_send(backend, socket);
+                else if (active)
+                    px_reactor_add_ready(reactor, socket->entry, POLLOUT);
+            }
+            break;
+        case px_reactor_io_uring_request_poll:
+            socket->polling = false;
+            socket->outstanding--;
+        
+            if (cqe->res > 0 && active)
+            {
+                px_reactor_add_ready(reactor, socket->entry, (short)cqe->res);
+            
+                // queries keep watching until they finish, unlike opening
+                if (socket->entry->operation == px_reactor_operation_query)
+                    px_reactor_io_uring_poll(backend, socket, socket->entry->events);
+            }
+            break;
+    }
+    
+    if (socket->entry == NULL && socket->outstanding == 0)
+        px_reactor_io_uring_socket_release(backend, socket);
+}
+
+static px_reactor_io_uring_socket *px_reactor_io_uring_socket_new(px_reactor_io_uring *restrict backend, px_reactor_entry *restrict entry, const int socket_number)
+{
+    px_reactor_io_uring_socket *socket = calloc(1, sizeof(px_reactor_io_uring_socket));
+    socket->entry = entry;
+    socket->socket_number = socket_number;
+    
+    socket->next = backend->sockets;
+    if (backend->sockets != NULL)
+        backend->sockets->previous = socket;
+    backend->sockets = socket;
+    
+    return socket;
+}
+
+static void px_reactor_io_uring_socket_end(px_reactor *restrict reactor, px_reactor_io_uring_socket *restrict socket)
+{
+    px_reactor_io_uring *backend = reactor->backend;
+    
+    // while the entry is still there, whatever the receive got still ends up in the input buffer
+    px_reactor_io_uring_socket_settle(reactor, socket);
+    socket->entry = NULL;
+    
+    // polls don't take anything off the socket, they may as well finish in their own time
+    if (socket->polling)
+        px_reactor_io_uring_cancel(backend, socket, px_reactor_io_uring_request_poll);
+    
+    if (socket->outstanding == 0)
+        px_reactor_io_uring_socket_release(backend, socket);
+}
+
+static void px_reactor_io_uring_socket_settle(px_reactor *restrict reactor, px_reactor_io_uring_socket *restrict socket)
+{
+    px_reactor_io_uring *backend = reactor->backend;
+    
+    if (!socket->receiving && !socket->sending)
+        return;
+    
+    // a cancellation only reaches the kernel with the next io_uring_enter, until then a receive
+    // could go on taking bytes off the socket, so this waits for both to come back right away
+    socket->settling = true;
+    
+    if (socket->receiving)
+        px_reactor_io_uring_cancel(backend, socket, px_reactor_io_uring_request_receive);
+    
+    if (socket->sending)
+        px_reactor_io_uring_cancel(backend, socket, px_reactor_io_uring_request_send);
+    
+    while ((socket->receiving || socket->sending) && px_reactor_io_uring_enter(backend, 1, -1) >= 0)
+        px_reactor_io_uring_reap(reactor);
+    
+    socket->settling = false;
+    
+    // what hasn't been sent goes back to the connection, ahead of anything queued since
+    if (px_buffer_get_length(&socket->send_buffer) > 0 && socket->entry != NULL
+        && px_connection_get_socket(socket->entry->connection) == socket->socket_number)
+    {
+        px_buffer *output_buffer = &socket->entry->connection->output_buffer;
+        px_buffer_append(&socket->send_buffer, px_buffer_get_bytes(output_buffer), px_buffer_get_length(output_buffer));
+        px_buffer_clear(output_buffer);
+        px_buffer_append(output_buffer, px_buffer_get_bytes(&socket->send_buffer), px_buffer_get_length(&socket->send_buffer));
+    }
+    
+    px_buffer_clear(&socket->send_buffer);
+}
+
+static void px_reactor_io_uring_socket_release(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket)
+{
+    if (socket->receive_wanted)
+    {
+        for (unsigned int i = 0; i < backend->receives.count; i++)
+        {
+            if (backend->receives.values[i] == socket)
+            {
+                backend->receives.values[i] = backend->receives.values[--backend->receives.count];
+                break;
+            }
+        }
+    }
+    
+    if (socket->previous != NULL)
+        socket->previous->next = socket->next;
+    else
+        backend->sockets = socket->next;
+    
+    if (socket->next != NULL)
+        socket->next->previous = socket->previous;
+    
+    px_buffer_delete_members(&socket->send_buffer);
+    free(socket);
+}
+
+static bool px_reactor_io_uring_socket_is_active(const px_reactor_io_uring_socket *restrict socket)
+{
+    return socket->entry != NULL && socket->entry->backend_data == socket && socket->entry->events != 0;
+}
+
+static void px_reactor_io_uring_want_receive(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket)
+{
+    if (socket->receive_wanted)
+        return;
+    
+    if (backend->receives.count == backend->receives.capacity)
+    {
+        backend->receives.capacity = backend->receives.capacity == 0 ? 64 : backend->receives.capacity * 2;
+        backend->receives.values = realloc(backend->receives.values, backend->receives.capacity * sizeof(px_reactor_io_uring_socket *));
+    }
+    
+    backend->receives.values[backend->receives.count++] = socket;
+    socket->receive_wanted = true;
+}
+
+static void px_reactor_io_uring_receive(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket)
+{
+    // one-shot, a receive that stayed armed after the operation would take the next one's data
+    struct io_uring_sqe *sqe = px_reactor_io_uring_get_sqe(backend);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = socket->socket_number;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = PX_REACTOR_IO_URING_BUFFER_GROUP;
+    sqe->user_data = (uint64_t)(uintptr_t)socket | px_reactor_io_uring_request_receive;
+    
+    socket->receiving = true;
+    socket->outstanding++;
+}
+
+static void px_reactor_io_uring_send(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket)
+{
+    // the kernel reads the data after this returns, so it is moved to a buffer owned by the
+    // socket that stays put even if the connection goes away in the meantime
+    px_buffer *output_buffer = &socket->entry->connection->output_buffer;
+    const size_t length = px_buffer_get_length(output_buffer);
+    
+    if (length > 0)
+    {
+        px_buffer_append(&socket->send_buffer, px_buffer_get_bytes(output_buffer), length);
+        px_buffer_clear(output_buffer);
+    }
+    
+    if (px_buffer_get_length(&socket->send_buffer) == 0)
+        return;
+    
+    struct io_uring_sqe *sqe = px_reactor_io_uring_get_sqe(backend);
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = socket->socket_number;
+    sqe->addr = (uint64_t)(uintptr_t)px_buffer_get_bytes(&socket->send_buffer);
+    sqe->len = (unsigned int)px_buffer_get_length(&socket->send_buffer);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = (uint64_t)(uintptr_t)socket | px_reactor_io_uring_request_send;
+    
+    socket->sending = true;
+    socket->outstanding++;
+}
+
+static void px_reactor_io_uring_poll(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket, const short events)
+{
+    struct io_uring_sqe *sqe = px_reactor_io_uring_get_sqe(backend);
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = socket->socket_number;
+    sqe->poll32_events = (unsigned int)events;
+    sqe->user_data = (uint64_t)(uintptr_t)socket | px_reactor_io_uring_request_poll;
+    
+    socket->polling = true;
+    socket->outstanding++;
+}
+
+static void px_reactor_io_uring_cancel(px_reactor_io_uring *restrict backend, px_reactor_io_uring_socket *restrict socket, const px_reactor_io_uring_request request)
+{
+    struct io_uring_sqe *sqe = px_reactor_io_uring_get_sqe(backend);
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)(uintptr_t)socket | request;
+    sqe->user_data = 0;
+}
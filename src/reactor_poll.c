@@ -0,0 +1,112 @@
+//
+//  reactor_poll.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include "connection.h"
+#include "reactor.h"
+
+typedef struct px_reactor_poll
+{
+    unsigned int count;
+    unsigned int capacity;
+    struct pollfd *fds;
+    px_reactor_entry **entries;
+} px_reactor_poll;
+
+static bool px_reactor_poll_new(px_reactor *restrict reactor);
+static void px_reactor_poll_delete(px_reactor *restrict reactor);
+static bool px_reactor_poll_watch(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events);
+static int px_reactor_poll_wait(px_reactor *restrict reactor, const int timeout);
+
+const px_reactor_backend px_reactor_backend_poll =
+{
+    .type = px_reactor_backend_type_poll,
+    .transfers_data = false,
+    .new = px_reactor_poll_new,
+    .delete = px_reactor_poll_delete,
+    .watch = px_reactor_poll_watch,
+    .detach = NULL,
+    .wait = px_reactor_poll_wait
+};
+
+static bool px_reactor_poll_new(px_reactor *restrict reactor)
+{
+    reactor->backend = calloc(1, sizeof(px_reactor_poll));
+    return true;
+}
+
+static void px_reactor_poll_delete(px_reactor *restrict reactor)
+{
+    px_reactor_poll *backend = reactor->backend;
+    
+    if (backend->fds != NULL)
+        free(backend->fds);
+    
+    if (backend->entries != NULL)
+        free(backend->entries);
+    
+    free(backend);
+}
+
+static bool px_reactor_poll_watch(px_reactor *restrict reactor, px_reactor_entry *restrict entry, const short events)
+{
+    px_reactor_poll *backend = reactor->backend;
+    
+    if (entry->events == 0 && events != 0)
+    {
+        if (backend->count == backend->capacity)
+        {
+            backend->capacity = backend->capacity == 0 ? 64 : backend->capacity * 2;
+            backend->fds = realloc(backend->fds, backend->capacity * sizeof(struct pollfd));
+            backend->entries = realloc(backend->entries, backend->capacity * sizeof(px_reactor_entry *));
+        }
+        
+        entry->backend_index = backend->count++;
+        backend->entries[entry->backend_index] = entry;
+    }
+    else if (entry->events != 0 && events == 0)
+    {
+        const unsigned int last = --backend->count;
+        backend->fds[entry->backend_index] = backend->fds[last];
+        backend->entries[entry->backend_index] = backend->entries[last];
+        backend->entries[entry->backend_index]->backend_index = entry->backend_index;
+    }
+    
+    if (events != 0)
+        backend->fds[entry->backend_index].events = events;
+    
+    entry->events = events;
+    return true;
+}
+
+static int px_reactor_poll_wait(px_reactor *restrict reactor, const int timeout)
+{
+    px_reactor_poll *backend = reactor->backend;
+    
+    // the socket of a connection changes when it gets reopened
+    for (unsigned int i = 0; i < backend->count; i++)
+    {
+        backend->fds[i].fd = px_connection_get_socket(backend->entries[i]->connection);
+        backend->fds[i].revents = 0;
+    }
+    
+    const int count = poll(backend->fds, backend->count, timeout);
+    
+    if (count == -1)
+        return errno == EINTR ? 0 : -1;
+    
+    for (unsigned int i = 0; i < backend->count; i++)
+    {
+        if (backend->fds[i].revents != 0)
+            px_reactor_add_ready(reactor, backend->entries[i], backend->fds[i].revents);
+    }
+    
+    return count;
+}
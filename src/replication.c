@@ -0,0 +1,651 @@
+//
+//  replication.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replication.h"
+#include "connection.h"
+#include "error.h"
+#include "message.h"
+#include "pgoutput.h"
+#include "query.h"
+#include "response.h"
+#include "result.h"
+#include "utility.h"
+
+static bool px_replication_start(px_replication *restrict replication, const char *restrict command_text, const uint64_t start_lsn, const bool logical);
+static bool px_replication_finish(px_replication *restrict replication);
+static bool px_replication_wait(px_replication *restrict replication, const int timeout, const uint64_t deadline);
+static bool px_replication_process_copy_data(px_replication *restrict replication, const px_response *restrict response);
+static void px_replication_release_response(px_replication *restrict replication);
+static px_result *px_replication_execute(px_replication *restrict replication, const char *restrict command_text, const unsigned int column_count);
+static char *px_replication_copy_cell(const px_result *restrict result, const unsigned int column, size_t *restrict length);
+static void px_replication_parse_next_timeline(px_replication *restrict replication, const px_response *restrict response);
+
+// wal_receiver_status_interval defaults to the same
+static const unsigned int px_replication_default_status_interval = 10000;
+
+// XLogData: 'w', the start and the end of the WAL and the send time, followed by the WAL itself
+static const size_t px_replication_xlog_data_header_length = 25;
+
+// primary keepalive message: 'k', the end of the WAL, the send time and whether to reply right away
+static const size_t px_replication_keepalive_length = 18;
+
+// standby status update: 'r', the received, flushed and applied positions, the time and whether to reply
+#define PX_REPLICATION_STATUS_LENGTH 34
+
+px_replication *px_replication_new(px_connection *connection)
+{
+    px_replication *replication = calloc(1, sizeof(px_replication));
+    replication->connection = connection;
+    replication->status_interval = px_replication_default_status_interval;
+    
+    return replication;
+}
+
+void px_replication_delete(px_replication *replication)
+{
+    if (replication->streaming)
+        px_replication_stop(replication);
+    
+    px_replication_release_response(replication);
+    
+    if (replication->pgoutput != NULL)
+        px_pgoutput_delete(replication->pgoutput);
+    
+    free(replication);
+}
+
+bool px_replication_start_logical(px_replication *restrict replication, const char *restrict slot_name, const uint64_t start_lsn, const char *restrict publication_names)
+{
+    char lsn[PX_LSN_STRING_SIZE];
+    px_replication_format_lsn(start_lsn, lsn);
+    
+    // the slot name is an identifier, the publication names a literal the server splits at commas
+    char *command_text = malloc(strlen(slot_name) * 2 + strlen(publication_names) * 2 + 128);
+    char *end = stpcpy(command_text, "START_REPLICATION SLOT ");
+    end = px_replication_append_quoted(end, slot_name, '"');
+    end += sprintf(end, " LOGICAL %s (proto_version '1', publication_names ", lsn);
+    end = px_replication_append_quoted(end, publication_names, '\'');
+    strcpy(end, ")");
+    
+    if (replication->pgoutput == NULL)
+        replication->pgoutput = px_pgoutput_new();
+    
+    const bool started = px_replication_start(replication, command_text, start_lsn, true);
+    free(command_text);
+    
+    return started;
+}
+
+bool px_replication_start_physical(px_replication *restrict replication, const char *restrict slot_name, const uint64_t start_lsn, const unsigned int timeline)
+{
+    char lsn[PX_LSN_STRING_SIZE];
+    px_replication_format_lsn(start_lsn, lsn);
+    
+    // without a slot the server keeps the WAL only as long as wal_keep_size lets it
+    char *command_text = malloc((slot_name == NULL ? 0 : strlen(slot_name) * 2) + 128);
+    char *end = stpcpy(command_text, "START_REPLICATION ");
+    if (slot_name != NULL)
+    {
+        end = stpcpy(end, "SLOT ");
+        end = px_replication_append_quoted(end, slot_name, '"');
+        *end++ = ' ';
+    }
+    
+    end += sprintf(end, "PHYSICAL %s", lsn);
+    if (timeline != 0)
+        sprintf(end, " TIMELINE %u", timeline);
+    
+    const bool started = px_replication_start(replication, command_text, start_lsn, false);
+    free(command_text);
+    
+    return started;
+}
+
+bool px_replication_stop(px_replication *restrict replication)
+{
+    if (!replication->streaming)
+        return false;
+    
+    px_replication_release_response(replication);
+    
+    // the final positions are reported before the server is told to stop
+    px_message *message = px_message_new("cT");
+    const bool sent = px_replication_send_status(replication, false) && px_connection_send_message(replication->connection, message);
+    px_message_delete(message);
+    
+    if (!sent)
+    {
+        px_connection_fail(replication->connection);
+        replication->streaming = false;
+        return false;
+    }
+    
+    return px_replication_finish(replication);
+}
+
+const px_replication_data *px_replication_read(px_replication *restrict replication, const int timeout)
+{
+    px_connection *connection = replication->connection;
+    const uint64_t deadline = px_get_monotonic_time() + (uint64_t)(timeout < 0 ? 0 : timeout);
+    
+    px_replication_release_response(replication);
+    
+    while (replication->streaming)
+    {
+        px_response *response = px_response_next(connection);
+        if (response == NULL)
+        {
+            // the messages that arrived before the connection was lost have been read by now
+            if (connection->connection_status == px_connection_status_failed)
+            {
+                replication->streaming = false;
+                return NULL;
+            }
+            
+            if (!px_replication_wait(replication, timeout, deadline))
+                return NULL;
+            
+            continue;
+        }
+        
+        switch (response->message_type)
+        {
+            case px_message_type_copy_data:
+                if (px_replication_process_copy_data(replication, response))
+                {
+                    replication->response = response;
+                    return &replication->data;
+                }
+                break;
+            case px_message_type_copy_done:
+            {
+                // the server ended the stream, it has to be acknowledged before it is ready for queries
+                px_message *message = px_message_new("cT");
+                const bool sent = px_connection_send_message(connection, message);
+                px_message_delete(message);
+                
+                px_response_delete(response);
+                if (sent)
+                    px_replication_finish(replication);
+                else
+                    px_connection_fail(connection);
+                
+                replication->streaming = false;
+                return NULL;
+            }
+            case px_message_type_error:
+                // the error is kept as the last error of the connection
+                px_response_delete(response);
+                px_replication_finish(replication);
+                return NULL;
+            default:
+                break;
+        }
+        
+        px_response_delete(response);
+    }
+    
+    return NULL;
+}
+
+const px_pgoutput_message *px_replication_read_change(px_replication *restrict replication, const int timeout)
+{
+    if (replication->pgoutput == NULL)
+    {
+        px_connection_set_last_error(replication->connection, px_error_new_custom("55000", "the replication stream is not logical"));
+        return NULL;
+    }
+    
+    const px_replication_data *data = px_replication_read(replication, timeout);
+    if (data == NULL)
+        return NULL;
+    
+    const px_pgoutput_message *message = px_pgoutput_decode(replication->pgoutput, data->data, data->length);
+    if (message == NULL)
+    {
+        // carrying on would lose the change
+        px_replication_stop(replication);
+        px_connection_set_last_error(replication->connection, px_error_new_custom("08P01", "malformed logical replication message"));
+    }
+    
+    return message;
+}
+
+void px_replication_confirm(px_replication *restrict replication, const uint64_t lsn)
+{
+    if (lsn > replication->flushed_lsn)
+        replication->flushed_lsn = lsn;
+    
+    if (lsn > replication->applied_lsn)
+        replication->applied_lsn = lsn;
+}
+
+bool px_replication_send_status(px_replication *restrict replication, const bool reply_requested)
+{
+    char status[PX_REPLICATION_STATUS_LENGTH];
+    status[0] = 'r';
+    px_write_network_uint64(status + 1, replication->received_lsn);
+    px_write_network_uint64(status + 9, replication->flushed_lsn);
+    px_write_network_uint64(status + 17, replication->applied_lsn);
+    px_write_network_uint64(status + 25, (uint64_t)px_get_postgres_time());
+    status[33] = reply_requested ? 1 : 0;
+    
+    px_message *message = px_message_new("dTb", status, sizeof(status));
+    const bool sent = px_connection_send_message(replication->connection, message);
+    px_message_delete(message);
+    
+    replication->next_status = px_get_monotonic_time() + replication->status_interval;
+    
+    if (!sent)
+        px_connection_set_last_error(replication->connection, px_error_new_io_error());
+    
+    return sent;
+}
+
+bool px_replication_identify_system(px_replication *restrict replication, uint64_t *restrict system_identifier, unsigned int *restrict timeline, uint64_t *restrict lsn)
+{
+    px_result *result = px_replication_execute(replication, "IDENTIFY_SYSTEM", 3);
+    if (result == NULL)
+        return false;
+    
+    char *system_identifier_text = px_replication_copy_cell(result, 0, NULL);
+    char *timeline_text = px_replication_copy_cell(result, 1, NULL);
+    char *lsn_text = px_replication_copy_cell(result, 2, NULL);
+    px_result_delete(result);
+    
+    char *system_identifier_end, *timeline_end;
+    *system_identifier = strtoull(system_identifier_text, &system_identifier_end, 10);
+    *timeline = (unsigned int)strtoul(timeline_text, &timeline_end, 10);
+    const bool valid = *system_identifier_text != '\0' && *system_identifier_end == '\0' && *timeline_text != '\0' && *timeline_end == '\0' && px_replication_parse_lsn(lsn_text, lsn);
+    
+    free(system_identifier_text);
+    free(timeline_text);
+    free(lsn_text);
+    
+    if (!valid)
+        px_connection_set_last_error(replication->connection, px_error_new_custom("08P01", "malformed IDENTIFY_SYSTEM result"));
+    
+    return valid;
+}
+
+bool px_replication_fetch_timeline_history(px_replication *restrict replication, const unsigned int timeline, char **restrict file_name, char **restrict content, size_t *restrict length)
+{
+    char command_text[32];
+    sprintf(command_text, "TIMELINE_HISTORY %u", timeline);
+    
+    px_result *result = px_replication_execute(replication, command_text, 2);
+    if (result == NULL)
+        return false;
+    
+    // the content is declared bytea, but it is sent as the file is
+    *file_name = px_replication_copy_cell(result, 0, NULL);
+    *content = px_replication_copy_cell(result, 1, length);
+    px_result_delete(result);
+    
+    // the file name is written to a directory, so anything but a plain name is refused
+    if (**file_name == '\0' || strchr(*file_name, '/') != NULL || **file_name == '.')
+    {
+        free(*file_name);
+        free(*content);
+        px_connection_set_last_error(replication->connection, px_error_new_custom("08P01", "malformed TIMELINE_HISTORY result"));
+        return false;
+    }
+    
+    return true;
+}
+
+bool px_replication_is_streaming(const px_replication *restrict replication)
+{
+    return replication->streaming;
+}
+
+uint64_t px_replication_get_received_lsn(const px_replication *restrict replication)
+{
+    return replication->received_lsn;
+}
+
+uint64_t px_replication_get_server_lsn(const px_replication *restrict replication)
+{
+    return replication->server_lsn;
+}
+
+unsigned int px_replication_get_next_timeline(const px_replication *restrict replication)
+{
+    return replication->next_timeline;
+}
+
+uint64_t px_replication_get_next_timeline_lsn(const px_replication *restrict replication)
+{
+    return replication->next_timeline_lsn;
+}
+
+const px_pgoutput *px_replication_get_pgoutput(const px_replication *restrict replication)
+{
+    return replication->pgoutput;
+}
+
+unsigned int px_replication_get_status_interval(const px_replication *restrict replication)
+{
+    return replication->status_interval;
+}
+
+void px_replication_set_status_interval(px_replication *restrict replication, const unsigned int value)
+{
+    replication->status_interval = value;
+    replication->next_status = px_get_monotonic_time() + value;
+}
+
+bool px_replication_parse_lsn(const char *restrict text, uint64_t *restrict lsn)
+{
+    unsigned int high, low;
+    int length;
+    
+    if (sscanf(text, "%X/%X%n", &high, &low, &length) != 2 || text[length] != '\0')
+        return false;
+    
+    *lsn = (uint64_t)high << 32 | low;
+    return true;
+}
+
+void px_replication_format_lsn(const uint64_t lsn, char *restrict text)
+{
+    sprintf(text, "%X/%X", (unsigned int)(lsn >> 32), (unsigned int)lsn);
+}
+
+char *px_replication_append_quoted(char *restrict end, const char *restrict value, const char quote)
+{
+    *end++ = quote;
+    for (const char *c = value; *c != '\0'; c++)
+    {
+        if (*c == quote)
+            *end++ = quote;
+        
+        *end++ = *c;
+    }
+    
+    *end++ = quote;
+    *end = '\0';
+    
+    return end;
+}
+
+static bool px_replication_start(px_replication *restrict replication, const char *restrict command_text, const uint64_t start_lsn, const bool logical)
+{
+    px_connection *connection = replication->connection;
+    
+    if (connection->connection_status != px_connection_status_open)
+    {
+        px_connection_set_last_error(connection, px_error_new_io_error());
+        return false;
+    }
+    
+    if (replication->streaming || connection->results.busy)
+    {
+        px_connection_set_last_error(connection, px_error_new_custom("55000", "another query is already in progress"));
+        return false;
+    }
+    
+    px_message *message = px_message_new("QTs", command_text);
+    const bool sent = px_connection_send_message(connection, message);
+    px_message_delete(message);
+    
+    if (!sent)
+    {
+        px_connection_set_last_error(connection, px_error_new_io_error());
+        return false;
+    }
+    
+    px_connection_set_last_error(connection, NULL);
+    
+    // the server either switches to copy both mode or reports an error and becomes ready again
+    bool streaming = false;
+    while (!streaming)
+    {
+        px_response *response = px_response_read_with_timeout(connection, -1);
+        if (response == NULL)
+            return false;
+        
+        const px_message_type message_type = response->message_type;
+        if (message_type == px_message_type_ready_for_query)
+            connection->transaction_status = response->response_data.ready_for_query.transaction_status;
+        
+        px_response_delete(response);
+        
+        if (message_type == px_message_type_copy_both_response)
+        {
+            streaming = true;
+        }
+        else if (message_type == px_message_type_ready_for_query)
+        {
+            if (connection->last_error == NULL)
+                px_connection_set_last_error(connection, px_error_new_custom("08P01", "the server did not start streaming"));
+            
+            return false;
+        }
+    }
+    
+    // queries can't be sent until the stream is stopped
+    connection->results.busy = true;
+    
+    replication->streaming = true;
+    replication->logical = logical;
+    replication->next_timeline = 0;
+    replication->next_timeline_lsn = 0;
+    replication->received_lsn = start_lsn;
+    replication->flushed_lsn = start_lsn;
+    replication->applied_lsn = start_lsn;
+    replication->server_lsn = start_lsn;
+    replication->next_status = px_get_monotonic_time() + replication->status_interval;
+    
+    return true;
+}
+
+// skips the rest of the stream after copy done until the server is ready for queries again
+static bool px_replication_finish(px_replication *restrict replication)
+{
+    px_connection *connection = replication->connection;
+    replication->streaming = false;
+    
+    while (true)
+    {
+        px_response *response = px_response_read_with_timeout(connection, -1);
+        if (response == NULL)
+        {
+            px_connection_fail(connection);
+            return false;
+        }
+        
+        // a physical stream that ended with its timeline is followed by the timeline to continue with
+        if (response->message_type == px_message_type_data_row)
+            px_replication_parse_next_timeline(replication, response);
+        
+        const bool ready_for_query = response->message_type == px_message_type_ready_for_query;
+        if (ready_for_query)
+            connection->transaction_status = response->response_data.ready_for_query.transaction_status;
+        
+        px_response_delete(response);
+        
+        if (ready_for_query)
+        {
+            connection->results.busy = false;
+            return connection->last_error == NULL;
+        }
+    }
+}
+
+// waits for more of the stream and sends the status updates that are due in the meantime.
+// returns false once the timeout runs out
+static bool px_replication_wait(px_replication *restrict replication, const int timeout, const uint64_t deadline)
+{
+    px_connection *connection = replication->connection;
+    uint64_t now = px_get_monotonic_time();
+    
+    if (replication->status_interval > 0 && now >= replication->next_status)
+    {
+        if (!px_replication_send_status(replication, false))
+        {
+            px_connection_fail(connection);
+            return true;
+        }
+        
+        now = px_get_monotonic_time();
+    }
+    
+    int wait_time = timeout < 0 ? -1 : now < deadline ? (int)(deadline - now) : 0;
+    if (replication->status_interval > 0)
+    {
+        const int status_time = replication->next_status > now ? (int)(replication->next_status - now) : 0;
+        if (wait_time < 0 || status_time < wait_time)
+            wait_time = status_time;
+    }
+    
+    if (px_connection_poll(connection, wait_time))
+    {
+        // the messages read before the connection was lost are still processed
+        if (!px_connection_read_input(connection))
+            px_connection_fail(connection);
+        
+        return true;
+    }
+    
+    if (wait_time < 0)
+    {
+        px_connection_fail(connection);
+        return true;
+    }
+    
+    // either a status update is due or the time is up
+    return timeout < 0 || px_get_monotonic_time() < deadline;
+}
+
+static bool px_replication_process_copy_data(px_replication *restrict replication, const px_response *restrict response)
+{
+    const char *data = response->response_data.copy_data.data;
+    const size_t length = response->response_data.copy_data.length;
+    
+    if (length >= px_replication_xlog_data_header_length && data[0] == 'w')
+    {
+        px_replication_data *replication_data = &replication->data;
+        replication_data->start_lsn = px_read_network_uint64(data + 1);
+        replication_data->end_lsn = px_read_network_uint64(data + 9);
+        replication_data->send_time = (int64_t)px_read_network_uint64(data + 17);
+        replication_data->data = data + px_replication_xlog_data_header_length;
+        replication_data->length = length - px_replication_xlog_data_header_length;
+        
+        // logical streams send one change at a time, the WAL in between isn't sent at all
+        const uint64_t received_lsn = replication->logical ? replication_data->start_lsn : replication_data->start_lsn + replication_data->length;
+        if (received_lsn > replication->received_lsn)
+            replication->received_lsn = received_lsn;
+        
+        if (replication_data->end_lsn > replication->server_lsn)
+            replication->server_lsn = replication_data->end_lsn;
+        
+        return true;
+    }
+    
+    if (length >= px_replication_keepalive_length && data[0] == 'k')
+    {
+        const uint64_t server_lsn = px_read_network_uint64(data + 1);
+        if (server_lsn > replication->server_lsn)
+            replication->server_lsn = server_lsn;
+        
+        // once every change received has been confirmed, there is nothing else to wait for up to the
+        // end of the WAL, which lets the server recycle it even if nothing is published for a while
+        if (replication->logical && replication->flushed_lsn >= replication->received_lsn && server_lsn > replication->flushed_lsn)
+        {
+            replication->received_lsn = server_lsn;
+            replication->flushed_lsn = server_lsn;
+            replication->applied_lsn = server_lsn;
+        }
+        
+        // the server disconnects after wal_sender_timeout if it doesn't get a reply
+        if (data[17] != 0 && !px_replication_send_status(replication, false))
+            px_connection_fail(replication->connection);
+    }
+    
+    return false;
+}
+
+static void px_replication_release_response(px_replication *restrict replication)
+{
+    if (replication->response != NULL)
+    {
+        px_response_delete(replication->response);
+        replication->response = NULL;
+    }
+}
+
+static void px_replication_parse_next_timeline(px_replication *restrict replication, const px_response *restrict response)
+{
+    const px_data_cell *cells = response->response_data.data_row.cells;
+    if (response->response_data.data_row.cell_count != 2 || cells[0].length <= 0 || cells[1].length <= 0 || cells[1].length >= PX_LSN_STRING_SIZE)
+        return;
+    
+    char timeline[16], lsn[PX_LSN_STRING_SIZE];
+    const size_t timeline_length = (size_t)cells[0].length < sizeof(timeline) ? (size_t)cells[0].length : sizeof(timeline) - 1;
+    memcpy(timeline, cells[0].data, timeline_length);
+    timeline[timeline_length] = '\0';
+    memcpy(lsn, cells[1].data, (size_t)cells[1].length);
+    lsn[cells[1].length] = '\0';
+    
+    uint64_t next_timeline_lsn;
+    const unsigned long next_timeline = strtoul(timeline, NULL, 10);
+    if (next_timeline > 0 && px_replication_parse_lsn(lsn, &next_timeline_lsn))
+    {
+        replication->next_timeline = (unsigned int)next_timeline;
+        replication->next_timeline_lsn = next_timeline_lsn;
+    }
+}
+
+// runs a replication command that returns a single row, NULL on errors
+static px_result *px_replication_execute(px_replication *restrict replication, const char *restrict command_text, const unsigned int column_count)
+{
+    if (replication->streaming)
+    {
+        px_connection_set_last_error(replication->connection, px_error_new_custom("55000", "another query is already in progress"));
+        return NULL;
+    }
+    
+    px_query *query = px_query_new(command_text, replication->connection);
+    px_result_list *result_list = px_query_execute(query);
+    px_query_delete(query);
+    
+    if (result_list == NULL)
+        return NULL;
+    
+    px_result *result = NULL;
+    if (result_list->count == 1 && px_result_get_row_count(result_list->results[0]) == 1 && px_result_get_column_count(result_list->results[0]) >= column_count)
+        result = result_list->results[0];
+    else if (px_connection_get_last_error(replication->connection) == NULL)
+        px_connection_set_last_error(replication->connection, px_error_new_custom("08P01", "unexpected result of a replication command"));
+    
+    px_result_list_delete(result_list, result != NULL);
+    
+    return result;
+}
+
+// copies a cell of the first row as a zero terminated string, NULLs become empty strings
+static char *px_replication_copy_cell(const px_result *restrict result, const unsigned int column, size_t *restrict length)
+{
+    const px_data_cell *cell = &result->rows.values[0].cells[column];
+    const size_t cell_length = px_result_is_db_null(result, column, 0) ? 0 : (size_t)cell->length;
+    
+    char *value = malloc(cell_length + 1);
+    if (cell_length > 0)
+        memcpy(value, cell->data, cell_length);
+    
+    value[cell_length] = '\0';
+    
+    if (length != NULL)
+        *length = cell_length;
+    
+    return value;
+}
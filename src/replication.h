@@ -0,0 +1,99 @@
+//
+//  replication.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_replication_h
+#define libpx_replication_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "typedef.h"
+
+// the longest LSN in its text form (e.g. "16/B374D848") including the terminating zero
+#define PX_LSN_STRING_SIZE 18
+
+// the WAL sent by the server (XLogData), a change decoded by the output plugin in logical streams.
+// end_lsn is where the WAL ended on the server when it was sent
+struct px_replication_data
+{
+    uint64_t start_lsn;
+    uint64_t end_lsn;
+    int64_t send_time;
+    const char *data;
+    size_t length;
+};
+
+struct px_replication
+{
+    px_connection *connection;
+    bool streaming;
+    bool logical;
+    
+    // where a physical stream continues once the server has streamed all of the timeline requested
+    unsigned int next_timeline;
+    uint64_t next_timeline_lsn;
+    
+    // the decoder of logical streams
+    px_pgoutput *pgoutput;
+    
+    // positions reported in standby status updates. the WAL received is tracked as it arrives,
+    // flushing and applying it is up to the consumer to confirm
+    uint64_t received_lsn;
+    uint64_t flushed_lsn;
+    uint64_t applied_lsn;
+    uint64_t server_lsn;
+    
+    // status updates are sent every status_interval milliseconds while reading, and right away
+    // when the server asks for one
+    unsigned int status_interval;
+    uint64_t next_status;
+    
+    // the message the data points into, kept until the next one is read
+    px_response *response;
+    px_replication_data data;
+};
+
+// create & delete
+px_replication *px_replication_new(px_connection *connection);
+void px_replication_delete(px_replication *replication);
+
+// starting and stopping streaming
+bool px_replication_start_logical(px_replication *restrict replication, const char *restrict slot_name, const uint64_t start_lsn, const char *restrict publication_names);
+bool px_replication_start_physical(px_replication *restrict replication, const char *restrict slot_name, const uint64_t start_lsn, const unsigned int timeline);
+bool px_replication_stop(px_replication *restrict replication);
+
+// reading the stream
+const px_replication_data *px_replication_read(px_replication *restrict replication, const int timeout);
+const px_pgoutput_message *px_replication_read_change(px_replication *restrict replication, const int timeout);
+
+// reporting progress to the server
+void px_replication_confirm(px_replication *restrict replication, const uint64_t lsn);
+bool px_replication_send_status(px_replication *restrict replication, const bool reply_requested);
+
+// commands of physical replication
+bool px_replication_identify_system(px_replication *restrict replication, uint64_t *restrict system_identifier, unsigned int *restrict timeline, uint64_t *restrict lsn);
+bool px_replication_fetch_timeline_history(px_replication *restrict replication, const unsigned int timeline, char **restrict file_name, char **restrict content, size_t *restrict length);
+
+// getters & setters
+bool px_replication_is_streaming(const px_replication *restrict replication) __attribute__((pure));
+uint64_t px_replication_get_received_lsn(const px_replication *restrict replication) __attribute__((pure));
+uint64_t px_replication_get_server_lsn(const px_replication *restrict replication) __attribute__((pure));
+unsigned int px_replication_get_next_timeline(const px_replication *restrict replication) __attribute__((pure));
+uint64_t px_replication_get_next_timeline_lsn(const px_replication *restrict replication) __attribute__((pure));
+const px_pgoutput *px_replication_get_pgoutput(const px_replication *restrict replication) __attribute__((pure));
+unsigned int px_replication_get_status_interval(const px_replication *restrict replication) __attribute__((pure));
+void px_replication_set_status_interval(px_replication *restrict replication, const unsigned int value);
+
+// LSNs in their text form
+bool px_replication_parse_lsn(const char *restrict text, uint64_t *restrict lsn);
+void px_replication_format_lsn(const uint64_t lsn, char *restrict text);
+
+// quoting the identifiers and the literals of replication commands, end needs twice the value's length and 3 bytes
+char *px_replication_append_quoted(char *restrict end, const char *restrict value, const char quote);
+
+#endif
@@ -15,13 +15,14 @@
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <arpa/inet.h>
+#include "buffer.h"
 #include "connection.h"
 #include "error.h"
 
 static void px_response_delete_contents(px_response *response);
 static void px_response_delete_without_contents(px_response *response);
 
-static bool px_response_read_bytes_from_file(const int file_descriptor, px_message_class *out_message_class, void *restrict* out_message_bytes, size_t *restrict out_message_length);
+static const size_t px_response_header_length = 5;
 
 #ifdef DEBUG_RESPONSE
 static char* px_message_type_string(px_message_type type);
@@ -33,8 +34,12 @@ static bool px_response_parse_bind_complete(px_response *restrict response);
 static bool px_response_parse_cancellation_key_data(px_response *restrict response);
 static bool px_response_parse_close_complete(px_response *restrict response);
 static bool px_response_parse_command_complete(px_response *restrict response);
+static bool px_response_parse_copy_data(px_response *restrict response);
+static bool px_response_parse_copy_response(px_response *restrict response, const px_message_type message_type);
 static bool px_response_parse_data_row(px_response *restrict response);
+static bool px_response_parse_empty_query_response(px_response *restrict response);
 static bool px_response_parse_error(px_response *restrict response);
+static bool px_response_parse_notification(px_response *restrict response);
 static bool px_response_parse_parse_complete(px_response *restrict response);
 static bool px_response_parse_ready_for_query(px_response *restrict response);
 static bool px_response_parse_row_description(px_response *restrict response);
@@ -75,7 +80,7 @@ static void px_response_delete_contents(px_response *response)
     {
         free(response->response_data.row_description.columns);
     }
-    else if (response->message_type == px_message_class_data_row &&
+    else if (response->message_type == px_message_type_data_row &&
              response->response_data.data_row.cells != NULL)
     {
         free(response->response_data.data_row.cells);
@@ -88,84 +93,72 @@ static void px_response_delete_without_contents(px_response *response)
 }
 
 px_response *px_response_read_with_timeout(px_connection *restrict connection, const int timeout)
-{   
-    if (px_connection_poll(connection, timeout))
-    {
-        return px_response_read(connection);
-    }
-    else
-    {
-        px_connection_set_last_error(connection, px_error_new_io_error());
-        return NULL;
-    }
-}
-
-px_response *px_response_read(px_connection *restrict connection)
 {
-    void *message_bytes = NULL;
-    px_message_class message_class = px_message_class_undefined;
-    size_t message_length = 0;
-    
-    if (!px_response_read_bytes_from_file(connection->socket_number,
-                                          &message_class,
-                                          &message_bytes,
-                                          &message_length))
-    {
-        if (message_bytes != NULL)
-            free(message_bytes);
-        return NULL;
-    }
-    
-    px_response *response = px_response_new();
-    response->message_length = message_length;
-    response->message_bytes = message_bytes;
-    response->message_class = message_class;
-    
-    if (!px_response_parse(response))
+    px_response *response;
+    while ((response = px_response_next(connection)) == NULL)
     {
-        px_response_delete(response);
-        return NULL;
-    }
-#ifdef DEBUG_RESPONSE
-    else
-    {
-        printf("Parsed: %c %s (%i)\n", (char)response->message_class, px_message_type_string(response->message_type), response->message_type);
+        if (!px_connection_poll(connection, timeout) || !px_connection_read_input(connection))
+        {
+            px_connection_set_last_error(connection, px_error_new_io_error());
+            return NULL;
+        }
     }
-#endif /* DEBUG_RESPONSE */
-    
-    if (response->message_type == px_message_type_error)
-        px_connection_set_last_error(connection, px_error_new(response));
     
     return response;
 }
 
-static bool px_response_read_bytes_from_file(const int fileDescriptor, px_message_class *restrict outMessageClass, void *restrict* outMessageBytes, size_t *restrict outMessageLength)
+px_response *px_response_read(px_connection *restrict connection)
 {
-    static const size_t header_length = 5;
-    char response_header[header_length];
+    return px_response_read_with_timeout(connection, -1);
+}
 
-    if (read(fileDescriptor, response_header, header_length) != header_length)
+px_response *px_response_next(px_connection *restrict connection)
+{
+    px_buffer *input_buffer = &connection->input_buffer;
+    
+    while (px_buffer_get_length(input_buffer) >= px_response_header_length)
     {
-        return false;
+        const char *header = px_buffer_get_bytes(input_buffer);
+        unsigned int network_message_length;
+        memcpy(&network_message_length, header + 1, sizeof(network_message_length));
+        
+        // the length includes itself but not the message class
+        const size_t message_length = ntohl(network_message_length);
+        if (px_buffer_get_length(input_buffer) < message_length + 1)
+        {
+            return NULL;
+        }
+        
+        void *message_bytes = malloc(message_length);
+        memcpy(message_bytes, header + 1, message_length);
+        
+        px_response *response = px_response_new();
+        response->message_length = message_length;
+        response->message_bytes = message_bytes;
+        response->message_class = (px_message_class)header[0];
+        
+        px_buffer_consume(input_buffer, message_length + 1);
+        
+        if (!px_response_parse(response))
+        {
+            // skip messages we don't understand and carry on with the next one
+            px_response_delete(response);
+            continue;
+        }
+#ifdef DEBUG_RESPONSE
+        else
+        {
+            printf("Parsed: %c %s (%i)\n", (char)response->message_class, px_message_type_string(response->message_type), response->message_type);
+        }
+#endif /* DEBUG_RESPONSE */
+        
+        if (response->message_type == px_message_type_error)
+            px_connection_set_last_error(connection, px_error_new(response));
+        
+        return response;
     }
     
-    const size_t message_length = ntohl(*((unsigned int*)(response_header + 1)));
-    
-    void *message_bytes = calloc(message_length, sizeof(char));
-    memcpy(message_bytes, response_header + 1, header_length - 1);
-    
-    read(fileDescriptor, message_bytes + header_length - 1, message_length - header_length + 1);
-    
-    if (outMessageClass != NULL)
-        *outMessageClass = (px_message_class)response_header[0];
-    
-    if (outMessageBytes != NULL)
-        *outMessageBytes = message_bytes;
-    
-    if (outMessageLength != NULL)
-        *outMessageLength = message_length;
-    
-    return true;
+    return NULL;
 }
 
 static bool px_response_parse(px_response *restrict response)
@@ -177,7 +170,7 @@ static bool px_response_parse(px_response *restrict response)
         
         case px_message_class_bind_complete:
             return px_response_parse_bind_complete(response);
-            
+        
         case px_message_class_cancellation_key_data:
             return px_response_parse_cancellation_key_data(response);
         
@@ -186,25 +179,46 @@ static bool px_response_parse(px_response *restrict response)
         
         case px_message_class_command_complete:
             return px_response_parse_command_complete(response);
-            
+        
+        case px_message_class_copy_data:
+            return px_response_parse_copy_data(response);
+        
+        case px_message_class_copy_done:
+            return px_response_parse_copy_response(response, px_message_type_copy_done);
+        
+        case px_message_class_copy_both_response:
+            return px_response_parse_copy_response(response, px_message_type_copy_both_response);
+        
+        case px_message_class_copy_in_response:
+            return px_response_parse_copy_response(response, px_message_type_copy_in_response);
+        
+        case px_message_class_copy_out_response:
+            return px_response_parse_copy_response(response, px_message_type_copy_out_response);
+        
         case px_message_class_error:
             return px_response_parse_error(response);
-            
+        
+        case px_message_class_notification:
+            return px_response_parse_notification(response);
+        
         case px_message_class_parse_complete:
             return px_response_parse_parse_complete(response);
-            
+        
         case px_message_class_runtime_parameter_status_report:
             return px_response_parse_runtime_parameter_status_report(response);
-            
+        
         case px_message_class_ready_for_query:
             return px_response_parse_ready_for_query(response);
         
         case px_message_class_row_description:
             return px_response_parse_row_description(response);
-            
+        
         case px_message_class_data_row:
             return px_response_parse_data_row(response);
-            
+        
+        case px_message_class_empty_query_response:
+            return px_response_parse_empty_query_response(response);
+        
         default:
             fprintf(stderr, "Unknown PostgreSQL message class: %c\n", (char)response->message_class);
             return false;
@@ -213,7 +227,8 @@ static bool px_response_parse(px_response *restrict response)
 
 static bool px_response_parse_authentication_request(px_response *restrict response)
 {
-    const int code = htonl(*((int*)(response->message_bytes + 4)));
+    // a truncated request is answered like a method the library doesn't know
+    const int code = response->message_length >= 8 ? (int)ntohl(*((unsigned int*)(response->message_bytes + 4))) : -1;
     
     switch (code)
     {
@@ -221,13 +236,29 @@ static bool px_response_parse_authentication_request(px_response *restrict respo
             response->message_type = px_message_type_authentication_ok;
             return true;
         case 5:
+            if (response->message_length < 12)
+                break;
+            
             response->message_type = px_message_type_authentication_md5_password;
             memcpy(response->response_data.authentication_md5_password.salt, response->message_bytes + 8, 4);
             return true;
+        case 10:
+        case 11:
+        case 12:
+            response->message_type = code == 10 ? px_message_type_authentication_sasl :
+                                     code == 11 ? px_message_type_authentication_sasl_continue :
+                                                  px_message_type_authentication_sasl_final;
+            response->response_data.authentication_sasl.data = response->message_bytes + 8;
+            response->response_data.authentication_sasl.length = response->message_length - 8;
+            return true;
         default:
-            fprintf(stderr, "Unknown PostgreSQL authentication response: %i\n", code);
-            return false;
+            break;
     }
+    
+    // still a message in its own right, the connection has to fail on it rather than wait for another one
+    response->message_type = px_message_type_authentication_unsupported;
+    response->response_data.authentication_unsupported.code = code;
+    return true;
 }
 
 static bool px_response_parse_cancellation_key_data(px_response *restrict response)
@@ -263,6 +294,12 @@ static bool px_response_parse_close_complete(px_response *restrict response)
     return true;
 }
 
+static bool px_response_parse_empty_query_response(px_response *restrict response)
+{
+    response->message_type = px_message_type_empty_query_response;
+    return true;
+}
+
 static bool px_response_parse_command_complete(px_response *restrict response)
 {
     response->message_type = px_message_type_command_complete;
@@ -271,6 +308,22 @@ static bool px_response_parse_command_complete(px_response *restrict response)
     return true;
 }
 
+static bool px_response_parse_copy_data(px_response *restrict response)
+{
+    response->message_type = px_message_type_copy_data;
+    response->response_data.copy_data.data = (char*)response->message_bytes + 4;
+    response->response_data.copy_data.length = response->message_length - 4;
+    
+    return true;
+}
+
+static bool px_response_parse_copy_response(px_response *restrict response, const px_message_type message_type)
+{
+    // the formats of the columns don't matter to replication, the only user of copy so far
+    response->message_type = message_type;
+    return true;
+}
+
 static bool px_response_parse_parse_complete(px_response *restrict response)
 {
     response->message_type = px_message_type_parse_complete;
@@ -343,6 +396,26 @@ static bool px_response_parse_error(px_response *restrict response)
     return true;
 }
 
+static bool px_response_parse_notification(px_response *restrict response)
+{
+    // the process id is followed by the channel and the payload, both of them terminated
+    if (response->message_length < 10)
+        return false;
+    
+    char *channel = (char*)response->message_bytes + 8;
+    const char *end = (char*)response->message_bytes + response->message_length;
+    const char *channel_end = memchr(channel, '\0', (size_t)(end - channel));
+    if (channel_end == NULL || memchr(channel_end + 1, '\0', (size_t)(end - channel_end - 1)) == NULL)
+        return false;
+    
+    response->message_type = px_message_type_notification;
+    response->response_data.notification.process_id = ntohl(*((int*)(response->message_bytes + 4)));
+    response->response_data.notification.channel = channel;
+    response->response_data.notification.payload = channel + (channel_end - channel) + 1;
+    
+    return true;
+}
+
 static bool px_response_parse_row_description(px_response *restrict response)
 {
     response->message_type = px_message_type_row_description;
@@ -354,7 +427,7 @@ static bool px_response_parse_row_description(px_response *restrict response)
             calloc(response->response_data.row_description.column_count,
                    sizeof(px_row_description_column));
     }
-       
+    
     void *cursor = response->message_bytes + 6;
     for (unsigned int i = 0; i < response->response_data.row_description.column_count; i++)
     {
@@ -447,6 +520,14 @@ static char* px_message_type_string(px_message_type type)
             return "authentication ok";
         case px_message_type_authentication_md5_password:
             return "authentication md5 password";
+        case px_message_type_authentication_sasl:
+            return "authentication sasl";
+        case px_message_type_authentication_sasl_continue:
+            return "authentication sasl continue";
+        case px_message_type_authentication_sasl_final:
+            return "authentication sasl final";
+        case px_message_type_authentication_unsupported:
+            return "authentication unsupported";
         case px_message_type_backend_key_data:
             return "backend key data";
         case px_message_type_bind_complete:
@@ -455,10 +536,24 @@ static char* px_message_type_string(px_message_type type)
             return "close complete";
         case px_message_type_command_complete:
             return "command complete";
+        case px_message_type_copy_both_response:
+            return "copy both response";
+        case px_message_type_copy_data:
+            return "copy data";
+        case px_message_type_copy_done:
+            return "copy done";
+        case px_message_type_copy_in_response:
+            return "copy in response";
+        case px_message_type_copy_out_response:
+            return "copy out response";
         case px_message_type_data_row:
             return "data row";
+        case px_message_type_empty_query_response:
+            return "empty query response";
         case px_message_type_error:
             return "error";
+        case px_message_type_notification:
+            return "notification";
         case px_message_type_parameter_status:
             return "parameter status";
         case px_message_type_parse_complete:
@@ -51,6 +51,12 @@ typedef union px_response_data
         int secret_key;
     } backend_key_data;
     struct
+    {
+        int process_id;
+        char *channel;
+        char *payload;
+    } notification;
+    struct
     {
         char *severity;
         char *sqlstate;
@@ -84,9 +90,24 @@ typedef union px_response_data
         char *command_tag;
     } command_complete;
     struct
+    {
+        char *data;
+        size_t length;
+    } copy_data;
+    struct
     {
         unsigned char salt[4];
     } authentication_md5_password;
+    struct
+    {
+        // the list of mechanisms for sasl, the data of the mechanism for sasl continue and sasl final
+        char *data;
+        size_t length;
+    } authentication_sasl;
+    struct
+    {
+        int code;
+    } authentication_unsupported;
 } px_response_data;
 
 struct px_response
@@ -108,6 +129,7 @@ px_response *px_response_new(void);
 void px_response_delete(px_response *response);
 void px_response_list_delete(px_response_list *response_list);
 
+px_response *px_response_next(px_connection *restrict connection);
 px_response *px_response_read(px_connection *restrict connection);
 px_response *px_response_read_with_timeout(px_connection *restrict connection, const int timeout);
 
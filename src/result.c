@@ -6,18 +6,33 @@
 //  Copyright (c) 2012 Tamas Czinege. All rights reserved.
 //
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "result.h"
+#include "array.h"
+#include "numeric.h"
 #include "response.h"
+#include "type_cache.h"
 #include "utility.h"
 
 static const char *px_result_get_fixed_datatype_as_string(const px_datatype type) __attribute__((const));
+static bool px_result_is_binary(const px_result *restrict result, const unsigned int column) __attribute__((pure));
+static char *px_result_copy_binary_value_as_string(const px_result *restrict result, const unsigned int column, const unsigned int row);
+static bool px_result_get_binary_integer(const px_result *restrict result, const unsigned int column, const unsigned int row, int64_t *restrict value);
+static bool px_result_get_binary_float(const px_result *restrict result, const unsigned int column, const unsigned int row, double *restrict value);
+static char *px_result_copy_float_as_string(const double value, const bool is_single);
+
+// the text of a number is copied to the stack to be zero terminated for strtod, longer ones aren't parsed
+#define PX_RESULT_MAX_NUMBER_LENGTH 64
 
 px_result *px_result_new(void)
 {
-    return calloc(1, sizeof(px_result));
+    px_result *result = calloc(1, sizeof(px_result));
+    result->reference_count = 1;
+    
+    return result;
 }
 
 void px_result_delete(px_result *result)
@@ -32,7 +47,7 @@ void px_result_delete(px_result *result)
         }
         free(result->headers.values);
     }
-       
+    
     if (result->rows.capacity > 0)
     {       
         for (unsigned int i = 0; i < result->rows.count; i++)
@@ -52,9 +67,30 @@ void px_result_delete(px_result *result)
         free(result->command_tag);
     }
     
+    px_type_cache_release(result->type_cache);
     free(result);
 }
 
+px_result *px_result_retain(px_result *result)
+{
+    __sync_add_and_fetch(&result->reference_count, 1);
+    
+    return result;
+}
+
+void px_result_release(px_result *result)
+{
+    if (result == NULL || __sync_sub_and_fetch(&result->reference_count, 1) != 0)
+        return;
+    
+    px_result_delete(result);
+}
+
+px_result_list *px_result_list_new(void)
+{
+    return calloc(1, sizeof(px_result_list));
+}
+
 void px_result_list_delete(px_result_list *result_list, bool keepElements)
 {
     if (result_list == NULL) return;
@@ -69,6 +105,22 @@ void px_result_list_delete(px_result_list *result_list, bool keepElements)
     free(result_list);
 }
 
+void px_result_list_add(px_result_list *restrict result_list, px_result *result)
+{
+    if (result_list->capacity == 0)
+    {
+        result_list->capacity = 4;
+        result_list->results = malloc(result_list->capacity * sizeof(px_result*));
+    }
+    else if (result_list->count + 1 > result_list->capacity)
+    {
+        result_list->capacity *= 2;
+        result_list->results = realloc(result_list->results, result_list->capacity * sizeof(px_result*));
+    }
+    
+    result_list->results[result_list->count++] = result;
+}
+
 void px_result_add_headers(px_result *restrict result, const size_t count, const px_row_description_column *restrict headers)
 {
     result->headers.count = count;
@@ -193,6 +245,12 @@ char *px_result_copy_column_datatype_as_string(const px_result *restrict result,
             {
                 return px_copy_string(fixed_type);
             }
+            
+            const px_type *type = result->type_cache == NULL ? NULL : px_type_cache_find(result->type_cache, data_type);
+            if (type != NULL)
+            {
+                return px_copy_string(type->formatted_name);
+            }
             else
             {
                 char *str = malloc(32);
@@ -225,12 +283,12 @@ static const char *px_result_get_fixed_datatype_as_string(const px_datatype type
         case px_data_type_timestampz:              return "timestamp with time zone";
         case px_data_type_uuid:                    return "uuid";
         case px_data_type_acl:                     return "acl";
-            
+        
         case px_data_type_texta:                   return "text[]";
         case px_data_type_acla:                    return "acl[]";
         case px_data_type_oidau:                   return "oid[]";
         case px_data_type_int16au:                 return "smallint[]";
-            
+        
         default:
             return NULL;
     }
@@ -243,6 +301,9 @@ char *px_result_copy_cell_value_as_string(const px_result *restrict result, cons
         return px_copy_string("NULL");
     }
     
+    if (px_result_is_binary(result, column))
+        return px_result_copy_binary_value_as_string(result, column, row);
+    
     switch ((px_datatype)result->headers.values[column].datatype_oid)
     {
         case px_data_type_bool:
@@ -278,6 +339,14 @@ char *px_result_copy_cell_value_as_string(const px_result *restrict result, cons
             str[length] = 0;
             return str;
         }
+        case px_data_type_numeric:
+        {
+            const px_data_cell *cell = &result->rows.values[row].cells[column];
+            char *str = malloc((size_t)cell->length + 1);
+            memcpy(str, cell->data, (size_t)cell->length);
+            str[cell->length] = 0;
+            return str;
+        }
         default:
         {
             const unsigned int length = (unsigned int)result->rows.values[row].cells[column].length;
@@ -293,6 +362,259 @@ char *px_result_copy_cell_value_as_string(const px_result *restrict result, cons
     }
 }
 
+bool px_result_get_cell_value_as_decimal(const px_result *restrict result, const unsigned int column, const unsigned int row, const unsigned int scale, int64_t *restrict value)
+{
+    if (px_result_is_db_null(result, column, row))
+        return false;
+    
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    
+    if (!px_result_is_binary(result, column))
+        return px_numeric_parse_int64(cell->data, (size_t)cell->length, scale, value);
+    
+    if (result->headers.values[column].datatype_oid == px_data_type_numeric)
+        return px_numeric_decode_int64(cell->data, (size_t)cell->length, scale, value);
+    
+    // floats are rounded like their text would be
+    double number;
+    if (px_result_get_binary_float(result, column, row, &number))
+    {
+        char *text = px_result_copy_float_as_string(number, cell->length == 4);
+        const bool parsed = px_numeric_parse_int64(text, strlen(text), scale, value);
+        free(text);
+        return parsed;
+    }
+    
+    int64_t integer;
+    if (!px_result_get_binary_integer(result, column, row, &integer))
+        return false;
+    
+    for (unsigned int i = 0; i < scale; i++)
+    {
+        if (__builtin_mul_overflow(integer, 10, &integer))
+            return false;
+    }
+    
+    *value = integer;
+    return true;
+}
+
+bool px_result_get_cell_value_as_double(const px_result *restrict result, const unsigned int column, const unsigned int row, double *restrict value)
+{
+    if (px_result_is_db_null(result, column, row))
+        return false;
+    
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    
+    if (px_result_is_binary(result, column))
+    {
+        if (result->headers.values[column].datatype_oid == px_data_type_numeric)
+            return px_numeric_decode_double(cell->data, (size_t)cell->length, value);
+        
+        int64_t integer;
+        if (px_result_get_binary_float(result, column, row, value))
+            return true;
+        if (!px_result_get_binary_integer(result, column, row, &integer))
+            return false;
+        
+        *value = (double)integer;
+        return true;
+    }
+    
+    if (cell->length == 0 || cell->length >= PX_RESULT_MAX_NUMBER_LENGTH)
+        return false;
+    
+    char text[PX_RESULT_MAX_NUMBER_LENGTH];
+    memcpy(text, cell->data, (size_t)cell->length);
+    text[cell->length] = 0;
+    
+    char *end;
+    *value = strtod(text, &end);
+    return *end == 0;
+}
+
+px_array *px_result_copy_cell_value_as_array(const px_result *restrict result, const unsigned int column, const unsigned int row)
+{
+    if (px_result_is_db_null(result, column, row))
+        return NULL;
+    
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    
+    // the binary form tells the element type itself
+    if (px_result_is_binary(result, column))
+        return px_array_decode_binary(cell->data, (size_t)cell->length);
+    
+    const unsigned int array_oid = result->headers.values[column].datatype_oid;
+    if (array_oid == px_data_type_int16a || array_oid == px_data_type_oida)
+        return px_array_decode_vector(cell->data, (size_t)cell->length, array_oid == px_data_type_int16a ? px_data_type_int16 : px_data_type_oid);
+    
+    unsigned int element_oid = px_array_get_element_oid(array_oid);
+    char delimiter = ',';
+    
+    // arrays of other types have their elements as strings, split by the delimiter of their type (box uses ;)
+    const px_type *type = element_oid != 0 || result->type_cache == NULL ? NULL : px_type_cache_find(result->type_cache, array_oid);
+    if (type != NULL && type->element_oid != 0)
+    {
+        element_oid = type->element_oid;
+        
+        const px_type *element_type = px_type_cache_find(result->type_cache, element_oid);
+        if (element_type != NULL && element_type->delimiter != '\0')
+            delimiter = element_type->delimiter;
+    }
+    
+    return px_array_decode_text(cell->data, (size_t)cell->length, element_oid, delimiter);
+}
+
+static bool px_result_is_binary(const px_result *restrict result, const unsigned int column)
+{
+    return result->headers.values[column].format_code == 1;
+}
+
+static char *px_result_copy_binary_value_as_string(const px_result *restrict result, const unsigned int column, const unsigned int row)
+{
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    const unsigned char *data = (const unsigned char *)cell->data;
+    const size_t length = (size_t)cell->length;
+    char *str;
+    
+    int64_t integer;
+    double number;
+    if (px_result_get_binary_integer(result, column, row, &integer))
+    {
+        str = malloc(24);
+        sprintf(str, "%lld", (long long)integer);
+        return str;
+    }
+    
+    if (px_result_get_binary_float(result, column, row, &number))
+        return px_result_copy_float_as_string(number, length == 4);
+    
+    switch ((px_datatype)result->headers.values[column].datatype_oid)
+    {
+        case px_data_type_bool:
+            if (length != 1)
+                break;
+            return px_copy_string(data[0] != 0 ? "true" : "false");
+        case px_data_type_numeric:
+        {
+            str = px_numeric_copy_string(data, length);
+            if (str == NULL)
+                break;
+            return str;
+        }
+        case px_data_type_uuid:
+        {
+            if (length != 16)
+                break;
+            str = malloc(37);
+            char *end = str;
+            for (unsigned int i = 0; i < 16; i++)
+                end += sprintf(end, i == 4 || i == 6 || i == 8 || i == 10 ? "-%02x" : "%02x", data[i]);
+            return str;
+        }
+        case px_data_type_char:
+        case px_data_type_name:
+        case px_data_type_varcharu:
+        case px_data_type_charn:
+        case px_data_type_varcharn:
+            // strings are the same in both formats
+            str = malloc(length + 1);
+            memcpy(str, data, length);
+            str[length] = 0;
+            return str;
+        default:
+            break;
+    }
+    
+    // other types are shown as their bytes, the way bytea is
+    str = malloc(length * 2 + 3);
+    char *end = stpcpy(str, "\\x");
+    for (size_t i = 0; i < length; i++)
+        end += sprintf(end, "%02x", data[i]);
+    return str;
+}
+
+static bool px_result_get_binary_integer(const px_result *restrict result, const unsigned int column, const unsigned int row, int64_t *restrict value)
+{
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    
+    switch ((px_datatype)result->headers.values[column].datatype_oid)
+    {
+        case px_data_type_int16:
+            if (cell->length != 2)
+                return false;
+            *value = (int16_t)px_read_network_uint16(cell->data);
+            return true;
+        case px_data_type_int32:
+            if (cell->length != 4)
+                return false;
+            *value = (int32_t)px_read_network_uint32(cell->data);
+            return true;
+        case px_data_type_int64:
+            if (cell->length != 8)
+                return false;
+            *value = (int64_t)px_read_network_uint64(cell->data);
+            return true;
+        case px_data_type_oid:
+        case px_data_type_xid:
+        case px_data_type_cid:
+            if (cell->length != 4)
+                return false;
+            *value = px_read_network_uint32(cell->data);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool px_result_get_binary_float(const px_result *restrict result, const unsigned int column, const unsigned int row, double *restrict value)
+{
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    
+    switch ((px_datatype)result->headers.values[column].datatype_oid)
+    {
+        case px_data_type_single:
+        {
+            if (cell->length != 4)
+                return false;
+            const uint32_t bits = px_read_network_uint32(cell->data);
+            float single;
+            memcpy(&single, &bits, sizeof(single));
+            *value = single;
+            return true;
+        }
+        case px_data_type_double:
+        {
+            if (cell->length != 8)
+                return false;
+            const uint64_t bits = px_read_network_uint64(cell->data);
+            memcpy(value, &bits, sizeof(double));
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+static char *px_result_copy_float_as_string(const double value, const bool is_single)
+{
+    if (isnan(value))
+        return px_copy_string("NaN");
+    if (isinf(value))
+        return px_copy_string(value > 0 ? "Infinity" : "-Infinity");
+    
+    // the shortest text that reads back as the same value, as the server writes it
+    char *str = malloc(32);
+    for (int precision = 1; precision <= 17; precision++)
+    {
+        sprintf(str, "%.*g", precision, value);
+        if (is_single ? strtof(str, NULL) == (float)value : strtod(str, NULL) == value)
+            break;
+    }
+    
+    return str;
+}
+
 void px_result_parse_command_tag(px_result *restrict result, const char *restrict command_tag)
 {
     if (strncmp(command_tag, "SELECT ", 7) == 0)
@@ -10,6 +10,7 @@
 #define libpx_result_h
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include "typedef.h"
 #include "message_type.h"
@@ -38,6 +39,12 @@ struct px_result
     px_command_type command_type;
     unsigned int affected_rows;
     unsigned int row_oid;
+    
+    // results shared by a result cache are deleted when the last reference is released
+    volatile unsigned int reference_count;
+    
+    // the types of the server the result came from if its connection has one, a reference is held
+    px_type_cache *type_cache;
 };
 
 struct px_result_list
@@ -49,8 +56,12 @@ struct px_result_list
 
 px_result *px_result_new(void);
 void px_result_delete(px_result *result);
+px_result *px_result_retain(px_result *result);
+void px_result_release(px_result *result);
 
+px_result_list *px_result_list_new(void);
 void px_result_list_delete(px_result_list *result_list, bool keepElements);
+void px_result_list_add(px_result_list *restrict result_list, px_result *result);
 
 void px_result_add_headers(px_result *restrict result, const size_t count, const px_row_description_column *restrict headers);
 
@@ -72,5 +83,8 @@ unsigned int px_result_get_row_oid(const px_result *restrict result) __attribute
 
 bool px_result_is_db_null(const px_result *restrict result, const unsigned int column, const unsigned int row) __attribute__((pure));
 char *px_result_copy_cell_value_as_string(const px_result *restrict result, const unsigned int column, const unsigned int row);
+bool px_result_get_cell_value_as_decimal(const px_result *restrict result, const unsigned int column, const unsigned int row, const unsigned int scale, int64_t *restrict value);
+bool px_result_get_cell_value_as_double(const px_result *restrict result, const unsigned int column, const unsigned int row, double *restrict value);
+px_array *px_result_copy_cell_value_as_array(const px_result *restrict result, const unsigned int column, const unsigned int row);
 
 #endif
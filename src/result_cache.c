@@ -0,0 +1,488 @@
+//
+//  result_cache.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "result_cache.h"
+#include "connection.h"
+#include "error.h"
+#include "notification.h"
+#include "parameter.h"
+#include "query.h"
+#include "replication.h"
+#include "result.h"
+#include "utility.h"
+
+static char *px_result_cache_build_key(const px_query *restrict query, size_t *restrict length);
+static uint64_t px_result_cache_hash(const char *restrict key, const size_t length) __attribute__((pure));
+static px_result_cache_entry **px_result_cache_find(const px_result_cache *restrict result_cache, const char *restrict key, const size_t length, const uint64_t hash) __attribute__((pure));
+static void px_result_cache_insert(px_result_cache *restrict result_cache, px_result_cache_entry *restrict entry);
+static void px_result_cache_remove(px_result_cache *restrict result_cache, px_result_cache_entry **restrict link);
+static void px_result_cache_touch(px_result_cache *restrict result_cache, px_result_cache_entry *restrict entry);
+static void px_result_cache_grow(px_result_cache *restrict result_cache);
+static size_t px_result_cache_measure(const px_result *restrict result) __attribute__((pure));
+static bool px_result_cache_tags_overlap(const char *restrict tags, const char *restrict other_tags) __attribute__((pure));
+static bool px_result_cache_notify(px_connection *connection, const px_notification *notification, void *context);
+
+// reference data rarely changes, and when it does a notification usually evicts it long before this
+static const unsigned int px_result_cache_default_ttl = 60 * 1000;
+
+static const size_t px_result_cache_initial_capacity = 64;
+
+px_result_cache *px_result_cache_new(const size_t memory_limit)
+{
+    px_result_cache *result_cache = calloc(1, sizeof(px_result_cache));
+    pthread_mutex_init(&result_cache->mutex, NULL);
+    result_cache->capacity = px_result_cache_initial_capacity;
+    result_cache->buckets = calloc(result_cache->capacity, sizeof(px_result_cache_entry *));
+    result_cache->memory_limit = memory_limit;
+    result_cache->default_ttl = px_result_cache_default_ttl;
+    
+    return result_cache;
+}
+
+void px_result_cache_delete(px_result_cache *result_cache)
+{
+    px_result_cache_clear(result_cache);
+    
+    pthread_mutex_destroy(&result_cache->mutex);
+    free(result_cache->buckets);
+    free(result_cache->channel);
+    free(result_cache);
+}
+
+px_result *px_result_cache_execute(px_result_cache *restrict result_cache, const px_query *restrict query, const unsigned int ttl, const char *restrict tags)
+{
+    size_t key_length;
+    char *key = px_result_cache_build_key(query, &key_length);
+    const uint64_t hash = px_result_cache_hash(key, key_length);
+    
+    pthread_mutex_lock(&result_cache->mutex);
+    
+    px_result_cache_entry **link = px_result_cache_find(result_cache, key, key_length, hash);
+    if (*link != NULL)
+    {
+        if ((*link)->expires > px_get_monotonic_time())
+        {
+            px_result_cache_entry *entry = *link;
+            px_result_cache_touch(result_cache, entry);
+            px_result *result = px_result_retain(entry->result);
+            result_cache->hit_count++;
+            
+            pthread_mutex_unlock(&result_cache->mutex);
+            free(key);
+            
+            return result;
+        }
+        
+        px_result_cache_remove(result_cache, link);
+    }
+    
+    result_cache->miss_count++;
+    const uint64_t generation = result_cache->generation;
+    
+    pthread_mutex_unlock(&result_cache->mutex);
+    
+    // the query runs without holding the lock, concurrent misses of the same key all run it
+    px_result_list *result_list = px_query_execute(query);
+    if (result_list == NULL)
+    {
+        free(key);
+        return NULL;
+    }
+    
+    if (result_list->count != 1)
+    {
+        px_result_list_delete(result_list, false);
+        px_connection_set_last_error(query->connection, px_error_new_custom("42601", "cached queries must consist of a single statement"));
+        free(key);
+        return NULL;
+    }
+    
+    px_result *result = result_list->results[0];
+    px_result_list_delete(result_list, true);
+    
+    // rows read in a transaction may include its own uncommitted changes, they are only returned
+    const size_t size = sizeof(px_result_cache_entry) + key_length + (tags == NULL ? 0 : strlen(tags) + 1) + px_result_cache_measure(result);
+    if (result->command_type != px_command_type_select || query->connection->transaction_status != px_transaction_status_idle || size > result_cache->memory_limit)
+    {
+        free(key);
+        return result;
+    }
+    
+    px_result_cache_entry *entry = calloc(1, sizeof(px_result_cache_entry));
+    entry->hash = hash;
+    entry->key = key;
+    entry->key_length = key_length;
+    entry->tags = tags == NULL ? NULL : px_copy_string(tags);
+    entry->result = px_result_retain(result);
+    entry->expires = px_get_monotonic_time() + (ttl == 0 ? result_cache->default_ttl : ttl);
+    entry->size = size;
+    
+    pthread_mutex_lock(&result_cache->mutex);
+    
+    // an invalidation since the query started may have been about what it read
+    if (result_cache->generation == generation)
+    {
+        link = px_result_cache_find(result_cache, key, key_length, hash);
+        if (*link != NULL)
+            px_result_cache_remove(result_cache, link);
+        
+        px_result_cache_insert(result_cache, entry);
+        entry = NULL;
+        
+        while (result_cache->memory_used > result_cache->memory_limit)
+            px_result_cache_remove(result_cache, px_result_cache_find(result_cache, result_cache->oldest->key, result_cache->oldest->key_length, result_cache->oldest->hash));
+    }
+    
+    pthread_mutex_unlock(&result_cache->mutex);
+    
+    if (entry != NULL)
+    {
+        px_result_release(entry->result);
+        free(entry->key);
+        free(entry->tags);
+        free(entry);
+    }
+    
+    return result;
+}
+
+bool px_result_cache_listen(px_result_cache *restrict result_cache, px_connection *restrict connection, const char *restrict channel)
+{
+    char *command_text = malloc(strlen(channel) * 2 + 16);
+    char *end = stpcpy(command_text, "LISTEN ");
+    px_replication_append_quoted(end, channel, '"');
+    
+    px_query *query = px_query_new(command_text, connection);
+    px_result_list *result_list = px_query_execute(query);
+    px_query_delete(query);
+    free(command_text);
+    
+    if (result_list == NULL)
+        return false;
+    
+    px_result_list_delete(result_list, false);
+    
+    pthread_mutex_lock(&result_cache->mutex);
+    free(result_cache->channel);
+    result_cache->channel = px_copy_string(channel);
+    pthread_mutex_unlock(&result_cache->mutex);
+    
+    px_connection_set_notification_callback(connection, px_result_cache_notify, result_cache);
+    
+    return true;
+}
+
+void px_result_cache_invalidate(px_result_cache *restrict result_cache, const char *restrict tags)
+{
+    pthread_mutex_lock(&result_cache->mutex);
+    
+    result_cache->generation++;
+    
+    // invalidations are rare compared to lookups, so the tags aren't indexed
+    for (size_t i = 0; i < result_cache->capacity; i++)
+    {
+        px_result_cache_entry **link = &result_cache->buckets[i];
+        while (*link != NULL)
+        {
+            if ((*link)->tags != NULL && px_result_cache_tags_overlap((*link)->tags, tags))
+                px_result_cache_remove(result_cache, link);
+            else
+                link = &(*link)->next;
+        }
+    }
+    
+    pthread_mutex_unlock(&result_cache->mutex);
+}
+
+void px_result_cache_clear(px_result_cache *restrict result_cache)
+{
+    pthread_mutex_lock(&result_cache->mutex);
+    
+    result_cache->generation++;
+    
+    for (size_t i = 0; i < result_cache->capacity; i++)
+    {
+        while (result_cache->buckets[i] != NULL)
+            px_result_cache_remove(result_cache, &result_cache->buckets[i]);
+    }
+    
+    pthread_mutex_unlock(&result_cache->mutex);
+}
+
+unsigned int px_result_cache_get_default_ttl(px_result_cache *restrict result_cache)
+{
+    return result_cache->default_ttl;
+}
+
+void px_result_cache_set_default_ttl(px_result_cache *restrict result_cache, const unsigned int value)
+{
+    result_cache->default_ttl = value;
+}
+
+size_t px_result_cache_get_memory_used(px_result_cache *restrict result_cache)
+{
+    pthread_mutex_lock(&result_cache->mutex);
+    const size_t memory_used = result_cache->memory_used;
+    pthread_mutex_unlock(&result_cache->mutex);
+    
+    return memory_used;
+}
+
+size_t px_result_cache_get_count(px_result_cache *restrict result_cache)
+{
+    pthread_mutex_lock(&result_cache->mutex);
+    const size_t count = result_cache->count;
+    pthread_mutex_unlock(&result_cache->mutex);
+    
+    return count;
+}
+
+uint64_t px_result_cache_get_hit_count(px_result_cache *restrict result_cache)
+{
+    pthread_mutex_lock(&result_cache->mutex);
+    const uint64_t hit_count = result_cache->hit_count;
+    pthread_mutex_unlock(&result_cache->mutex);
+    
+    return hit_count;
+}
+
+uint64_t px_result_cache_get_miss_count(px_result_cache *restrict result_cache)
+{
+    pthread_mutex_lock(&result_cache->mutex);
+    const uint64_t miss_count = result_cache->miss_count;
+    pthread_mutex_unlock(&result_cache->mutex);
+    
+    return miss_count;
+}
+
+// the command text with its terminating zero, then the type, the length and the value of every parameter
+static char *px_result_cache_build_key(const px_query *restrict query, size_t *restrict length)
+{
+    // the same query gives results of another format with binary results
+    const size_t command_text_length = strlen(query->command_text) + 1;
+    size_t key_length = command_text_length + 1;
+    for (unsigned int i = 0; i < query->parameters.count; i++)
+    {
+        const px_parameter *parameter = &query->parameters.values[i];
+        key_length += sizeof(parameter->type) + sizeof(parameter->length) + (parameter->length > 0 ? (size_t)parameter->length : 0);
+    }
+    
+    char *key = malloc(key_length);
+    char *end = key;
+    memcpy(end, query->command_text, command_text_length);
+    end += command_text_length;
+    *end++ = query->binary_results ? 'b' : 't';
+    
+    for (unsigned int i = 0; i < query->parameters.count; i++)
+    {
+        const px_parameter *parameter = &query->parameters.values[i];
+        memcpy(end, &parameter->type, sizeof(parameter->type));
+        end += sizeof(parameter->type);
+        memcpy(end, &parameter->length, sizeof(parameter->length));
+        end += sizeof(parameter->length);
+        
+        if (parameter->length > 0)
+        {
+            memcpy(end, parameter->value, (size_t)parameter->length);
+            end += parameter->length;
+        }
+    }
+    
+    *length = key_length;
+    return key;
+}
+
+static uint64_t px_result_cache_hash(const char *restrict key, const size_t length)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ull;
+    }
+    
+    return hash;
+}
+
+// returns the link to the entry of the key, or the link at the end of its bucket
+static px_result_cache_entry **px_result_cache_find(const px_result_cache *restrict result_cache, const char *restrict key, const size_t length, const uint64_t hash)
+{
+    px_result_cache_entry **link = &result_cache->buckets[hash & (result_cache->capacity - 1)];
+    while (*link != NULL && ((*link)->hash != hash || (*link)->key_length != length || memcmp((*link)->key, key, length) != 0))
+        link = &(*link)->next;
+    
+    return link;
+}
+
+static void px_result_cache_insert(px_result_cache *restrict result_cache, px_result_cache_entry *restrict entry)
+{
+    if (result_cache->count >= result_cache->capacity)
+        px_result_cache_grow(result_cache);
+    
+    px_result_cache_entry **bucket = &result_cache->buckets[entry->hash & (result_cache->capacity - 1)];
+    entry->next = *bucket;
+    *bucket = entry;
+    
+    entry->older = result_cache->newest;
+    if (result_cache->newest != NULL)
+        result_cache->newest->newer = entry;
+    else
+        result_cache->oldest = entry;
+    
+    result_cache->newest = entry;
+    
+    result_cache->count++;
+    result_cache->memory_used += entry->size;
+}
+
+static void px_result_cache_remove(px_result_cache *restrict result_cache, px_result_cache_entry **restrict link)
+{
+    px_result_cache_entry *entry = *link;
+    *link = entry->next;
+    
+    if (entry->newer != NULL)
+        entry->newer->older = entry->older;
+    else
+        result_cache->newest = entry->older;
+    
+    if (entry->older != NULL)
+        entry->older->newer = entry->newer;
+    else
+        result_cache->oldest = entry->newer;
+    
+    result_cache->count--;
+    result_cache->memory_used -= entry->size;
+    
+    // users of the result keep it alive
+    px_result_release(entry->result);
+    free(entry->key);
+    free(entry->tags);
+    free(entry);
+}
+
+static void px_result_cache_touch(px_result_cache *restrict result_cache, px_result_cache_entry *restrict entry)
+{
+    if (entry == result_cache->newest)
+        return;
+    
+    // unlinked from its place, it has a newer entry
+    entry->newer->older = entry->older;
+    if (entry->older != NULL)
+        entry->older->newer = entry->newer;
+    else
+        result_cache->oldest = entry->newer;
+    
+    entry->newer = NULL;
+    entry->older = result_cache->newest;
+    result_cache->newest->newer = entry;
+    result_cache->newest = entry;
+}
+
+static void px_result_cache_grow(px_result_cache *restrict result_cache)
+{
+    const size_t old_capacity = result_cache->capacity;
+    px_result_cache_entry **old_buckets = result_cache->buckets;
+    
+    result_cache->capacity = old_capacity * 2;
+    result_cache->buckets = calloc(result_cache->capacity, sizeof(px_result_cache_entry *));
+    
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        px_result_cache_entry *entry = old_buckets[i];
+        while (entry != NULL)
+        {
+            px_result_cache_entry *next = entry->next;
+            px_result_cache_entry **bucket = &result_cache->buckets[entry->hash & (result_cache->capacity - 1)];
+            entry->next = *bucket;
+            *bucket = entry;
+            entry = next;
+        }
+    }
+    
+    free(old_buckets);
+}
+
+// the memory a result takes up, allocator overhead aside
+static size_t px_result_cache_measure(const px_result *restrict result)
+{
+    size_t size = sizeof(px_result) + result->headers.count * sizeof(px_row_description_column) + result->rows.capacity * sizeof(px_data_row);
+    
+    for (size_t i = 0; i < result->headers.count; i++)
+        size += strlen(result->headers.values[i].field_name) + 1;
+    
+    for (size_t i = 0; i < result->rows.count; i++)
+    {
+        const px_data_row *row = &result->rows.values[i];
+        size += row->cellCount * sizeof(px_data_cell);
+        
+        for (size_t j = 0; j < row->cellCount; j++)
+        {
+            if (row->cells[j].length > 0)
+                size += (size_t)row->cells[j].length;
+        }
+    }
+    
+    if (result->command_tag != NULL)
+        size += strlen(result->command_tag) + 1;
+    
+    return size;
+}
+
+// whether two lists of tags separated by commas have a tag in common
+static bool px_result_cache_tags_overlap(const char *restrict tags, const char *restrict other_tags)
+{
+    const char *tag = tags;
+    while (true)
+    {
+        const char *tag_end = strchr(tag, ',');
+        const size_t tag_length = tag_end == NULL ? strlen(tag) : (size_t)(tag_end - tag);
+        
+        const char *other_tag = other_tags;
+        while (true)
+        {
+            const char *other_tag_end = strchr(other_tag, ',');
+            const size_t other_tag_length = other_tag_end == NULL ? strlen(other_tag) : (size_t)(other_tag_end - other_tag);
+            
+            if (tag_length == other_tag_length && memcmp(tag, other_tag, tag_length) == 0)
+                return true;
+            
+            if (other_tag_end == NULL)
+                break;
+            
+            other_tag = other_tag_end + 1;
+        }
+        
+        if (tag_end == NULL)
+            return false;
+        
+        tag = tag_end + 1;
+    }
+}
+
+static bool px_result_cache_notify(px_connection *connection __attribute__((unused)), const px_notification *notification, void *context)
+{
+    // px_result_cache_listen may be changing the channel on another connection
+    px_result_cache *result_cache = context;
+    pthread_mutex_lock(&result_cache->mutex);
+    const bool is_ours = result_cache->channel != NULL && strcmp(notification->channel, result_cache->channel) == 0;
+    pthread_mutex_unlock(&result_cache->mutex);
+    
+    if (!is_ours)
+        return true;
+    
+    // a notification without a payload is about everything
+    if (*notification->payload == '\0')
+        px_result_cache_clear(result_cache);
+    else
+        px_result_cache_invalidate(result_cache, notification->payload);
+    
+    return false;
+}
@@ -0,0 +1,88 @@
+//
+//  result_cache.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_result_cache_h
+#define libpx_result_cache_h
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "typedef.h"
+
+// a cached result, keyed by the command text and the parameters of its query
+typedef struct px_result_cache_entry
+{
+    // the next entry of the same bucket
+    struct px_result_cache_entry *next;
+    
+    // the entries from the most to the least recently used
+    struct px_result_cache_entry *newer;
+    struct px_result_cache_entry *older;
+    
+    uint64_t hash;
+    char *key;
+    size_t key_length;
+    
+    // the tables the result depends on, separated by commas
+    char *tags;
+    
+    px_result *result;
+    uint64_t expires;
+    size_t size;
+} px_result_cache_entry;
+
+// results of read-only queries shared by any number of connections to the same database and threads.
+// results are immutable and reference counted, so an entry evicted while a result is in use only
+// goes away once the last user releases it
+struct px_result_cache
+{
+    pthread_mutex_t mutex;
+    
+    // a chained hash table, its capacity is a power of two
+    px_result_cache_entry **buckets;
+    size_t capacity;
+    size_t count;
+    
+    px_result_cache_entry *newest;
+    px_result_cache_entry *oldest;
+    
+    size_t memory_limit;
+    size_t memory_used;
+    unsigned int default_ttl;
+    
+    // counts invalidations, so that a result of a query that started before one isn't cached
+    uint64_t generation;
+    
+    // the channel notifications of which evict the entries tagged with their payload
+    char *channel;
+    
+    uint64_t hit_count;
+    uint64_t miss_count;
+};
+
+// create & delete
+px_result_cache *px_result_cache_new(const size_t memory_limit);
+void px_result_cache_delete(px_result_cache *result_cache);
+
+// executing queries through the cache
+px_result *px_result_cache_execute(px_result_cache *restrict result_cache, const px_query *restrict query, const unsigned int ttl, const char *restrict tags);
+
+// invalidation
+bool px_result_cache_listen(px_result_cache *restrict result_cache, px_connection *restrict connection, const char *restrict channel);
+void px_result_cache_invalidate(px_result_cache *restrict result_cache, const char *restrict tags);
+void px_result_cache_clear(px_result_cache *restrict result_cache);
+
+// getters & setters
+unsigned int px_result_cache_get_default_ttl(px_result_cache *restrict result_cache);
+void px_result_cache_set_default_ttl(px_result_cache *restrict result_cache, const unsigned int value);
+size_t px_result_cache_get_memory_used(px_result_cache *restrict result_cache);
+size_t px_result_cache_get_count(px_result_cache *restrict result_cache);
+uint64_t px_result_cache_get_hit_count(px_result_cache *restrict result_cache);
+uint64_t px_result_cache_get_miss_count(px_result_cache *restrict result_cache);
+
+#endif
@@ -0,0 +1,237 @@
+//
+//  scram.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include "scram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *px_scram_gs2_header = "n,,";
+static const char *px_scram_encoded_gs2_header = "biws";
+
+static const char *px_scram_find_attribute(const char *restrict message, const size_t length, const char name, size_t *restrict value_length);
+static void px_scram_derive_keys(const char *restrict password, const unsigned char *restrict salt, const size_t salt_length, const unsigned int iterations, px_scram_keys *restrict keys);
+
+px_scram *px_scram_new(void)
+{
+    unsigned char nonce[PX_SCRAM_NONCE_LENGTH / 4 * 3];
+    if (!px_security_random(nonce, sizeof(nonce)))
+        return NULL;
+    
+    px_scram *scram = calloc(1, sizeof(px_scram));
+    px_security_base64_encode(nonce, sizeof(nonce), scram->nonce);
+    
+    return scram;
+}
+
+void px_scram_delete(px_scram *scram)
+{
+    if (scram->auth_message != NULL)
+        free(scram->auth_message);
+    
+    free(scram);
+}
+
+char *px_scram_get_client_first_message(const px_scram *restrict scram)
+{
+    // the server takes the user from the startup message, so the user name is left empty
+    char *message = malloc(strlen(px_scram_gs2_header) + PX_SCRAM_NONCE_LENGTH + 6);
+    sprintf(message, "%sn=,r=%s", px_scram_gs2_header, scram->nonce);
+    return message;
+}
+
+char *px_scram_process_server_first_message(px_scram *restrict scram, px_scram_cache *restrict cache, const char *restrict password, const char *restrict message, const size_t length)
+{
+    size_t nonce_length;
+    size_t salt_length;
+    size_t iterations_length;
+    const char *nonce = px_scram_find_attribute(message, length, 'r', &nonce_length);
+    const char *encoded_salt = px_scram_find_attribute(message, length, 's', &salt_length);
+    const char *iterations_string = px_scram_find_attribute(message, length, 'i', &iterations_length);
+    
+    // the nonce of the server has to extend the one of the client
+    if (nonce == NULL || encoded_salt == NULL || iterations_string == NULL ||
+        nonce_length <= PX_SCRAM_NONCE_LENGTH || memcmp(nonce, scram->nonce, PX_SCRAM_NONCE_LENGTH) != 0 ||
+        px_scram_find_attribute(message, length, 'm', NULL) != NULL)
+    {
+        return NULL;
+    }
+    
+    unsigned int iterations = 0;
+    for (size_t i = 0; i < iterations_length; i++)
+    {
+        if (iterations_string[i] < '0' || iterations_string[i] > '9' || iterations > 100000000)
+            return NULL;
+        
+        iterations = iterations * 10 + (unsigned int)(iterations_string[i] - '0');
+    }
+    
+    unsigned char *salt = malloc(salt_length / 4 * 3 + 1);
+    if (iterations == 0 || !px_security_base64_decode(encoded_salt, salt_length, salt, &salt_length) || salt_length == 0)
+    {
+        free(salt);
+        return NULL;
+    }
+    
+    px_scram_keys keys;
+    px_scram_cache_get_keys(cache, password, salt, salt_length, iterations, &keys);
+    free(salt);
+    
+    // client-first-message-bare "," server-first-message "," client-final-message-without-proof
+    const size_t gs2_header_length = strlen(px_scram_gs2_header);
+    char *client_first = px_scram_get_client_first_message(scram);
+    const size_t without_proof_length = strlen(px_scram_encoded_gs2_header) + nonce_length + 5;
+    char *auth_message = malloc(strlen(client_first) - gs2_header_length + length + without_proof_length + 3);
+    char *without_proof = auth_message + sprintf(auth_message, "%s,%.*s,", client_first + gs2_header_length, (int)length, message);
+    sprintf(without_proof, "c=%s,r=%.*s", px_scram_encoded_gs2_header, (int)nonce_length, nonce);
+    free(client_first);
+    
+    if (scram->auth_message != NULL)
+        free(scram->auth_message);
+    scram->auth_message = auth_message;
+    
+    unsigned char stored_key[PX_SECURITY_SHA256_LENGTH];
+    unsigned char client_proof[PX_SECURITY_SHA256_LENGTH];
+    px_security_sha256_to_buffer(keys.client_key, sizeof(keys.client_key), stored_key);
+    px_security_hmac_sha256(stored_key, sizeof(stored_key), auth_message, strlen(auth_message), client_proof);
+    
+    for (size_t i = 0; i < sizeof(client_proof); i++)
+    {
+        client_proof[i] ^= keys.client_key[i];
+    }
+    
+    px_security_hmac_sha256(keys.server_key, sizeof(keys.server_key), auth_message, strlen(auth_message), scram->server_signature);
+    memset(&keys, 0, sizeof(keys));
+    
+    char *client_final = malloc(without_proof_length + 4 + (sizeof(client_proof) + 2) / 3 * 4 + 1);
+    char *proof = stpcpy(stpcpy(client_final, without_proof), ",p=");
+    px_security_base64_encode(client_proof, sizeof(client_proof), proof);
+    
+    return client_final;
+}
+
+bool px_scram_verify_server_final_message(const px_scram *restrict scram, const char *restrict message, const size_t length)
+{
+    size_t encoded_length;
+    const char *encoded_signature = px_scram_find_attribute(message, length, 'v', &encoded_length);
+    if (scram->auth_message == NULL || encoded_signature == NULL || encoded_length != (PX_SECURITY_SHA256_LENGTH + 2) / 3 * 4)
+        return false;
+    
+    unsigned char server_signature[PX_SECURITY_SHA256_LENGTH + 2];
+    size_t signature_length;
+    if (!px_security_base64_decode(encoded_signature, encoded_length, server_signature, &signature_length) ||
+        signature_length != PX_SECURITY_SHA256_LENGTH)
+    {
+        return false;
+    }
+    
+    // compared in constant time, the signature proves that the server knows the password as well
+    unsigned char difference = 0;
+    for (size_t i = 0; i < PX_SECURITY_SHA256_LENGTH; i++)
+    {
+        difference |= server_signature[i] ^ scram->server_signature[i];
+    }
+    
+    return difference == 0;
+}
+
+px_scram_cache *px_scram_cache_new(void)
+{
+    px_scram_cache *scram_cache = calloc(1, sizeof(px_scram_cache));
+    pthread_mutex_init(&scram_cache->mutex, NULL);
+    
+    return scram_cache;
+}
+
+void px_scram_cache_delete(px_scram_cache *scram_cache)
+{
+    px_scram_cache_clear(scram_cache);
+    pthread_mutex_destroy(&scram_cache->mutex);
+    free(scram_cache);
+}
+
+void px_scram_cache_get_keys(px_scram_cache *restrict scram_cache, const char *restrict password, const unsigned char *restrict salt, const size_t salt_length, const unsigned int iterations, px_scram_keys *restrict keys)
+{
+    if (salt_length > PX_SCRAM_MAX_SALT_LENGTH)
+    {
+        px_scram_derive_keys(password, salt, salt_length, iterations, keys);
+        return;
+    }
+    
+    // keys are derived while holding the lock, so that connections opened at the same
+    // time wait for the first one instead of all of them running PBKDF2
+    pthread_mutex_lock(&scram_cache->mutex);
+    
+    for (unsigned int i = 0; i < scram_cache->count; i++)
+    {
+        const px_scram_cache_entry *entry = &scram_cache->entries[i];
+        if (entry->iterations == iterations && entry->salt_length == salt_length && memcmp(entry->salt, salt, salt_length) == 0)
+        {
+            *keys = entry->keys;
+            pthread_mutex_unlock(&scram_cache->mutex);
+            return;
+        }
+    }
+    
+    px_scram_derive_keys(password, salt, salt_length, iterations, keys);
+    
+    // the oldest entry makes room once the cache is full
+    px_scram_cache_entry *entry = &scram_cache->entries[scram_cache->next];
+    entry->iterations = iterations;
+    entry->salt_length = salt_length;
+    memcpy(entry->salt, salt, salt_length);
+    entry->keys = *keys;
+    
+    scram_cache->next = (scram_cache->next + 1) % PX_SCRAM_CACHE_SIZE;
+    if (scram_cache->count < PX_SCRAM_CACHE_SIZE)
+        scram_cache->count++;
+    
+    pthread_mutex_unlock(&scram_cache->mutex);
+}
+
+void px_scram_cache_clear(px_scram_cache *restrict scram_cache)
+{
+    pthread_mutex_lock(&scram_cache->mutex);
+    memset(scram_cache->entries, 0, sizeof(scram_cache->entries));
+    scram_cache->count = 0;
+    scram_cache->next = 0;
+    pthread_mutex_unlock(&scram_cache->mutex);
+}
+
+static const char *px_scram_find_attribute(const char *restrict message, const size_t length, const char name, size_t *restrict value_length)
+{
+    // attributes are single letters followed by '=' and separated by commas
+    size_t start = 0;
+    while (start < length)
+    {
+        size_t end = start;
+        while (end < length && message[end] != ',')
+            end++;
+        
+        if (end - start >= 2 && message[start] == name && message[start + 1] == '=')
+        {
+            if (value_length != NULL)
+                *value_length = end - start - 2;
+            return message + start + 2;
+        }
+        
+        start = end + 1;
+    }
+    
+    return NULL;
+}
+
+static void px_scram_derive_keys(const char *restrict password, const unsigned char *restrict salt, const size_t salt_length, const unsigned int iterations, px_scram_keys *restrict keys)
+{
+    // the password is used as it is, SASLprep leaves ASCII passwords unchanged
+    unsigned char salted_password[PX_SECURITY_SHA256_LENGTH];
+    px_security_pbkdf2_sha256(password, strlen(password), salt, salt_length, iterations, salted_password);
+    px_security_hmac_sha256(salted_password, sizeof(salted_password), "Client Key", 10, keys->client_key);
+    px_security_hmac_sha256(salted_password, sizeof(salted_password), "Server Key", 10, keys->server_key);
+    memset(salted_password, 0, sizeof(salted_password));
+}
@@ -0,0 +1,70 @@
+//
+//  scram.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_scram_h
+#define libpx_scram_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "security.h"
+#include "typedef.h"
+
+#define PX_SCRAM_CACHE_SIZE 8
+#define PX_SCRAM_MAX_SALT_LENGTH 64
+#define PX_SCRAM_NONCE_LENGTH 24
+
+// keys derived from the password with PBKDF2, which is by far the most expensive part of the exchange
+typedef struct px_scram_keys
+{
+    unsigned char client_key[PX_SECURITY_SHA256_LENGTH];
+    unsigned char server_key[PX_SECURITY_SHA256_LENGTH];
+} px_scram_keys;
+
+typedef struct px_scram_cache_entry
+{
+    unsigned int iterations;
+    size_t salt_length;
+    unsigned char salt[PX_SCRAM_MAX_SALT_LENGTH];
+    px_scram_keys keys;
+} px_scram_cache_entry;
+
+// the keys of the user of the connection params per salt and iteration count, shared by all
+// connections using the same params. it has to be cleared whenever the user or the password changes
+struct px_scram_cache
+{
+    pthread_mutex_t mutex;
+    unsigned int count;
+    unsigned int next;
+    px_scram_cache_entry entries[PX_SCRAM_CACHE_SIZE];
+};
+
+// a single SCRAM-SHA-256 exchange, without channel binding
+struct px_scram
+{
+    char nonce[PX_SCRAM_NONCE_LENGTH + 1];
+    char *auth_message;
+    unsigned char server_signature[PX_SECURITY_SHA256_LENGTH];
+};
+
+// creation & deletion
+px_scram *px_scram_new(void);
+void px_scram_delete(px_scram *scram);
+
+// messages of the exchange, the client messages are terminated and have to be freed by the caller
+char *px_scram_get_client_first_message(const px_scram *restrict scram);
+char *px_scram_process_server_first_message(px_scram *restrict scram, px_scram_cache *restrict cache, const char *restrict password, const char *restrict message, const size_t length);
+bool px_scram_verify_server_final_message(const px_scram *restrict scram, const char *restrict message, const size_t length);
+
+// caching derived keys
+px_scram_cache *px_scram_cache_new(void);
+void px_scram_cache_delete(px_scram_cache *scram_cache);
+void px_scram_cache_get_keys(px_scram_cache *restrict scram_cache, const char *restrict password, const unsigned char *restrict salt, const size_t salt_length, const unsigned int iterations, px_scram_keys *restrict keys);
+void px_scram_cache_clear(px_scram_cache *restrict scram_cache);
+
+#endif
@@ -10,6 +10,10 @@
 #include <stdlib.h>
 #include "security.h"
 
+static const char px_security_base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int px_security_base64_value(const char character) __attribute__((const));
+
 unsigned char *px_security_md5(const void *data, size_t length)
 {
     unsigned char *buffer = malloc(64);
@@ -19,22 +23,85 @@ unsigned char *px_security_md5(const void *data, size_t length)
 
 void px_security_print_md5(const unsigned char *restrict md5, char *restrict str)
 {
-    sprintf(str,
-            "%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
-            (unsigned int)md5[0],
-            (unsigned int)md5[1],
-            (unsigned int)md5[2],
-            (unsigned int)md5[3],
-            (unsigned int)md5[4],
-            (unsigned int)md5[5],
-            (unsigned int)md5[6],
-            (unsigned int)md5[7],
-            (unsigned int)md5[8],
-            (unsigned int)md5[9],
-            (unsigned int)md5[10],
-            (unsigned int)md5[11],
-            (unsigned int)md5[12],
-            (unsigned int)md5[13],
-            (unsigned int)md5[14],
-            (unsigned int)md5[15]);
+    static const char digits[] = "0123456789abcdef";
+    
+    for (unsigned int i = 0; i < 16; i++)
+    {
+        str[2 * i] = digits[md5[i] >> 4];
+        str[2 * i + 1] = digits[md5[i] & 0x0f];
+    }
+    
+    str[32] = '\0';
+}
+
+size_t px_security_base64_encode(const void *restrict data, const size_t length, char *restrict str)
+{
+    const unsigned char *bytes = data;
+    size_t position = 0;
+    
+    for (size_t i = 0; i < length; i += 3)
+    {
+        const unsigned int remaining = length - i < 3 ? (unsigned int)(length - i) : 3;
+        const unsigned int group = (unsigned int)bytes[i] << 16
+            | (remaining > 1 ? (unsigned int)bytes[i + 1] << 8 : 0)
+            | (remaining > 2 ? (unsigned int)bytes[i + 2] : 0);
+        
+        str[position++] = px_security_base64_alphabet[(group >> 18) & 0x3f];
+        str[position++] = px_security_base64_alphabet[(group >> 12) & 0x3f];
+        str[position++] = remaining > 1 ? px_security_base64_alphabet[(group >> 6) & 0x3f] : '=';
+        str[position++] = remaining > 2 ? px_security_base64_alphabet[group & 0x3f] : '=';
+    }
+    
+    str[position] = '\0';
+    return position;
+}
+
+bool px_security_base64_decode(const char *restrict str, const size_t length, unsigned char *restrict buffer, size_t *restrict decoded_length)
+{
+    if (length % 4 != 0)
+        return false;
+    
+    size_t position = 0;
+    
+    for (size_t i = 0; i < length; i += 4)
+    {
+        // padding is only allowed at the very end
+        const bool last = i + 4 == length;
+        const unsigned int padding = last && str[i + 3] == '=' ? (str[i + 2] == '=' ? 2 : 1) : 0;
+        unsigned int group = 0;
+        
+        for (unsigned int j = 0; j < 4; j++)
+        {
+            const int value = j >= 4 - padding ? 0 : px_security_base64_value(str[i + j]);
+            if (value < 0)
+                return false;
+            
+            group = group << 6 | (unsigned int)value;
+        }
+        
+        buffer[position++] = (unsigned char)(group >> 16);
+        if (padding < 2)
+            buffer[position++] = (unsigned char)(group >> 8);
+        if (padding < 1)
+            buffer[position++] = (unsigned char)group;
+    }
+    
+    *decoded_length = position;
+    return true;
+}
+
+static int px_security_base64_value(const char character)
+{
+    if (character >= 'A' && character <= 'Z')
+        return character - 'A';
+    if (character >= 'a' && character <= 'z')
+        return character - 'a' + 26;
+    if (character >= '0' && character <= '9')
+        return character - '0' + 52;
+    if (character == '+')
+        return 62;
+    if (character == '/')
+        return 63;
+    
+    return -1;
 }
@@ -9,10 +9,23 @@
 #ifndef libpx_security_h
 #define libpx_security_h
 
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PX_SECURITY_SHA256_LENGTH 32
+
 unsigned char *px_security_md5(const void *data, size_t length);
 void px_security_print_md5(const unsigned char *restrict md5, char *restrict str);
 
+// base64 as used by SASL, the encoded string is always terminated
+size_t px_security_base64_encode(const void *restrict data, const size_t length, char *restrict str);
+bool px_security_base64_decode(const char *restrict str, const size_t length, unsigned char *restrict buffer, size_t *restrict decoded_length);
+
 // implementation-specific
 void px_security_md5_to_buffer(const void *data, size_t length, unsigned char *buffer);
+void px_security_sha256_to_buffer(const void *data, size_t length, unsigned char *buffer);
+void px_security_hmac_sha256(const void *key, size_t key_length, const void *data, size_t length, unsigned char *buffer);
+void px_security_pbkdf2_sha256(const char *password, size_t password_length, const void *salt, size_t salt_length, unsigned int iterations, unsigned char *buffer);
+bool px_security_random(void *buffer, size_t length);
 
 #endif
@@ -0,0 +1,546 @@
+//
+//  security_builtin.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <sys/random.h>
+#endif
+#include "security.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PX_SECURITY_HAVE_SHA_NI
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+typedef struct px_security_md5_context
+{
+    uint32_t state[4];
+    uint64_t length;
+    unsigned char buffer[64];
+} px_security_md5_context;
+
+typedef struct px_security_sha256_context
+{
+    uint32_t state[8];
+    uint64_t length;
+    unsigned char buffer[64];
+} px_security_sha256_context;
+
+typedef void px_security_sha256_compress_function(uint32_t *restrict state, const unsigned char *restrict data, size_t blocks);
+
+static const uint32_t px_security_md5_initial_state[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+static const uint32_t px_security_md5_constants[64] =
+{
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const unsigned int px_security_md5_shifts[64] =
+{
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static const uint32_t px_security_sha256_initial_state[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t px_security_sha256_constants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// picked once by the features of the processor
+static px_security_sha256_compress_function *px_security_sha256_compress;
+static pthread_once_t px_security_sha256_once = PTHREAD_ONCE_INIT;
+
+static void px_security_md5_update(px_security_md5_context *restrict context, const unsigned char *restrict data, size_t length);
+static void px_security_md5_compress(uint32_t *restrict state, const unsigned char *restrict data, size_t blocks);
+
+static void px_security_sha256_init(px_security_sha256_context *restrict context);
+static void px_security_sha256_update(px_security_sha256_context *restrict context, const unsigned char *restrict data, size_t length);
+static void px_security_sha256_final(px_security_sha256_context *restrict context, unsigned char *restrict buffer);
+static void px_security_sha256_select_compress(void);
+static void px_security_sha256_compress_generic(uint32_t *restrict state, const unsigned char *restrict data, size_t blocks);
+#ifdef PX_SECURITY_HAVE_SHA_NI
+static void px_security_sha256_compress_sha_ni(uint32_t *restrict state, const unsigned char *restrict data, size_t blocks);
+#endif
+
+static void px_security_hmac_sha256_init(px_security_sha256_context *restrict inner, px_security_sha256_context *restrict outer, const void *restrict key, size_t key_length);
+
+static inline uint32_t px_security_rotate_left(const uint32_t value, const unsigned int count)
+{
+    return (value << count) | (value >> (32 - count));
+}
+
+static inline uint32_t px_security_rotate_right(const uint32_t value, const unsigned int count)
+{
+    return (value >> count) | (value << (32 - count));
+}
+
+static inline uint32_t px_security_load_le32(const unsigned char *restrict data)
+{
+    return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static inline uint32_t px_security_load_be32(const unsigned char *restrict data)
+{
+    return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | (uint32_t)data[3];
+}
+
+static inline void px_security_store_be32(unsigned char *restrict data, const uint32_t value)
+{
+    data[0] = (unsigned char)(value >> 24);
+    data[1] = (unsigned char)(value >> 16);
+    data[2] = (unsigned char)(value >> 8);
+    data[3] = (unsigned char)value;
+}
+
+void px_security_md5_to_buffer(const void *data, size_t length, unsigned char *buffer)
+{
+    px_security_md5_context context = { .length = 0 };
+    memcpy(context.state, px_security_md5_initial_state, sizeof(context.state));
+    px_security_md5_update(&context, data, length);
+    
+    // the padding ends with the length in bits, little-endian
+    const uint64_t bit_length = context.length * 8;
+    static const unsigned char padding[64] = { 0x80 };
+    const size_t used = (size_t)(context.length % 64);
+    px_security_md5_update(&context, padding, used < 56 ? 56 - used : 120 - used);
+    
+    unsigned char length_bytes[8];
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        length_bytes[i] = (unsigned char)(bit_length >> (8 * i));
+    }
+    px_security_md5_update(&context, length_bytes, sizeof(length_bytes));
+    
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        buffer[4 * i] = (unsigned char)context.state[i];
+        buffer[4 * i + 1] = (unsigned char)(context.state[i] >> 8);
+        buffer[4 * i + 2] = (unsigned char)(context.state[i] >> 16);
+        buffer[4 * i + 3] = (unsigned char)(context.state[i] >> 24);
+    }
+}
+
+void px_security_sha256_to_buffer(const void *data, size_t length, unsigned char *buffer)
+{
+    px_security_sha256_context context;
+    px_security_sha256_init(&context);
+    px_security_sha256_update(&context, data, length);
+    px_security_sha256_final(&context, buffer);
+}
+
+void px_security_hmac_sha256(const void *key, size_t key_length, const void *data, size_t length, unsigned char *buffer)
+{
+    px_security_sha256_context inner;
+    px_security_sha256_context outer;
+    px_security_hmac_sha256_init(&inner, &outer, key, key_length);
+    
+    px_security_sha256_update(&inner, data, length);
+    px_security_sha256_final(&inner, buffer);
+    px_security_sha256_update(&outer, buffer, PX_SECURITY_SHA256_LENGTH);
+    px_security_sha256_final(&outer, buffer);
+}
+
+void px_security_pbkdf2_sha256(const char *password, size_t password_length, const void *salt, size_t salt_length, unsigned int iterations, unsigned char *buffer)
+{
+    // the states after the padded keys are the same for every iteration, so they are only computed once.
+    // every later iteration hashes a single digest, which is a single block with fixed padding
+    px_security_sha256_context inner;
+    px_security_sha256_context outer;
+    px_security_hmac_sha256_init(&inner, &outer, password, password_length);
+    
+    // U1 = HMAC(password, salt || INT(1)), the only block of output that is needed
+    static const unsigned char block_index[4] = { 0, 0, 0, 1 };
+    unsigned char digest[PX_SECURITY_SHA256_LENGTH];
+    px_security_sha256_context context = inner;
+    px_security_sha256_update(&context, salt, salt_length);
+    px_security_sha256_update(&context, block_index, sizeof(block_index));
+    px_security_sha256_final(&context, digest);
+    context = outer;
+    px_security_sha256_update(&context, digest, sizeof(digest));
+    px_security_sha256_final(&context, digest);
+    memcpy(buffer, digest, sizeof(digest));
+    
+    // a digest after the 64 bytes of the padded key is 96 bytes in total, i.e. 768 bits
+    unsigned char block[64] = { 0 };
+    block[PX_SECURITY_SHA256_LENGTH] = 0x80;
+    block[62] = 0x03;
+    
+    for (unsigned int i = 1; i < iterations; i++)
+    {
+        uint32_t state[8];
+        
+        memcpy(block, digest, sizeof(digest));
+        memcpy(state, inner.state, sizeof(state));
+        px_security_sha256_compress(state, block, 1);
+        for (unsigned int j = 0; j < 8; j++)
+            px_security_store_be32(block + 4 * j, state[j]);
+        
+        memcpy(state, outer.state, sizeof(state));
+        px_security_sha256_compress(state, block, 1);
+        for (unsigned int j = 0; j < 8; j++)
+        {
+            px_security_store_be32(digest + 4 * j, state[j]);
+        }
+        
+        for (unsigned int j = 0; j < PX_SECURITY_SHA256_LENGTH; j++)
+        {
+            buffer[j] ^= digest[j];
+        }
+    }
+    
+    memset(block, 0, sizeof(block));
+    memset(digest, 0, sizeof(digest));
+    memset(&inner, 0, sizeof(inner));
+    memset(&outer, 0, sizeof(outer));
+}
+
+bool px_security_random(void *buffer, size_t length)
+{
+    // getentropy hands out at most 256 bytes at a time
+    unsigned char *bytes = buffer;
+    while (length > 0)
+    {
+        const size_t chunk = length < 256 ? length : 256;
+        if (getentropy(bytes, chunk) != 0)
+            break;
+        
+        bytes += chunk;
+        length -= chunk;
+    }
+    
+    if (length == 0)
+        return true;
+    
+    // older kernels only have the device
+    const int file = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (file == -1)
+        return false;
+    
+    while (length > 0)
+    {
+        const ssize_t count = read(file, bytes, length);
+        if (count <= 0)
+            break;
+        
+        bytes += count;
+        length -= (size_t)count;
+    }
+    
+    close(file);
+    return length == 0;
+}
+
+static void px_security_md5_update(px_security_md5_context *restrict context, const unsigned char *restrict data, size_t length)
+{
+    size_t used = (size_t)(context->length % 64);
+    context->length += length;
+    
+    if (used > 0)
+    {
+        const size_t missing = 64 - used;
+        if (length < missing)
+        {
+            memcpy(context->buffer + used, data, length);
+            return;
+        }
+        
+        memcpy(context->buffer + used, data, missing);
+        px_security_md5_compress(context->state, context->buffer, 1);
+        data += missing;
+        length -= missing;
+    }
+    
+    // whole blocks are hashed in place
+    px_security_md5_compress(context->state, data, length / 64);
+    memcpy(context->buffer, data + length / 64 * 64, length % 64);
+}
+
+static void px_security_md5_compress(uint32_t *restrict state, const unsigned char *restrict data, size_t blocks)
+{
+    for (; blocks > 0; blocks--, data += 64)
+    {
+        uint32_t words[16];
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            words[i] = px_security_load_le32(data + 4 * i);
+        }
+        
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        
+        for (unsigned int i = 0; i < 64; i++)
+        {
+            uint32_t f;
+            unsigned int g;
+            
+            switch (i / 16)
+            {
+                case 0:
+                    f = d ^ (b & (c ^ d));
+                    g = i;
+                    break;
+                case 1:
+                    f = c ^ (d & (b ^ c));
+                    g = (5 * i + 1) % 16;
+                    break;
+                case 2:
+                    f = b ^ c ^ d;
+                    g = (3 * i + 5) % 16;
+                    break;
+                default:
+                    f = c ^ (b | ~d);
+                    g = (7 * i) % 16;
+                    break;
+            }
+            
+            const uint32_t temporary = d;
+            d = c;
+            c = b;
+            b = b + px_security_rotate_left(a + f + px_security_md5_constants[i] + words[g], px_security_md5_shifts[i]);
+            a = temporary;
+        }
+        
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+    }
+}
+
+static void px_security_sha256_init(px_security_sha256_context *restrict context)
+{
+    pthread_once(&px_security_sha256_once, px_security_sha256_select_compress);
+    
+    memcpy(context->state, px_security_sha256_initial_state, sizeof(context->state));
+    context->length = 0;
+}
+
+static void px_security_sha256_update(px_security_sha256_context *restrict context, const unsigned char *restrict data, size_t length)
+{
+    size_t used = (size_t)(context->length % 64);
+    context->length += length;
+    
+    if (used > 0)
+    {
+        const size_t missing = 64 - used;
+        if (length < missing)
+        {
+            memcpy(context->buffer + used, data, length);
+            return;
+        }
+        
+        memcpy(context->buffer + used, data, missing);
+        px_security_sha256_compress(context->state, context->buffer, 1);
+        data += missing;
+        length -= missing;
+    }
+    
+    // whole blocks are hashed in place
+    if (length >= 64)
+        px_security_sha256_compress(context->state, data, length / 64);
+    memcpy(context->buffer, data + length / 64 * 64, length % 64);
+}
+
+static void px_security_sha256_final(px_security_sha256_context *restrict context, unsigned char *restrict buffer)
+{
+    // the padding ends with the length in bits, big-endian
+    const uint64_t bit_length = context->length * 8;
+    static const unsigned char padding[64] = { 0x80 };
+    const size_t used = (size_t)(context->length % 64);
+    px_security_sha256_update(context, padding, used < 56 ? 56 - used : 120 - used);
+    
+    unsigned char length_bytes[8];
+    px_security_store_be32(length_bytes, (uint32_t)(bit_length >> 32));
+    px_security_store_be32(length_bytes + 4, (uint32_t)bit_length);
+    px_security_sha256_update(context, length_bytes, sizeof(length_bytes));
+    
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        px_security_store_be32(buffer + 4 * i, context->state[i]);
+    }
+}
+
+static void px_security_sha256_select_compress(void)
+{
+    px_security_sha256_compress = px_security_sha256_compress_generic;
+    
+#ifdef PX_SECURITY_HAVE_SHA_NI
+    // the SHA extensions need SSSE3 and SSE4.1 for shuffling the state as well
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSSE3) && (ecx & bit_SSE4_1) &&
+        __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_SHA))
+    {
+        px_security_sha256_compress = px_security_sha256_compress_sha_ni;
+    }
+#endif
+}
+
+static void px_security_sha256_compress_generic(uint32_t *restrict state, const unsigned char *restrict data, size_t blocks)
+{
+    for (; blocks > 0; blocks--, data += 64)
+    {
+        uint32_t words[64];
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            words[i] = px_security_load_be32(data + 4 * i);
+        }
+        
+        for (unsigned int i = 16; i < 64; i++)
+        {
+            const uint32_t s0 = px_security_rotate_right(words[i - 15], 7) ^ px_security_rotate_right(words[i - 15], 18) ^ (words[i - 15] >> 3);
+            const uint32_t s1 = px_security_rotate_right(words[i - 2], 17) ^ px_security_rotate_right(words[i - 2], 19) ^ (words[i - 2] >> 10);
+            words[i] = words[i - 16] + s0 + words[i - 7] + s1;
+        }
+        
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+        uint32_t f = state[5];
+        uint32_t g = state[6];
+        uint32_t h = state[7];
+        
+        for (unsigned int i = 0; i < 64; i++)
+        {
+            const uint32_t s1 = px_security_rotate_right(e, 6) ^ px_security_rotate_right(e, 11) ^ px_security_rotate_right(e, 25);
+            const uint32_t choice = (e & f) ^ (~e & g);
+            const uint32_t temporary1 = h + s1 + choice + px_security_sha256_constants[i] + words[i];
+            const uint32_t s0 = px_security_rotate_right(a, 2) ^ px_security_rotate_right(a, 13) ^ px_security_rotate_right(a, 22);
+            const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+            const uint32_t temporary2 = s0 + majority;
+            
+            h = g;
+            g = f;
+            f = e;
+            e = d + temporary1;
+            d = c;
+            c = b;
+            b = a;
+            a = temporary1 + temporary2;
+        }
+        
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#ifdef PX_SECURITY_HAVE_SHA_NI
+__attribute__((target("sha,ssse3,sse4.1")))
+static void px_security_sha256_compress_sha_ni(uint32_t *restrict state, const unsigned char *restrict data, size_t blocks)
+{
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    
+    // the instructions keep the state as ABEF and CDGH
+    __m128i temporary = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xb1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1b);
+    __m128i state0 = _mm_alignr_epi8(temporary, state1, 8);
+    state1 = _mm_blend_epi16(state1, temporary, 0xf0);
+    
+    for (; blocks > 0; blocks--, data += 64)
+    {
+        const __m128i saved0 = state0;
+        const __m128i saved1 = state1;
+        __m128i words[4];
+        
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            __m128i message;
+            if (i < 4)
+            {
+                message = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16 * i)), byte_swap);
+            }
+            else
+            {
+                // the schedule only ever needs the last four groups of words
+                message = _mm_add_epi32(_mm_sha256msg1_epu32(words[i % 4], words[(i + 1) % 4]),
+                                        _mm_alignr_epi8(words[(i + 3) % 4], words[(i + 2) % 4], 4));
+                message = _mm_sha256msg2_epu32(message, words[(i + 3) % 4]);
+            }
+            words[i % 4] = message;
+            
+            __m128i rounds = _mm_add_epi32(message, _mm_loadu_si128((const __m128i *)&px_security_sha256_constants[4 * i]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, rounds);
+            rounds = _mm_shuffle_epi32(rounds, 0x0e);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, rounds);
+        }
+        
+        state0 = _mm_add_epi32(state0, saved0);
+        state1 = _mm_add_epi32(state1, saved1);
+    }
+    
+    temporary = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    state0 = _mm_blend_epi16(temporary, state1, 0xf0);
+    state1 = _mm_alignr_epi8(state1, temporary, 8);
+    
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+#endif
+
+static void px_security_hmac_sha256_init(px_security_sha256_context *restrict inner, px_security_sha256_context *restrict outer, const void *restrict key, size_t key_length)
+{
+    // keys longer than a block are hashed first
+    unsigned char padded_key[64] = { 0 };
+    if (key_length > sizeof(padded_key))
+        px_security_sha256_to_buffer(key, key_length, padded_key);
+    else
+        memcpy(padded_key, key, key_length);
+    
+    unsigned char pad[64];
+    
+    for (unsigned int i = 0; i < sizeof(pad); i++)
+        pad[i] = padded_key[i] ^ 0x36;
+    px_security_sha256_init(inner);
+    px_security_sha256_update(inner, pad, sizeof(pad));
+    
+    for (unsigned int i = 0; i < sizeof(pad); i++)
+        pad[i] = padded_key[i] ^ 0x5c;
+    px_security_sha256_init(outer);
+    px_security_sha256_update(outer, pad, sizeof(pad));
+    
+    memset(padded_key, 0, sizeof(padded_key));
+    memset(pad, 0, sizeof(pad));
+}
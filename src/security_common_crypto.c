@@ -9,9 +9,32 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <CommonCrypto/CommonDigest.h>
+#include <CommonCrypto/CommonHMAC.h>
+#include <CommonCrypto/CommonKeyDerivation.h>
+#include <CommonCrypto/CommonRandom.h>
 #include "security.h"
 
 void px_security_md5_to_buffer(const void *data, size_t length, unsigned char *buffer)
 {
     CC_MD5(data, (unsigned int)length, buffer);
 }
+
+void px_security_sha256_to_buffer(const void *data, size_t length, unsigned char *buffer)
+{
+    CC_SHA256(data, (CC_LONG)length, buffer);
+}
+
+void px_security_hmac_sha256(const void *key, size_t key_length, const void *data, size_t length, unsigned char *buffer)
+{
+    CCHmac(kCCHmacAlgSHA256, key, key_length, data, length, buffer);
+}
+
+void px_security_pbkdf2_sha256(const char *password, size_t password_length, const void *salt, size_t salt_length, unsigned int iterations, unsigned char *buffer)
+{
+    CCKeyDerivationPBKDF(kCCPBKDF2, password, password_length, salt, salt_length, kCCPRFHmacAlgSHA256, iterations, buffer, PX_SECURITY_SHA256_LENGTH);
+}
+
+bool px_security_random(void *buffer, size_t length)
+{
+    return CCRandomGenerateBytes(buffer, length) == kCCSuccess;
+}
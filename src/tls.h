@@ -0,0 +1,49 @@
+//
+//  tls.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_tls_h
+#define libpx_tls_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "typedef.h"
+
+typedef enum px_tls_result
+{
+    px_tls_result_failed = -1,
+    px_tls_result_done = 0,
+    px_tls_result_want_read = 1,
+    px_tls_result_want_write = 2,
+    px_tls_result_closed = 3
+} px_tls_result;
+
+// whether libpx has been built with a TLS implementation
+bool px_tls_is_supported(void) __attribute__((const));
+
+// the configuration of the connections using the same params and the sessions they can resume
+// per host. it is set up on first use and has to be cleared whenever the TLS settings change
+px_tls_context *px_tls_context_new(void);
+void px_tls_context_delete(px_tls_context *tls_context);
+void px_tls_context_clear(px_tls_context *restrict tls_context);
+
+// implementation-specific: tls_openssl.c when built with TLS=openssl, tls_none.c otherwise.
+// px_tls_new returns NULL with a static description of the problem in error, px_tls_get_error
+// returns NULL when errno describes the problem
+px_tls *px_tls_new(px_tls_context *restrict tls_context, const px_connection_params *restrict connection_params, const char *restrict hostname, const int socket_number, const char **restrict error);
+void px_tls_delete(px_tls *tls);
+
+px_tls_result px_tls_handshake(px_tls *restrict tls);
+px_tls_result px_tls_read(px_tls *restrict tls, void *restrict buffer, const size_t length, size_t *restrict bytes_read);
+px_tls_result px_tls_write(px_tls *restrict tls, const void *restrict buffer, const size_t length, size_t *restrict bytes_written);
+
+const char *px_tls_get_error(const px_tls *restrict tls) __attribute__((pure));
+bool px_tls_is_resumed(const px_tls *restrict tls);
+// whether the kernel decrypts the records received
+bool px_tls_is_kernel_offloaded(const px_tls *restrict tls);
+
+#endif
@@ -0,0 +1,80 @@
+//
+//  tls_none.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <stdlib.h>
+#include "tls.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+// without a TLS library connections can only fall back to plaintext, which prefer does
+struct px_tls_context
+{
+    char unused;
+};
+
+bool px_tls_is_supported(void)
+{
+    return false;
+}
+
+px_tls_context *px_tls_context_new(void)
+{
+    return calloc(1, sizeof(px_tls_context));
+}
+
+void px_tls_context_delete(px_tls_context *tls_context)
+{
+    free(tls_context);
+}
+
+void px_tls_context_clear(px_tls_context *restrict tls_context)
+{
+}
+
+px_tls *px_tls_new(px_tls_context *restrict tls_context, const px_connection_params *restrict connection_params, const char *restrict hostname, const int socket_number, const char **restrict error)
+{
+    *error = "libpx was built without TLS support";
+    return NULL;
+}
+
+void px_tls_delete(px_tls *tls)
+{
+}
+
+px_tls_result px_tls_handshake(px_tls *restrict tls)
+{
+    return px_tls_result_failed;
+}
+
+px_tls_result px_tls_read(px_tls *restrict tls, void *restrict buffer, const size_t length, size_t *restrict bytes_read)
+{
+    return px_tls_result_failed;
+}
+
+px_tls_result px_tls_write(px_tls *restrict tls, const void *restrict buffer, const size_t length, size_t *restrict bytes_written)
+{
+    return px_tls_result_failed;
+}
+
+const char *px_tls_get_error(const px_tls *restrict tls)
+{
+    return NULL;
+}
+
+bool px_tls_is_resumed(const px_tls *restrict tls)
+{
+    return false;
+}
+
+bool px_tls_is_kernel_offloaded(const px_tls *restrict tls)
+{
+    return false;
+}
+
+#pragma clang diagnostic pop
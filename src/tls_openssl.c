@@ -0,0 +1,342 @@
+//
+//  tls_openssl.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include "tls.h"
+#include "connection_params.h"
+#include "utility.h"
+
+#define PX_TLS_SESSION_CACHE_SIZE 16
+
+typedef struct px_tls_session_entry
+{
+    char *key;
+    SSL_SESSION *session;
+} px_tls_session_entry;
+
+struct px_tls_context
+{
+    pthread_mutex_t mutex;
+    SSL_CTX *ssl_context;
+
+    // the latest resumable session per host and port, the oldest one makes room once full
+    unsigned int count;
+    unsigned int next;
+    px_tls_session_entry sessions[PX_TLS_SESSION_CACHE_SIZE];
+};
+
+struct px_tls
+{
+    px_tls_context *tls_context;
+    SSL *ssl;
+    char *key;
+    const char *error;
+    bool failed;
+};
+
+static bool px_tls_context_set_up(px_tls_context *restrict tls_context, const px_connection_params *restrict connection_params, const char **restrict error);
+static int px_tls_context_add_session(SSL *ssl, SSL_SESSION *session);
+static px_tls_result px_tls_get_result(px_tls *restrict tls, const int return_value);
+static bool px_tls_is_ip_address(const char *restrict hostname) __attribute__((pure));
+
+bool px_tls_is_supported(void)
+{
+    return true;
+}
+
+px_tls_context *px_tls_context_new(void)
+{
+    px_tls_context *tls_context = calloc(1, sizeof(px_tls_context));
+    pthread_mutex_init(&tls_context->mutex, NULL);
+
+    return tls_context;
+}
+
+void px_tls_context_delete(px_tls_context *tls_context)
+{
+    px_tls_context_clear(tls_context);
+    pthread_mutex_destroy(&tls_context->mutex);
+    free(tls_context);
+}
+
+void px_tls_context_clear(px_tls_context *restrict tls_context)
+{
+    pthread_mutex_lock(&tls_context->mutex);
+
+    // connections still using the SSL_CTX hold a reference of their own
+    if (tls_context->ssl_context != NULL)
+    {
+        SSL_CTX_free(tls_context->ssl_context);
+        tls_context->ssl_context = NULL;
+    }
+
+    for (unsigned int i = 0; i < tls_context->count; i++)
+    {
+        free(tls_context->sessions[i].key);
+        SSL_SESSION_free(tls_context->sessions[i].session);
+    }
+
+    // the slots are reused as they are, they mustn't point at what has just been freed
+    memset(tls_context->sessions, 0, sizeof(tls_context->sessions));
+    tls_context->count = 0;
+    tls_context->next = 0;
+    pthread_mutex_unlock(&tls_context->mutex);
+}
+
+px_tls *px_tls_new(px_tls_context *restrict tls_context, const px_connection_params *restrict connection_params, const char *restrict hostname, const int socket_number, const char **restrict error)
+{
+    pthread_mutex_lock(&tls_context->mutex);
+
+    if (tls_context->ssl_context == NULL && !px_tls_context_set_up(tls_context, connection_params, error))
+    {
+        pthread_mutex_unlock(&tls_context->mutex);
+        return NULL;
+    }
+
+    SSL *ssl = SSL_new(tls_context->ssl_context);
+    if (ssl == NULL || SSL_set_fd(ssl, socket_number) != 1)
+    {
+        pthread_mutex_unlock(&tls_context->mutex);
+
+        if (ssl != NULL)
+            SSL_free(ssl);
+
+        *error = "could not set up the TLS session";
+        return NULL;
+    }
+
+    px_tls *tls = calloc(1, sizeof(px_tls));
+    tls->tls_context = tls_context;
+    tls->ssl = ssl;
+    tls->key = malloc(strlen(hostname) + 12);
+    sprintf(tls->key, "%s:%u", hostname, connection_params->port);
+
+    // the session the previous connection to the same server left behind saves a full handshake
+    for (unsigned int i = 0; i < tls_context->count; i++)
+    {
+        if (strcmp(tls_context->sessions[i].key, tls->key) == 0)
+        {
+            SSL_set_session(ssl, tls_context->sessions[i].session);
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&tls_context->mutex);
+
+    SSL_set_app_data(ssl, tls);
+    SSL_set_connect_state(ssl);
+
+    const bool ip_address = px_tls_is_ip_address(hostname);
+    if (!ip_address)
+        SSL_set_tlsext_host_name(ssl, hostname);
+
+    if (connection_params->ssl_mode == px_ssl_mode_verify_full)
+    {
+        const int host_set = ip_address ?
+            X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl), hostname) :
+            SSL_set1_host(ssl, hostname);
+
+        if (host_set != 1)
+        {
+            *error = "could not set up the host name verification";
+            px_tls_delete(tls);
+            return NULL;
+        }
+    }
+
+    return tls;
+}
+
+void px_tls_delete(px_tls *tls)
+{
+    // the close_notify alert is sent on a best-effort basis, the socket is about to be closed
+    if (!tls->failed && SSL_is_init_finished(tls->ssl))
+        SSL_shutdown(tls->ssl);
+
+    SSL_free(tls->ssl);
+    free(tls->key);
+    free(tls);
+}
+
+px_tls_result px_tls_handshake(px_tls *restrict tls)
+{
+    ERR_clear_error();
+    return px_tls_get_result(tls, SSL_do_handshake(tls->ssl));
+}
+
+px_tls_result px_tls_read(px_tls *restrict tls, void *restrict buffer, const size_t length, size_t *restrict bytes_read)
+{
+    ERR_clear_error();
+
+    // reading may also process post-handshake messages such as new session tickets
+    const int return_value = SSL_read_ex(tls->ssl, buffer, length, bytes_read);
+    return return_value == 1 ? px_tls_result_done : px_tls_get_result(tls, return_value);
+}
+
+px_tls_result px_tls_write(px_tls *restrict tls, const void *restrict buffer, const size_t length, size_t *restrict bytes_written)
+{
+    ERR_clear_error();
+
+    // partial writes are enabled, the rest of the buffer is sent once the socket is writable again
+    const int return_value = SSL_write_ex(tls->ssl, buffer, length, bytes_written);
+    return return_value == 1 ? px_tls_result_done : px_tls_get_result(tls, return_value);
+}
+
+const char *px_tls_get_error(const px_tls *restrict tls)
+{
+    return tls->error;
+}
+
+bool px_tls_is_resumed(const px_tls *restrict tls)
+{
+    return SSL_session_reused(tls->ssl) == 1;
+}
+
+bool px_tls_is_kernel_offloaded(const px_tls *restrict tls)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+    // receiving is what matters for result rows, OpenSSL 3.0 only offloads sending for TLS 1.3
+    return BIO_get_ktls_recv(SSL_get_rbio(tls->ssl));
+#else
+    return false;
+#endif
+}
+
+static bool px_tls_context_set_up(px_tls_context *restrict tls_context, const px_connection_params *restrict connection_params, const char **restrict error)
+{
+    SSL_CTX *ssl_context = SSL_CTX_new(TLS_client_method());
+    if (ssl_context == NULL)
+    {
+        *error = "could not set up the TLS context";
+        return false;
+    }
+
+    SSL_CTX_set_min_proto_version(ssl_context, TLS1_2_VERSION);
+    SSL_CTX_set_mode(ssl_context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+#ifdef SSL_OP_ENABLE_KTLS
+    // once the handshake is over the kernel encrypts and decrypts the records if it can, so
+    // that result rows are read without another copy through the userspace crypto
+    SSL_CTX_set_options(ssl_context, SSL_OP_ENABLE_KTLS);
+#endif
+
+    // sessions are kept in the px_tls_context instead of the SSL_CTX, keyed by host and port
+    SSL_CTX_set_session_cache_mode(ssl_context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ssl_context, px_tls_context_add_session);
+
+    if (connection_params->ssl_mode == px_ssl_mode_verify_ca || connection_params->ssl_mode == px_ssl_mode_verify_full)
+    {
+        const int loaded = connection_params->ssl_root_cert != NULL ?
+            SSL_CTX_load_verify_locations(ssl_context, connection_params->ssl_root_cert, NULL) :
+            SSL_CTX_set_default_verify_paths(ssl_context);
+
+        if (loaded != 1)
+        {
+            SSL_CTX_free(ssl_context);
+            *error = "could not load the root certificates";
+            return false;
+        }
+
+        SSL_CTX_set_verify(ssl_context, SSL_VERIFY_PEER, NULL);
+    }
+    else
+    {
+        SSL_CTX_set_verify(ssl_context, SSL_VERIFY_NONE, NULL);
+    }
+
+    tls_context->ssl_context = ssl_context;
+    return true;
+}
+
+static int px_tls_context_add_session(SSL *ssl, SSL_SESSION *session)
+{
+    px_tls *tls = SSL_get_app_data(ssl);
+    if (tls == NULL || !SSL_SESSION_is_resumable(session))
+        return 0;
+
+    px_tls_context *tls_context = tls->tls_context;
+    pthread_mutex_lock(&tls_context->mutex);
+
+    px_tls_session_entry *entry = NULL;
+    for (unsigned int i = 0; i < tls_context->count && entry == NULL; i++)
+    {
+        if (strcmp(tls_context->sessions[i].key, tls->key) == 0)
+            entry = &tls_context->sessions[i];
+    }
+
+    if (entry == NULL)
+    {
+        entry = &tls_context->sessions[tls_context->next];
+        if (tls_context->count == PX_TLS_SESSION_CACHE_SIZE)
+            free(entry->key);
+        else
+            tls_context->count++;
+
+        entry->key = px_copy_string(tls->key);
+        tls_context->next = (tls_context->next + 1) % PX_TLS_SESSION_CACHE_SIZE;
+    }
+
+    if (entry->session != NULL)
+        SSL_SESSION_free(entry->session);
+    entry->session = session;
+
+    pthread_mutex_unlock(&tls_context->mutex);
+
+    // keeping the reference of the session
+    return 1;
+}
+
+static px_tls_result px_tls_get_result(px_tls *restrict tls, const int return_value)
+{
+    switch (SSL_get_error(tls->ssl, return_value))
+    {
+        case SSL_ERROR_NONE:
+            return px_tls_result_done;
+        case SSL_ERROR_WANT_READ:
+            return px_tls_result_want_read;
+        case SSL_ERROR_WANT_WRITE:
+            return px_tls_result_want_write;
+        case SSL_ERROR_ZERO_RETURN:
+            tls->error = "the server closed the TLS session";
+            tls->failed = true;
+            return px_tls_result_closed;
+        case SSL_ERROR_SYSCALL:
+            // errno describes the problem unless the connection was closed without an alert
+            tls->error = errno == 0 ? "the server closed the connection" : NULL;
+            tls->failed = true;
+            return px_tls_result_failed;
+        default:
+        {
+            tls->failed = true;
+
+            const unsigned long error_code = ERR_peek_last_error();
+            if (ERR_GET_REASON(error_code) == SSL_R_CERTIFICATE_VERIFY_FAILED)
+                tls->error = X509_verify_cert_error_string(SSL_get_verify_result(tls->ssl));
+            else
+                tls->error = ERR_reason_error_string(error_code);
+
+            if (tls->error == NULL)
+                tls->error = "TLS error";
+            return px_tls_result_failed;
+        }
+    }
+}
+
+static bool px_tls_is_ip_address(const char *restrict hostname)
+{
+    unsigned char address[sizeof(struct in6_addr)];
+    return inet_pton(AF_INET, hostname, address) == 1 || inet_pton(AF_INET6, hostname, address) == 1;
+}
@@ -0,0 +1,375 @@
+//
+//  type_cache.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "type_cache.h"
+#include "connection.h"
+#include "error.h"
+#include "query.h"
+#include "result.h"
+#include "utility.h"
+
+static bool px_type_cache_load(px_type_cache *restrict type_cache, px_connection *restrict connection, const unsigned int *restrict oids, const unsigned int count);
+static px_type *px_type_cache_parse_type(const px_result *restrict result, const unsigned int row);
+static char *px_type_cache_copy_cell(const px_result *restrict result, const unsigned int column, const unsigned int row);
+static long px_type_cache_parse_number(const px_result *restrict result, const unsigned int column, const unsigned int row) __attribute__((pure));
+static char px_type_cache_parse_char(const px_result *restrict result, const unsigned int column, const unsigned int row) __attribute__((pure));
+static px_type_receive px_type_cache_parse_receive(const px_result *restrict result, const unsigned int column, const unsigned int row) __attribute__((pure));
+static px_type **px_type_cache_find_slot(const px_type_cache *restrict type_cache, const unsigned int oid) __attribute__((pure));
+static void px_type_cache_insert(px_type_cache *restrict type_cache, px_type *restrict type);
+static void px_type_cache_grow(px_type_cache *restrict type_cache);
+static void px_type_delete(px_type *type);
+
+// the columns are parsed by position in px_type_cache_parse_type
+static const char px_type_cache_query[] = "SELECT t.oid, t.typname, pg_catalog.format_type(t.oid, NULL), t.typlen, t.typtype, t.typcategory, "
+                                          "t.typelem, t.typarray, t.typbasetype, t.typdelim, t.typreceive FROM pg_catalog.pg_type t";
+
+// a new database has about 600 types
+static const size_t px_type_cache_initial_capacity = 2048;
+
+// types missing after the catalog has been loaded are looked up this many at a time
+#define PX_TYPE_CACHE_MAX_MISSING 64
+
+static const struct
+{
+    const char *function_name;
+    px_type_receive receive;
+} px_type_cache_receive_functions[] =
+{
+    { "boolrecv", px_type_receive_bool },
+    { "bytearecv", px_type_receive_bytea },
+    { "charrecv", px_type_receive_char },
+    { "int2recv", px_type_receive_int16 },
+    { "int4recv", px_type_receive_int32 },
+    { "int8recv", px_type_receive_int64 },
+    { "oidrecv", px_type_receive_oid },
+    { "xidrecv", px_type_receive_oid },
+    { "cidrecv", px_type_receive_oid },
+    { "regprocrecv", px_type_receive_oid },
+    { "regclassrecv", px_type_receive_oid },
+    { "regtyperecv", px_type_receive_oid },
+    { "float4recv", px_type_receive_single },
+    { "float8recv", px_type_receive_double },
+    { "numeric_recv", px_type_receive_numeric },
+    { "textrecv", px_type_receive_text },
+    { "varcharrecv", px_type_receive_text },
+    { "bpcharrecv", px_type_receive_text },
+    { "namerecv", px_type_receive_text },
+    { "unknownrecv", px_type_receive_text },
+    { "enum_recv", px_type_receive_text },
+    { "xml_recv", px_type_receive_text },
+    { "uuid_recv", px_type_receive_uuid },
+    { "date_recv", px_type_receive_date },
+    { "time_recv", px_type_receive_time },
+    { "timestamp_recv", px_type_receive_timestamp },
+    { "timestamptz_recv", px_type_receive_timestampz },
+    { "interval_recv", px_type_receive_interval },
+    { "json_recv", px_type_receive_json },
+    { "jsonb_recv", px_type_receive_jsonb },
+    { "array_recv", px_type_receive_array },
+    { "int2vectorrecv", px_type_receive_array },
+    { "oidvectorrecv", px_type_receive_array },
+    { "record_recv", px_type_receive_record },
+    { "range_recv", px_type_receive_range },
+    { "domain_recv", px_type_receive_domain }
+};
+
+px_type_cache *px_type_cache_new(void)
+{
+    px_type_cache *type_cache = calloc(1, sizeof(px_type_cache));
+    pthread_mutex_init(&type_cache->mutex, NULL);
+    type_cache->reference_count = 1;
+    type_cache->capacity = px_type_cache_initial_capacity;
+    type_cache->types = calloc(type_cache->capacity, sizeof(px_type *));
+    
+    return type_cache;
+}
+
+void px_type_cache_delete(px_type_cache *type_cache)
+{
+    px_type_cache_release(type_cache);
+}
+
+px_type_cache *px_type_cache_retain(px_type_cache *type_cache)
+{
+    if (type_cache != NULL)
+        __sync_add_and_fetch(&type_cache->reference_count, 1);
+    
+    return type_cache;
+}
+
+void px_type_cache_release(px_type_cache *type_cache)
+{
+    if (type_cache == NULL || __sync_sub_and_fetch(&type_cache->reference_count, 1) != 0)
+        return;
+    
+    for (size_t i = 0; i < type_cache->capacity; i++)
+        px_type_delete(type_cache->types[i]);
+    
+    pthread_mutex_destroy(&type_cache->mutex);
+    free(type_cache->types);
+    free(type_cache);
+}
+
+const px_type *px_type_cache_find(px_type_cache *restrict type_cache, const unsigned int oid)
+{
+    pthread_mutex_lock(&type_cache->mutex);
+    const px_type *type = *px_type_cache_find_slot(type_cache, oid);
+    pthread_mutex_unlock(&type_cache->mutex);
+    
+    return type;
+}
+
+const px_type *px_type_cache_get(px_type_cache *restrict type_cache, px_connection *restrict connection, const unsigned int oid)
+{
+    const px_type *type = px_type_cache_find(type_cache, oid);
+    if (type != NULL || oid == 0)
+        return type;
+    
+    px_type_cache_load(type_cache, connection, &oid, 1);
+    return px_type_cache_find(type_cache, oid);
+}
+
+bool px_type_cache_resolve(px_type_cache *restrict type_cache, px_connection *restrict connection, const px_result_list *restrict result_list)
+{
+    unsigned int missing[PX_TYPE_CACHE_MAX_MISSING];
+    unsigned int missing_count = 0;
+    
+    pthread_mutex_lock(&type_cache->mutex);
+    
+    for (unsigned int i = 0; i < result_list->count; i++)
+    {
+        const px_result *result = result_list->results[i];
+        for (size_t column = 0; column < result->headers.count && missing_count < PX_TYPE_CACHE_MAX_MISSING; column++)
+        {
+            const unsigned int oid = result->headers.values[column].datatype_oid;
+            if (oid == 0 || *px_type_cache_find_slot(type_cache, oid) != NULL)
+                continue;
+            
+            bool duplicate = false;
+            for (unsigned int j = 0; j < missing_count && !duplicate; j++)
+                duplicate = missing[j] == oid;
+            
+            if (!duplicate)
+                missing[missing_count++] = oid;
+        }
+    }
+    
+    pthread_mutex_unlock(&type_cache->mutex);
+    
+    return missing_count == 0 || px_type_cache_load(type_cache, connection, missing, missing_count);
+}
+
+size_t px_type_cache_get_count(px_type_cache *restrict type_cache)
+{
+    pthread_mutex_lock(&type_cache->mutex);
+    const size_t count = type_cache->count;
+    pthread_mutex_unlock(&type_cache->mutex);
+    
+    return count;
+}
+
+static bool px_type_cache_load(px_type_cache *restrict type_cache, px_connection *restrict connection, const unsigned int *restrict oids, const unsigned int count)
+{
+    // a query of the application may be in flight, and a failed transaction doesn't run any more
+    if (connection->connection_status != px_connection_status_open
+        || connection->results.busy
+        || connection->transaction_status == px_transaction_status_in_failed_transaction)
+    {
+        return false;
+    }
+    
+    pthread_mutex_lock(&type_cache->mutex);
+    const bool loaded = type_cache->loaded;
+    pthread_mutex_unlock(&type_cache->mutex);
+    
+    // the whole catalog the first time, only the missing types (created since) after that
+    char *command_text = malloc(sizeof(px_type_cache_query) + 16 + count * 11);
+    char *end = stpcpy(command_text, px_type_cache_query);
+    if (loaded)
+    {
+        end = stpcpy(end, " WHERE t.oid IN (");
+        for (unsigned int i = 0; i < count; i++)
+            end += sprintf(end, i == 0 ? "%u" : ",%u", oids[i]);
+        stpcpy(end, ")");
+    }
+    
+    // the error of the last query of the application stays its last error, whatever happens here.
+    // this doesn't go through px_query_execute, which would resolve the types of this query too
+    px_error *last_error = connection->last_error;
+    connection->last_error = NULL;
+    
+    px_query *query = px_query_new(command_text, connection);
+    free(command_text);
+    
+    px_result_list *result_list = px_result_list_new();
+    if (px_query_send(query) && px_connection_wait_for_flush(connection))
+    {
+        px_result *result;
+        while ((result = px_connection_get_next_result(connection)) != NULL)
+            px_result_list_add(result_list, result);
+    }
+    
+    px_query_delete(query);
+    
+    const bool succeeded = connection->last_error == NULL && result_list->count == 1;
+    px_connection_set_last_error(connection, last_error);
+    
+    if (succeeded)
+    {
+        const px_result *result = result_list->results[0];
+        const unsigned int row_count = (unsigned int)result->rows.count;
+        px_type **types = malloc(row_count * sizeof(px_type *));
+        
+        // parsed outside of the lock, it is only taken to insert them
+        for (unsigned int row = 0; row < row_count; row++)
+            types[row] = px_type_cache_parse_type(result, row);
+        
+        pthread_mutex_lock(&type_cache->mutex);
+        
+        for (unsigned int row = 0; row < row_count; row++)
+        {
+            // another connection may have loaded the same type in the meantime
+            if (*px_type_cache_find_slot(type_cache, types[row]->oid) == NULL)
+                px_type_cache_insert(type_cache, types[row]);
+            else
+                px_type_delete(types[row]);
+        }
+        
+        type_cache->loaded = true;
+        
+        pthread_mutex_unlock(&type_cache->mutex);
+        free(types);
+    }
+    
+    px_result_list_delete(result_list, false);
+    return succeeded;
+}
+
+static px_type *px_type_cache_parse_type(const px_result *restrict result, const unsigned int row)
+{
+    px_type *type = calloc(1, sizeof(px_type));
+    type->oid = (unsigned int)px_type_cache_parse_number(result, 0, row);
+    type->name = px_type_cache_copy_cell(result, 1, row);
+    type->formatted_name = px_type_cache_copy_cell(result, 2, row);
+    type->length = (short)px_type_cache_parse_number(result, 3, row);
+    type->kind = px_type_cache_parse_char(result, 4, row);
+    type->category = px_type_cache_parse_char(result, 5, row);
+    type->element_oid = (unsigned int)px_type_cache_parse_number(result, 6, row);
+    type->array_oid = (unsigned int)px_type_cache_parse_number(result, 7, row);
+    type->base_oid = (unsigned int)px_type_cache_parse_number(result, 8, row);
+    type->delimiter = px_type_cache_parse_char(result, 9, row);
+    type->receive = px_type_cache_parse_receive(result, 10, row);
+    
+    return type;
+}
+
+static char *px_type_cache_copy_cell(const px_result *restrict result, const unsigned int column, const unsigned int row)
+{
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    const size_t length = cell->length < 0 ? 0 : (size_t)cell->length;
+    
+    char *value = malloc(length + 1);
+    memcpy(value, cell->data, length);
+    value[length] = '\0';
+    
+    return value;
+}
+
+static long px_type_cache_parse_number(const px_result *restrict result, const unsigned int column, const unsigned int row)
+{
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    
+    char text[16];
+    const size_t length = cell->length < 0 ? 0 : ((size_t)cell->length < sizeof(text) ? (size_t)cell->length : sizeof(text) - 1);
+    memcpy(text, cell->data, length);
+    text[length] = '\0';
+    
+    return strtol(text, NULL, 10);
+}
+
+static char px_type_cache_parse_char(const px_result *restrict result, const unsigned int column, const unsigned int row)
+{
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    return cell->length > 0 ? *(const char *)cell->data : '\0';
+}
+
+static px_type_receive px_type_cache_parse_receive(const px_result *restrict result, const unsigned int column, const unsigned int row)
+{
+    const px_data_cell *cell = &result->rows.values[row].cells[column];
+    if (cell->length <= 0)
+        return px_type_receive_unknown;
+    
+    // functions that aren't on the search path are qualified with their schema
+    const char *name = cell->data;
+    size_t length = (size_t)cell->length;
+    const char *dot = memchr(name, '.', length);
+    if (dot != NULL)
+    {
+        length -= (size_t)(dot + 1 - name);
+        name = dot + 1;
+    }
+    
+    for (size_t i = 0; i < sizeof(px_type_cache_receive_functions) / sizeof(px_type_cache_receive_functions[0]); i++)
+    {
+        const char *function_name = px_type_cache_receive_functions[i].function_name;
+        if (strlen(function_name) == length && memcmp(function_name, name, length) == 0)
+            return px_type_cache_receive_functions[i].receive;
+    }
+    
+    return px_type_receive_unknown;
+}
+
+static px_type **px_type_cache_find_slot(const px_type_cache *restrict type_cache, const unsigned int oid)
+{
+    // OIDs are mostly sequential, multiplying spreads them over the whole table
+    const size_t mask = type_cache->capacity - 1;
+    size_t index = (oid * 2654435761u) & mask;
+    
+    while (type_cache->types[index] != NULL && type_cache->types[index]->oid != oid)
+        index = (index + 1) & mask;
+    
+    return &type_cache->types[index];
+}
+
+static void px_type_cache_insert(px_type_cache *restrict type_cache, px_type *restrict type)
+{
+    if ((type_cache->count + 1) * 2 > type_cache->capacity)
+        px_type_cache_grow(type_cache);
+    
+    *px_type_cache_find_slot(type_cache, type->oid) = type;
+    type_cache->count++;
+}
+
+static void px_type_cache_grow(px_type_cache *restrict type_cache)
+{
+    px_type **types = type_cache->types;
+    const size_t capacity = type_cache->capacity;
+    
+    type_cache->capacity *= 2;
+    type_cache->types = calloc(type_cache->capacity, sizeof(px_type *));
+    
+    for (size_t i = 0; i < capacity; i++)
+    {
+        if (types[i] != NULL)
+            *px_type_cache_find_slot(type_cache, types[i]->oid) = types[i];
+    }
+    
+    free(types);
+}
+
+static void px_type_delete(px_type *type)
+{
+    if (type == NULL) return;
+    
+    free(type->name);
+    free(type->formatted_name);
+    free(type);
+}
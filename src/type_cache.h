@@ -0,0 +1,108 @@
+//
+//  type_cache.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_type_cache_h
+#define libpx_type_cache_h
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "typedef.h"
+
+// how values of a type are sent in binary, told by the receive function of the type
+typedef enum px_type_receive
+{
+    px_type_receive_unknown = 0,
+    px_type_receive_bool = 1,
+    px_type_receive_bytea = 2,
+    px_type_receive_char = 3,
+    px_type_receive_int16 = 4,
+    px_type_receive_int32 = 5,
+    px_type_receive_int64 = 6,
+    px_type_receive_oid = 7,
+    px_type_receive_single = 8,
+    px_type_receive_double = 9,
+    px_type_receive_numeric = 10,
+    px_type_receive_text = 11,          // also names, enum labels and anything else sent as plain text
+    px_type_receive_uuid = 12,
+    px_type_receive_date = 13,
+    px_type_receive_time = 14,
+    px_type_receive_timestamp = 15,
+    px_type_receive_timestampz = 16,
+    px_type_receive_interval = 17,
+    px_type_receive_json = 18,
+    px_type_receive_jsonb = 19,
+    px_type_receive_array = 20,         // also int2vector and oidvector
+    px_type_receive_record = 21,
+    px_type_receive_range = 22,
+    px_type_receive_domain = 23         // sent as the base type
+} px_type_receive;
+
+// a row of pg_type. the name is the one in the catalog (_int4), the formatted name is the one
+// used in SQL (integer[]), qualified with the schema if it isn't on the search path
+struct px_type
+{
+    unsigned int oid;
+    char *name;
+    char *formatted_name;
+    
+    // typlen: -1 for varlena types, -2 for C strings
+    short length;
+    
+    // typtype (b, c, d, e, m, p or r) and typcategory
+    char kind;
+    char category;
+    
+    // the element type of arrays and the array type of elements, 0 if none
+    unsigned int element_oid;
+    unsigned int array_oid;
+    
+    // the type of domains, 0 for other types
+    unsigned int base_oid;
+    
+    // separates the elements of arrays of the type in their text form
+    char delimiter;
+    
+    px_type_receive receive;
+};
+
+// the types of a server, shared by all connections to it (e.g. those of a pool). the catalog is
+// loaded the first time a type is missing, and only the types still missing after that are looked up.
+// types are never removed, so the ones returned stay valid until the cache is deleted
+struct px_type_cache
+{
+    pthread_mutex_t mutex;
+    
+    // held by its creator, the connections using it and the results they read, which may outlive both
+    volatile unsigned int reference_count;
+    
+    // open addressing on the OID, its capacity is a power of two and at most half of it is used
+    px_type **types;
+    size_t capacity;
+    size_t count;
+    
+    bool loaded;
+};
+
+// create & delete. deleting releases the reference of the creator
+px_type_cache *px_type_cache_new(void);
+void px_type_cache_delete(px_type_cache *type_cache);
+px_type_cache *px_type_cache_retain(px_type_cache *type_cache);
+void px_type_cache_release(px_type_cache *type_cache);
+
+// looking up types, either without a round trip or querying the server through a connection if missing
+const px_type *px_type_cache_find(px_type_cache *restrict type_cache, const unsigned int oid);
+const px_type *px_type_cache_get(px_type_cache *restrict type_cache, px_connection *restrict connection, const unsigned int oid);
+
+// looking up the types of the columns of results that are missing in a single round trip
+bool px_type_cache_resolve(px_type_cache *restrict type_cache, px_connection *restrict connection, const px_result_list *restrict result_list);
+
+// getters
+size_t px_type_cache_get_count(px_type_cache *restrict type_cache);
+
+#endif
@@ -1,18 +1,41 @@
 #ifndef libpx_typedef_h
 #define libpx_typedef_h
 
+typedef struct px_address_cache px_address_cache;
+typedef struct px_address_list px_address_list;
+typedef struct px_array px_array;
+typedef struct px_base_backup px_base_backup;
+typedef struct px_buffer px_buffer;
+typedef struct px_compressor px_compressor;
 typedef struct px_connection px_connection;
 typedef struct px_connection_params px_connection_params;
 typedef struct px_data_cell px_data_cell;
 typedef struct px_data_row px_data_row;
 typedef struct px_error px_error;
 typedef struct px_message px_message;
+typedef struct px_notification px_notification;
 typedef struct px_parameter px_parameter;
+typedef struct px_pgoutput px_pgoutput;
+typedef struct px_pgoutput_message px_pgoutput_message;
+typedef struct px_pgoutput_relation px_pgoutput_relation;
+typedef struct px_pool px_pool;
 typedef struct px_query px_query;
+typedef struct px_reactor px_reactor;
+typedef struct px_reactor_entry px_reactor_entry;
+typedef struct px_replication px_replication;
+typedef struct px_replication_data px_replication_data;
 typedef struct px_response px_response;
 typedef struct px_response_list px_response_list;
 typedef struct px_result px_result;
 typedef struct px_result_list px_result_list;
+typedef struct px_result_cache px_result_cache;
 typedef struct px_row_description_column px_row_description_column;
+typedef struct px_scram px_scram;
+typedef struct px_scram_cache px_scram_cache;
+typedef struct px_tls px_tls;
+typedef struct px_tls_context px_tls_context;
+typedef struct px_type px_type;
+typedef struct px_type_cache px_type_cache;
+typedef struct px_wal_receiver px_wal_receiver;
 
 #endif /* libpx_typedef_h */
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "utility.h"
 
 char *px_copy_string(const char *restrict str)
@@ -30,6 +31,51 @@ const char *px_null_coalesce(const char *restrict str)
         return str;
 }
 
+// milliseconds elapsed since an arbitrary point, unaffected by changes to the wall clock
+uint64_t px_get_monotonic_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+// microseconds since 2000-01-01 00:00:00 UTC, the epoch of PostgreSQL timestamps
+int64_t px_get_postgres_time(void)
+{
+    static const int64_t postgres_epoch = 946684800;
+    
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    
+    return ((int64_t)now.tv_sec - postgres_epoch) * 1000000 + now.tv_nsec / 1000;
+}
+
+uint16_t px_read_network_uint16(const void *restrict bytes)
+{
+    const unsigned char *b = bytes;
+    return (uint16_t)(b[0] << 8 | b[1]);
+}
+
+uint32_t px_read_network_uint32(const void *restrict bytes)
+{
+    const unsigned char *b = bytes;
+    return (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 8 | b[3];
+}
+
+uint64_t px_read_network_uint64(const void *restrict bytes)
+{
+    const unsigned char *b = bytes;
+    return (uint64_t)px_read_network_uint32(b) << 32 | px_read_network_uint32(b + 4);
+}
+
+void px_write_network_uint64(void *restrict bytes, const uint64_t value)
+{
+    unsigned char *b = bytes;
+    for (unsigned int i = 0; i < 8; i++)
+        b[i] = (unsigned char)(value >> (56 - i * 8));
+}
+
 #define ONEMASK ((size_t)(-1) / 0xFF)
 
 #pragma clang diagnostic push
@@ -10,9 +10,18 @@
 #define libpx_utility_h
 
 #include <stdio.h>
+#include <stdint.h>
 
 char *px_copy_string(const char *restrict str);
 const char *px_null_coalesce(const char *restrict str) __attribute__((const));
 size_t px_utf8_strlen(const char *str) __attribute__((const));
+uint64_t px_get_monotonic_time(void);
+int64_t px_get_postgres_time(void);
+
+// reading and writing integers in network byte order at any alignment
+uint16_t px_read_network_uint16(const void *restrict bytes) __attribute__((pure));
+uint32_t px_read_network_uint32(const void *restrict bytes) __attribute__((pure));
+uint64_t px_read_network_uint64(const void *restrict bytes) __attribute__((pure));
+void px_write_network_uint64(void *restrict bytes, const uint64_t value);
 
 #endif
@@ -0,0 +1,632 @@
+//
+//  wal_receiver.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "wal_receiver.h"
+#include "connection.h"
+#include "error.h"
+#include "replication.h"
+#include "utility.h"
+
+static bool px_wal_receiver_begin(px_wal_receiver *restrict wal_receiver, const uint64_t start_lsn, const unsigned int timeline);
+static bool px_wal_receiver_end_of_stream(px_wal_receiver *restrict wal_receiver);
+static bool px_wal_receiver_append(px_wal_receiver *restrict wal_receiver, const px_replication_data *restrict data);
+static bool px_wal_receiver_sync_if_due(px_wal_receiver *restrict wal_receiver, const bool idle);
+static bool px_wal_receiver_write_buffer(px_wal_receiver *restrict wal_receiver);
+static bool px_wal_receiver_open_segment(px_wal_receiver *restrict wal_receiver);
+static bool px_wal_receiver_close_segment(px_wal_receiver *restrict wal_receiver, const bool complete);
+static bool px_wal_receiver_write_history(px_wal_receiver *restrict wal_receiver, const unsigned int timeline);
+static bool px_wal_receiver_find_start(px_wal_receiver *restrict wal_receiver, uint64_t *restrict start_lsn, unsigned int *restrict timeline);
+static bool px_wal_receiver_sync_directory(px_wal_receiver *restrict wal_receiver);
+static char *px_wal_receiver_copy_path(const px_wal_receiver *restrict wal_receiver, const char *restrict name, const char *restrict suffix);
+static void px_wal_receiver_fail(px_wal_receiver *restrict wal_receiver, const char *restrict action, const char *restrict path);
+
+// O_DIRECT needs the memory, the offset and the length of writes aligned to the logical block size
+static const size_t px_wal_receiver_block_size = 4096;
+
+// the server sends at most 128 kB at a time, which is collected into writes this large
+static const size_t px_wal_receiver_write_size = 1024 * 1024;
+
+// pg_receivewal reports its position as often by default
+static const unsigned int px_wal_receiver_default_sync_interval = 10000;
+
+px_wal_receiver *px_wal_receiver_new(px_connection *restrict connection, const char *restrict directory)
+{
+    px_wal_receiver *wal_receiver = calloc(1, sizeof(px_wal_receiver));
+    wal_receiver->replication = px_replication_new(connection);
+    wal_receiver->directory = px_copy_string(directory);
+    wal_receiver->segment_size = PX_WAL_SEGMENT_SIZE;
+    wal_receiver->sync_interval = px_wal_receiver_default_sync_interval;
+    wal_receiver->fd = -1;
+    
+    void *buffer;
+    if (posix_memalign(&buffer, px_wal_receiver_block_size, px_wal_receiver_write_size) != 0)
+    {
+        px_replication_delete(wal_receiver->replication);
+        free(wal_receiver->directory);
+        free(wal_receiver);
+        return NULL;
+    }
+    
+    wal_receiver->buffer = buffer;
+    
+    return wal_receiver;
+}
+
+void px_wal_receiver_delete(px_wal_receiver *wal_receiver)
+{
+    px_wal_receiver_stop(wal_receiver);
+    
+    px_replication_delete(wal_receiver->replication);
+    free(wal_receiver->directory);
+    free(wal_receiver->slot_name);
+    free(wal_receiver->buffer);
+    free(wal_receiver);
+}
+
+bool px_wal_receiver_start(px_wal_receiver *restrict wal_receiver, const char *restrict slot_name, const uint64_t start_lsn, const unsigned int timeline)
+{
+    px_replication *replication = wal_receiver->replication;
+    
+    if (px_replication_is_streaming(replication))
+    {
+        px_connection_set_last_error(replication->connection, px_error_new_custom("55000", "the WAL receiver is already streaming"));
+        return false;
+    }
+    
+    // by default the stream continues where the files in the directory end, or starts at the
+    // current position of the server for an empty directory
+    uint64_t lsn = start_lsn;
+    unsigned int start_timeline = timeline;
+    if (lsn == 0 && !px_wal_receiver_find_start(wal_receiver, &lsn, &start_timeline))
+        return false;
+    
+    if (lsn == 0 || start_timeline == 0)
+    {
+        uint64_t system_identifier, server_lsn;
+        unsigned int server_timeline;
+        if (!px_replication_identify_system(replication, &system_identifier, &server_timeline, &server_lsn))
+            return false;
+        
+        if (lsn == 0)
+            lsn = server_lsn;
+        
+        if (start_timeline == 0)
+            start_timeline = server_timeline;
+    }
+    
+    free(wal_receiver->slot_name);
+    wal_receiver->slot_name = slot_name == NULL ? NULL : px_copy_string(slot_name);
+    
+    return px_wal_receiver_begin(wal_receiver, lsn, start_timeline);
+}
+
+bool px_wal_receiver_receive(px_wal_receiver *restrict wal_receiver, const int timeout)
+{
+    px_replication *replication = wal_receiver->replication;
+    const uint64_t deadline = px_get_monotonic_time() + (uint64_t)(timeout < 0 ? 0 : timeout);
+    
+    while (true)
+    {
+        // whatever has arrived already is taken before waiting for more
+        const px_replication_data *data = px_replication_read(replication, 0);
+        if (data == NULL)
+        {
+            if (!px_replication_is_streaming(replication))
+                return px_wal_receiver_end_of_stream(wal_receiver);
+            
+            // the stream is idle, which is the time for a sync that is due
+            if (!px_wal_receiver_sync_if_due(wal_receiver, true))
+            {
+                px_replication_stop(replication);
+                return false;
+            }
+            
+            const uint64_t now = px_get_monotonic_time();
+            if (timeout >= 0 && now >= deadline)
+                return true;
+            
+            // what has been written isn't left unsynced for longer than the interval while waiting
+            int wait_time = timeout < 0 ? -1 : (int)(deadline - now);
+            if (wal_receiver->buffer_lsn + wal_receiver->buffer_length > wal_receiver->synced_lsn && wal_receiver->sync_interval > 0)
+            {
+                const int sync_time = wal_receiver->next_sync > now ? (int)(wal_receiver->next_sync - now) : 0;
+                if (wait_time < 0 || sync_time < wait_time)
+                    wait_time = sync_time;
+            }
+            
+            data = px_replication_read(replication, wait_time);
+            if (data == NULL)
+                continue;
+        }
+        
+        if (!px_wal_receiver_append(wal_receiver, data) || !px_wal_receiver_sync_if_due(wal_receiver, false))
+        {
+            // the server is told how much of the WAL is safe before it's stopped
+            px_replication_stop(replication);
+            return false;
+        }
+        
+        if (timeout >= 0 && px_get_monotonic_time() >= deadline)
+            return true;
+    }
+}
+
+bool px_wal_receiver_sync(px_wal_receiver *restrict wal_receiver)
+{
+    if (wal_receiver->fd < 0)
+        return true;
+    
+    if (!px_wal_receiver_write_buffer(wal_receiver))
+        return false;
+    
+    wal_receiver->next_sync = px_get_monotonic_time() + wal_receiver->sync_interval;
+    
+    if (wal_receiver->synced_lsn == wal_receiver->written_lsn)
+        return true;
+    
+    if (fdatasync(wal_receiver->fd) != 0)
+    {
+        char name[PX_WAL_FILE_NAME_SIZE];
+        px_wal_receiver_format_segment_name(wal_receiver->timeline, wal_receiver->segment_start, wal_receiver->segment_size, name);
+        px_wal_receiver_fail(wal_receiver, "sync", name);
+        return false;
+    }
+    
+    wal_receiver->synced_lsn = wal_receiver->written_lsn;
+    
+    // the server learns about the new position right away, which lets it recycle the WAL sooner
+    px_replication *replication = wal_receiver->replication;
+    px_replication_confirm(replication, wal_receiver->synced_lsn);
+    if (px_replication_is_streaming(replication) && !px_replication_send_status(replication, false))
+        px_connection_fail(replication->connection);
+    
+    return true;
+}
+
+bool px_wal_receiver_stop(px_wal_receiver *restrict wal_receiver)
+{
+    // the segment being written is kept as a partial one, the stream continues with it next time
+    const bool closed = px_wal_receiver_close_segment(wal_receiver, false);
+    
+    if (!px_replication_is_streaming(wal_receiver->replication))
+        return closed;
+    
+    return px_replication_stop(wal_receiver->replication) && closed;
+}
+
+px_replication *px_wal_receiver_get_replication(const px_wal_receiver *restrict wal_receiver)
+{
+    return wal_receiver->replication;
+}
+
+unsigned int px_wal_receiver_get_timeline(const px_wal_receiver *restrict wal_receiver)
+{
+    return wal_receiver->timeline;
+}
+
+uint64_t px_wal_receiver_get_written_lsn(const px_wal_receiver *restrict wal_receiver)
+{
+    return wal_receiver->written_lsn;
+}
+
+uint64_t px_wal_receiver_get_synced_lsn(const px_wal_receiver *restrict wal_receiver)
+{
+    return wal_receiver->synced_lsn;
+}
+
+uint64_t px_wal_receiver_get_segment_size(const px_wal_receiver *restrict wal_receiver)
+{
+    return wal_receiver->segment_size;
+}
+
+bool px_wal_receiver_set_segment_size(px_wal_receiver *restrict wal_receiver, const uint64_t value)
+{
+    // the server allows powers of two between 1 MB and 1 GB, and the size can't change mid-stream
+    if (value < 1024 * 1024 || value > 1024 * 1024 * 1024 || (value & (value - 1)) != 0 || wal_receiver->fd >= 0)
+        return false;
+    
+    wal_receiver->segment_size = value;
+    return true;
+}
+
+unsigned int px_wal_receiver_get_sync_interval(const px_wal_receiver *restrict wal_receiver)
+{
+    return wal_receiver->sync_interval;
+}
+
+void px_wal_receiver_set_sync_interval(px_wal_receiver *restrict wal_receiver, const unsigned int value)
+{
+    wal_receiver->sync_interval = value;
+    wal_receiver->next_sync = px_get_monotonic_time() + value;
+}
+
+bool px_wal_receiver_is_direct_io(const px_wal_receiver *restrict wal_receiver)
+{
+    return wal_receiver->direct_io;
+}
+
+void px_wal_receiver_set_direct_io(px_wal_receiver *restrict wal_receiver, const bool value)
+{
+    wal_receiver->direct_io = value;
+}
+
+void px_wal_receiver_format_segment_name(const unsigned int timeline, const uint64_t lsn, const uint64_t segment_size, char *restrict name)
+{
+    const uint64_t segments_per_id = UINT64_C(0x100000000) / segment_size;
+    const uint64_t segment_number = lsn / segment_size;
+    
+    sprintf(name, "%08X%08X%08X", timeline, (unsigned int)(segment_number / segments_per_id), (unsigned int)(segment_number % segments_per_id));
+}
+
+// starts streaming the timeline from the beginning of the segment the position is in, so that
+// every segment file is complete from its start
+static bool px_wal_receiver_begin(px_wal_receiver *restrict wal_receiver, const uint64_t start_lsn, const unsigned int timeline)
+{
+    const uint64_t segment_start = start_lsn - start_lsn % wal_receiver->segment_size;
+    
+    // restoring WAL of a later timeline needs its history
+    if (timeline > 1 && !px_wal_receiver_write_history(wal_receiver, timeline))
+        return false;
+    
+    wal_receiver->timeline = timeline;
+    wal_receiver->buffer_lsn = segment_start;
+    wal_receiver->buffer_length = 0;
+    wal_receiver->written_lsn = segment_start;
+    wal_receiver->synced_lsn = segment_start;
+    wal_receiver->next_sync = px_get_monotonic_time() + wal_receiver->sync_interval;
+    
+    return px_replication_start_physical(wal_receiver->replication, wal_receiver->slot_name, segment_start, timeline);
+}
+
+// the server ends the stream when it is stopped or when a standby is promoted. the latter is followed
+// by the next timeline, which is then streamed the same way
+static bool px_wal_receiver_end_of_stream(px_wal_receiver *restrict wal_receiver)
+{
+    // the last segment of a timeline is kept as a partial one, the next timeline has it complete
+    if (!px_wal_receiver_close_segment(wal_receiver, false))
+        return false;
+    
+    px_replication *replication = wal_receiver->replication;
+    const unsigned int next_timeline = px_replication_get_next_timeline(replication);
+    if (next_timeline == 0 || px_connection_get_status(replication->connection) != px_connection_status_open)
+        return false;
+    
+    return px_wal_receiver_begin(wal_receiver, px_replication_get_next_timeline_lsn(replication), next_timeline);
+}
+
+static bool px_wal_receiver_append(px_wal_receiver *restrict wal_receiver, const px_replication_data *restrict data)
+{
+    // the stream is contiguous, anything else would leave a hole in the segment
+    if (data->start_lsn != wal_receiver->buffer_lsn + wal_receiver->buffer_length)
+    {
+        px_connection_set_last_error(wal_receiver->replication->connection, px_error_new_custom("08P01", "the WAL received is not contiguous"));
+        return false;
+    }
+    
+    const char *source = data->data;
+    size_t remaining = data->length;
+    
+    while (remaining > 0)
+    {
+        if (wal_receiver->fd < 0 && !px_wal_receiver_open_segment(wal_receiver))
+            return false;
+        
+        // a message may span two segments
+        const uint64_t position = wal_receiver->buffer_lsn + wal_receiver->buffer_length;
+        const uint64_t segment_end = wal_receiver->segment_start + wal_receiver->segment_size;
+        
+        size_t length = px_wal_receiver_write_size - wal_receiver->buffer_length;
+        if (segment_end - position < length)
+            length = (size_t)(segment_end - position);
+        
+        if (remaining < length)
+            length = remaining;
+        
+        memcpy(wal_receiver->buffer + wal_receiver->buffer_length, source, length);
+        wal_receiver->buffer_length += length;
+        source += length;
+        remaining -= length;
+        
+        if (position + length == segment_end)
+        {
+            if (!px_wal_receiver_close_segment(wal_receiver, true))
+                return false;
+        }
+        else if (wal_receiver->buffer_length == px_wal_receiver_write_size && !px_wal_receiver_write_buffer(wal_receiver))
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+static bool px_wal_receiver_sync_if_due(px_wal_receiver *restrict wal_receiver, const bool idle)
+{
+    if (wal_receiver->buffer_lsn + wal_receiver->buffer_length == wal_receiver->synced_lsn)
+        return true;
+    
+    // without an interval everything is synced as soon as the stream goes idle
+    const bool due = wal_receiver->sync_interval == 0 ? idle : px_get_monotonic_time() >= wal_receiver->next_sync;
+    return !due || px_wal_receiver_sync(wal_receiver);
+}
+
+static bool px_wal_receiver_write_buffer(px_wal_receiver *restrict wal_receiver)
+{
+    const uint64_t end_lsn = wal_receiver->buffer_lsn + wal_receiver->buffer_length;
+    if (end_lsn == wal_receiver->written_lsn)
+        return true;
+    
+    // the rest of the last block is padding, the segment is zeros after the end of the WAL anyway
+    const size_t tail_length = wal_receiver->buffer_length % px_wal_receiver_block_size;
+    const size_t length = wal_receiver->buffer_length - tail_length + (tail_length == 0 ? 0 : px_wal_receiver_block_size);
+    memset(wal_receiver->buffer + wal_receiver->buffer_length, 0, length - wal_receiver->buffer_length);
+    
+    size_t written = 0;
+    while (written < length)
+    {
+        const ssize_t result = pwrite(wal_receiver->fd, wal_receiver->buffer + written, length - written, (off_t)(wal_receiver->buffer_lsn - wal_receiver->segment_start + written));
+        if (result < 0 && errno == EINTR)
+            continue;
+        
+        if (result <= 0)
+        {
+            char name[PX_WAL_FILE_NAME_SIZE];
+            px_wal_receiver_format_segment_name(wal_receiver->timeline, wal_receiver->segment_start, wal_receiver->segment_size, name);
+            px_wal_receiver_fail(wal_receiver, "write", name);
+            return false;
+        }
+        
+        written += (size_t)result;
+    }
+    
+    wal_receiver->written_lsn = end_lsn;
+    
+    // the partial block is written again with the rest of it
+    if (tail_length > 0)
+        memmove(wal_receiver->buffer, wal_receiver->buffer + wal_receiver->buffer_length - tail_length, tail_length);
+    
+    wal_receiver->buffer_lsn += wal_receiver->buffer_length - tail_length;
+    wal_receiver->buffer_length = tail_length;
+    
+    return true;
+}
+
+static bool px_wal_receiver_open_segment(px_wal_receiver *restrict wal_receiver)
+{
+    wal_receiver->segment_start = wal_receiver->buffer_lsn - wal_receiver->buffer_lsn % wal_receiver->segment_size;
+    
+    char name[PX_WAL_FILE_NAME_SIZE];
+    px_wal_receiver_format_segment_name(wal_receiver->timeline, wal_receiver->segment_start, wal_receiver->segment_size, name);
+    char *path = px_wal_receiver_copy_path(wal_receiver, name, ".partial");
+    
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+#ifdef O_DIRECT
+    if (wal_receiver->direct_io)
+        flags |= O_DIRECT;
+#endif
+    
+    const int fd = open(path, flags, 0600);
+    if (fd < 0)
+    {
+        px_wal_receiver_fail(wal_receiver, "open", path);
+        free(path);
+        return false;
+    }
+    
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+    if (wal_receiver->direct_io)
+        fcntl(fd, F_NOCACHE, 1);
+#endif
+    
+    // the whole segment is allocated up front, so that syncing the WAL doesn't have to sync the size
+    // of the file as it grows
+#ifdef __linux__
+    const int error = posix_fallocate(fd, 0, (off_t)wal_receiver->segment_size);
+#else
+    const int error = ftruncate(fd, (off_t)wal_receiver->segment_size) == 0 ? 0 : errno;
+#endif
+    if (error != 0)
+    {
+        errno = error;
+        px_wal_receiver_fail(wal_receiver, "allocate", path);
+        close(fd);
+        free(path);
+        return false;
+    }
+    
+    free(path);
+    wal_receiver->fd = fd;
+    
+    return px_wal_receiver_sync_directory(wal_receiver);
+}
+
+// writes and syncs what is left of the segment. a complete segment gets its final name
+static bool px_wal_receiver_close_segment(px_wal_receiver *restrict wal_receiver, const bool complete)
+{
+    if (wal_receiver->fd < 0)
+        return true;
+    
+    if (!px_wal_receiver_sync(wal_receiver))
+        return false;
+    
+    close(wal_receiver->fd);
+    wal_receiver->fd = -1;
+    
+    if (!complete)
+        return true;
+    
+    char name[PX_WAL_FILE_NAME_SIZE];
+    px_wal_receiver_format_segment_name(wal_receiver->timeline, wal_receiver->segment_start, wal_receiver->segment_size, name);
+    char *partial_path = px_wal_receiver_copy_path(wal_receiver, name, ".partial");
+    char *path = px_wal_receiver_copy_path(wal_receiver, name, "");
+    
+    const bool renamed = rename(partial_path, path) == 0;
+    if (!renamed)
+        px_wal_receiver_fail(wal_receiver, "rename", partial_path);
+    
+    free(partial_path);
+    free(path);
+    
+    return renamed && px_wal_receiver_sync_directory(wal_receiver);
+}
+
+static bool px_wal_receiver_write_history(px_wal_receiver *restrict wal_receiver, const unsigned int timeline)
+{
+    char name[PX_WAL_FILE_NAME_SIZE];
+    sprintf(name, "%08X.history", timeline);
+    
+    char *path = px_wal_receiver_copy_path(wal_receiver, name, "");
+    const bool exists = access(path, F_OK) == 0;
+    free(path);
+    
+    if (exists)
+        return true;
+    
+    char *file_name, *content;
+    size_t length;
+    if (!px_replication_fetch_timeline_history(wal_receiver->replication, timeline, &file_name, &content, &length))
+        return false;
+    
+    // written under a temporary name first, so that a history file is either complete or missing
+    char *temporary_path = px_wal_receiver_copy_path(wal_receiver, file_name, ".tmp");
+    path = px_wal_receiver_copy_path(wal_receiver, file_name, "");
+    free(file_name);
+    
+    const int fd = open(temporary_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    bool written = fd >= 0;
+    
+    size_t offset = 0;
+    while (written && offset < length)
+    {
+        const ssize_t result = write(fd, content + offset, length - offset);
+        if (result < 0 && errno == EINTR)
+            continue;
+        
+        written = result > 0;
+        offset += written ? (size_t)result : 0;
+    }
+    
+    written = written && fsync(fd) == 0;
+    if (fd >= 0)
+        close(fd);
+    
+    written = written && rename(temporary_path, path) == 0;
+    if (!written)
+    {
+        px_wal_receiver_fail(wal_receiver, "write", temporary_path);
+        unlink(temporary_path);
+    }
+    
+    free(content);
+    free(temporary_path);
+    free(path);
+    
+    return written && px_wal_receiver_sync_directory(wal_receiver);
+}
+
+// the stream continues after the last complete segment in the directory, or restarts the last
+// segment if it's partial. an empty directory leaves the start position at 0
+static bool px_wal_receiver_find_start(px_wal_receiver *restrict wal_receiver, uint64_t *restrict start_lsn, unsigned int *restrict timeline)
+{
+    DIR *directory = opendir(wal_receiver->directory);
+    if (directory == NULL)
+    {
+        px_wal_receiver_fail(wal_receiver, "open", wal_receiver->directory);
+        return false;
+    }
+    
+    const uint64_t segments_per_id = UINT64_C(0x100000000) / wal_receiver->segment_size;
+    uint64_t last_segment = 0;
+    unsigned int last_timeline = 0;
+    bool last_complete = false;
+    
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL)
+    {
+        const char *name = entry->d_name;
+        const size_t length = strlen(name);
+        const bool complete = length == 24;
+        
+        if ((!complete && (length != 32 || strcmp(name + 24, ".partial") != 0)) || strspn(name, "0123456789ABCDEF") != 24)
+            continue;
+        
+        unsigned int segment_timeline, log, segment;
+        if (sscanf(name, "%08X%08X%08X", &segment_timeline, &log, &segment) != 3 || segment >= segments_per_id)
+            continue;
+        
+        // a segment of a different size was written with a different setting
+        if (complete)
+        {
+            struct stat file_stat;
+            char *path = px_wal_receiver_copy_path(wal_receiver, name, "");
+            const bool valid = stat(path, &file_stat) == 0 && (uint64_t)file_stat.st_size == wal_receiver->segment_size;
+            free(path);
+            
+            if (!valid)
+                continue;
+        }
+        
+        const uint64_t segment_number = log * segments_per_id + segment;
+        if (last_timeline == 0 || segment_number > last_segment ||
+            (segment_number == last_segment && (segment_timeline > last_timeline || (segment_timeline == last_timeline && complete))))
+        {
+            last_segment = segment_number;
+            last_timeline = segment_timeline;
+            last_complete = complete;
+        }
+    }
+    
+    closedir(directory);
+    
+    if (last_timeline != 0)
+    {
+        *start_lsn = (last_segment + (last_complete ? 1 : 0)) * wal_receiver->segment_size;
+        *timeline = last_timeline;
+    }
+    
+    return true;
+}
+
+static bool px_wal_receiver_sync_directory(px_wal_receiver *restrict wal_receiver)
+{
+    const int fd = open(wal_receiver->directory, O_RDONLY | O_CLOEXEC);
+    const bool synced = fd >= 0 && fsync(fd) == 0;
+    
+    if (!synced)
+        px_wal_receiver_fail(wal_receiver, "sync", wal_receiver->directory);
+    
+    if (fd >= 0)
+        close(fd);
+    
+    return synced;
+}
+
+static char *px_wal_receiver_copy_path(const px_wal_receiver *restrict wal_receiver, const char *restrict name, const char *restrict suffix)
+{
+    char *path = malloc(strlen(wal_receiver->directory) + strlen(name) + strlen(suffix) + 2);
+    sprintf(path, "%s/%s%s", wal_receiver->directory, name, suffix);
+    
+    return path;
+}
+
+static void px_wal_receiver_fail(px_wal_receiver *restrict wal_receiver, const char *restrict action, const char *restrict path)
+{
+    char *message = malloc(strlen(path) + 128);
+    sprintf(message, "could not %s \"%s\": %s", action, path, strerror(errno));
+    px_connection_set_last_error(wal_receiver->replication->connection, px_error_new_custom("58030", message));
+    free(message);
+}
@@ -0,0 +1,81 @@
+//
+//  wal_receiver.h
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+#ifndef libpx_wal_receiver_h
+#define libpx_wal_receiver_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "typedef.h"
+
+// the server's default WAL segment size
+#define PX_WAL_SEGMENT_SIZE (16 * 1024 * 1024)
+
+// the longest segment or history file name including the terminating zero
+#define PX_WAL_FILE_NAME_SIZE 32
+
+// streams the WAL of a physical replication connection into segment files named and laid out the
+// way the server names them, so that they can be restored with restore_command. a segment is written
+// as a .partial file preallocated to its full size and renamed once all of it has been received
+struct px_wal_receiver
+{
+    px_replication *replication;
+    char *directory;
+    char *slot_name;
+    
+    // settings
+    uint64_t segment_size;
+    unsigned int sync_interval;
+    bool direct_io;
+    
+    unsigned int timeline;
+    
+    // the segment being written, -1 between segments
+    int fd;
+    uint64_t segment_start;
+    
+    // the WAL is collected in an aligned buffer and written to the segment in large blocks. the buffer
+    // always starts at a block boundary, a partially received block is written padded with zeros and
+    // kept in the buffer to be written again once the rest of it arrives
+    char *buffer;
+    size_t buffer_length;
+    uint64_t buffer_lsn;
+    
+    // positions written to the segment and synced to disk, the latter is reported to the server
+    uint64_t written_lsn;
+    uint64_t synced_lsn;
+    uint64_t next_sync;
+};
+
+// create & delete
+px_wal_receiver *px_wal_receiver_new(px_connection *restrict connection, const char *restrict directory);
+void px_wal_receiver_delete(px_wal_receiver *wal_receiver);
+
+// streaming
+bool px_wal_receiver_start(px_wal_receiver *restrict wal_receiver, const char *restrict slot_name, const uint64_t start_lsn, const unsigned int timeline);
+bool px_wal_receiver_receive(px_wal_receiver *restrict wal_receiver, const int timeout);
+bool px_wal_receiver_sync(px_wal_receiver *restrict wal_receiver);
+bool px_wal_receiver_stop(px_wal_receiver *restrict wal_receiver);
+
+// getters & setters
+px_replication *px_wal_receiver_get_replication(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+unsigned int px_wal_receiver_get_timeline(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+uint64_t px_wal_receiver_get_written_lsn(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+uint64_t px_wal_receiver_get_synced_lsn(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+uint64_t px_wal_receiver_get_segment_size(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+bool px_wal_receiver_set_segment_size(px_wal_receiver *restrict wal_receiver, const uint64_t value);
+unsigned int px_wal_receiver_get_sync_interval(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+void px_wal_receiver_set_sync_interval(px_wal_receiver *restrict wal_receiver, const unsigned int value);
+bool px_wal_receiver_is_direct_io(const px_wal_receiver *restrict wal_receiver) __attribute__((pure));
+void px_wal_receiver_set_direct_io(px_wal_receiver *restrict wal_receiver, const bool value);
+
+// segment file names
+void px_wal_receiver_format_segment_name(const unsigned int timeline, const uint64_t lsn, const uint64_t segment_size, char *restrict name);
+
+#endif
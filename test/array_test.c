@@ -0,0 +1,290 @@
+//
+//  array_test.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+// decodes arrays in the text, vector and binary formats, well formed and malformed ones alike.
+// it needs no server, make test builds and runs it before the tests against the server
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "px.h"
+
+#define OID_INT16 21
+#define OID_INT32 23
+#define OID_INT64 20
+#define OID_TEXT 25
+#define OID_OID 26
+
+static unsigned int failures = 0;
+
+static void check(const bool condition, const char *restrict description);
+static px_array *decode(const char *restrict text, const unsigned int element_oid);
+static bool decodes(const char *restrict text, const unsigned int element_oid);
+static size_t write_uint32(unsigned char *restrict data, const uint32_t value);
+static void test_text(void);
+static void test_bounds(void);
+static void test_vector(void);
+static void test_binary(void);
+
+int main(void)
+{
+    test_text();
+    test_bounds();
+    test_vector();
+    test_binary();
+    
+    if (failures > 0)
+    {
+        printf("%u failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+static void check(const bool condition, const char *restrict description)
+{
+    if (condition)
+        return;
+    
+    printf("%s failed\n", description);
+    failures++;
+}
+
+static px_array *decode(const char *restrict text, const unsigned int element_oid)
+{
+    return px_array_decode_text(text, strlen(text), element_oid, ',');
+}
+
+static bool decodes(const char *restrict text, const unsigned int element_oid)
+{
+    px_array *array = decode(text, element_oid);
+    if (array == NULL)
+        return false;
+    
+    px_array_delete(array);
+    return true;
+}
+
+static size_t write_uint32(unsigned char *restrict data, const uint32_t value)
+{
+    data[0] = (unsigned char)(value >> 24);
+    data[1] = (unsigned char)(value >> 16);
+    data[2] = (unsigned char)(value >> 8);
+    data[3] = (unsigned char)value;
+    return 4;
+}
+
+static void test_text(void)
+{
+    px_array *array = decode("{{1,2,3},{4,NULL,6}}", OID_INT32);
+    check(array != NULL && array->dimension_count == 2 && array->dimensions[0] == 2 && array->dimensions[1] == 3, "two dimensions");
+    if (array != NULL)
+    {
+        const int32_t *values = array->values;
+        check(array->lower_bounds[0] == 1 && array->lower_bounds[1] == 1, "default lower bounds");
+        check(array->count == 6 && array->null_count == 1 && px_array_is_null(array, 4), "NULL element");
+        check(values[0] == 1 && values[2] == 3 && values[5] == 6, "int4 elements");
+        px_array_delete(array);
+    }
+    
+    array = decode("{\"a\\\"b\",NULL,\"NULL\", c d }", OID_TEXT);
+    check(array != NULL && array->count == 4 && array->null_count == 1, "string elements");
+    if (array != NULL)
+    {
+        const char *const *values = array->values;
+        check(strcmp(values[0], "a\"b") == 0, "escaped quote");
+        check(px_array_is_null(array, 1) && !px_array_is_null(array, 2) && strcmp(values[2], "NULL") == 0, "quoted NULL is a string");
+        check(strcmp(values[3], "c d") == 0, "unquoted element keeps its inner space");
+        px_array_delete(array);
+    }
+    
+    array = decode("{}", OID_INT32);
+    check(array != NULL && array->dimension_count == 0 && array->count == 0, "empty array");
+    if (array != NULL)
+        px_array_delete(array);
+    
+    array = decode("{-9223372036854775808,9223372036854775807}", OID_INT64);
+    check(array != NULL && array->count == 2, "int8 limits");
+    if (array != NULL)
+    {
+        const int64_t *values = array->values;
+        check(values[0] == INT64_MIN && values[1] == INT64_MAX, "int8 limit values");
+        px_array_delete(array);
+    }
+    
+    check(!decodes("{9223372036854775808}", OID_INT64), "int8 overflow");
+    check(!decodes("{-9223372036854775809}", OID_INT64), "int8 underflow");
+    check(!decodes("{99999999999999999999}", OID_INT64), "int8 far overflow");
+    check(!decodes("{2147483648}", OID_INT32), "int4 overflow");
+    check(!decodes("{32768}", OID_INT16), "int2 overflow");
+    check(!decodes("{1x}", OID_INT32), "trailing garbage in an integer");
+    
+    check(!decodes("{{1,2},{3}}", OID_INT32), "ragged array");
+    check(!decodes("{{1},2}", OID_INT32), "element beside a sub-array");
+    check(!decodes("{{1}{2}}", OID_INT32), "missing delimiter between sub-arrays");
+    check(!decodes("{\"a\"b}", OID_TEXT), "missing delimiter after a quoted element");
+    check(!decodes("{a,}", OID_TEXT), "trailing delimiter");
+    check(!decodes("{,a}", OID_TEXT), "leading delimiter");
+    check(!decodes("{a,,b}", OID_TEXT), "empty element");
+    check(!decodes("{,}", OID_TEXT), "only a delimiter");
+    check(!decodes("{1,2", OID_INT32), "unterminated array");
+    check(!decodes("{1} x", OID_INT32), "trailing garbage");
+    check(!decodes("{{{{{{{1}}}}}}}", OID_INT32), "too many dimensions");
+}
+
+static void test_bounds(void)
+{
+    px_array *array = decode("[0:2]={7,8,9}", OID_INT32);
+    check(array != NULL && array->dimension_count == 1 && array->lower_bounds[0] == 0 && array->count == 3, "lower bound prefix");
+    if (array != NULL)
+    {
+        const int32_t *values = array->values;
+        check(values[0] == 7 && values[2] == 9, "elements after a lower bound prefix");
+        px_array_delete(array);
+    }
+    
+    array = decode("[-3:-2][5:5]={{1},{2}}", OID_INT32);
+    check(array != NULL && array->dimension_count == 2 && array->lower_bounds[0] == -3 && array->lower_bounds[1] == 5, "negative lower bounds");
+    if (array != NULL)
+        px_array_delete(array);
+    
+    check(decodes("[-2147483648:-2147483648]={1}", OID_INT32), "smallest lower bound");
+    check(!decodes("[0:1]={1,2,3}", OID_INT32), "bounds of fewer elements");
+    check(!decodes("[0:3]={1,2,3}", OID_INT32), "bounds of more elements");
+    check(!decodes("[0:1]={{1,2},{3,4}}", OID_INT32), "bounds of fewer dimensions");
+    check(!decodes("[2:1]={}", OID_INT32), "upper bound below the lower bound");
+    check(!decodes("[1:2147483647]={1}", OID_INT32), "bounds of too many elements");
+    check(!decodes("[-2147483648:2147483647]={1}", OID_INT32), "overflowing bounds");
+    check(!decodes("[1:99999999999]={1}", OID_INT32), "overflowing upper bound");
+    check(!decodes("[1:1]{1}", OID_INT32), "bounds without equals sign");
+    check(!decodes("[1:1={1}", OID_INT32), "unterminated bounds");
+}
+
+static void test_vector(void)
+{
+    px_array *array = px_array_decode_vector("1 2 3", 5, OID_INT16);
+    check(array != NULL && array->dimension_count == 1 && array->lower_bounds[0] == 0 && array->count == 3, "int2vector");
+    if (array != NULL)
+    {
+        const int16_t *values = array->values;
+        check(values[0] == 1 && values[1] == 2 && values[2] == 3, "int2vector elements");
+        px_array_delete(array);
+    }
+    
+    array = px_array_decode_vector("", 0, OID_INT16);
+    check(array != NULL && array->dimension_count == 0 && array->count == 0, "empty vector");
+    if (array != NULL)
+        px_array_delete(array);
+    
+    array = px_array_decode_vector("4294967295", 10, OID_OID);
+    check(array != NULL && array->count == 1 && ((const uint32_t *)array->values)[0] == 4294967295u, "largest oid");
+    if (array != NULL)
+        px_array_delete(array);
+    
+    check(px_array_decode_vector("1 x", 3, OID_INT16) == NULL, "malformed vector element");
+    check(px_array_decode_vector("40000", 5, OID_INT16) == NULL, "int2vector overflow");
+    check(px_array_decode_vector("4294967296", 10, OID_OID) == NULL, "oidvector overflow");
+    check(px_array_decode_vector("{1,2}", 5, OID_INT16) == NULL, "array text as a vector");
+}
+
+static void test_binary(void)
+{
+    unsigned char data[256];
+    size_t length = 0;
+    
+    // 2x2 int8 from 0, then a NULL int4
+    length += write_uint32(data + length, 2);
+    length += write_uint32(data + length, 0);
+    length += write_uint32(data + length, OID_INT64);
+    length += write_uint32(data + length, 2);
+    length += write_uint32(data + length, 0);
+    length += write_uint32(data + length, 2);
+    length += write_uint32(data + length, 1);
+    
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        length += write_uint32(data + length, 8);
+        length += write_uint32(data + length, 0x80000000u);
+        length += write_uint32(data + length, i);
+    }
+    
+    px_array *array = px_array_decode_binary(data, length);
+    check(array != NULL && array->dimension_count == 2 && array->lower_bounds[0] == 0 && array->count == 4, "binary int8");
+    if (array != NULL)
+    {
+        const int64_t *values = array->values;
+        check(values[0] == INT64_MIN && values[3] == INT64_MIN + 3, "binary int8 elements");
+        px_array_delete(array);
+    }
+    
+    check(px_array_decode_binary(data, length - 1) == NULL, "truncated binary element");
+    check(px_array_decode_binary(data, 20) == NULL, "truncated binary dimensions");
+    check(px_array_decode_binary(data, 8) == NULL, "truncated binary header");
+    
+    // an element of the wrong size
+    length = 0;
+    length += write_uint32(data + length, 1);
+    length += write_uint32(data + length, 1);
+    length += write_uint32(data + length, OID_INT32);
+    length += write_uint32(data + length, 2);
+    length += write_uint32(data + length, 1);
+    length += write_uint32(data + length, UINT32_MAX);
+    length += write_uint32(data + length, 2);
+    length += write_uint32(data + length, 42);
+    check(px_array_decode_binary(data, length) == NULL, "binary element of the wrong size");
+    
+    length -= 8;
+    length += write_uint32(data + length, 4);
+    length += write_uint32(data + length, 42);
+    array = px_array_decode_binary(data, length);
+    check(array != NULL && array->count == 2 && array->null_count == 1 && px_array_is_null(array, 0), "binary NULL element");
+    if (array != NULL)
+    {
+        check(((const int32_t *)array->values)[1] == 42, "binary int4 element");
+        px_array_delete(array);
+    }
+    
+    check(px_array_decode_binary(data, length + 4) == NULL, "trailing bytes after the binary elements");
+    
+    // a count that the data can't possibly hold
+    length = 0;
+    length += write_uint32(data + length, 2);
+    length += write_uint32(data + length, 0);
+    length += write_uint32(data + length, OID_INT32);
+    length += write_uint32(data + length, 0x7fffffff);
+    length += write_uint32(data + length, 1);
+    length += write_uint32(data + length, 0x7fffffff);
+    length += write_uint32(data + length, 1);
+    check(px_array_decode_binary(data, length) == NULL, "huge binary count");
+    
+    length = 0;
+    length += write_uint32(data + length, 1);
+    length += write_uint32(data + length, 0);
+    length += write_uint32(data + length, OID_INT32);
+    length += write_uint32(data + length, UINT32_MAX);
+    length += write_uint32(data + length, 1);
+    check(px_array_decode_binary(data, length) == NULL, "negative binary dimension");
+    
+    length = 0;
+    length += write_uint32(data + length, 7);
+    length += write_uint32(data + length, 0);
+    length += write_uint32(data + length, OID_INT32);
+    check(px_array_decode_binary(data, length) == NULL, "too many binary dimensions");
+    
+    length = 0;
+    length += write_uint32(data + length, 0);
+    length += write_uint32(data + length, 0);
+    length += write_uint32(data + length, OID_INT32);
+    array = px_array_decode_binary(data, length);
+    check(array != NULL && array->dimension_count == 0 && array->count == 0, "empty binary array");
+    if (array != NULL)
+        px_array_delete(array);
+}
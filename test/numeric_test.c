@@ -0,0 +1,296 @@
+//
+//  numeric_test.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+// decodes, formats and parses NUMERIC values: rounding at the scale, digits on both sides of the
+// decimal point, the limits of int64, the special values and malformed input. it needs no server
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "px.h"
+
+#define SIGN_POSITIVE 0x0000
+#define SIGN_NEGATIVE 0x4000
+#define SIGN_NAN 0xC000
+#define SIGN_INFINITY 0xD000
+#define SIGN_NEGATIVE_INFINITY 0xF000
+
+#define DIGITS(...) (sizeof((const uint16_t[]){ __VA_ARGS__ }) / sizeof(uint16_t)), (const uint16_t[]){ __VA_ARGS__ }
+
+static unsigned int failures = 0;
+
+static void check(const bool condition, const char *restrict description);
+static size_t write_numeric(unsigned char *restrict data, const int weight, const unsigned int sign, const unsigned int display_scale, const size_t digit_count, const uint16_t *restrict digits);
+static bool decodes_to(const unsigned char *restrict data, const size_t length, const unsigned int scale, const int64_t expected);
+static bool decodes(const unsigned char *restrict data, const size_t length, const unsigned int scale);
+static bool formats_to(const unsigned char *restrict data, const size_t length, const char *restrict expected);
+static bool parses_to(const char *restrict text, const unsigned int scale, const int64_t expected);
+static bool parses(const char *restrict text, const unsigned int scale);
+static void test_decode(void);
+static void test_special(void);
+static void test_malformed(void);
+static void test_format(void);
+static void test_parse(void);
+
+int main(void)
+{
+    test_decode();
+    test_special();
+    test_malformed();
+    test_format();
+    test_parse();
+    
+    if (failures > 0)
+    {
+        printf("%u failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+static void check(const bool condition, const char *restrict description)
+{
+    if (condition)
+        return;
+    
+    printf("%s failed\n", description);
+    failures++;
+}
+
+static size_t write_numeric(unsigned char *restrict data, const int weight, const unsigned int sign, const unsigned int display_scale, const size_t digit_count, const uint16_t *restrict digits)
+{
+    // the number of base 10000 digits, the weight of the first one, the sign and the display scale
+    const uint16_t header[] = { (uint16_t)digit_count, (uint16_t)weight, (uint16_t)sign, (uint16_t)display_scale };
+    size_t length = 0;
+    
+    for (size_t i = 0; i < 4 + digit_count; i++)
+    {
+        const uint16_t value = i < 4 ? header[i] : digits[i - 4];
+        data[length++] = (unsigned char)(value >> 8);
+        data[length++] = (unsigned char)value;
+    }
+    
+    return length;
+}
+
+static bool decodes_to(const unsigned char *restrict data, const size_t length, const unsigned int scale, const int64_t expected)
+{
+    int64_t value;
+    return px_numeric_decode_int64(data, length, scale, &value) && value == expected;
+}
+
+static bool decodes(const unsigned char *restrict data, const size_t length, const unsigned int scale)
+{
+    int64_t value;
+    return px_numeric_decode_int64(data, length, scale, &value);
+}
+
+static bool formats_to(const unsigned char *restrict data, const size_t length, const char *restrict expected)
+{
+    char text[64];
+    return px_numeric_format(data, length, text, sizeof(text)) == strlen(expected) && strcmp(text, expected) == 0;
+}
+
+static bool parses_to(const char *restrict text, const unsigned int scale, const int64_t expected)
+{
+    int64_t value;
+    return px_numeric_parse_int64(text, strlen(text), scale, &value) && value == expected;
+}
+
+static bool parses(const char *restrict text, const unsigned int scale)
+{
+    int64_t value;
+    return px_numeric_parse_int64(text, strlen(text), scale, &value);
+}
+
+static void test_decode(void)
+{
+    unsigned char data[64];
+    double value;
+    
+    // 12345.678
+    size_t length = write_numeric(data, 1, SIGN_POSITIVE, 3, DIGITS(1, 2345, 6780));
+    check(decodes_to(data, length, 0, 12346), "rounding to no decimals");
+    check(decodes_to(data, length, 2, 1234568), "rounding within a digit");
+    check(decodes_to(data, length, 3, 12345678), "exact decimals");
+    check(decodes_to(data, length, 6, 12345678000), "decimals beyond the last digit");
+    check(px_numeric_decode_double(data, length, &value) && value == 12345.678, "double");
+    
+    length = write_numeric(data, 1, SIGN_NEGATIVE, 3, DIGITS(1, 2345, 6780));
+    check(decodes_to(data, length, 2, -1234568), "rounding a negative value away from zero");
+    check(px_numeric_decode_double(data, length, &value) && value == -12345.678, "negative double");
+    
+    // 0.125 and -0.125, halfway
+    length = write_numeric(data, -1, SIGN_POSITIVE, 3, DIGITS(1250));
+    check(decodes_to(data, length, 2, 13), "rounding half up");
+    check(decodes_to(data, length, 1, 1), "rounding down");
+    length = write_numeric(data, -1, SIGN_NEGATIVE, 3, DIGITS(1250));
+    check(decodes_to(data, length, 2, -13), "rounding half away from zero");
+    
+    // 0.5 rounds at a digit boundary
+    length = write_numeric(data, -1, SIGN_POSITIVE, 1, DIGITS(5000));
+    check(decodes_to(data, length, 0, 1), "rounding at a digit boundary");
+    
+    // 100000000, a weight beyond the digits
+    length = write_numeric(data, 2, SIGN_POSITIVE, 0, DIGITS(1));
+    check(decodes_to(data, length, 0, 100000000), "positive weight");
+    check(decodes_to(data, length, 2, 10000000000), "positive weight with decimals");
+    check(px_numeric_decode_double(data, length, &value) && value == 1e8, "double of a positive weight");
+    
+    // 0.00001234, a negative weight
+    length = write_numeric(data, -2, SIGN_POSITIVE, 8, DIGITS(1234));
+    check(decodes_to(data, length, 8, 1234), "negative weight");
+    check(decodes_to(data, length, 5, 1), "negative weight cut within a digit");
+    check(decodes_to(data, length, 4, 0), "negative weight below the scale");
+    check(px_numeric_decode_double(data, length, &value) && value == 0.00001234, "double of a negative weight");
+    
+    // 0.000000005 is rounded off entirely
+    length = write_numeric(data, -3, SIGN_POSITIVE, 9, DIGITS(5000));
+    check(decodes_to(data, length, 4, 0), "digits far below the scale");
+    
+    length = write_numeric(data, 0, SIGN_POSITIVE, 2, DIGITS());
+    check(decodes_to(data, length, 2, 0), "zero");
+    check(px_numeric_decode_double(data, length, &value) && value == 0.0, "double of zero");
+    
+    // the limits of int64: 9223372036854775807 and one beyond
+    length = write_numeric(data, 4, SIGN_POSITIVE, 0, DIGITS(922, 3372, 368, 5477, 5807));
+    check(decodes_to(data, length, 0, INT64_MAX), "largest int64");
+    check(!decodes(data, length, 1), "largest int64 with a decimal");
+    length = write_numeric(data, 4, SIGN_POSITIVE, 0, DIGITS(922, 3372, 368, 5477, 5808));
+    check(!decodes(data, length, 0), "int64 overflow");
+    length = write_numeric(data, 4, SIGN_NEGATIVE, 0, DIGITS(922, 3372, 368, 5477, 5808));
+    check(decodes_to(data, length, 0, INT64_MIN), "smallest int64");
+    length = write_numeric(data, 4, SIGN_NEGATIVE, 0, DIGITS(922, 3372, 368, 5477, 5809));
+    check(!decodes(data, length, 0), "int64 underflow");
+    length = write_numeric(data, 4, SIGN_POSITIVE, 1, DIGITS(922, 3372, 368, 5477, 5807, 5000));
+    check(!decodes(data, length, 0), "int64 overflow by rounding");
+    
+    // 1234567890123456789 and 1e-40 take the slow path of the double
+    length = write_numeric(data, 4, SIGN_POSITIVE, 0, DIGITS(123, 4567, 8901, 2345, 6789));
+    check(px_numeric_decode_double(data, length, &value) && value == 1234567890123456789.0, "double of many digits");
+    length = write_numeric(data, -10, SIGN_POSITIVE, 40, DIGITS(1));
+    check(px_numeric_decode_double(data, length, &value) && value == 1e-40, "double of a large exponent");
+
+#ifdef __SIZEOF_INT128__
+    // 10^30
+    __int128 wide_value;
+    length = write_numeric(data, 7, SIGN_POSITIVE, 0, DIGITS(100));
+    check(px_numeric_decode_int128(data, length, 0, &wide_value) && wide_value == (__int128)1000000000000000 * 1000000000000000, "int128");
+#endif
+}
+
+static void test_special(void)
+{
+    unsigned char data[64];
+    int64_t integer_value;
+    double value;
+    
+    size_t length = write_numeric(data, 0, SIGN_NAN, 0, DIGITS());
+    check(!px_numeric_decode_int64(data, length, 0, &integer_value), "NaN as int64");
+    check(px_numeric_decode_double(data, length, &value) && isnan(value), "NaN as double");
+    check(formats_to(data, length, "NaN"), "NaN as text");
+    
+    length = write_numeric(data, 0, SIGN_INFINITY, 0, DIGITS());
+    check(!px_numeric_decode_int64(data, length, 0, &integer_value), "infinity as int64");
+    check(px_numeric_decode_double(data, length, &value) && isinf(value) && value > 0, "infinity as double");
+    check(formats_to(data, length, "Infinity"), "infinity as text");
+    
+    length = write_numeric(data, 0, SIGN_NEGATIVE_INFINITY, 0, DIGITS());
+    check(!px_numeric_decode_int64(data, length, 0, &integer_value), "negative infinity as int64");
+    check(px_numeric_decode_double(data, length, &value) && isinf(value) && value < 0, "negative infinity as double");
+    check(formats_to(data, length, "-Infinity"), "negative infinity as text");
+}
+
+static void test_malformed(void)
+{
+    unsigned char data[64];
+    int64_t integer_value;
+    double value;
+    char text[16];
+    
+    size_t length = write_numeric(data, 0, SIGN_POSITIVE, 0, DIGITS(1, 2));
+    check(!px_numeric_decode_int64(data, length - 1, 0, &integer_value), "truncated digits");
+    check(!px_numeric_decode_int64(data, length - 2, 0, &integer_value), "missing digit");
+    check(!px_numeric_decode_double(data, 6, &value), "truncated header");
+    check(px_numeric_format(data, 6, text, sizeof(text)) == 0 && text[0] == '\0', "formatting a truncated header");
+    check(px_numeric_copy_string(data, length - 1) == NULL, "copying truncated digits");
+    
+    length = write_numeric(data, 0, SIGN_POSITIVE, 0, DIGITS(10000));
+    check(!px_numeric_decode_int64(data, length, 0, &integer_value), "digit beyond base 10000");
+    
+    length = write_numeric(data, 0, 0x1234, 0, DIGITS(1));
+    check(!px_numeric_decode_double(data, length, &value), "unknown sign");
+    
+    length = write_numeric(data, 0, SIGN_POSITIVE, 0, DIGITS());
+    data[0] = 0xff;
+    data[1] = 0xff;
+    check(!px_numeric_decode_int64(data, length, 0, &integer_value), "negative digit count");
+}
+
+static void test_format(void)
+{
+    unsigned char data[64];
+    
+    size_t length = write_numeric(data, 1, SIGN_POSITIVE, 3, DIGITS(1, 2345, 6780));
+    check(formats_to(data, length, "12345.678"), "decimals cut at the display scale");
+    
+    length = write_numeric(data, 1, SIGN_NEGATIVE, 6, DIGITS(1, 2345, 6780));
+    check(formats_to(data, length, "-12345.678000"), "decimals padded to the display scale");
+    
+    length = write_numeric(data, 2, SIGN_POSITIVE, 0, DIGITS(1));
+    check(formats_to(data, length, "100000000"), "zeros of a positive weight");
+    
+    length = write_numeric(data, -2, SIGN_POSITIVE, 8, DIGITS(1234));
+    check(formats_to(data, length, "0.00001234"), "zeros of a negative weight");
+    
+    length = write_numeric(data, -1, SIGN_NEGATIVE, 1, DIGITS(5000));
+    check(formats_to(data, length, "-0.5"), "negative fraction");
+    
+    length = write_numeric(data, 0, SIGN_POSITIVE, 2, DIGITS());
+    check(formats_to(data, length, "0.00"), "zero with decimals");
+    
+    // like snprintf, the length of the whole text even when it's cut
+    char text[4];
+    length = write_numeric(data, 1, SIGN_POSITIVE, 3, DIGITS(1, 2345, 6780));
+    check(px_numeric_format(data, length, text, sizeof(text)) == 9 && strcmp(text, "123") == 0, "formatting into a short buffer");
+    
+    char *copy = px_numeric_copy_string(data, length);
+    check(copy != NULL && strcmp(copy, "12345.678") == 0, "copying the text");
+    free(copy);
+}
+
+static void test_parse(void)
+{
+    check(parses_to("12345.678", 2, 1234568), "parsing with rounding");
+    check(parses_to("12345.678", 3, 12345678), "parsing exact decimals");
+    check(parses_to("12", 3, 12000), "parsing an integer with decimals");
+    check(parses_to("0.124", 2, 12), "parsing with rounding down");
+    check(parses_to("-0.125", 2, -13), "parsing with rounding half away from zero");
+    check(parses_to("1.49999", 0, 1), "rounding by the first dropped digit only");
+    check(parses_to("-1.5", 0, -2), "parsing a negative half");
+    check(parses_to("+7", 0, 7), "parsing a plus sign");
+    check(parses_to(".5", 0, 1), "parsing without an integral part");
+    check(parses_to("9223372036854775807", 0, INT64_MAX), "parsing the largest int64");
+    check(parses_to("-9223372036854775808", 0, INT64_MIN), "parsing the smallest int64");
+    
+    check(!parses("9223372036854775808", 0), "parsing an int64 overflow");
+    check(!parses("-9223372036854775809", 0), "parsing an int64 underflow");
+    check(!parses("922337203685477580.8", 1), "parsing an int64 overflow by the scale");
+    check(!parses("9223372036854775807.5", 0), "parsing an int64 overflow by rounding");
+    check(!parses("", 0), "parsing nothing");
+    check(!parses("-", 0), "parsing a sign only");
+    check(!parses(".", 0), "parsing a point only");
+    check(!parses("1.2.3", 0), "parsing two points");
+    check(!parses("1e5", 0), "parsing an exponent");
+    check(!parses(" 1", 0), "parsing a space");
+    check(!parses("NaN", 0), "parsing NaN");
+}
@@ -0,0 +1,153 @@
+//
+//  reactor_test.c
+//  libpx
+//
+//  Created by Tamas Czinege on 19/10/2026.
+//  Copyright (c) 2026 Tamas Czinege. All rights reserved.
+//
+
+// runs the same queries through every reactor backend the library was built with against the
+// server given by PGHOST, PGPORT, PGUSER, PGDATABASE and PGPASSWORD. make test builds and runs it
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "px.h"
+
+static const char *const backend_names[] = { "default", "poll", "epoll", "io_uring" };
+static const unsigned int round_count = 50;
+
+static unsigned int failures = 0;
+
+static px_connection_params *connection_params_from_environment(void);
+static void check(const bool condition, const px_reactor_backend_type backend_type, const char *restrict description);
+static bool has_rows(const px_result_list *restrict results, const unsigned int row_count) __attribute__((pure));
+static void on_query(px_reactor *reactor __attribute__((unused)), px_connection *connection __attribute__((unused)), px_result_list *results, void *context);
+static int run_query(px_reactor *restrict reactor, px_query *restrict query);
+static void test_backend(px_connection_params *restrict connection_params, const px_reactor_backend_type backend_type);
+
+int main(void)
+{
+    px_connection_params *connection_params = connection_params_from_environment();
+    
+    test_backend(connection_params, px_reactor_backend_type_poll);
+    test_backend(connection_params, px_reactor_backend_type_epoll);
+    test_backend(connection_params, px_reactor_backend_type_io_uring);
+    
+    px_connection_params_delete(connection_params);
+    
+    if (failures > 0)
+    {
+        printf("%u failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+static px_connection_params *connection_params_from_environment(void)
+{
+    px_connection_params *connection_params = px_connection_params_new();
+    const char *value;
+    
+    px_connection_params_set_hostname(connection_params, (value = getenv("PGHOST")) != NULL ? value : "localhost");
+    px_connection_params_set_port(connection_params, (value = getenv("PGPORT")) != NULL ? (unsigned int)atoi(value) : 5432);
+    
+    if ((value = getenv("PGUSER")) != NULL)
+        px_connection_params_set_username(connection_params, value);
+    
+    if ((value = getenv("PGDATABASE")) != NULL)
+        px_connection_params_set_database(connection_params, value);
+    
+    if ((value = getenv("PGPASSWORD")) != NULL)
+        px_connection_params_set_password(connection_params, value);
+    
+    return connection_params;
+}
+
+static void check(const bool condition, const px_reactor_backend_type backend_type, const char *restrict description)
+{
+    if (condition)
+        return;
+    
+    printf("%s: %s failed\n", backend_names[backend_type], description);
+    failures++;
+}
+
+static bool has_rows(const px_result_list *restrict results, const unsigned int row_count)
+{
+    return results != NULL && results->count == 1 && px_result_get_row_count(results->results[0]) == row_count;
+}
+
+static void on_query(px_reactor *reactor __attribute__((unused)), px_connection *connection __attribute__((unused)), px_result_list *results, void *context)
+{
+    *(int *)context = has_rows(results, 10) ? 1 : -1;
+    
+    if (results != NULL)
+        px_result_list_delete(results, false);
+}
+
+static int run_query(px_reactor *restrict reactor, px_query *restrict query)
+{
+    int outcome = 0;
+    
+    if (!px_reactor_query(reactor, query, 5000, on_query, &outcome))
+        return -1;
+    
+    while (outcome == 0 && px_reactor_run_once(reactor, -1) >= 0);
+    
+    return outcome;
+}
+
+static void test_backend(px_connection_params *restrict connection_params, const px_reactor_backend_type backend_type)
+{
+    px_reactor *reactor = px_reactor_new_with_backend(backend_type);
+    if (reactor == NULL)
+    {
+        printf("%s: not available, skipped\n", backend_names[backend_type]);
+        return;
+    }
+    
+    const unsigned int failures_before = failures;
+    
+    for (unsigned int round = 0; round < round_count && failures == failures_before; round++)
+    {
+        px_connection *connection = px_connection_new(connection_params);
+        if (px_connection_open(connection) != px_connection_attempt_result_success)
+        {
+            check(false, backend_type, "opening a connection");
+            px_connection_delete(connection);
+            break;
+        }
+        
+        px_query *query = px_query_new("SELECT generate_series(1, 10)", connection);
+        check(run_query(reactor, query) == 1, backend_type, "query in the reactor");
+        
+        // once removed, nothing of the reactor may read or write the socket any more
+        px_reactor_remove(reactor, connection);
+        
+        px_query *blocking_query = px_query_new("SELECT generate_series(1, 7)", connection);
+        px_query_set_timeout(blocking_query, 5000);
+        
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            px_result_list *results = px_query_execute(blocking_query);
+            check(has_rows(results, 7), backend_type, "blocking query after removal");
+            
+            if (results != NULL)
+                px_result_list_delete(results, false);
+        }
+        
+        px_query_delete(blocking_query);
+        
+        // and the reactor can take it back
+        check(run_query(reactor, query) == 1, backend_type, "query in the reactor after blocking queries");
+        px_query_delete(query);
+        
+        px_reactor_remove(reactor, connection);
+        px_connection_delete(connection);
+    }
+    
+    px_reactor_delete(reactor);
+    printf("%s: done\n", backend_names[backend_type]);
+}